@@ -29,6 +29,9 @@ public:
 	// Frees the current content. Allows you to optionally set the new initial capacity. If growCount == -1, the
 	// growCount remains unchanged.
 	void Clear(int capacity = 0, int growCount = -1);
+
+	// Sets the number of elements to zero but keeps the memory so the array may be refilled without reallocating.
+	void Reset()																										{ NumElements = 0; }
 	int GetNumElements() const																							{ return NumElements; }
 	T* GetElements() const																								{ return Elements; }
 
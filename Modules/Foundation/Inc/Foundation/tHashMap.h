@@ -0,0 +1,422 @@
+// tHashMap.h
+//
+// Open addressing hash map and hash set containers. Both use Robin Hood linear probing: an item being inserted takes
+// the slot of any resident that is closer to its home slot, which keeps probe sequences short and lets a failed lookup
+// stop early. Removal uses backward-shift deletion so there are no tombstones. Like the pools, nothing here calls new or
+// delete. Memory comes from tMem::tMalloc or from an optional tMem::tAllocator, so the containers may be used from
+// inside an overloaded operator new.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "Foundation/tAssert.h"
+#include "Foundation/tPlatform.h"
+#include "Foundation/tMemory.h"
+#include "Foundation/tPool.h"
+
+
+// The key traits used by tHashMap and tHashSet. A specialization supplies a static Hash function returning a uint32 and
+// a static Equal function. Integral, enum, and pointer keys are handled here. String keys are hashed with the tMath
+// hash functions so their specialization lives in Math/tHash.h. You may supply your own traits as the last template
+// argument of the containers.
+template<typename K, typename Enable = void> struct tHashKey;
+
+
+template<typename K> struct tHashKey
+<
+	K, typename std::enable_if<std::is_integral<K>::value || std::is_enum<K>::value || std::is_pointer<K>::value>::type
+>
+{
+	// This is the 64 bit finalizer from MurmurHash3. Every input bit affects every output bit.
+	static uint32 Hash(const K& key)
+	{
+		uint64 k = uint64(key);
+		k ^= k >> 33;
+		k *= 0xFF51AFD7ED558CCDull;
+		k ^= k >> 33;
+		k *= 0xC4CEB9FE1A85EC53ull;
+		k ^= k >> 33;
+		return uint32(k ^ (k >> 32));
+	}
+	static bool Equal(const K& a, const K& b)																			{ return a == b; }
+};
+
+
+// The common open addressing table used by tHashMap and tHashSet. E is the entry type and must have a member called
+// Key. A stored hash of 0 marks an empty slot. Any key that actually hashes to 0 is stored as 1 instead.
+template<typename K, typename E, typename HashFn> class tHashTable
+{
+public:
+	// The initialCapacity is the number of items you expect to insert before the table needs to grow. If an allocator
+	// is supplied it is used for the table memory. Should it fail (return nullptr) tMem::tMalloc is used instead.
+	tHashTable(int initialCapacity = 0, tMem::tAllocator* allocator = nullptr)											: Allocator(allocator) { if (initialCapacity > 0) Reserve(initialCapacity); }
+	tHashTable(const tHashTable& src)																					: Allocator(src.Allocator) { *this = src; }
+	~tHashTable()																										{ Reset(); }
+
+	int GetNumItems() const																								{ return NumItems; }
+	int GetCapacity() const																								{ return Capacity; }
+	bool IsEmpty() const																								{ return NumItems == 0; }
+	bool Contains(const K& key) const																					{ return FindIndex(key, ComputeHash(key)) >= 0; }
+
+	// Returns true if the key was present and removed.
+	bool Remove(const K& key);
+
+	// Clear destroys all items but keeps the table memory around. Reset destroys all items and frees the memory.
+	void Clear();
+	void Reset();
+
+	// Makes sure numItems items can be present without the table growing.
+	void Reserve(int numItems);
+
+	tHashTable& operator=(const tHashTable& src);
+
+	// Iteration visits items in no particular order. Do not insert or remove items, or modify the Key member of an
+	// entry, while iterating. Iterators are invalidated by both insertion and removal.
+	template<bool Const> class IterT
+	{
+	public:
+		typedef typename std::conditional<Const, const tHashTable, tHashTable>::type TableType;
+		typedef typename std::conditional<Const, const E, E>::type EntryType;
+		IterT(TableType* table, int index)																				: Table(table), Index(index) { Skip(); }
+		EntryType& operator*() const																					{ return Table->Entries[Index]; }
+		EntryType* operator->() const																					{ return &Table->Entries[Index]; }
+		IterT& operator++()																								{ Index++; Skip(); return *this; }
+		bool operator==(const IterT& it) const																			{ return Index == it.Index; }
+		bool operator!=(const IterT& it) const																			{ return Index != it.Index; }
+
+	private:
+		void Skip()																										{ while ((Index < Table->Capacity) && !Table->Hashes[Index]) Index++; }
+		TableType* Table;
+		int Index;
+	};
+	typedef IterT<false> Iter;
+	typedef IterT<true> ConstIter;
+
+	// For range-based iteration supported by C++11.
+	Iter begin()																										{ return Iter(this, 0); }
+	Iter end()																											{ return Iter(this, Capacity); }
+	ConstIter begin() const																								{ return ConstIter(this, 0); }
+	ConstIter end() const																								{ return ConstIter(this, Capacity); }
+
+protected:
+	static uint32 ComputeHash(const K& key)																				{ uint32 h = HashFn::Hash(key); return h ? h : 1; }
+
+	// Fibonacci hashing. The multiply spreads the hash so the top bits are good to use even for poor hash functions.
+	int HomeIndex(uint32 hash) const																					{ return int((hash * 2654435769u) >> Shift); }
+	int ProbeDistance(int index) const																					{ return (index - HomeIndex(Hashes[index])) & (Capacity - 1); }
+
+	// Returns -1 if the key is not present.
+	int FindIndex(const K& key, uint32 hash) const;
+
+	// Must be called before inserting a key that is not already present.
+	void GrowIfNeeded()																									{ if ((NumItems + 1) * 5 > Capacity * 4) Rehash(Capacity ? Capacity << 1 : MinCapacity); }
+
+	// Inserts an entry whose key is known not to be present. Capacity must be available. Returns the index of the
+	// newly inserted entry.
+	int InsertEntry(uint32 hash, E&& entry);
+
+	void Rehash(int newCapacity);
+
+	const static int MinCapacity = 8;
+	tMem::tAllocator* Allocator = nullptr;
+	void* Memory = nullptr;
+	bool MemoryFromAllocator = false;
+	uint32* Hashes = nullptr;
+	E* Entries = nullptr;
+	int Capacity = 0;																	// Always 0 or a power of 2.
+	int NumItems = 0;
+	int Shift = 32;
+};
+
+
+template<typename K, typename V> struct tHashMapEntry
+{
+	K Key;
+	V Value;
+};
+
+
+// A map from keys of type K to values of type V. If a key type does not have a suitable tHashKey specialization you may
+// supply your own traits in HashFn.
+template<typename K, typename V, typename HashFn = tHashKey<K>> class tHashMap : public tHashTable<K, tHashMapEntry<K, V>, HashFn>
+{
+public:
+	typedef tHashMapEntry<K, V> Entry;
+	typedef tHashTable<K, Entry, HashFn> Base;
+	tHashMap(int initialCapacity = 0, tMem::tAllocator* allocator = nullptr)											: Base(initialCapacity, allocator) { }
+
+	// Returns nullptr if the key is not present. The returned pointer is invalidated by any insertion or removal.
+	V* Find(const K& key)																								{ int i = this->FindIndex(key, Base::ComputeHash(key)); return (i >= 0) ? &this->Entries[i].Value : nullptr; }
+	const V* Find(const K& key) const																					{ int i = this->FindIndex(key, Base::ComputeHash(key)); return (i >= 0) ? &this->Entries[i].Value : nullptr; }
+
+	// Returns false and leaves the existing value unmodified if the key is already present.
+	bool Insert(const K& key, const V& value);
+
+	// Returns the value for the key, inserting a default constructed value if the key is not present.
+	V& operator[](const K& key);
+};
+
+
+template<typename K> struct tHashSetEntry
+{
+	K Key;
+};
+
+
+// A set of unique keys. Iteration gives you entries with a Key member.
+template<typename K, typename HashFn = tHashKey<K>> class tHashSet : public tHashTable<K, tHashSetEntry<K>, HashFn>
+{
+public:
+	typedef tHashSetEntry<K> Entry;
+	typedef tHashTable<K, Entry, HashFn> Base;
+	tHashSet(int initialCapacity = 0, tMem::tAllocator* allocator = nullptr)											: Base(initialCapacity, allocator) { }
+
+	// Returns false if the key was already present.
+	bool Insert(const K& key);
+};
+
+
+// Implementation below this line.
+
+
+template<typename K, typename E, typename HashFn> inline int tHashTable<K, E, HashFn>::FindIndex(const K& key, uint32 hash) const
+{
+	if (!NumItems)
+		return -1;
+
+	int mask = Capacity - 1;
+	int index = HomeIndex(hash);
+	for (int dist = 0; ; dist++)
+	{
+		// Since the load factor is always below 1 an empty slot is guaranteed to exist. If the resident is closer to
+		// its home than we are to ours, our key would have displaced it on insertion, so it can't be further along.
+		uint32 h = Hashes[index];
+		if (!h || (ProbeDistance(index) < dist))
+			return -1;
+
+		if ((h == hash) && HashFn::Equal(Entries[index].Key, key))
+			return index;
+
+		index = (index + 1) & mask;
+	}
+}
+
+
+template<typename K, typename E, typename HashFn> inline int tHashTable<K, E, HashFn>::InsertEntry(uint32 hash, E&& entry)
+{
+	tAssert(NumItems < Capacity);
+	int mask = Capacity - 1;
+	int index = HomeIndex(hash);
+	int inserted = -1;
+	for (int dist = 0; ; dist++)
+	{
+		if (!Hashes[index])
+		{
+			new (&Entries[index]) E(std::move(entry));
+			Hashes[index] = hash;
+			NumItems++;
+			return (inserted >= 0) ? inserted : index;
+		}
+
+		// Take from the rich and give to the poor. The displaced resident continues the probe in our place.
+		int residentDist = ProbeDistance(index);
+		if (residentDist < dist)
+		{
+			std::swap(hash, Hashes[index]);
+			std::swap(entry, Entries[index]);
+			if (inserted < 0)
+				inserted = index;
+			dist = residentDist;
+		}
+
+		index = (index + 1) & mask;
+	}
+}
+
+
+template<typename K, typename E, typename HashFn> inline bool tHashTable<K, E, HashFn>::Remove(const K& key)
+{
+	int index = FindIndex(key, ComputeHash(key));
+	if (index < 0)
+		return false;
+
+	// Backward-shift deletion. Subsequent entries in the run move back one slot until we hit an empty slot or an
+	// entry that is already in its home slot.
+	int mask = Capacity - 1;
+	Entries[index].~E();
+	int next = (index + 1) & mask;
+	while (Hashes[next] && ProbeDistance(next))
+	{
+		new (&Entries[index]) E(std::move(Entries[next]));
+		Entries[next].~E();
+		Hashes[index] = Hashes[next];
+		index = next;
+		next = (next + 1) & mask;
+	}
+	Hashes[index] = 0;
+	NumItems--;
+	return true;
+}
+
+
+template<typename K, typename E, typename HashFn> inline void tHashTable<K, E, HashFn>::Clear()
+{
+	for (int i = 0; i < Capacity; i++)
+	{
+		if (Hashes[i])
+		{
+			Entries[i].~E();
+			Hashes[i] = 0;
+		}
+	}
+	NumItems = 0;
+}
+
+
+template<typename K, typename E, typename HashFn> inline void tHashTable<K, E, HashFn>::Reset()
+{
+	Clear();
+	if (Memory)
+	{
+		if (MemoryFromAllocator)
+			Allocator->Free(Memory);
+		else
+			tMem::tFree(Memory);
+	}
+
+	Memory = nullptr;
+	MemoryFromAllocator = false;
+	Hashes = nullptr;
+	Entries = nullptr;
+	Capacity = 0;
+	Shift = 32;
+}
+
+
+template<typename K, typename E, typename HashFn> inline void tHashTable<K, E, HashFn>::Reserve(int numItems)
+{
+	int capacity = MinCapacity;
+	while (capacity * 4 < numItems * 5)
+		capacity <<= 1;
+
+	if (capacity > Capacity)
+		Rehash(capacity);
+}
+
+
+template<typename K, typename E, typename HashFn> inline void tHashTable<K, E, HashFn>::Rehash(int newCapacity)
+{
+	tAssert(newCapacity >= MinCapacity);
+	tAssert((newCapacity & (newCapacity - 1)) == 0);
+
+	// A single block holds the hashes followed by the entries. We align manually because a user supplied allocator
+	// need not honour the alignment of E.
+	int align = (alignof(E) > 4) ? int(alignof(E)) : 4;
+	int hashBytes = (newCapacity * int(sizeof(uint32)) + align - 1) & ~(align - 1);
+	int numBytes = hashBytes + newCapacity * int(sizeof(E)) + align;
+
+	void* memory = Allocator ? Allocator->Malloc(numBytes) : nullptr;
+	bool fromAllocator = memory ? true : false;
+	if (!memory)
+		memory = tMem::tMalloc(numBytes);
+
+	uint8* base = (uint8*)((uint64(memory) + align - 1) & ~uint64(align - 1));
+	void* oldMemory = Memory;
+	bool oldFromAllocator = MemoryFromAllocator;
+	uint32* oldHashes = Hashes;
+	E* oldEntries = Entries;
+	int oldCapacity = Capacity;
+
+	Memory = memory;
+	MemoryFromAllocator = fromAllocator;
+	Hashes = (uint32*)base;
+	Entries = (E*)(base + hashBytes);
+	Capacity = newCapacity;
+	NumItems = 0;
+	Shift = 32;
+	for (int c = newCapacity; c > 1; c >>= 1)
+		Shift--;
+
+	for (int i = 0; i < newCapacity; i++)
+		Hashes[i] = 0;
+
+	for (int i = 0; i < oldCapacity; i++)
+	{
+		if (!oldHashes[i])
+			continue;
+
+		InsertEntry(oldHashes[i], std::move(oldEntries[i]));
+		oldEntries[i].~E();
+	}
+
+	if (oldMemory)
+	{
+		if (oldFromAllocator)
+			Allocator->Free(oldMemory);
+		else
+			tMem::tFree(oldMemory);
+	}
+}
+
+
+template<typename K, typename E, typename HashFn> inline tHashTable<K, E, HashFn>& tHashTable<K, E, HashFn>::operator=(const tHashTable& src)
+{
+	if (&src == this)
+		return *this;
+
+	Clear();
+	Reserve(src.NumItems);
+	for (int i = 0; i < src.Capacity; i++)
+		if (src.Hashes[i])
+			InsertEntry(src.Hashes[i], E(src.Entries[i]));
+
+	return *this;
+}
+
+
+template<typename K, typename V, typename HashFn> inline bool tHashMap<K, V, HashFn>::Insert(const K& key, const V& value)
+{
+	uint32 hash = Base::ComputeHash(key);
+	if (this->FindIndex(key, hash) >= 0)
+		return false;
+
+	this->GrowIfNeeded();
+	this->InsertEntry(hash, Entry{ key, value });
+	return true;
+}
+
+
+template<typename K, typename V, typename HashFn> inline V& tHashMap<K, V, HashFn>::operator[](const K& key)
+{
+	uint32 hash = Base::ComputeHash(key);
+	int index = this->FindIndex(key, hash);
+	if (index >= 0)
+		return this->Entries[index].Value;
+
+	this->GrowIfNeeded();
+	index = this->InsertEntry(hash, Entry{ key, V() });
+	return this->Entries[index].Value;
+}
+
+
+template<typename K, typename HashFn> inline bool tHashSet<K, HashFn>::Insert(const K& key)
+{
+	uint32 hash = Base::ComputeHash(key);
+	if (this->FindIndex(key, hash) >= 0)
+		return false;
+
+	this->GrowIfNeeded();
+	this->InsertEntry(hash, Entry{ key });
+	return true;
+}
@@ -228,10 +228,10 @@ public:
 	};
 
 	// Insert before head and append after tail.
-	T* Insert(const T* obj)																								{ tAssert(obj); Nodes.Insert(new IterNode(obj)); return obj; }
-	T* Insert(const T* obj, const Iter& here)																			{ tAssert(obj); tAssert(this == here.List); Nodes.Insert(new IterNode(obj), here.Node); return obj; }
-	T* Append(T* obj)																									{ tAssert(obj); Nodes.Append(new IterNode(obj)); return obj; }
-	T* Append(const T* obj, const Iter& here)																			{ tAssert(obj); tAssert(this == here.List); Nodes.Append(new IterNode(obj), here.Node); return obj; }
+	T* Insert(const T* obj)																								{ tAssert(obj); Nodes.Insert(new IterNode(obj)); ModCount++; return obj; }
+	T* Insert(const T* obj, const Iter& here)																			{ tAssert(obj); tAssert(this == here.List); Nodes.Insert(new IterNode(obj), here.Node); ModCount++; return obj; }
+	T* Append(T* obj)																									{ tAssert(obj); Nodes.Append(new IterNode(obj)); ModCount++; return obj; }
+	T* Append(const T* obj, const Iter& here)																			{ tAssert(obj); tAssert(this == here.List); Nodes.Append(new IterNode(obj), here.Node); ModCount++; return obj; }
 
 	T* Remove()												/* Removes and returns head. */								{ Iter head = Head(); return Remove(head); }
 	T* Remove(Iter&);										// Removed object referred to by Iter. Invalidates Iter.
@@ -255,6 +255,10 @@ public:
 	int Count() const																									{ return Nodes.Count(); }
 	bool IsEmpty()	const																								{ return Nodes.IsEmpty(); }
 
+	// Changes every time an object is inserted, appended, or removed. Two equal values mean the list holds the same
+	// objects it did before, even if the number of items happens to be the same after a remove and an append.
+	uint32 GetModCount() const																							{ return ModCount; }
+
 	Iter begin() const										/* For range-based iteration supported by C++11. */			{ return Head(); }
 	Iter end() const										/* For range-based iteration supported by C++11. */			{ return Iter(nullptr, this); }
 
@@ -267,7 +271,7 @@ public:
 	template<typename CompareFunc> int Sort(CompareFunc compare, tListSortAlgorithm algo = tListSortAlgorithm::Merge)	{ auto cmp = [&compare](const IterNode& a, const IterNode& b) { return compare(*a.Get(), *b.Get()); }; return Nodes.Sort(cmp, algo); }
 
 	// Inserts item in a sorted list. It will remain sorted.
-	template<typename CompareFunc> T* Insert(const T* item, CompareFunc compare)										{ auto cmp = [&compare](IterNode& a, IterNode& b) { return compare(*a.Get(), *b.Get()); }; return Nodes.Insert(item, cmp); }
+	template<typename CompareFunc> T* Insert(const T* item, CompareFunc compare)										{ auto cmp = [&compare](IterNode& a, IterNode& b) { return compare(*a.Get(), *b.Get()); }; ModCount++; return Nodes.Insert(item, cmp); }
 
 	// This does an O(n) single pass of a bubble sort iteration. Allows the cost of sorting to be distributed over time
 	// for objects that do not change their order very often. Do the expensive merge sort when the list is initially
@@ -288,6 +292,7 @@ private:
 	// tItList is implemented using a tList of Nodes that point to the objects.
 	tList<IterNode> Nodes;
 	bool OwnsObjects;
+	uint32 ModCount = 0;
 };
 
 
@@ -851,6 +856,7 @@ template<typename T> inline T* tItList<T>::Remove(Iter& iter)
 
 	IterNode* node = Nodes.Remove(iter.Node);
 	T* obj = (T*)node->Object;
+	ModCount++;
 
 	delete node;
 	iter.Node = 0;
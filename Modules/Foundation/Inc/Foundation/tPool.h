@@ -17,6 +17,7 @@
 #pragma once
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include "Foundation/tAssert.h"
 #include "Foundation/tList.h"
 #include "Foundation/tMemory.h"
@@ -41,7 +42,9 @@ public:
 	virtual ~tAllocator()																								{ Constructed = false; }
 	virtual void* Malloc(int numBytes)																					= 0;
 	virtual void Free(void*)																							= 0;
-	int GetNumAllocations() const																						{ return NumAllocations; }
+
+	// Allocators that can't keep NumAllocations up-to-date cheaply may count another way.
+	virtual int GetNumAllocations() const																				{ return NumAllocations; }
 
 	// This variable is to keep track of whether the allocator object is initialized. If the allocator is static and
 	// we are overriding operator new, we don't know when the allocator is constructed or destructed. This can cause the
@@ -130,6 +133,127 @@ private:
 };
 
 
+// tThreadCachePool is a thread-safe slot pool for many threads allocating at once. The constructor takes the same
+// parameters as tFastPool, followed by the batch size, so it can replace one directly. It never takes a lock on the
+// common path. Each thread keeps its own list of free slots. When it runs out, it takes
+// a batch of slots from a shared free list. When it has too many, it gives a batch back. The shared list is a
+// lock-free stack of batches. The head pointer is tagged with a counter that changes on every update to avoid the ABA
+// problem. Only growing the pool takes a lock.
+//
+// The tag lives in the upper 16 bits of the head so slot addresses must fit in 48 bits. This holds for user-space
+// memory on all current 64 bit platforms. A thread's cached slots are returned to the shared list when the thread
+// exits or calls ReleaseThreadCache. A thread caches slots for at most MaxPoolsPerThread pools at a time. Any more
+// share a single locked cache.
+class tThreadCachePool : public tAllocator
+{
+public:
+	tThreadCachePool
+	(
+		// This is the max item size in bytes. Slots are at least 16 bytes so a free batch can be linked in.
+		int slotSize,
+		int initialSlotsInBlock = 256,
+
+		// If slotsPerExpansionBlock is zero, Malloc will fail (return 0) once all initial slots are used up.
+		int slotsPerExpansionBlock = 128,
+
+		// Ignored. The pool is always thread-safe. It is here so the parameters line up with tFastPool's.
+		bool threadSafe = true,
+
+		// The number of slots moved between a thread and the shared list at once. A thread keeps up to twice this many
+		// free slots.
+		int slotsPerBatch = 32
+	);
+	~tThreadCachePool();
+
+	// Same behaviour as tFastPool. Returns nullptr if numBytes is over the slot size or the pool can't grow.
+	void* Malloc(int numBytes = 0) override;
+
+	// The memory may be freed by a different thread than the one that allocated it.
+	void Free(void*) override;
+
+	// Returns the calling thread's free slots to the shared list. Threads do this automatically when they exit. It is
+	// worth calling from a thread that is about to go idle for a long time.
+	void ReleaseThreadCache();
+
+	// The count kept by tAllocator is not maintained because a shared counter would have every thread contending for
+	// it again. This gathers the per-thread counts instead. It is exact when no other thread is in Malloc or Free.
+	int GetNumAllocations() const override;
+
+	int GetSlotSize() const																								{ return SlotSize; }
+	int GetSlotsPerBatch() const																						{ return SlotsPerBatch; }
+	int GetNumExpansionBlocks() const																					{ return NumBlocks - 1; }
+	int GetTotalPoolSize() const																						{ return SlotSize * (GetNumExpansionBlocks()*SlotsPerExpansionBlock + SlotsInitialBlock); }
+
+	static const int MaxPoolsPerThread = 16;
+
+private:
+	struct ThreadCache : public tLink<ThreadCache>
+	{
+		std::atomic<tThreadCachePool*> Pool = { nullptr };
+		uint8* Head = nullptr;
+		int Count = 0;
+
+		// Only written by the owning thread. It goes negative if the thread frees more than it allocates.
+		std::atomic<int> NumAllocated = { 0 };
+	};
+	struct ThreadCacheTable;
+	friend struct ThreadCacheTable;
+	static thread_local ThreadCacheTable CacheTable;
+
+	// A free batch is a chain of slots linked through their first pointer. The second pointer of the first slot links
+	// the batch to the next one in the shared list. The number of slots in the batch is kept in its upper 16 bits.
+	static uint8*& SlotNext(uint8* slot)																				{ return *((uint8**)slot); }
+	static uint64& BatchLink(uint8* slot)																				{ return *((uint64*)(slot + sizeof(uint8*))); }
+
+	// Returns nullptr if the calling thread already caches slots for MaxPoolsPerThread other pools.
+	ThreadCache* GetThreadCache();
+	void* MallocFromCache(ThreadCache*);
+	void FreeToCache(ThreadCache*, void* slot);
+
+	void PushBatch(uint8* batch, int count);
+	uint8* PopBatch(int& count);
+
+	// These return one batch of the new slots and put the rest on the shared list.
+	uint8* GrowPool(int& count);
+	uint8* AddBlock(int numSlots, int& count);
+
+	void ReturnCache(ThreadCache*);
+	void FreeBlocks();
+
+	struct SlotBlock : public tLink<SlotBlock>
+	{
+		int NumSlots;
+		uint8* Slots;
+	};
+
+	// Blocks are only added while holding GrowMutex.
+	tList<SlotBlock> Blocks;
+	std::atomic<int> NumBlocks;
+	std::mutex GrowMutex;
+
+	int SlotSize;
+	int SlotsInitialBlock;
+	int SlotsPerExpansionBlock;
+	int SlotsPerBatch;
+
+	// The tagged head of the shared list of free batches.
+	std::atomic<uint64> FreeBatches;
+
+	// The caches of all threads that use this pool. Only changed while holding the registry lock in tPool.cpp.
+	tList<ThreadCache> Caches;
+
+	// Used by threads that already cache slots for MaxPoolsPerThread other pools.
+	ThreadCache SharedCache;
+	std::mutex SharedCacheMutex;
+
+	// Allocation counts of caches that have been returned.
+	std::atomic<int> NumAllocatedRetired;
+
+	// If the pool is destroyed with live allocations its memory is freed when the last one is.
+	std::atomic<int> NumAllocatedAtShutdown;
+};
+
+
 }
 
 
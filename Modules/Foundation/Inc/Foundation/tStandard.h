@@ -35,6 +35,8 @@ template<typename T> inline void tSwap(T& a, T& b)																		{ T t = a; a
 inline void* tMemcpy(void* dest, const void* src, int numBytes)															{ return memcpy(dest, src, numBytes); }
 inline void* tMemset(void* dest, uint8 val, int numBytes)																{ return memset(dest, val, numBytes); }
 inline int tMemcmp(const void* a, const void* b, int numBytes)															{ return memcmp(a, b, numBytes); }
+inline void* tMemmove(void* dest, const void* src, int numBytes)														{ return memmove(dest, src, numBytes); }
+inline const void* tMemchr(const void* data, uint8 val, int numBytes)													{ return memchr(data, val, numBytes); }
 
 // For character strings we support regular 8 bit characters (ASCII) and full unicode via UTF8. We do not support either
 // USC2 or UTF16. The CT (Compile-Time) strlen variant below can compute the string length at compile-time for constant
@@ -4,7 +4,10 @@
 // no UCS2 or UTF16 support since UTF8 is, in my opinion, superior and the way forward. tStrings will work with UTF8.
 // You cannot stream (from cin etc) more than 512 chars into a string. This restriction is only for wacky << streaming.
 //
-// Copyright (c) 2004-2006, 2015, 2017, 2019 Tristan Grimmer.
+// Short strings are stored inline in the tString object so they do not need a heap allocation. The length is cached so
+// Length is O(1) and appending does not need to rescan the string.
+//
+// Copyright (c) 2004-2006, 2015, 2017, 2019, 2020 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
 // granted, provided that the above copyright notice and this permission notice appear in all copies.
 //
@@ -21,8 +24,9 @@
 
 struct tString
 {
-	tString()																											{ TextData = &EmptyChar; }
+	tString()																											{ SmallData[0] = '\0'; }
 	tString(const tString&);
+	tString(tString&&);
 
 	// Construct a string with enough room for length characters. Length+1 characters are reserved to make room for the
 	// null terminator. The reserved space is zeroed.
@@ -32,26 +36,28 @@ struct tString
 	virtual ~tString();
 
 	tString& operator=(const tString&);
-	bool operator==(const tString& s) const																				{ return( !tStd::tStrcmp(TextData, s.TextData) ); }
+	tString& operator=(tString&&);
+	bool operator==(const tString& s) const																				{ return (Length() == s.Length()) && !tStd::tStrcmp(TextData, s.TextData); }
 	bool operator==(const char* s) const																				{ return( !tStd::tStrcmp(TextData, s) ); }
-	bool operator!=(const tString& s) const																				{ return( !!tStd::tStrcmp(TextData, s.TextData) ); }
+	bool operator!=(const tString& s) const																				{ return (Length() != s.Length()) || tStd::tStrcmp(TextData, s.TextData); }
 	bool operator!=(const char* s) const																				{ return( !!tStd::tStrcmp(TextData, s) ); }
 
-	bool IsEqual(const tString& s) const																				{ return( !tStd::tStrcmp(TextData, s.TextData) ); }
+	bool IsEqual(const tString& s) const																				{ return operator==(s); }
 	bool IsEqual(const char* s) const																					{ return( !tStd::tStrcmp(TextData, s) ); }
 	bool IsEqualCI(const tString& s) const																				{ return( !tStd::tStricmp(TextData, s.TextData) ); }
 	bool IsEqualCI(const char* s) const																					{ return( !tStd::tStricmp(TextData, s) ); }
 
 	operator const char*()																								{ return TextData; }
 	operator const char*() const																						{ return TextData; }
-	char& operator[](int i)																								{ return TextData[i]; }
+	char& operator[](int i)																								{ StringLength = -1; return TextData[i]; }
+	char operator[](int i) const																						{ return TextData[i]; }
 	friend tString operator+(const tString& prefix, const tString& suffix);
 	tString& operator+=(const tString&);
 
 	void Set(const char*);
-	int Length() const																									{ return int(tStd::tStrlen(TextData)); }
-	bool IsEmpty() const																								{ return (TextData == &EmptyChar) || !tStd::tStrlen(TextData); }
-	void Clear()																										{ if (TextData != &EmptyChar) delete[] TextData; TextData = &EmptyChar; }
+	int Length() const																									{ if (StringLength < 0) StringLength = int(tStd::tStrlen(TextData)); return StringLength; }
+	bool IsEmpty() const																								{ return TextData[0] == '\0'; }
+	void Clear();
 
 	bool IsAlphabetic(bool includeUnderscore = true) const;
 	bool IsNumeric(bool includeDecimal = false) const;
@@ -84,7 +90,9 @@ struct tString
 	// divider isn't found, the entire string is returned and the tString is left empty.
 	tString ExtractLastWord(const char divider = ' ');
 
-	char* Text()																										{ return TextData; }
+	// Text gives write access to the string data. Since the contents may change, the length is recomputed the next time
+	// it is needed. Don't hold on to the returned pointer and write through it after calling other members.
+	char* Text()																										{ StringLength = -1; return TextData; }
 	const char* ConstText() const																						{ return TextData; }
 
 	// Returns POD representation (Plain Old Data). For use with tPrintf and %s.
@@ -166,8 +174,21 @@ struct tString
 	float AsFloat() const																								{ return GetAsFloat(); }
 
 protected:
-	char* TextData;
-	static char EmptyChar;										// All empty strings can use this.
+	// Strings up to SmallCapacity characters long are stored in SmallData. Keeps sizeof(tString) at 48 bytes.
+	const static int SmallCapacity = 23;
+
+	// Makes room for length characters plus the terminating null. The current contents are preserved if keepContents
+	// is true. Never shrinks.
+	void Grow(int length, bool keepContents);
+
+	// Sets the string to the first length characters of text. Text need not be null-terminated and may overlap.
+	void Assign(const char* text, int length);
+	bool IsLocal() const																								{ return TextData == SmallData; }
+
+	char* TextData = SmallData;									// Points to SmallData or to heap memory.
+	mutable int StringLength = 0;								// Negative if the text may have been modified via Text().
+	int Capacity = SmallCapacity;								// Max chars TextData can hold, not including the null.
+	char SmallData[SmallCapacity + 1];
 };
 
 
@@ -206,63 +227,101 @@ namespace tStd
 
 inline tString::tString(const char* t)
 {
-	if (t)
-	{
-		int len = int(tStd::tStrlen(t));
-		if (len > 0)
-		{
-			TextData = new char[1 + len];
-			tStd::tStrcpy(TextData, t);
-			return;
-		}
-	}
-
-	TextData = &EmptyChar;
+	Assign(t, t ? int(tStd::tStrlen(t)) : 0);
 }
 
 
 inline tString::tString(const tString& s)
 {
-	TextData = new char[1 + tStd::tStrlen(s.TextData)];
-	tStd::tStrcpy(TextData, s.TextData);
+	Assign(s.TextData, s.Length());
+}
+
+
+inline tString::tString(tString&& s)
+{
+	*this = static_cast<tString&&>(s);
 }
 
 
 inline tString::tString(char c)
 {
-	TextData = new char[2];
-	TextData[0] = c;
-	TextData[1] = '\0';
+	StringLength = c ? 1 : 0;
+	SmallData[0] = c;
+	SmallData[1] = '\0';
 }
 
 
 inline tString::tString(int length)
 {
-	if (!length)
+	Reserve(length);
+}
+
+
+inline void tString::Grow(int length, bool keepContents)
+{
+	if (length <= Capacity)
+		return;
+
+	char* newText = new char[length + 1];
+	if (keepContents)
+		tStd::tMemcpy(newText, TextData, Length() + 1);
+	else
+		newText[0] = '\0';
+
+	if (!IsLocal())
+		delete[] TextData;
+
+	TextData = newText;
+	Capacity = length;
+}
+
+
+inline void tString::Assign(const char* text, int length)
+{
+	if (length > Capacity)
 	{
-		TextData = &EmptyChar;
+		// The text may be part of this string so we can't free the old memory until the copy is done.
+		char* newText = new char[length + 1];
+		tStd::tMemcpy(newText, text, length);
+		if (!IsLocal())
+			delete[] TextData;
+		TextData = newText;
+		Capacity = length;
 	}
-	else
+	else if (length > 0)
 	{
-		TextData = new char[1+length];
-		tStd::tMemset(TextData, 0, 1+length);
+		tStd::tMemmove(TextData, text, length);
 	}
+
+	TextData[length] = '\0';
+	StringLength = length;
 }
 
 
-inline void tString::Reserve(int length)
+inline void tString::Clear()
 {
-	if (TextData != &EmptyChar)
+	if (!IsLocal())
 		delete[] TextData;
 
+	TextData = SmallData;
+	Capacity = SmallCapacity;
+	SmallData[0] = '\0';
+	StringLength = 0;
+}
+
+
+inline void tString::Reserve(int length)
+{
 	if (length <= 0)
 	{
-		TextData = &EmptyChar;
+		Clear();
 		return;
 	}
 
-	TextData = new char[length+1];
+	// The current contents are lost so we don't need to copy them over if the memory is reallocated.
+	Grow(length, false);
 	tStd::tMemset(TextData, 0, length+1);
+	StringLength = 0;
 }
 
 
@@ -279,65 +338,83 @@ inline int tString::CountChar(char c) const
 
 inline void tString::Set(const char* s)
 {
-	Clear();
-	if (!s)
-		return;
+	Assign(s, s ? int(tStd::tStrlen(s)) : 0);
+}
 
-	int len = tStd::tStrlen(s);
-	if (len <= 0)
-		return;
 
-	TextData = new char[1 + len];
-	tStd::tStrcpy(TextData, s);
+inline tString& tString::operator=(const tString& src)
+{
+	if (this == &src)
+		return *this;
+
+	Assign(src.TextData, src.Length());
+	return *this;
 }
 
 
-inline tString& tString::operator=(const tString& src)
+inline tString& tString::operator=(tString&& src)
 {
 	if (this == &src)
 		return *this;
 
-	if (TextData != &EmptyChar)
+	// Short strings are copied. Long ones have their memory taken and the source is left empty.
+	if (src.IsLocal())
+	{
+		Assign(src.TextData, src.Length());
+		return *this;
+	}
+
+	if (!IsLocal())
 		delete[] TextData;
 
-	TextData = new char[1 + src.Length()];
-	tStd::tStrcpy(TextData, src.TextData);
+	TextData = src.TextData;
+	StringLength = src.StringLength;
+	Capacity = src.Capacity;
+
+	src.TextData = src.SmallData;
+	src.StringLength = 0;
+	src.Capacity = SmallCapacity;
+	src.SmallData[0] = '\0';
 	return *this;
 }
 
 
 inline tString operator+(const tString& preStr, const tString& sufStr)
 {
-	tString buf( preStr.Length() + sufStr.Length() );
-	tStd::tStrcpy(buf.TextData, preStr.TextData);
-	tStd::tStrcpy(buf.TextData + preStr.Length(), sufStr.TextData);
-
+	int preLength = preStr.Length();
+	int sufLength = sufStr.Length();
+
+	tString buf;
+	buf.Grow(preLength + sufLength, false);
+	tStd::tMemcpy(buf.TextData, preStr.TextData, preLength);
+	tStd::tMemcpy(buf.TextData + preLength, sufStr.TextData, sufLength + 1);
+	buf.StringLength = preLength + sufLength;
 	return buf;
 }
 
 
 inline tString& tString::operator+=(const tString& sufStr)
 {
-	if (sufStr.IsEmpty())
+	int sufLength = sufStr.Length();
+	if (!sufLength)
 		return *this;
-	else
-	{
-		char* newTextData = new char[ Length() + sufStr.Length() + 1 ];
-		tStd::tStrcpy(newTextData, TextData);
-		tStd::tStrcpy(newTextData + Length(), sufStr.TextData);
 
-		if (TextData != &EmptyChar)
-			delete[] TextData;
+	// Growing geometrically keeps repeated appends linear. If sufStr is this string, Grow updates its TextData too.
+	int length = Length();
+	int newLength = length + sufLength;
+	if (newLength > Capacity)
+		Grow((newLength > 2*Capacity) ? newLength : 2*Capacity, true);
 
-		TextData = newTextData;
-		return *this;
-	}
+	tStd::tMemcpy(TextData + length, sufStr.TextData, sufLength);
+	TextData[newLength] = '\0';
+	StringLength = newLength;
+	return *this;
 }
 
 
 inline bool tString::IsAlphabetic(bool includeUnderscore) const 
 {
-	if (TextData == &EmptyChar)
+	if (IsEmpty())
 		return false;
 
 	const char* c = TextData;
@@ -354,7 +431,7 @@ inline bool tString::IsAlphabetic(bool includeUnderscore) const
 
 inline bool tString::IsNumeric(bool includeDecimal) const 
 {
-	if (TextData == &EmptyChar)
+	if (IsEmpty())
 		return false;
 
 	const char* c = TextData;
@@ -377,7 +454,7 @@ inline bool tString::IsAlphaNumeric(bool includeUnderscore, bool includeDecimal)
 
 inline int tString::FindAny(const char* chars) const
 {
-	if (TextData == &EmptyChar)
+	if (IsEmpty())
 		return -1;
 	
 	int i = 0;
@@ -446,12 +523,20 @@ inline int tString::FindString(const char* s, int start) const
 inline int tString::Replace(const char c, const char r)
 {
 	int numReplaced = 0;
-	for (int i = 0; i < Length(); i++)
+	int length = Length();
+	for (int i = 0; i < length; i++)
 	{
 		if (TextData[i] == c)
 		{
 			numReplaced++;
 			TextData[i] = r;
+
+			// Replacing with the null terminator truncates the string.
+			if (r == '\0')
+			{
+				StringLength = i;
+				break;
+			}
 		}
 	}
 
@@ -461,7 +546,7 @@ inline int tString::Replace(const char c, const char r)
 
 inline tString::~tString()
 {
-	if (TextData != &EmptyChar)
+	if (!IsLocal())
 		delete[] TextData;
 }
 
@@ -471,10 +556,6 @@ inline tStringItem& tStringItem::operator=(const tStringItem& src)
 	if (this == &src)
 		return *this;
 
-	if (TextData != &EmptyChar)
-		delete[] TextData;
-
-	TextData = new char[1 + src.Length()];
-	tStd::tStrcpy(TextData, src.TextData);
+	Assign(src.TextData, src.Length());
 	return *this;
 }
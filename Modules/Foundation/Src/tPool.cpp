@@ -105,6 +105,378 @@ void tMem::tFastPool::GrowPool()
 }
 
 
+namespace ThreadCachePool
+{
+	// The shared free list head is a slot pointer in the low 48 bits and a tag in the upper 16.
+	const uint64 PointerMask	= (uint64(1) << 48) - 1;
+	const uint64 TagMask		= ~PointerMask;
+	const uint64 TagUnit		= uint64(1) << 48;
+	const int MaxSlotsPerBatch	= 16*1024;
+
+	// Registering a thread cache with a pool, returning it, and destroying a pool all happen under this lock. They are
+	// rare so the lock is never contended in practice. A function static is used so it works before main.
+	std::mutex& GetRegistryMutex();
+}
+
+
+std::mutex& ThreadCachePool::GetRegistryMutex()
+{
+	static std::mutex registryMutex;
+	return registryMutex;
+}
+
+
+struct tMem::tThreadCachePool::ThreadCacheTable
+{
+	// Runs when the thread exits. Any slots still cached go back to their pools.
+	~ThreadCacheTable();
+
+	ThreadCache Caches[MaxPoolsPerThread];
+	ThreadCache* Last = nullptr;
+};
+
+
+thread_local tMem::tThreadCachePool::ThreadCacheTable tMem::tThreadCachePool::CacheTable;
+
+
+tMem::tThreadCachePool::ThreadCacheTable::~ThreadCacheTable()
+{
+	std::lock_guard<std::mutex> lock(ThreadCachePool::GetRegistryMutex());
+	for (int c = 0; c < MaxPoolsPerThread; c++)
+	{
+		tThreadCachePool* pool = Caches[c].Pool.load(std::memory_order_relaxed);
+		if (pool)
+			pool->ReturnCache(&Caches[c]);
+	}
+}
+
+
+tMem::tThreadCachePool::tThreadCachePool(int slotSize, int initialSlotsInBlock, int slotsPerExpansionBlock, bool threadSafe, int slotsPerBatch) :
+	Blocks(false),
+	NumBlocks(0),
+	GrowMutex(),
+	SlotSize(slotSize),
+	SlotsInitialBlock(initialSlotsInBlock),
+	SlotsPerExpansionBlock(slotsPerExpansionBlock),
+	SlotsPerBatch(slotsPerBatch),
+	FreeBatches(0),
+	Caches(false),
+	SharedCache(),
+	SharedCacheMutex(),
+	NumAllocatedRetired(0),
+	NumAllocatedAtShutdown(0)
+{
+	// A free batch needs two pointers in its first slot. Slots are kept a multiple of 8 so the pointers are aligned.
+	if (SlotSize < 16)
+		SlotSize = 16;
+	SlotSize = (SlotSize + 7) & ~7;
+
+	// Batch sizes are stored in 16 bits and a cache may give back up to twice the batch size at once.
+	if (SlotsPerBatch < 1)
+		SlotsPerBatch = 1;
+	if (SlotsPerBatch > ThreadCachePool::MaxSlotsPerBatch)
+		SlotsPerBatch = ThreadCachePool::MaxSlotsPerBatch;
+
+	int count = 0;
+	uint8* batch = AddBlock(SlotsInitialBlock, count);
+	if (batch)
+		PushBatch(batch, count);
+}
+
+
+tMem::tThreadCachePool::~tThreadCachePool()
+{
+	int numAllocated = 0;
+	{
+		// Threads still caching slots from this pool are detached. The slots are part of the blocks so there is nothing
+		// to give back.
+		std::lock_guard<std::mutex> lock(ThreadCachePool::GetRegistryMutex());
+		numAllocated = NumAllocatedRetired + SharedCache.NumAllocated;
+		while (ThreadCache* cache = Caches.Remove())
+		{
+			numAllocated += cache->NumAllocated;
+			cache->Head = nullptr;
+			cache->Count = 0;
+			cache->NumAllocated = 0;
+			cache->Pool.store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	// Statically allocated pools can't assume all allocations have been freed even if there are no leaks.
+	if (numAllocated == 0)
+		FreeBlocks();
+	else
+		NumAllocatedAtShutdown = numAllocated;
+}
+
+
+void* tMem::tThreadCachePool::Malloc(int numBytes)
+{
+	// Same as tFastPool. A pool that has yet to be constructed returns nullptr so the caller can fall back.
+	if (!Constructed)
+		return nullptr;
+
+	if (numBytes > SlotSize)
+		return nullptr;
+
+	ThreadCache* cache = GetThreadCache();
+	if (!cache)
+	{
+		std::lock_guard<std::mutex> lock(SharedCacheMutex);
+		return MallocFromCache(&SharedCache);
+	}
+
+	return MallocFromCache(cache);
+}
+
+
+void tMem::tThreadCachePool::Free(void* slot)
+{
+	// This isn't delete. Zero is not allowed.
+	tAssert(slot);
+
+	// The pool was destroyed with live allocations. The memory goes when the last one is freed.
+	if (!Constructed)
+	{
+		if (NumAllocatedAtShutdown.fetch_sub(1) == 1)
+			FreeBlocks();
+		return;
+	}
+
+	ThreadCache* cache = GetThreadCache();
+	if (!cache)
+	{
+		std::lock_guard<std::mutex> lock(SharedCacheMutex);
+		FreeToCache(&SharedCache, slot);
+		return;
+	}
+
+	FreeToCache(cache, slot);
+}
+
+
+void tMem::tThreadCachePool::ReleaseThreadCache()
+{
+	if (!Constructed)
+		return;
+
+	ThreadCacheTable& table = CacheTable;
+	std::lock_guard<std::mutex> lock(ThreadCachePool::GetRegistryMutex());
+	for (int c = 0; c < MaxPoolsPerThread; c++)
+		if (table.Caches[c].Pool.load(std::memory_order_relaxed) == this)
+			ReturnCache(&table.Caches[c]);
+}
+
+
+int tMem::tThreadCachePool::GetNumAllocations() const
+{
+	std::lock_guard<std::mutex> lock(ThreadCachePool::GetRegistryMutex());
+	int numAllocated = NumAllocatedRetired + SharedCache.NumAllocated;
+	for (const ThreadCache* cache = Caches.Head(); cache; cache = cache->Next())
+		numAllocated += cache->NumAllocated.load(std::memory_order_relaxed);
+
+	return numAllocated;
+}
+
+
+tMem::tThreadCachePool::ThreadCache* tMem::tThreadCachePool::GetThreadCache()
+{
+	ThreadCacheTable& table = CacheTable;
+	ThreadCache* cache = table.Last;
+	if (cache && (cache->Pool.load(std::memory_order_relaxed) == this))
+		return cache;
+
+	for (int c = 0; c < MaxPoolsPerThread; c++)
+	{
+		if (table.Caches[c].Pool.load(std::memory_order_relaxed) == this)
+		{
+			table.Last = &table.Caches[c];
+			return table.Last;
+		}
+	}
+
+	// This is the first time the thread has used this pool.
+	std::lock_guard<std::mutex> lock(ThreadCachePool::GetRegistryMutex());
+	for (int c = 0; c < MaxPoolsPerThread; c++)
+	{
+		cache = &table.Caches[c];
+		if (cache->Pool.load(std::memory_order_relaxed))
+			continue;
+
+		cache->Head = nullptr;
+		cache->Count = 0;
+		cache->NumAllocated = 0;
+		cache->Pool.store(this, std::memory_order_relaxed);
+		Caches.Append(cache);
+		table.Last = cache;
+		return cache;
+	}
+
+	return nullptr;
+}
+
+
+void* tMem::tThreadCachePool::MallocFromCache(ThreadCache* cache)
+{
+	uint8* slot = cache->Head;
+	if (!slot)
+	{
+		int count = 0;
+		slot = PopBatch(count);
+		if (!slot)
+			slot = GrowPool(count);
+		if (!slot)
+			return nullptr;
+
+		cache->Count = count;
+	}
+
+	cache->Head = SlotNext(slot);
+	cache->Count--;
+
+	// Only this thread writes the count so there is no need for an atomic add.
+	cache->NumAllocated.store(cache->NumAllocated.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	return slot;
+}
+
+
+void tMem::tThreadCachePool::FreeToCache(ThreadCache* cache, void* slot)
+{
+	SlotNext((uint8*)slot) = cache->Head;
+	cache->Head = (uint8*)slot;
+	cache->Count++;
+	cache->NumAllocated.store(cache->NumAllocated.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+
+	// Keep one batch and give the other back. Splitting at the batch size keeps a thread that allocates and frees
+	// around the boundary from going to the shared list every call.
+	if (cache->Count >= 2*SlotsPerBatch)
+	{
+		uint8* batch = cache->Head;
+		uint8* tail = batch;
+		for (int s = 1; s < SlotsPerBatch; s++)
+			tail = SlotNext(tail);
+
+		cache->Head = SlotNext(tail);
+		SlotNext(tail) = nullptr;
+		cache->Count -= SlotsPerBatch;
+		PushBatch(batch, SlotsPerBatch);
+	}
+}
+
+
+void tMem::tThreadCachePool::PushBatch(uint8* batch, int count)
+{
+	tAssert(batch && (count > 0) && (count < (1 << 16)));
+	uint64 head = FreeBatches.load(std::memory_order_relaxed);
+	uint64 newHead;
+	do
+	{
+		BatchLink(batch) = (head & ThreadCachePool::PointerMask) | (uint64(count) << 48);
+		newHead = uint64(batch) | ((head + ThreadCachePool::TagUnit) & ThreadCachePool::TagMask);
+	}
+	while (!FreeBatches.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+uint8* tMem::tThreadCachePool::PopBatch(int& count)
+{
+	uint64 head = FreeBatches.load(std::memory_order_acquire);
+	while (uint8* batch = (uint8*)(head & ThreadCachePool::PointerMask))
+	{
+		// Another thread may pop this batch and start using it before we read the link. The memory is never returned
+		// while the pool exists so the read is safe, and the tag guarantees the exchange fails if the head has changed.
+		uint64 link = BatchLink(batch);
+		uint64 newHead = (link & ThreadCachePool::PointerMask) | ((head + ThreadCachePool::TagUnit) & ThreadCachePool::TagMask);
+		if (FreeBatches.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+		{
+			count = int(link >> 48);
+			return batch;
+		}
+	}
+
+	return nullptr;
+}
+
+
+uint8* tMem::tThreadCachePool::GrowPool(int& count)
+{
+	std::lock_guard<std::mutex> lock(GrowMutex);
+
+	// Another thread may have grown the pool while we were waiting.
+	uint8* batch = PopBatch(count);
+	if (batch || (SlotsPerExpansionBlock <= 0))
+		return batch;
+
+	return AddBlock(SlotsPerExpansionBlock, count);
+}
+
+
+uint8* tMem::tThreadCachePool::AddBlock(int numSlots, int& count)
+{
+	if (numSlots <= 0)
+		return nullptr;
+
+	SlotBlock* block = (SlotBlock*)tMalloc(sizeof(SlotBlock));
+	block->NumSlots = numSlots;
+	block->Slots = (uint8*)tMalloc(SlotSize * numSlots, 16);
+	tAssert(((uint64(block->Slots) + uint64(SlotSize) * numSlots) & ThreadCachePool::TagMask) == 0);
+	Blocks.Append(block);
+	NumBlocks++;
+
+	// Link the slots into batches. The first batch is returned and the rest are pushed to the shared list.
+	uint8* first = nullptr;
+	for (int start = 0; start < numSlots; start += SlotsPerBatch)
+	{
+		int batchCount = ((numSlots - start) < SlotsPerBatch) ? (numSlots - start) : SlotsPerBatch;
+		uint8* batch = block->Slots + start*SlotSize;
+		for (int s = 0; s < batchCount; s++)
+		{
+			uint8* slot = batch + s*SlotSize;
+			SlotNext(slot) = (s < batchCount-1) ? slot + SlotSize : nullptr;
+		}
+
+		if (first)
+		{
+			PushBatch(batch, batchCount);
+		}
+		else
+		{
+			first = batch;
+			count = batchCount;
+		}
+	}
+
+	return first;
+}
+
+
+void tMem::tThreadCachePool::ReturnCache(ThreadCache* cache)
+{
+	// The registry lock must be held.
+	if (cache->Head)
+		PushBatch(cache->Head, cache->Count);
+
+	NumAllocatedRetired += cache->NumAllocated;
+	cache->Head = nullptr;
+	cache->Count = 0;
+	cache->NumAllocated = 0;
+	Caches.Remove(cache);
+	cache->Pool.store(nullptr, std::memory_order_relaxed);
+}
+
+
+void tMem::tThreadCachePool::FreeBlocks()
+{
+	while (SlotBlock* block = Blocks.Remove())
+	{
+		tFree(block->Slots);
+		tFree(block);
+	}
+	NumBlocks = 0;
+	FreeBatches = 0;
+}
+
+
 #ifdef MEMORY_ALLOCATOR_CHECK
 void tMem::tFastPool::SanityCheckSlotValid(void* slot)
 {
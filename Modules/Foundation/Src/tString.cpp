@@ -18,20 +18,14 @@
 #include "Foundation/tStandard.h"
 
 
-char tString::EmptyChar = '\0';
-
-
 tString tString::Prefix(const char c) const
 {
 	int pos = FindChar(c);
 	if (pos == -1)
 		return *this;
-	if (pos == 0)
-		return tString();
 
-	// Remember, this zeros the memory, so tStrncpy not dealing with the terminating null is ok.
-	tString buf(pos);
-	tStd::tStrncpy(buf.TextData, TextData, pos);
+	tString buf;
+	buf.Assign(TextData, pos);
 	return buf;
 }
 
@@ -42,25 +36,19 @@ tString tString::Suffix(const char c) const
 	if (pos == -1)
 		return *this;
 
-	int length = Length();
-	if (pos == (length-1))
-		return tString();
-
-	// Remember, this zeros the memory, so tStrncpy not dealing with the terminating null is ok.
-	tString buf(length - 1 - pos);
-	tStd::tStrncpy(buf.TextData, TextData + pos + 1, length - 1 - pos);
+	tString buf;
+	buf.Assign(TextData + pos + 1, Length() - 1 - pos);
 	return buf;
 }
 
 
 tString tString::Prefix(int i) const
 {
-	if (i > Length())
+	if ((i <= 0) || (i > Length()))
 		return tString();
 
-	// Remember, this zeros the memory, so tStrncpy not dealing with the terminating null is ok.
-	tString buf(i);
-	tStd::tStrncpy(buf.TextData, TextData, i);
+	tString buf;
+	buf.Assign(TextData, i);
 	return buf;
 }
 
@@ -68,12 +56,11 @@ tString tString::Prefix(int i) const
 tString tString::Suffix(int i) const
 {
 	int length = Length();
-	if (i > length)
+	if ((i >= length) || (i < 0))
 		return tString();
 
-	// Remember, this zeros the memory, so tStrncpy not dealing with the terminating null is ok.
-	tString buf( length - 1 - i );
-	tStd::tStrncpy(buf.TextData, TextData + i + 1, length - 1 - i );
+	tString buf;
+	buf.Assign(TextData + i + 1, length - 1 - i);
 	return buf;
 }
 
@@ -90,19 +77,13 @@ tString tString::ExtractPrefix(int i)
 	int newLength = length - i;
 	if (newLength == 0)
 	{
-		if (TextData != &EmptyChar)
-			delete[] TextData;
-		TextData = &EmptyChar;
+		Clear();
 		return prefix;
 	}
 
-	char* newText = new char[newLength+1];
-	strcpy(newText, TextData+i);
-
-	if (TextData != &EmptyChar)
-		delete[] TextData;
-	TextData = newText;
-
+	// Shuffle the remainder down in place. This includes the terminating null.
+	tStd::tMemmove(TextData, TextData + i, newLength + 1);
+	StringLength = newLength;
 	return prefix;
 }
 
@@ -119,21 +100,12 @@ tString tString::ExtractSuffix(int i)
 	int newLength = length - i;
 	if (newLength == 0)
 	{
-		// It couldn't have been empty before.
-		delete TextData;
-		TextData = &EmptyChar;
+		Clear();
 		return suffix;
 	}
 
-	char* newText = new char[newLength+1];
-	TextData[length - i] = '\0';
-
-	tStd::tStrcpy(newText, TextData);
-
-	if (TextData != &EmptyChar)
-		delete[] TextData;
-	TextData = newText;
-
+	TextData[newLength] = '\0';
+	StringLength = newLength;
 	return suffix;
 }
 
@@ -143,25 +115,18 @@ tString tString::ExtractFirstWord(const char divider)
 	int pos = FindChar(divider);
 	if (pos == -1)
 	{
-		tString buf(Text());
+		tString buf(*this);
 		Clear();
 		return buf;
 	}
 
-	// Remember, this constructor zeros the memory, so strncpy not dealing with the terminating null is ok.
-	tString buf(pos);
-	tStd::tStrncpy(buf.TextData, TextData, pos);
-
-	int length = Length();
-	char* newText = new char[length-pos];
-
-	// This will append the null.
-	tStd::tStrncpy(newText, TextData+pos+1, length-pos);
-
-	if (TextData != &EmptyChar)
-		delete[] TextData;
-	TextData = newText;
+	tString buf;
+	buf.Assign(TextData, pos);
 
+	// The remainder does not include the divider. This moves the null too.
+	int newLength = Length() - pos - 1;
+	tStd::tMemmove(TextData, TextData + pos + 1, newLength + 1);
+	StringLength = newLength;
 	return buf;
 }
 
@@ -171,25 +136,16 @@ tString tString::ExtractLastWord(const char divider)
 	int pos = FindChar(divider, true);
 	if (pos == -1)
 	{
-		tString buf(Text());
+		tString buf(*this);
 		Clear();
 		return buf;
 	}
 
-	int wordLength = Length() - pos - 1;
-
-	// Remember, this constructor zeros the memory, so strncpy not dealing with the terminating null is ok.
-	tString buf(wordLength);
-	tStd::tStrncpy(buf.TextData, TextData+pos+1, wordLength);
-
-	char* newText = new char[pos+1];
-	tStd::tStrncpy(newText, TextData, pos);
-	newText[pos] = '\0';
-
-	if (TextData != &EmptyChar)
-		delete[] TextData;
-	TextData = newText;
+	tString buf;
+	buf.Assign(TextData + pos + 1, Length() - pos - 1);
 
+	TextData[pos] = '\0';
+	StringLength = pos;
 	return buf;
 }
 
@@ -199,7 +155,7 @@ int tString::Replace(const char* s, const char* r)
 	if (!s || (s[0] == '\0'))
 		return 0;
 
-	int origTextLength = tStd::tStrlen(TextData);
+	int origTextLength = Length();
 	int searchStringLength = tStd::tStrlen(s);
 	int replaceStringLength = r ? tStd::tStrlen(r) : 0;
 	int replaceCount = 0;
@@ -220,23 +176,21 @@ int tString::Replace(const char* s, const char* r)
 			searchStart = foundString + searchStringLength;
 		}
 
+		if (!replaceCount)
+			return 0;
+
 		// The new length may be bigger or smaller than the original. If the newlength is precisely
 		// 0, it means that the entire string is being replaced with nothing, so we can exit early.
 		// Ex. Replace "abcd" in "abcdabcd" with ""
 		int newTextLength = origTextLength + replaceCount*(replaceStringLength - searchStringLength);
 		if (!newTextLength)
 		{
-			if (TextData != &EmptyChar)
-				delete[] TextData;
-			TextData = &EmptyChar;
+			Clear();
 			return replaceCount;
 		}
 
-		char* newText = new char[newTextLength + 16];
-		newText[newTextLength] = '\0';
-
-		tStd::tMemset( newText, 0, newTextLength + 16 );
-
+		tString newText;
+		newText.Grow(newTextLength, false);
 		int newTextWritePos = 0;
 
 		searchStart = TextData;
@@ -246,24 +200,27 @@ int tString::Replace(const char* s, const char* r)
 
 			if (foundString)
 			{
-				tStd::tMemcpy(newText+newTextWritePos, searchStart, int(foundString-searchStart));
+				tStd::tMemcpy(newText.TextData+newTextWritePos, searchStart, int(foundString-searchStart));
 				newTextWritePos += int(foundString-searchStart);
 
-				tStd::tMemcpy(newText+newTextWritePos, r, replaceStringLength);
+				tStd::tMemcpy(newText.TextData+newTextWritePos, r, replaceStringLength);
 				newTextWritePos += replaceStringLength;
 			}
 			else
 			{
-				tStd::tStrcpy(newText+newTextWritePos, searchStart);
+				int remaining = int(TextData + origTextLength - searchStart);
+				tStd::tMemcpy(newText.TextData+newTextWritePos, searchStart, remaining);
+				newTextWritePos += remaining;
 				break;
 			}
 
 			searchStart = foundString + searchStringLength;
 		}
 
-		if (TextData != &EmptyChar)
-			delete[] TextData;
-		TextData = newText;
+		tAssert(newTextWritePos == newTextLength);
+		newText.TextData[newTextLength] = '\0';
+		newText.StringLength = newTextLength;
+		*this = static_cast<tString&&>(newText);
 	}
 	else
 	{
@@ -298,7 +255,8 @@ int tString::Remove(const char c)
 	int numRemoved = 0;
 
 	// This operation can be done in place.
-	for (int i = 0; i < Length(); i++)
+	int length = Length();
+	for (int i = 0; i < length; i++)
 	{
 		if (TextData[i] != c)
 		{
@@ -311,6 +269,7 @@ int tString::Remove(const char c)
 		}
 	}
 	TextData[destIndex] = '\0';
+	StringLength = destIndex;
 
 	return numRemoved;
 }
@@ -318,7 +277,7 @@ int tString::Remove(const char c)
 
 int tString::RemoveLeading(const char* removeThese)
 {
-	if (!TextData || (TextData == &EmptyChar) || !removeThese)
+	if (IsEmpty() || !removeThese)
 		return 0;
 
 	int cnt = 0;
@@ -340,10 +299,9 @@ int tString::RemoveLeading(const char* removeThese)
 
 	if (cnt > 0)
 	{
-		int oldlen = Length();
-		char* newtext = new char[oldlen-cnt+1];
-		tStd::tStrcpy(newtext, &TextData[cnt]);
-		TextData = newtext;
+		int newLength = Length() - cnt;
+		tStd::tMemmove(TextData, TextData + cnt, newLength + 1);
+		StringLength = newLength;
 	}
 
 	return cnt;
@@ -352,7 +310,7 @@ int tString::RemoveLeading(const char* removeThese)
 
 int tString::RemoveTrailing(const char* removeThese)
 {
-	if (!TextData || (TextData == &EmptyChar) || !removeThese)
+	if (IsEmpty() || !removeThese)
 		return 0;
 
 	int oldlen = Length();
@@ -375,6 +333,7 @@ int tString::RemoveTrailing(const char* removeThese)
 	}
 	int numRemoved = oldlen - i;
 	TextData[i+1] = '\0';
+	StringLength = i+1;
 
 	return numRemoved;
 }
@@ -382,17 +341,24 @@ int tString::RemoveTrailing(const char* removeThese)
 
 int tStd::tExplode(tList<tStringItem>& components, const tString& src, char divider)
 {
-	tString source = src;
+	// A single forward pass. Each component is copied once.
 	int startCount = components.GetNumItems();
-	while (source.FindChar(divider) != -1)
+	const char* start = src.Chars();
+	const char* found = divider ? tStd::tStrchr(start, divider) : nullptr;
+	while (found)
 	{
-		tString component = source.ExtractFirstWord(divider);
-		components.Append(new tStringItem(component));
+		// The int constructor zeros the memory so the component is null-terminated.
+		int length = int(found - start);
+		tStringItem* component = new tStringItem(length);
+		tStd::tMemcpy(component->Text(), start, length);
+		components.Append(component);
+		start = found + 1;
+		found = tStd::tStrchr(start, divider);
 	}
 
 	// If there's anything left in source we need to add it.
-	if (!source.IsEmpty())
-		components.Append(new tStringItem(source));
+	if (*start)
+		components.Append(new tStringItem(start));
 
 	return components.GetNumItems() - startCount;
 }
@@ -0,0 +1,51 @@
+// tBlockDecoder.h
+//
+// Decodes block-compressed (BC) pixel data into 32-bit tPixels. All of the BC formats are supported. The BC1 to BC5
+// palette construction and index lookup have SSE2 and AVX2 paths with a scalar fallback, and the instruction set is
+// chosen at runtime. BC6H is decoded natively for all 14 modes. BC7 uses the bc7decomp unpacker. Large layers are
+// decoded one row of blocks per job on the shared job system.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <Foundation/tStandard.h>
+#include <Math/tColour.h>
+#include "Image/tPixelFormat.h"
+namespace tImage
+{
+
+
+enum class tBlockDecodePath
+{
+	Auto,			// Uses the fastest path the CPU supports.
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+
+// Returns true if the supplied path can run on this machine. Auto and Scalar are always supported.
+bool tIsBlockDecodePathSupported(tBlockDecodePath);
+
+// Decodes width by height pixels of block data in the supplied format into dest, which must have room for width*height
+// pixels. The block rows are decoded in memory order, so the first block row fills dest rows 0 to 3. Partial blocks on
+// the right and top edges are clipped. BC4 decodes to (R, 0, 0, 255) and BC5 to (R, G, 0, 255) to match the graphics
+// APIs. BC6H is treated as unsigned and the half-float values are clamped to [0, 1]. If maxThreads is 1 the decode
+// is serial. If it is <= 0 the shared job system decides. Small images are always decoded serially. Returns false if
+// the pixel format is not a block format or the path is not supported.
+bool tDecodeBlocks
+(
+	tPixel* dest, const uint8* blocks, tPixelFormat, int width, int height,
+	tBlockDecodePath = tBlockDecodePath::Auto, int maxThreads = 0
+);
+
+
+}
@@ -56,6 +56,15 @@ public:
 	void Load(const tString& ddsFile, bool reverseRowOrder = true);
 	void Load(const uint8* ddsFileInMemory, int numBytes, bool reverseRowOrder = true);
 
+	// Reads just the header at the start of a dds file. Needs at least the first 128 bytes. Returns false if the
+	// header is malformed or describes a dds that Load would reject. This never throws. DXT1 files are always reported
+	// as BC1_DXT1 since binary alpha can only be detected by inspecting the blocks.
+	static bool GetHeaderInfo
+	(
+		const uint8* ddsHead, int numBytes, int& width, int& height,
+		int& numMipmapLevels, bool& isCubemap, tPixelFormat&
+	);
+
 	// After this call no memory will be consumed by the object and it will be invalid.
 	void Clear();
 
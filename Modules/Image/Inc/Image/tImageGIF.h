@@ -1,7 +1,8 @@
 // tImageGIF.h
 //
 // This knows how to load gifs. It knows the details of the gif file format and loads the data into multiple tPixel
-// arrays, one for each frame (gifs may be animated). These arrays may be 'stolen' by tPictures.
+// arrays, one for each frame (gifs may be animated). These arrays may be 'stolen' by tPictures. If you only need some
+// of the frames, or want to process them one at a time, a FrameStream decodes frames on demand instead.
 //
 // Copyright (c) 2020 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
@@ -30,7 +31,7 @@ public:
 
 	virtual ~tImageGIF()																								{ Clear(); }
 
-	// Clears the current tImageGIF before loading. If false returned object is invalid.
+	// Clears the current tImageGIF before loading. Every frame is decoded. If false returned object is invalid.
 	bool Load(const tString& gifFile);
 
 	// After this call no memory will be consumed by the object and it will be invalid.
@@ -53,15 +54,63 @@ public:
 	Frame* GetFrame(int frameNum);
 	tPixelFormat SrcPixelFormat = tPixelFormat::Invalid;
 
-private:
-	static void FrameCallbackBridge(void* imgGifRaw, struct GIF_WHDR*);
-	void FrameCallback(struct GIF_WHDR*);
-
-	// Variables used during callback processing.
-	int FrmLast = 0;
-	tPixel* FrmPict = nullptr;
-	tPixel* FrmPrev = nullptr;
+	// A FrameStream decodes the frames of a gif one at a time. Opening it reads the file and finds where each frame's
+	// data is, but decodes nothing. Gif frames are drawn over the ones before them, so the stream keeps the composited
+	// canvas and the saved canvas that 'restore previous' frames go back to. Reading frames in order decodes each
+	// frame once. Reading any other frame starts again from the closest key frame before it. Key frames cover the whole
+	// canvas with no transparent pixels, so nothing earlier is decoded.
+	class FrameStream
+	{
+	public:
+		FrameStream()																									{ }
+		FrameStream(const tString& gifFile)																				{ Open(gifFile); }
+		virtual ~FrameStream()																							{ Close(); }
+
+		// Closes the current file before opening. If false returned the stream is invalid.
+		bool Open(const tString& gifFile);
+		void Close();
+		bool IsValid() const																							{ return (NumFrames >= 1); }
+
+		int GetWidth() const																							{ return Width; }
+		int GetHeight() const																							{ return Height; }
+		int GetNumFrames() const																						{ return NumFrames; }
+
+		// Determined without decoding any frames. False if any frame uses a transparent colour or doesn't cover the
+		// whole canvas, either of which leaves pixels with zero alpha.
+		bool IsOpaque() const																							{ return Opaque; }
+
+		// Decodes frame frameNum and returns it. You are the owner of the returned frame and must eventually delete
+		// it and its pixels. Returns nullptr if frameNum is out of range or the frame could not be decoded.
+		Frame* ReadFrame(int frameNum);
+
+		// Reads the frame after the last one read, starting with the first. Returns nullptr after the last frame.
+		Frame* ReadNextFrame()																							{ return ReadFrame(NextFrame); }
+
+	private:
+		bool IndexFrames();
+		void ResetCanvas();
+		static void FrameCallbackBridge(void* streamRaw, struct GIF_WHDR*);
+		void FrameCallback(struct GIF_WHDR*);
+
+		uint8* FileData = nullptr;
+		int FileSize = 0;
+		int Width = 0;
+		int Height = 0;
+		int NumFrames = 0;
+		bool Opaque = true;
+		int* FrameEnds = nullptr;						// Offset of the end of each frame's data in FileData.
+		bool* KeyFrames = nullptr;						// True for frames that don't depend on the canvas before them.
+		int NextFrame = 0;								// The frame the canvas is ready for.
+
+		// Variables used during callback processing. FrmPict is the canvas and FrmPrev the saved canvas.
+		int FrmLast = 0;
+		tPixel* FrmPict = nullptr;
+		tPixel* FrmPrev = nullptr;
+		bool KeepFrame = false;
+		Frame* DecodedFrame = nullptr;
+	};
 
+private:
 	int Width				= 0;
 	int Height				= 0;
 	tList<Frame> Frames;
@@ -71,10 +120,10 @@ private:
 // Implementation only below.
 
 
-inline void tImageGIF::FrameCallbackBridge(void* imgGifRaw, struct GIF_WHDR* whdr)
+inline void tImageGIF::FrameStream::FrameCallbackBridge(void* streamRaw, struct GIF_WHDR* whdr)
 {
-	tImageGIF* imgGif = (tImageGIF*)imgGifRaw;
-	imgGif->FrameCallback(whdr);
+	FrameStream* stream = (FrameStream*)streamRaw;
+	stream->FrameCallback(whdr);
 }
 
 
@@ -0,0 +1,80 @@
+// tImageInfo.h
+//
+// Probes an image file for its dimensions, pixel format, number of frames, number of mipmaps, and whether it has
+// alpha, without decoding any pixels. For most formats only the first few bytes of the file are read. This is much
+// faster than constructing a tPicture, tImageDDS, or tTexture when all you need is the metadata, for example when
+// indexing a large number of files.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <Foundation/tString.h>
+#include <System/tFile.h>
+#include <Image/tPixelFormat.h>
+namespace tImage
+{
+
+
+struct tImageInfo
+{
+	tImageInfo()																										{ Clear(); }
+	void Clear();
+	bool IsValid() const																								{ return (Width > 0) && (Height > 0) && (NumFrames > 0); }
+
+	tSystem::tFileType FileType;
+
+	// The size of the first frame or part. For a dds it is the size of the main (largest) mipmap.
+	int Width;
+	int Height;
+
+	// The number of frames in an animated gif or webp, the number of images in an ico, or the number of parts in an
+	// exr. This is the number of valid partNums you can pass to tPicture::Load. One for everything else.
+	int NumFrames;
+
+	// Only dds files may have more than one mipmap level. A cubemap dds has NumMipmaps levels for each of its 6 sides.
+	int NumMipmaps;
+	bool IsCubemap;
+
+	// The same pixel format as the SrcPixelFormat you would get by loading the file into a tPicture, or the pixel
+	// format of a tImageDDS. The exception is DXT1 which is always BC1_DXT1 as binary alpha can only be detected by
+	// inspecting every block.
+	tPixelFormat PixelFormat;
+
+	// True if loading the image may produce pixels that aren't fully opaque. This is based on the header only. An
+	// image with an alpha channel that happens to be all 255 still has alpha.
+	bool HasAlpha;
+};
+
+
+// Fills in the info from only the header of imageFile. The file type is determined by the extension. Supported types
+// are tga, jpg, png, dds, hdr, exr, gif, webp, and ico. Returns false and leaves the info invalid if the file doesn't
+// exist, is an unsupported type, or the header can't be parsed. An animated webp and all gif files need a pass over
+// the whole file to count the frames, but only block headers are read and no frames are decoded. Never throws.
+bool tGetImageInfo(tImageInfo&, const tString& imageFile);
+
+
+// Implementation below this line.
+
+
+inline void tImageInfo::Clear()
+{
+	FileType = tSystem::tFileType::Unknown;
+	Width = 0;
+	Height = 0;
+	NumFrames = 0;
+	NumMipmaps = 0;
+	IsCubemap = false;
+	PixelFormat = tPixelFormat::Invalid;
+	HasAlpha = false;
+}
+
+
+}
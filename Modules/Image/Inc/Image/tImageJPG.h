@@ -28,10 +28,14 @@ class tImageJPG
 public:
 	// Creates an invalid tImageJPG. You must call Load manually.
 	tImageJPG()																											{ }
-	tImageJPG(const tString& jpgFile)																					{ Load(jpgFile); }
+	tImageJPG(const tString& jpgFile, int minWidth = 0, int minHeight = 0, bool fastDecode = false)					{ Load(jpgFile, minWidth, minHeight, fastDecode); }
 
 	// The data is copied out of jpgFileInMemory. Go ahead and delete after if you want.
-	tImageJPG(const uint8* jpgFileInMemory, int numBytes)																{ Set(jpgFileInMemory, numBytes); }
+	tImageJPG
+	(
+		const uint8* jpgFileInMemory, int numBytes,
+		int minWidth = 0, int minHeight = 0, bool fastDecode = false
+	)																													{ Set(jpgFileInMemory, numBytes, minWidth, minHeight, fastDecode); }
 
 	// This one sets from a supplied pixel array. If steal is true it takes ownership of the pixels pointer. Otherwise
 	// it just copies the data out.
@@ -39,9 +43,15 @@ public:
 
 	virtual ~tImageJPG()																								{ Clear(); }
 
-	// Clears the current tImageJPG before loading. Returns success. If false returned, object is invalid.
-	bool Load(const tString& jpgFile);
-	bool Set(const uint8* jpgFileInMemory, int numBytes);
+	// Clears the current tImageJPG before loading. Returns success. If false returned, object is invalid. If minWidth
+	// or minHeight are > 0 the jpg is decoded straight to a reduced size, which skips most of the IDCT work and is much
+	// faster than decoding at full size and resampling afterwards. The smallest scale libjpeg-turbo supports (1/8, 1/4,
+	// 3/8, 1/2 ... 1) that is at least minWidth by minHeight is chosen, so the result is generally not exactly that size.
+	// A zero min in one dimension leaves that dimension unconstrained. Both zero decodes at full size. If the jpg is
+	// smaller than the min it is decoded at full size. fastDecode uses the faster but less accurate integer IDCT and
+	// chroma upsampling, which is fine for thumbnails.
+	bool Load(const tString& jpgFile, int minWidth = 0, int minHeight = 0, bool fastDecode = false);
+	bool Set(const uint8* jpgFileInMemory, int numBytes, int minWidth = 0, int minHeight = 0, bool fastDecode = false);
 
 	// This one sets from a supplied pixel array. If steal is true it takes ownership of the pixels pointer. Otherwise
 	// it just copies the data out.
@@ -59,6 +69,10 @@ public:
 	int GetWidth() const																								{ return Width; }
 	int GetHeight() const																								{ return Height; }
 
+	// The full size of the jpg. Same as the width and height unless a reduced size was decoded.
+	int GetSrcWidth() const																								{ return SrcWidth; }
+	int GetSrcHeight() const																							{ return SrcHeight; }
+
 	// IsOpaque always return true for a JPeg.
 	bool IsOpaque() const																								{ return true; }
 
@@ -71,6 +85,8 @@ public:
 private:
 	int Width = 0;
 	int Height = 0;
+	int SrcWidth = 0;
+	int SrcHeight = 0;
 	tPixel* Pixels = nullptr;
 };
 
@@ -82,6 +98,8 @@ inline void tImageJPG::Clear()
 {
 	Width = 0;
 	Height = 0;
+	SrcWidth = 0;
+	SrcHeight = 0;
 	delete[] Pixels;
 	Pixels = nullptr;
 	SrcPixelFormat = tPixelFormat::Invalid;
@@ -1,7 +1,8 @@
 // tImageWEBP.h
 //
 // This knows how to load WebPs. It knows the details of the webp file format and loads the data into multiple tPixel
-// arrays, one for each frame (WebPs may be animated). These arrays may be 'stolen' by tPictures.
+// arrays, one for each frame (WebPs may be animated). These arrays may be 'stolen' by tPictures. If you only need some
+// of the frames, or want to process them one at a time, a FrameStream decodes frames on demand instead.
 //
 // Copyright (c) 2020 Tristan Grimmer.
 // Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
@@ -17,6 +18,7 @@
 #include <Foundation/tString.h>
 #include <Math/tColour.h>
 #include <Image/tPixelFormat.h>
+struct WebPDemuxer;
 namespace tImage
 {
 
@@ -30,7 +32,7 @@ public:
 
 	virtual ~tImageWEBP()																								{ Clear(); }
 
-	// Clears the current tImageWEBP before loading. If false returned object is invalid.
+	// Clears the current tImageWEBP before loading. Every frame is decoded. If false returned object is invalid.
 	bool Load(const tString& webpFile);
 
 	// After this call no memory will be consumed by the object and it will be invalid.
@@ -53,6 +55,56 @@ public:
 	Frame* GetFrame(int frameNum);
 	tPixelFormat SrcPixelFormat = tPixelFormat::Invalid;
 
+	// A FrameStream decodes the frames of a WebP one at a time. Opening it reads the file and parses the frame headers,
+	// but decodes nothing. Animated WebP frames may be blended over the ones before them, so the stream keeps the
+	// composited canvas between reads. Reading frames in order decodes each frame once. Reading any other frame starts
+	// again from the closest key frame before it. Key frames replace the whole canvas, so nothing earlier is decoded.
+	class FrameStream
+	{
+	public:
+		FrameStream()																									{ }
+		FrameStream(const tString& webpFile)																			{ Open(webpFile); }
+		virtual ~FrameStream()																							{ Close(); }
+
+		// Closes the current file before opening. If false returned the stream is invalid.
+		bool Open(const tString& webpFile);
+		void Close();
+		bool IsValid() const																							{ return (NumFrames >= 1); }
+
+		int GetWidth() const																							{ return Width; }
+		int GetHeight() const																							{ return Height; }
+		int GetNumFrames() const																						{ return NumFrames; }
+
+		// Decodes frame frameNum and returns it. You are the owner of the returned frame and must eventually delete
+		// it and its pixels. Returns nullptr if frameNum is out of range or the frame could not be decoded.
+		Frame* ReadFrame(int frameNum);
+
+		// Reads the frame after the last one read, starting with the first. Returns nullptr after the last frame.
+		Frame* ReadNextFrame()																							{ return ReadFrame(NextFrame); }
+
+	private:
+		bool IndexKeyFrames();
+		bool DecodeFrame(int frameNum);
+
+		uint8* FileData = nullptr;
+		int FileSize = 0;
+		WebPDemuxer* Demux = nullptr;
+		int Width = 0;
+		int Height = 0;
+		int NumFrames = 0;
+		bool* KeyFrames = nullptr;						// True for frames that don't depend on the canvas before them.
+		int NextFrame = 0;								// The frame the canvas is ready for.
+
+		// The canvas is stored top row first like the decoder writes it. Disposed is the canvas after the last decoded
+		// frame was disposed of, which is what the next frame is drawn over.
+		tPixel* Canvas = nullptr;
+		tPixel* Disposed = nullptr;
+		int PrevX = 0, PrevY = 0, PrevW = 0, PrevH = 0;	// Rectangle of the last decoded frame.
+		bool PrevDisposeBackground = false;
+		int FrameDuration = 0;							// In ms.
+		bool FrameHasAlpha = false;
+	};
+
 private:
 	tList<Frame> Frames;
 };
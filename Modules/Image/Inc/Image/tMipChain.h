@@ -0,0 +1,84 @@
+// tMipChain.h
+//
+// A tMipChain holds every mipmap level of an image, from the full size image down to 1x1, in a single contiguous
+// allocation of tPixels. The levels are generated in one call. Each level is a 2:1 reduction of the one above it, with
+// the intermediate levels kept in floating point so rounding errors don't accumulate down the chain. Filtering may
+// optionally be done in linear light, which stops sRGB images from darkening as they get smaller. The inner loops have
+// SSE2 and AVX2 paths with a scalar fallback, and large levels are split across the shared job system.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <Foundation/tStandard.h>
+#include <Math/tColour.h>
+#include "Image/tResample.h"
+namespace tImage
+{
+
+
+enum class tMipFilter
+{
+	Box,							// Averages each 2x2 square. Fast, and exact when cascaded.
+	Kaiser							// Kaiser windowed sinc with 12 taps per axis. Sharper mipmaps that don't alias.
+};
+
+
+class tMipChain
+{
+public:
+	tMipChain()																											{ }
+
+	// Generates the chain from src, which is copied and not modified. See Set.
+	tMipChain
+	(
+		const tPixel* src, int width, int height, tMipFilter filter = tMipFilter::Box, bool gammaCorrect = false,
+		tResamplePath path = tResamplePath::Auto, int maxThreads = 0, int maxLevels = 0
+	)																													{ Set(src, width, height, filter, gammaCorrect, path, maxThreads, maxLevels); }
+
+	virtual ~tMipChain()																								{ Clear(); }
+
+	// Generates every level from src down to 1x1. Width and height are halved each level until they reach 1 and then
+	// stay there. An odd dimension drops its last row or column. If gammaCorrect is true the colour channels are
+	// treated as sRGB and filtered in linear light. Alpha is always linear and is not premultiplied. maxThreads works
+	// the same as in tResample. If maxLevels is > 0 the chain stops after that many levels. Returns false, leaving the
+	// chain invalid, if the dimensions are not positive or the path is not supported.
+	bool Set
+	(
+		const tPixel* src, int width, int height, tMipFilter = tMipFilter::Box, bool gammaCorrect = false,
+		tResamplePath = tResamplePath::Auto, int maxThreads = 0, int maxLevels = 0
+	);
+	void Clear()																										{ delete[] Pixels; Pixels = nullptr; NumLevels = 0; }
+	bool IsValid() const																								{ return Pixels ? true : false; }
+
+	int GetNumLevels() const																							{ return NumLevels; }
+	int GetWidth(int level) const																						{ tAssert(level < NumLevels); return Widths[level]; }
+	int GetHeight(int level) const																						{ tAssert(level < NumLevels); return Heights[level]; }
+	tPixel* GetLevel(int level) const																					{ tAssert(level < NumLevels); return Pixels + Offsets[level]; }
+
+	// All levels are stored one after the other, largest first, in a single array of this many pixels.
+	int64 GetTotalNumPixels() const																						{ return NumLevels ? Offsets[NumLevels-1] + int64(Widths[NumLevels-1])*Heights[NumLevels-1] : 0; }
+
+	// Returns 1 + log2(max(width, height)), the number of levels in a full chain.
+	static int ComputeNumLevels(int width, int height);
+
+	// Enough for any positive int dimensions.
+	const static int MaxLevels = 32;
+
+private:
+	int NumLevels = 0;
+	int Widths[MaxLevels];
+	int Heights[MaxLevels];
+	int64 Offsets[MaxLevels];
+	tPixel* Pixels = nullptr;
+};
+
+
+}
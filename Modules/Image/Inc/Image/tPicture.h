@@ -34,7 +34,9 @@
 #include "Image/tImageJPG.h"
 #include "Image/tImageTGA.h"
 #include "Image/tImageWEBP.h"
+#include "Image/tLayer.h"
 #include "Image/tPixelFormat.h"
+#include "Image/tResample.h"
 namespace tImage
 {
 
@@ -74,14 +76,25 @@ public:
 		float	EXR_Defog				= tImageEXR::DefaultDefog;
 		float	EXR_KneeLow				= tImageEXR::DefaultKneeLow;
 		float	EXR_KneeHigh			= tImageEXR::DefaultKneeHigh;
+
+		// JPGs may be decoded straight to a reduced size for thumbnails. See tImageJPG::Load.
+		int		JPG_MinWidth			= 0;
+		int		JPG_MinHeight			= 0;
+		bool	JPG_FastDecode			= false;
 	};
 
 	// Loads the supplied image file. If the image couldn't be loaded, IsValid will return false afterwards. Uses the
 	// filename extension to determine what file type it is loading. dds files may _not_ be loaded into a tPicture.
 	// Use a tTexture if you want to load a dds. For images with more than one part (animated gif, tiff, etc) the
-	// partNum specifies which one to load and will result in an invalid tPicture if you go too high.
+	// partNum specifies which one to load and will result in an invalid tPicture if you go too high. Animated gif and
+	// webp frames are decoded starting at the closest key frame before partNum, so only the frames partNum is drawn
+	// over are decoded. To go through all the frames of an animation, use a FrameStream from tImageGIF or tImageWEBP
+	// rather than loading a tPicture per frame, which may decode the same frames many times.
 	tPicture(const tString& imageFile, int partNum = 0, LoadParams params = LoadParams())								{ Load(imageFile, partNum, params); }
 
+	// Constructs a picture by decoding a block-compressed layer. See Set(const tLayer&).
+	tPicture(const tLayer& layer)																						{ Set(layer); }
+
 	// Copy constructor.
 	tPicture(const tPicture& src)																						: tPicture() { Set(src); }
 
@@ -103,6 +116,11 @@ public:
 	void Set(int width, int height, tPixel* pixelBuffer, bool copyPixels = true);
 	void Set(const tPicture& src);
 
+	// Decodes a layer in any of the BC pixel formats. The block rows are taken in memory order, so the first row of
+	// blocks becomes the bottom 4 rows of the picture, which is how tTexture lays them out. Returns false and leaves the
+	// picture invalid if the layer is invalid or not block-compressed.
+	bool Set(const tLayer&);
+
 	// Can this class save the the filetype supplied?
 	static bool CanSave(const tString& imageFile);
 	static bool CanSave(tSystem::tFileType);
@@ -185,15 +203,8 @@ public:
 	// error and return false. A 1x1 successfully yields the same 1x1 image.
 	bool ScaleHalf();
 
-	enum class tFilter
-	{
-		NearestNeighbour,				// Useless.
-		Box,							// Fast pixel averaging.
-		Bilinear,						// Also known as a triangle filter.  Fast and not too bad quality.
-		Bicubic,						// Your standard good PS filter.
-		Quadratic,
-		Hamming
-	};
+	// The filters are implemented by the native resampler. See tResample.h.
+	typedef tResampleFilter tFilter;
 
 	// Resizes the image using the specified filter. Returns success. If the resample fails the tPicture is unmodified.
 	bool Resample(int width, int height, tFilter filter = tFilter::Bilinear);
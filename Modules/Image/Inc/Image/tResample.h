@@ -0,0 +1,66 @@
+// tResample.h
+//
+// A separable image resampler for 32-bit tPixels. The filter weights for each destination column and row are computed
+// once up front. The image is filtered horizontally into a floating-point intermediate and then vertically back to
+// tPixels. The inner loops have SSE2 and AVX2 paths with a scalar fallback, and the instruction set is chosen at
+// runtime. Large images are resampled a band of rows per job on the shared job system.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <Foundation/tStandard.h>
+#include <Math/tColour.h>
+namespace tImage
+{
+
+
+enum class tResampleFilter
+{
+	NearestNeighbour,				// Useless.
+	Box,							// Fast pixel averaging.
+	Bilinear,						// Also known as a triangle filter.  Fast and not too bad quality.
+	Bicubic,						// Your standard good PS filter. Cubic with a = -0.5.
+	Quadratic,
+	Hamming,
+	Lanczos3,						// Windowed sinc with 3 lobes. Sharp, with a little ringing.
+	Kaiser							// Kaiser windowed sinc. Good for mipmaps as it rings less than Lanczos.
+};
+
+
+enum class tResamplePath
+{
+	Auto,			// Uses the fastest path the CPU supports.
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+
+// Returns true if the supplied path can run on this machine. Auto and Scalar are always supported.
+bool tIsResamplePathSupported(tResamplePath);
+
+// Evaluates the filter's kernel at x, in source pixels. The kernels are even and are zero outside their radius.
+// NearestNeighbour is treated like Box.
+float tEvaluateResampleFilter(tResampleFilter, float x);
+
+// Resamples src into dest, which must have room for destWidth*destHeight pixels and must not overlap src. When
+// minifying, the filters are widened by the scale factor so every source pixel contributes. Pixels past the edges are
+// not used. Instead the weights of the pixels that remain are renormalized. Alpha is filtered like any other channel.
+// If maxThreads is 1 the resample is serial. If it is <= 0 the shared job system decides. Small images are always
+// done serially. Returns false if any dimension is not positive or the path is not supported.
+bool tResample
+(
+	tPixel* dest, int destWidth, int destHeight, const tPixel* src, int srcWidth, int srcHeight,
+	tResampleFilter = tResampleFilter::Bilinear, tResamplePath = tResamplePath::Auto, int maxThreads = 0
+);
+
+
+}
@@ -23,11 +23,13 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #pragma once
+#include <atomic>
 #include <Foundation/tList.h>
 #include <Foundation/tString.h>
 #include <System/tChunk.h>
 #include "Image/tImageDDS.h"
 #include "Image/tPicture.h"
+#include "Image/tMipChain.h"
 namespace tImage
 {
 
@@ -63,16 +65,18 @@ public:
 	// For simplicity there is only Fast and Production quality settings, and it affects resampling _and_ compression.
 	enum class tQuality
 	{
-		Fast,		// Bilinear resample filter. Fast BCn compress mode.
-		Production	// Lanczos or Kaiser sinc-based resample filter. High quality BCn compression.
+		Fast,		// Bilinear resize and box mipmap filters. Fast BCn compress mode.
+		Production	// Lanczos3 resize and Kaiser mipmap filters. High quality BCn compression.
 	};
 
 	// This constructor creates a texture from an image file such as a jpg, gif, tga, or bmp. It does this by creating
 	// a temporary tPicture object. If tPixelFormat is Auto, the constructor automatically chooses the most appropriate
 	// format for the texture based on the image's properties. DXT1/BC1 is chosen if the image is perfectly opaque, and
-	// DXT5/BC3 if it has alphas. This constructor forces power-of-2 texture dimensions and will resample to the nearest
-	// power-of-2 if required. If forceWidth is > 0, the image will be resampled if necessary to have that width. The
-	// same logic applies to forceHeight. Both forceWidth and forceHeight, if supplied, must be powers of 2.
+	// DXT5/BC3 if it has alphas. All BC formats may be requested explicitly. BC4 encodes the red channel and BC5 the
+	// red and green channels. BC6H encodes the colour as unsigned half-floats in [0, 1]. This constructor forces
+	// power-of-2 texture dimensions and will resample to the nearest power-of-2 if required. If forceWidth is > 0, the
+	// image will be resampled if necessary to have that width. The same logic applies to forceHeight. Both forceWidth
+	// and forceHeight, if supplied, must be powers of 2.
 	tTexture
 	(
 		const tString& imageFile, bool generateMipMaps, tPixelFormat pixelFormat = tPixelFormat::Auto,
@@ -113,7 +117,7 @@ public:
 		tQuality = tQuality::Production, int forceWidth = 0, int forceHeight = 0
 	);
 
-	void Clear()																										{ Layers.Clear(); Opaque = true; }
+	void Clear()																										{ Layers.Clear(); delete[] LayerData; LayerData = nullptr; Opaque = true; }
 
 	int GetWidth() const				/* Returns width of the main layer. */											{ return IsValid() ? Layers.First()->Width : 0; }
 	int GetHeight() const				/* Returns width of the main layer. */											{ return IsValid() ? Layers.First()->Height : 0; }
@@ -142,12 +146,57 @@ public:
 	bool operator==(const tTexture&) const;
 	bool operator!=(const tTexture& src) const																			{ return !(*this == src); }
 
+	// Mipmap generation and block compression are split across rows and run on the shared job system. This sets the
+	// maximum number of threads that may work at the same time, for all tTextures. 0 (the default) means use every
+	// core, and 1 means work serially on the calling thread. The output is identical for every setting.
+	static void SetMaxCompressionThreads(int maxThreads)																{ MaxCompressionThreads = tMath::tMax(maxThreads, 0); }
+	static int GetMaxCompressionThreads()																				{ return MaxCompressionThreads; }
+
+	// When true, generated mipmaps are filtered in linear light with the colour channels treated as sRGB. This keeps
+	// the smaller levels from getting darker. Leave it false for textures that don't hold colours, like normal maps.
+	// Applies to all tTextures.
+	static void SetGammaCorrectMipmaps(bool gammaCorrect)																{ GammaCorrectMipmaps = gammaCorrect; }
+	static bool GetGammaCorrectMipmaps()																				{ return GammaCorrectMipmaps; }
+
+	// Block compression settings. Each tQuality has its own set. The Fast defaults favour speed and the Production
+	// defaults favour quality. Call SetBCParams before creating textures to trade one off against the other. The
+	// settings apply to all tTextures.
+	struct tBCParams
+	{
+		int RGBCXLevel;						// BC1, BC2, and BC3 encoder level in [0, 18]. Higher is slower but better.
+		int BC7UberLevel;					// BC7 effort in [0, 4]. Higher is slower but better.
+		int BC7MaxPartitions;				// Number of BC7 mode 1 partitions to try in [0, 64]. 0 disables mode 1.
+		bool BC7Perceptual;					// Measure BC7 error in YCbCr instead of RGB.
+		int BC6HRefineIterations;			// Least-squares endpoint refinement passes for BC6H. 0 is fastest.
+	};
+	static void SetBCParams(tQuality quality, const tBCParams& params)													{ BCParams[int(quality)] = params; }
+	static const tBCParams& GetBCParams(tQuality quality)																{ return BCParams[int(quality)]; }
+
 private:
 	tPixelFormat DeterminePixelFormat(const tPicture&);
-	tPicture::tFilter DetermineFilter(tQuality);
-	void ProcessImageTo_R8G8B8_Or_R8G8B8A8(tPicture&, tPixelFormat, bool generateMipmaps, tQuality);
-	void ProcessImageTo_G3B5R5G3(tPicture&, bool generateMipmaps, tQuality);
-	void ProcessImageTo_BCTC(tPicture&, tPixelFormat, bool generateMipmaps, tQuality);
+	tMipFilter DetermineFilter(tQuality);
+	void ProcessImageTo_R8G8B8_Or_R8G8B8A8(const tMipChain&, tPixelFormat);
+	void ProcessImageTo_G3B5R5G3(const tMipChain&);
+	void ProcessImageTo_BCTC(const tMipChain&, tPixelFormat, tQuality);
+
+	// Appends a layer for every level of the chain. The layers reference consecutive slices of LayerData.
+	void CreateSharedLayers(const tMipChain&, tPixelFormat);
+
+	// A single mip level waiting to be block compressed. Output is the layer's data.
+	struct BCLevel : public tLink<BCLevel>
+	{
+		const tPixel* Source;
+		int Width;
+		int Height;
+		int NumBlocksX;
+		int NumBlocksY;
+		int FirstBlockRow;									// Index of this level's first row in the combined list of rows.
+		uint8* Output;
+	};
+	static void CompressBlockRow(tPixelFormat, const tBCParams&, const BCLevel&, int blockY);
+
+	// Marks every texel with alpha < 128 as transparent in an already encoded BC1 block.
+	static void SetBC1BinaryAlpha(uint8* block, const tPixel* pixels);
 
 	bool Opaque = true;										// Only true if the texture is completely opaque.
 
@@ -155,7 +204,14 @@ private:
 	// number of layers is > 1.
 	tList<tLayer> Layers;
 
+	// Layers generated from a tPicture don't own their data. It all lives in this single allocation. Layers that came
+	// from a dds file or a chunk own their own data and this is null.
+	uint8* LayerData = nullptr;
+
 	static bool BC7EncInitialized;
+	static std::atomic<int> MaxCompressionThreads;
+	static bool GammaCorrectMipmaps;
+	static tBCParams BCParams[2];
 };
 
 
@@ -181,17 +237,17 @@ inline tPixelFormat tTexture::DeterminePixelFormat(const tPicture& image)
 }
 
 
-inline tPicture::tFilter tTexture::DetermineFilter(tQuality quality)
+inline tMipFilter tTexture::DetermineFilter(tQuality quality)
 {
 	switch (quality)
 	{
 		case tQuality::Fast:
-			return tPicture::tFilter::Bilinear;
+			return tMipFilter::Box;
 
 		case tQuality::Production:
-			return tPicture::tFilter::Bicubic;
+			return tMipFilter::Kaiser;
 	}
-	return tPicture::tFilter::Bilinear;
+	return tMipFilter::Box;
 }
 
 
@@ -208,8 +264,20 @@ inline void tTexture::RemoveMipmaps()
 
 inline void tTexture::StealLayers(tList<tLayer>& layers)
 {
+	// Shared layer data is freed by Clear, so those layers get their own copy.
 	while (!Layers.IsEmpty())
-		layers.Append(Layers.Remove());
+	{
+		tLayer* layer = Layers.Remove();
+		if (LayerData)
+		{
+			int dataSize = layer->GetDataSize();
+			uint8* data = new uint8[dataSize];
+			tStd::tMemcpy(data, layer->Data, dataSize);
+			layer->Data = data;
+			layer->OwnsData = true;
+		}
+		layers.Append(layer);
+	}
 
 	Clear();
 }
@@ -0,0 +1,874 @@
+// tBlockDecoder.cpp
+//
+// Decodes block-compressed (BC) pixel data into 32-bit tPixels. All of the BC formats are supported. The BC1 to BC5
+// palette construction and index lookup have SSE2 and AVX2 paths with a scalar fallback, and the instruction set is
+// chosen at runtime. BC6H is decoded natively for all 14 modes. BC7 uses the bc7decomp unpacker. Large layers are
+// decoded one row of blocks per job on the shared job system.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <System/tJobSystem.h>
+#include <System/tMachine.h>
+#include <Image/tBlockDecoder.h>
+#include <BC7Enc/bc7decomp.h>
+#include <half.h>
+
+// SSE2 is part of the x64 baseline so it needs no special compiler flags. The AVX2 functions are compiled for AVX2 on
+// a per-function basis and are only called if the CPU supports them.
+#if defined(ARCHITECTURE_X64)
+#define BLOCK_DECODE_SIMD
+#include <immintrin.h>
+#if defined(PLATFORM_WINDOWS)
+#define BLOCK_DECODE_AVX2
+#else
+#define BLOCK_DECODE_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+namespace BlockDecode
+{
+	// Every block decoder writes 16 texels, row by row, as RGBA uint32s with red in the low byte. That is the same
+	// layout as a tPixel in memory.
+	typedef void BlockFunction(uint32* texels, const uint8* block);
+
+	// Below this many blocks the cost of waking the workers outweighs the gain.
+	const int MinParallelBlocks = 4096;
+
+	inline uint32 Pack(int r, int g, int b, int a)																		{ return uint32(r) | (uint32(g) << 8) | (uint32(b) << 16) | (uint32(a) << 24); }
+	inline uint32 LoadColourSelectors(const uint8* block)																{ return uint32(block[4]) | (uint32(block[5]) << 8) | (uint32(block[6]) << 16) | (uint32(block[7]) << 24); }
+	uint64 LoadAlphaSelectors(const uint8* block);
+	uint64 LoadExplicitAlpha(const uint8* block);
+	void GetEndpoints(const uint8* colourBlock, int& c0, int& c1, int e0[3], int e1[3]);
+
+	// The colour palettes use the ideal (exact thirds, truncated) interpolation, as does rgbcx. If the endpoints are
+	// ordered for three-colour mode and it is allowed, colour 2 is the average and colour 3 is transparent black. BC2
+	// and BC3 always use four-colour mode.
+	void ColourPaletteScalar(uint32 palette[4], const uint8* colourBlock, bool allowThreeColour);
+	void AlphaPaletteScalar(uint8 palette[8], int a0, int a1);
+	void ColourLookup(uint32* texels, const uint32 palette[4], const uint8* colourBlock);
+
+	void DecodeBC1Scalar(uint32* texels, const uint8* block);
+	void DecodeBC1BAScalar(uint32* texels, const uint8* block);
+	void DecodeBC2Scalar(uint32* texels, const uint8* block);
+	void DecodeBC3Scalar(uint32* texels, const uint8* block);
+	void DecodeBC4Scalar(uint32* texels, const uint8* block);
+	void DecodeBC5Scalar(uint32* texels, const uint8* block);
+	void DecodeBC6H(uint32* texels, const uint8* block);
+	void DecodeBC7(uint32* texels, const uint8* block);
+
+	#ifdef BLOCK_DECODE_SIMD
+	// The SSE2 path builds the palettes in vector registers. SSE2 has no variable shuffle so the index lookups are
+	// scalar. Divisions by 2, 3, 5, and 7 are done with a 16-bit reciprocal multiply that is exact for the range of
+	// sums involved, so every path produces identical output.
+	__m128i ColourPalette16SSE2(const uint8* colourBlock, bool allowThreeColour);
+	void ColourPaletteSSE2(uint32 palette[4], const uint8* colourBlock, bool allowThreeColour);
+	void AlphaWeightsSSE2(bool eightValue, __m128i& w0, __m128i& w1, __m128i& recip, __m128i& top);
+	__m128i AlphaPalette16SSE2(int a0, int a1);
+	void AlphaPaletteSSE2(uint8 palette[8], int a0, int a1);
+
+	void DecodeBC1SSE2(uint32* texels, const uint8* block);
+	void DecodeBC1BASSE2(uint32* texels, const uint8* block);
+	void DecodeBC2SSE2(uint32* texels, const uint8* block);
+	void DecodeBC3SSE2(uint32* texels, const uint8* block);
+	void DecodeBC4SSE2(uint32* texels, const uint8* block);
+	void DecodeBC5SSE2(uint32* texels, const uint8* block);
+
+	// The AVX2 path keeps the palettes in a register and uses a variable permute to look up 8 texels at a time.
+	BLOCK_DECODE_AVX2 __m256i ColourPaletteAVX2(const uint8* colourBlock, bool allowThreeColour);
+	BLOCK_DECODE_AVX2 void ColourLookupAVX2(__m256i texels[2], __m256i palette, uint32 selectors);
+	BLOCK_DECODE_AVX2 void AlphaLookupAVX2(__m256i texels[2], __m256i palette, uint64 selectors);
+	BLOCK_DECODE_AVX2 void DecodeBC1AVX2(uint32* texels, const uint8* block);
+	BLOCK_DECODE_AVX2 void DecodeBC1BAAVX2(uint32* texels, const uint8* block);
+	BLOCK_DECODE_AVX2 void DecodeBC2AVX2(uint32* texels, const uint8* block);
+	BLOCK_DECODE_AVX2 void DecodeBC3AVX2(uint32* texels, const uint8* block);
+	BLOCK_DECODE_AVX2 void DecodeBC4AVX2(uint32* texels, const uint8* block);
+	BLOCK_DECODE_AVX2 void DecodeBC5AVX2(uint32* texels, const uint8* block);
+	#endif
+
+	BlockFunction* GetBlockFunction(tImage::tPixelFormat, tImage::tBlockDecodePath);
+	void DecodeBlockRow(tPixel* dest, const uint8* blocks, int blockSize, int width, int height, int blockY, BlockFunction*);
+}
+
+
+namespace BC6HDecode
+{
+	// The fields a BC6H header can contain. W, X, Y, and Z are the 4 endpoints (2 per region) and D is the partition.
+	enum Field : uint8 { RW, RX, RY, RZ, GW, GX, GY, GZ, BW, BX, BY, BZ, D };
+
+	// A run of header bits. Shift is the position of the lowest bit in the field. A negative count means the bits are
+	// stored most-significant first.
+	struct Bits { uint8 Field; uint8 Shift; int8 Count; };
+
+	struct Mode
+	{
+		bool Transformed;						// The X, Y, and Z endpoints are signed deltas from W.
+		int EndpointBits;
+		int DeltaBits[3];
+		Bits Header[25];						// Terminated by a zero count.
+	};
+
+	// Modes 1 to 10 have 2 regions and modes 11 to 14 have one. The field layout is from the D3D11 specification.
+	const Mode Modes[14] =
+	{
+		{ true, 10, { 5, 5, 5 }, { {GY,4,1},{BY,4,1},{BZ,4,1},{RW,0,10},{GW,0,10},{BW,0,10},{RX,0,5},{GZ,4,1},{GY,0,4},{GX,0,5},{BZ,0,1},{GZ,0,4},{BX,0,5},{BZ,1,1},{BY,0,4},{RY,0,5},{BZ,2,1},{RZ,0,5},{BZ,3,1},{D,0,5} } },
+		{ true, 7, { 6, 6, 6 }, { {GY,5,1},{GZ,4,1},{GZ,5,1},{RW,0,7},{BZ,0,1},{BZ,1,1},{BY,4,1},{GW,0,7},{BY,5,1},{BZ,2,1},{GY,4,1},{BW,0,7},{BZ,3,1},{BZ,5,1},{BZ,4,1},{RX,0,6},{GY,0,4},{GX,0,6},{GZ,0,4},{BX,0,6},{BY,0,4},{RY,0,6},{RZ,0,6},{D,0,5} } },
+		{ true, 11, { 5, 4, 4 }, { {RW,0,10},{GW,0,10},{BW,0,10},{RX,0,5},{RW,10,1},{GY,0,4},{GX,0,4},{GW,10,1},{BZ,0,1},{GZ,0,4},{BX,0,4},{BW,10,1},{BZ,1,1},{BY,0,4},{RY,0,5},{BZ,2,1},{RZ,0,5},{BZ,3,1},{D,0,5} } },
+		{ true, 11, { 4, 5, 4 }, { {RW,0,10},{GW,0,10},{BW,0,10},{RX,0,4},{RW,10,1},{GZ,4,1},{GY,0,4},{GX,0,5},{GW,10,1},{GZ,0,4},{BX,0,4},{BW,10,1},{BZ,1,1},{BY,0,4},{RY,0,4},{BZ,0,1},{BZ,2,1},{RZ,0,4},{GY,4,1},{BZ,3,1},{D,0,5} } },
+		{ true, 11, { 4, 4, 5 }, { {RW,0,10},{GW,0,10},{BW,0,10},{RX,0,4},{RW,10,1},{BY,4,1},{GY,0,4},{GX,0,4},{GW,10,1},{BZ,0,1},{GZ,0,4},{BX,0,5},{BW,10,1},{BY,0,4},{RY,0,4},{BZ,1,1},{BZ,2,1},{RZ,0,4},{BZ,4,1},{BZ,3,1},{D,0,5} } },
+		{ true, 9, { 5, 5, 5 }, { {RW,0,9},{BY,4,1},{GW,0,9},{GY,4,1},{BW,0,9},{BZ,4,1},{RX,0,5},{GZ,4,1},{GY,0,4},{GX,0,5},{BZ,0,1},{GZ,0,4},{BX,0,5},{BZ,1,1},{BY,0,4},{RY,0,5},{BZ,2,1},{RZ,0,5},{BZ,3,1},{D,0,5} } },
+		{ true, 8, { 6, 5, 5 }, { {RW,0,8},{GZ,4,1},{BY,4,1},{GW,0,8},{BZ,2,1},{GY,4,1},{BW,0,8},{BZ,3,1},{BZ,4,1},{RX,0,6},{GY,0,4},{GX,0,5},{BZ,0,1},{GZ,0,4},{BX,0,5},{BZ,1,1},{BY,0,4},{RY,0,6},{RZ,0,6},{D,0,5} } },
+		{ true, 8, { 5, 6, 5 }, { {RW,0,8},{BZ,0,1},{BY,4,1},{GW,0,8},{GY,5,1},{GY,4,1},{BW,0,8},{GZ,5,1},{BZ,4,1},{RX,0,5},{GZ,4,1},{GY,0,4},{GX,0,6},{GZ,0,4},{BX,0,5},{BZ,1,1},{BY,0,4},{RY,0,5},{BZ,2,1},{RZ,0,5},{BZ,3,1},{D,0,5} } },
+		{ true, 8, { 5, 5, 6 }, { {RW,0,8},{BZ,1,1},{BY,4,1},{GW,0,8},{BY,5,1},{GY,4,1},{BW,0,8},{BZ,5,1},{BZ,4,1},{RX,0,5},{GZ,4,1},{GY,0,4},{GX,0,5},{BZ,0,1},{GZ,0,4},{BX,0,6},{BY,0,4},{RY,0,5},{BZ,2,1},{RZ,0,5},{BZ,3,1},{D,0,5} } },
+		{ false, 6, { 6, 6, 6 }, { {RW,0,6},{GZ,4,1},{BZ,0,1},{BZ,1,1},{BY,4,1},{GW,0,6},{GY,5,1},{BY,5,1},{BZ,2,1},{GY,4,1},{BW,0,6},{GZ,5,1},{BZ,3,1},{BZ,5,1},{BZ,4,1},{RX,0,6},{GY,0,4},{GX,0,6},{GZ,0,4},{BX,0,6},{BY,0,4},{RY,0,6},{RZ,0,6},{D,0,5} } },
+		{ false, 10, { 10, 10, 10 }, { {RW,0,10},{GW,0,10},{BW,0,10},{RX,0,10},{GX,0,10},{BX,0,10} } },
+		{ true, 11, { 9, 9, 9 }, { {RW,0,10},{GW,0,10},{BW,0,10},{RX,0,9},{RW,10,1},{GX,0,9},{GW,10,1},{BX,0,9},{BW,10,1} } },
+		{ true, 12, { 8, 8, 8 }, { {RW,0,10},{GW,0,10},{BW,0,10},{RX,0,8},{RW,10,-2},{GX,0,8},{GW,10,-2},{BX,0,8},{BW,10,-2} } },
+		{ true, 16, { 4, 4, 4 }, { {RW,0,10},{GW,0,10},{BW,0,10},{RX,0,4},{RW,10,-6},{GX,0,4},{GW,10,-6},{BX,0,4},{BW,10,-6} } }
+	};
+
+	// Maps the 2 or 5 mode bits to an index into Modes. The 4 reserved values map to -1.
+	const int ModeIndex[32] =
+	{
+		0, 1, 2, 10, -1, -1, 3, 11, -1, -1, 4, 12, -1, -1, 5, 13,
+		-1, -1, 6, -1, -1, -1, 7, -1, -1, -1, 8, -1, -1, -1, 9, -1
+	};
+
+	// The first 32 BC7 two-subset partitions as bit masks. A set bit means the texel is in the second region.
+	const uint16 Partitions[32] =
+	{
+		0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+		0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C
+	};
+
+	// The index of the second region's anchor texel for each partition.
+	const int Anchors[32] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2
+	};
+
+	const int Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const int Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BitReader
+	{
+		BitReader(const uint8* block)																					: Position(0) { tStd::tMemcpy(Words, block, 16); }
+		int Read(int count);
+		uint64 Words[2];
+		int Position;
+	};
+
+	int SignExtend(int value, int bits)																					{ int sign = 1 << (bits-1); return ((value & ((1 << bits)-1)) ^ sign) - sign; }
+	int Unquantize(int value, int bits);
+	uint8 HalfToUnorm8(int halfBits);
+}
+
+
+uint64 BlockDecode::LoadAlphaSelectors(const uint8* block)
+{
+	// The 48 bits of 3-bit selectors follow the two endpoint bytes.
+	uint64 selectors = 0;
+	for (int b = 7; b >= 2; b--)
+		selectors = (selectors << 8) | block[b];
+	return selectors;
+}
+
+
+uint64 BlockDecode::LoadExplicitAlpha(const uint8* block)
+{
+	uint64 alpha = 0;
+	for (int b = 7; b >= 0; b--)
+		alpha = (alpha << 8) | block[b];
+	return alpha;
+}
+
+
+void BlockDecode::GetEndpoints(const uint8* colourBlock, int& c0, int& c1, int e0[3], int e1[3])
+{
+	c0 = colourBlock[0] | (colourBlock[1] << 8);
+	c1 = colourBlock[2] | (colourBlock[3] << 8);
+
+	// Expand 565 to 888 by replicating the high bits into the low ones.
+	int r0 = (c0 >> 11) & 31;	int g0 = (c0 >> 5) & 63;	int b0 = c0 & 31;
+	int r1 = (c1 >> 11) & 31;	int g1 = (c1 >> 5) & 63;	int b1 = c1 & 31;
+	e0[0] = (r0 << 3) | (r0 >> 2);	e0[1] = (g0 << 2) | (g0 >> 4);	e0[2] = (b0 << 3) | (b0 >> 2);
+	e1[0] = (r1 << 3) | (r1 >> 2);	e1[1] = (g1 << 2) | (g1 >> 4);	e1[2] = (b1 << 3) | (b1 >> 2);
+}
+
+
+void BlockDecode::ColourPaletteScalar(uint32 palette[4], const uint8* colourBlock, bool allowThreeColour)
+{
+	int c0, c1, e0[3], e1[3];
+	GetEndpoints(colourBlock, c0, c1, e0, e1);
+
+	palette[0] = Pack(e0[0], e0[1], e0[2], 255);
+	palette[1] = Pack(e1[0], e1[1], e1[2], 255);
+	if ((c0 > c1) || !allowThreeColour)
+	{
+		palette[2] = Pack((2*e0[0] + e1[0])/3, (2*e0[1] + e1[1])/3, (2*e0[2] + e1[2])/3, 255);
+		palette[3] = Pack((e0[0] + 2*e1[0])/3, (e0[1] + 2*e1[1])/3, (e0[2] + 2*e1[2])/3, 255);
+	}
+	else
+	{
+		palette[2] = Pack((e0[0] + e1[0])/2, (e0[1] + e1[1])/2, (e0[2] + e1[2])/2, 255);
+		palette[3] = 0;
+	}
+}
+
+
+void BlockDecode::AlphaPaletteScalar(uint8 palette[8], int a0, int a1)
+{
+	palette[0] = a0;
+	palette[1] = a1;
+	if (a0 > a1)
+	{
+		for (int i = 1; i < 7; i++)
+			palette[i+1] = ((7-i)*a0 + i*a1) / 7;
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++)
+			palette[i+1] = ((5-i)*a0 + i*a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+
+void BlockDecode::ColourLookup(uint32* texels, const uint32 palette[4], const uint8* colourBlock)
+{
+	uint32 selectors = LoadColourSelectors(colourBlock);
+	for (int t = 0; t < 16; t++, selectors >>= 2)
+		texels[t] = palette[selectors & 3];
+}
+
+
+void BlockDecode::DecodeBC1Scalar(uint32* texels, const uint8* block)
+{
+	// BC1 without alpha is opaque even if a block uses the transparent colour.
+	uint32 palette[4];
+	ColourPaletteScalar(palette, block, true);
+	palette[3] |= 0xFF000000;
+	ColourLookup(texels, palette, block);
+}
+
+
+void BlockDecode::DecodeBC1BAScalar(uint32* texels, const uint8* block)
+{
+	uint32 palette[4];
+	ColourPaletteScalar(palette, block, true);
+	ColourLookup(texels, palette, block);
+}
+
+
+void BlockDecode::DecodeBC2Scalar(uint32* texels, const uint8* block)
+{
+	uint32 palette[4];
+	ColourPaletteScalar(palette, block+8, false);
+	ColourLookup(texels, palette, block+8);
+
+	uint64 alpha = LoadExplicitAlpha(block);
+	for (int t = 0; t < 16; t++, alpha >>= 4)
+		texels[t] = (texels[t] & 0x00FFFFFF) | (uint32((alpha & 15) * 17) << 24);
+}
+
+
+void BlockDecode::DecodeBC3Scalar(uint32* texels, const uint8* block)
+{
+	uint32 palette[4];
+	ColourPaletteScalar(palette, block+8, false);
+	ColourLookup(texels, palette, block+8);
+
+	uint8 alphaPalette[8];
+	AlphaPaletteScalar(alphaPalette, block[0], block[1]);
+	uint64 selectors = LoadAlphaSelectors(block);
+	for (int t = 0; t < 16; t++, selectors >>= 3)
+		texels[t] = (texels[t] & 0x00FFFFFF) | (uint32(alphaPalette[selectors & 7]) << 24);
+}
+
+
+void BlockDecode::DecodeBC4Scalar(uint32* texels, const uint8* block)
+{
+	uint8 palette[8];
+	AlphaPaletteScalar(palette, block[0], block[1]);
+	uint64 selectors = LoadAlphaSelectors(block);
+	for (int t = 0; t < 16; t++, selectors >>= 3)
+		texels[t] = Pack(palette[selectors & 7], 0, 0, 255);
+}
+
+
+void BlockDecode::DecodeBC5Scalar(uint32* texels, const uint8* block)
+{
+	uint8 red[8], green[8];
+	AlphaPaletteScalar(red, block[0], block[1]);
+	AlphaPaletteScalar(green, block[8], block[9]);
+	uint64 redSelectors = LoadAlphaSelectors(block);
+	uint64 greenSelectors = LoadAlphaSelectors(block+8);
+	for (int t = 0; t < 16; t++, redSelectors >>= 3, greenSelectors >>= 3)
+		texels[t] = Pack(red[redSelectors & 7], green[greenSelectors & 7], 0, 255);
+}
+
+
+int BC6HDecode::BitReader::Read(int count)
+{
+	int word = Position >> 6;
+	int shift = Position & 63;
+	uint64 bits = Words[word] >> shift;
+	if ((shift + count > 64) && (word == 0))
+		bits |= Words[1] << (64 - shift);
+
+	Position += count;
+	return int(bits & ((uint64(1) << count) - 1));
+}
+
+
+int BC6HDecode::Unquantize(int value, int bits)
+{
+	// Unsigned unquantize. The end values map exactly and everything else lands in the middle of its bucket.
+	if (bits >= 15)
+		return value;
+	if (value == 0)
+		return 0;
+	if (value == ((1 << bits) - 1))
+		return 0xFFFF;
+	return ((value << 16) + 0x8000) >> bits;
+}
+
+
+uint8 BC6HDecode::HalfToUnorm8(int halfBits)
+{
+	half h;
+	h.setBits(uint16(halfBits));
+	float f = tMath::tSaturate(float(h));
+	return uint8(f*255.0f + 0.5f);
+}
+
+
+void BlockDecode::DecodeBC6H(uint32* texels, const uint8* block)
+{
+	using namespace BC6HDecode;
+	BitReader reader(block);
+	int modeBits = reader.Read(2);
+	if (modeBits > 1)
+		modeBits |= reader.Read(3) << 2;
+
+	// Reserved modes decode to black.
+	int modeIndex = ModeIndex[modeBits];
+	if (modeIndex < 0)
+	{
+		for (int t = 0; t < 16; t++)
+			texels[t] = Pack(0, 0, 0, 255);
+		return;
+	}
+
+	const Mode& mode = Modes[modeIndex];
+	int fields[D+1] = { 0 };
+	for (const Bits* header = mode.Header; header->Count; header++)
+	{
+		int count = tMath::tAbs(int(header->Count));
+		int value = reader.Read(count);
+		if (header->Count < 0)
+		{
+			int reversed = 0;
+			for (int b = 0; b < count; b++)
+				reversed |= ((value >> b) & 1) << (count-1-b);
+			value = reversed;
+		}
+		fields[header->Field] |= value << header->Shift;
+	}
+
+	int numRegions = (modeIndex < 10) ? 2 : 1;
+	int numEndpoints = numRegions*2;
+	int mask = (1 << mode.EndpointBits) - 1;
+
+	// Endpoints are indexed W, X, Y, Z. The fields for a channel are 4 apart.
+	int endpoints[4][3];
+	for (int c = 0; c < 3; c++)
+	{
+		int base = fields[c*4];
+		for (int e = 1; e < numEndpoints; e++)
+		{
+			int value = fields[c*4 + e];
+			if (mode.Transformed)
+				value = (base + SignExtend(value, mode.DeltaBits[c])) & mask;
+			endpoints[e][c] = Unquantize(value, mode.EndpointBits);
+		}
+		endpoints[0][c] = Unquantize(base & mask, mode.EndpointBits);
+	}
+
+	int partition = fields[D];
+	int indexBits = (numRegions == 2) ? 3 : 4;
+	const int* weights = (numRegions == 2) ? Weights3 : Weights4;
+	int anchor = (numRegions == 2) ? Anchors[partition] : 0;
+	for (int t = 0; t < 16; t++)
+	{
+		int region = (numRegions == 2) ? ((Partitions[partition] >> t) & 1) : 0;
+		int bits = ((t == 0) || (t == anchor)) ? indexBits-1 : indexBits;
+		int weight = weights[reader.Read(bits)];
+
+		const int* e0 = endpoints[region*2];
+		const int* e1 = endpoints[region*2 + 1];
+		uint8 rgb[3];
+		for (int c = 0; c < 3; c++)
+		{
+			int value = ((64 - weight)*e0[c] + weight*e1[c] + 32) >> 6;
+			rgb[c] = HalfToUnorm8((value*31) >> 6);
+		}
+		texels[t] = Pack(rgb[0], rgb[1], rgb[2], 255);
+	}
+}
+
+
+void BlockDecode::DecodeBC7(uint32* texels, const uint8* block)
+{
+	// Invalid blocks are zeroed by the unpacker.
+	bc7decomp::unpack_bc7(block, (bc7decomp::color_rgba*)texels);
+}
+
+
+#ifdef BLOCK_DECODE_SIMD
+__m128i BlockDecode::ColourPalette16SSE2(const uint8* colourBlock, bool allowThreeColour)
+{
+	int c0, c1, e0[3], e1[3];
+	GetEndpoints(colourBlock, c0, c1, e0, e1);
+
+	__m128i end0 = _mm_setr_epi16(e0[0], e0[1], e0[2], 255, e0[0], e0[1], e0[2], 255);
+	__m128i end1 = _mm_setr_epi16(e1[0], e1[1], e1[2], 255, e1[0], e1[1], e1[2], 255);
+
+	// Colours 2 and 3 are weighted sums divided by 3, or in three-colour mode the average and zero.
+	__m128i w0, w1, recip;
+	if ((c0 > c1) || !allowThreeColour)
+	{
+		w0 = _mm_setr_epi16(2, 2, 2, 2, 1, 1, 1, 1);
+		w1 = _mm_setr_epi16(1, 1, 1, 1, 2, 2, 2, 2);
+		recip = _mm_set1_epi16(21846);
+	}
+	else
+	{
+		w0 = _mm_setr_epi16(1, 1, 1, 1, 0, 0, 0, 0);
+		w1 = w0;
+		recip = _mm_set1_epi16(short(0x8000));
+	}
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(end0, w0), _mm_mullo_epi16(end1, w1));
+	__m128i middle = _mm_mulhi_epu16(sum, recip);
+
+	// Colours 0 and 1 are the endpoints themselves.
+	__m128i ends = _mm_unpacklo_epi64(end0, end1);
+	return _mm_packus_epi16(ends, middle);
+}
+
+
+void BlockDecode::ColourPaletteSSE2(uint32 palette[4], const uint8* colourBlock, bool allowThreeColour)
+{
+	_mm_storeu_si128((__m128i*)palette, ColourPalette16SSE2(colourBlock, allowThreeColour));
+}
+
+
+void BlockDecode::AlphaWeightsSSE2(bool eightValue, __m128i& w0, __m128i& w1, __m128i& recip, __m128i& top)
+{
+	if (eightValue)
+	{
+		w0 = _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1);
+		w1 = _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6);
+		recip = _mm_set1_epi16(9363);
+		top = _mm_setzero_si128();
+	}
+	else
+	{
+		w0 = _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0);
+		w1 = _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0);
+		recip = _mm_set1_epi16(13108);
+		top = _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255);
+	}
+}
+
+
+__m128i BlockDecode::AlphaPalette16SSE2(int a0, int a1)
+{
+	__m128i w0, w1, recip, top;
+	AlphaWeightsSSE2(a0 > a1, w0, w1, recip, top);
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(_mm_set1_epi16(a0), w0), _mm_mullo_epi16(_mm_set1_epi16(a1), w1));
+	return _mm_or_si128(_mm_mulhi_epu16(sum, recip), top);
+}
+
+
+void BlockDecode::AlphaPaletteSSE2(uint8 palette[8], int a0, int a1)
+{
+	__m128i values = AlphaPalette16SSE2(a0, a1);
+	_mm_storel_epi64((__m128i*)palette, _mm_packus_epi16(values, values));
+}
+
+
+void BlockDecode::DecodeBC1SSE2(uint32* texels, const uint8* block)
+{
+	uint32 palette[4];
+	ColourPaletteSSE2(palette, block, true);
+	palette[3] |= 0xFF000000;
+	ColourLookup(texels, palette, block);
+}
+
+
+void BlockDecode::DecodeBC1BASSE2(uint32* texels, const uint8* block)
+{
+	uint32 palette[4];
+	ColourPaletteSSE2(palette, block, true);
+	ColourLookup(texels, palette, block);
+}
+
+
+void BlockDecode::DecodeBC2SSE2(uint32* texels, const uint8* block)
+{
+	uint32 palette[4];
+	ColourPaletteSSE2(palette, block+8, false);
+	ColourLookup(texels, palette, block+8);
+
+	uint64 alpha = LoadExplicitAlpha(block);
+	for (int t = 0; t < 16; t++, alpha >>= 4)
+		texels[t] = (texels[t] & 0x00FFFFFF) | (uint32((alpha & 15) * 17) << 24);
+}
+
+
+void BlockDecode::DecodeBC3SSE2(uint32* texels, const uint8* block)
+{
+	uint32 palette[4];
+	ColourPaletteSSE2(palette, block+8, false);
+	ColourLookup(texels, palette, block+8);
+
+	uint8 alphaPalette[8];
+	AlphaPaletteSSE2(alphaPalette, block[0], block[1]);
+	uint64 selectors = LoadAlphaSelectors(block);
+	for (int t = 0; t < 16; t++, selectors >>= 3)
+		texels[t] = (texels[t] & 0x00FFFFFF) | (uint32(alphaPalette[selectors & 7]) << 24);
+}
+
+
+void BlockDecode::DecodeBC4SSE2(uint32* texels, const uint8* block)
+{
+	uint8 palette[8];
+	AlphaPaletteSSE2(palette, block[0], block[1]);
+	uint64 selectors = LoadAlphaSelectors(block);
+	for (int t = 0; t < 16; t++, selectors >>= 3)
+		texels[t] = Pack(palette[selectors & 7], 0, 0, 255);
+}
+
+
+void BlockDecode::DecodeBC5SSE2(uint32* texels, const uint8* block)
+{
+	uint8 red[8], green[8];
+	AlphaPaletteSSE2(red, block[0], block[1]);
+	AlphaPaletteSSE2(green, block[8], block[9]);
+	uint64 redSelectors = LoadAlphaSelectors(block);
+	uint64 greenSelectors = LoadAlphaSelectors(block+8);
+	for (int t = 0; t < 16; t++, redSelectors >>= 3, greenSelectors >>= 3)
+		texels[t] = Pack(red[redSelectors & 7], green[greenSelectors & 7], 0, 255);
+}
+
+
+BLOCK_DECODE_AVX2 __m256i BlockDecode::ColourPaletteAVX2(const uint8* colourBlock, bool allowThreeColour)
+{
+	int c0, c1, e0[3], e1[3];
+	GetEndpoints(colourBlock, c0, c1, e0, e1);
+
+	// All 4 colours are computed at once. The endpoints use a weight of 3 (or 2) so one divide covers every lane.
+	__m256i end0 = _mm256_set1_epi64x(int64(e0[0]) | (int64(e0[1]) << 16) | (int64(e0[2]) << 32) | (int64(255) << 48));
+	__m256i end1 = _mm256_set1_epi64x(int64(e1[0]) | (int64(e1[1]) << 16) | (int64(e1[2]) << 32) | (int64(255) << 48));
+	__m256i w0, w1, recip;
+	if ((c0 > c1) || !allowThreeColour)
+	{
+		w0 = _mm256_setr_epi16(3, 3, 3, 3, 0, 0, 0, 0, 2, 2, 2, 2, 1, 1, 1, 1);
+		w1 = _mm256_setr_epi16(0, 0, 0, 0, 3, 3, 3, 3, 1, 1, 1, 1, 2, 2, 2, 2);
+		recip = _mm256_set1_epi16(21846);
+	}
+	else
+	{
+		w0 = _mm256_setr_epi16(2, 2, 2, 2, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0);
+		w1 = _mm256_setr_epi16(0, 0, 0, 0, 2, 2, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0);
+		recip = _mm256_set1_epi16(short(0x8000));
+	}
+	__m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(end0, w0), _mm256_mullo_epi16(end1, w1));
+	__m256i colours = _mm256_mulhi_epu16(sum, recip);
+
+	// The pack works per 128-bit lane, giving colours 0 1 0 1 | 2 3 2 3. The permute gathers 0 1 2 3 into the low
+	// half. The high half is a copy, which the lookup never indexes.
+	__m256i packed = _mm256_packus_epi16(colours, colours);
+	return _mm256_permute4x64_epi64(packed, 0x88);
+}
+
+
+BLOCK_DECODE_AVX2 void BlockDecode::ColourLookupAVX2(__m256i texels[2], __m256i palette, uint32 selectors)
+{
+	const __m256i shiftsLo = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+	const __m256i shiftsHi = _mm256_setr_epi32(16, 18, 20, 22, 24, 26, 28, 30);
+	const __m256i indexMask = _mm256_set1_epi32(3);
+	__m256i all = _mm256_set1_epi32(int(selectors));
+	texels[0] = _mm256_permutevar8x32_epi32(palette, _mm256_and_si256(_mm256_srlv_epi32(all, shiftsLo), indexMask));
+	texels[1] = _mm256_permutevar8x32_epi32(palette, _mm256_and_si256(_mm256_srlv_epi32(all, shiftsHi), indexMask));
+}
+
+
+BLOCK_DECODE_AVX2 void BlockDecode::AlphaLookupAVX2(__m256i texels[2], __m256i palette, uint64 selectors)
+{
+	// Each half of the 48 selector bits holds 8 texels and fits in a 32-bit lane.
+	const __m256i shifts = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	const __m256i indexMask = _mm256_set1_epi32(7);
+	__m256i lo = _mm256_set1_epi32(int(selectors & 0xFFFFFF));
+	__m256i hi = _mm256_set1_epi32(int((selectors >> 24) & 0xFFFFFF));
+	texels[0] = _mm256_permutevar8x32_epi32(palette, _mm256_and_si256(_mm256_srlv_epi32(lo, shifts), indexMask));
+	texels[1] = _mm256_permutevar8x32_epi32(palette, _mm256_and_si256(_mm256_srlv_epi32(hi, shifts), indexMask));
+}
+
+
+BLOCK_DECODE_AVX2 void BlockDecode::DecodeBC1AVX2(uint32* texels, const uint8* block)
+{
+	__m256i palette = _mm256_or_si256(ColourPaletteAVX2(block, true), _mm256_setr_epi32(0, 0, 0, int(0xFF000000), 0, 0, 0, 0));
+	__m256i colour[2];
+	ColourLookupAVX2(colour, palette, LoadColourSelectors(block));
+	_mm256_storeu_si256((__m256i*)texels, colour[0]);
+	_mm256_storeu_si256((__m256i*)(texels+8), colour[1]);
+}
+
+
+BLOCK_DECODE_AVX2 void BlockDecode::DecodeBC1BAAVX2(uint32* texels, const uint8* block)
+{
+	__m256i colour[2];
+	ColourLookupAVX2(colour, ColourPaletteAVX2(block, true), LoadColourSelectors(block));
+	_mm256_storeu_si256((__m256i*)texels, colour[0]);
+	_mm256_storeu_si256((__m256i*)(texels+8), colour[1]);
+}
+
+
+BLOCK_DECODE_AVX2 void BlockDecode::DecodeBC2AVX2(uint32* texels, const uint8* block)
+{
+	__m256i colour[2];
+	ColourLookupAVX2(colour, ColourPaletteAVX2(block+8, false), LoadColourSelectors(block+8));
+
+	// The explicit 4-bit alpha values are expanded to 8 bits by multiplying by 17.
+	const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+	const __m256i nibbleMask = _mm256_set1_epi32(15);
+	const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+	uint64 alpha = LoadExplicitAlpha(block);
+	for (int h = 0; h < 2; h++)
+	{
+		__m256i nibbles = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(int(alpha >> (32*h))), shifts), nibbleMask);
+		__m256i alpha8 = _mm256_mullo_epi32(nibbles, _mm256_set1_epi32(17));
+		__m256i result = _mm256_or_si256(_mm256_and_si256(colour[h], rgbMask), _mm256_slli_epi32(alpha8, 24));
+		_mm256_storeu_si256((__m256i*)(texels + 8*h), result);
+	}
+}
+
+
+BLOCK_DECODE_AVX2 void BlockDecode::DecodeBC3AVX2(uint32* texels, const uint8* block)
+{
+	__m256i colour[2];
+	ColourLookupAVX2(colour, ColourPaletteAVX2(block+8, false), LoadColourSelectors(block+8));
+
+	__m256i alpha[2];
+	__m256i alphaPalette = _mm256_cvtepu16_epi32(AlphaPalette16SSE2(block[0], block[1]));
+	AlphaLookupAVX2(alpha, alphaPalette, LoadAlphaSelectors(block));
+
+	const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+	for (int h = 0; h < 2; h++)
+	{
+		__m256i result = _mm256_or_si256(_mm256_and_si256(colour[h], rgbMask), _mm256_slli_epi32(alpha[h], 24));
+		_mm256_storeu_si256((__m256i*)(texels + 8*h), result);
+	}
+}
+
+
+BLOCK_DECODE_AVX2 void BlockDecode::DecodeBC4AVX2(uint32* texels, const uint8* block)
+{
+	__m256i red[2];
+	__m256i palette = _mm256_cvtepu16_epi32(AlphaPalette16SSE2(block[0], block[1]));
+	AlphaLookupAVX2(red, palette, LoadAlphaSelectors(block));
+
+	const __m256i opaque = _mm256_set1_epi32(int(0xFF000000));
+	_mm256_storeu_si256((__m256i*)texels, _mm256_or_si256(red[0], opaque));
+	_mm256_storeu_si256((__m256i*)(texels+8), _mm256_or_si256(red[1], opaque));
+}
+
+
+BLOCK_DECODE_AVX2 void BlockDecode::DecodeBC5AVX2(uint32* texels, const uint8* block)
+{
+	// Both channel palettes are built in one register. Red goes in the low 128 bits and green in the high.
+	__m128i rw0, rw1, rRecip, rTop, gw0, gw1, gRecip, gTop;
+	AlphaWeightsSSE2(block[0] > block[1], rw0, rw1, rRecip, rTop);
+	AlphaWeightsSSE2(block[8] > block[9], gw0, gw1, gRecip, gTop);
+	__m256i w0 = _mm256_inserti128_si256(_mm256_castsi128_si256(rw0), gw0, 1);
+	__m256i w1 = _mm256_inserti128_si256(_mm256_castsi128_si256(rw1), gw1, 1);
+	__m256i recip = _mm256_inserti128_si256(_mm256_castsi128_si256(rRecip), gRecip, 1);
+	__m256i top = _mm256_inserti128_si256(_mm256_castsi128_si256(rTop), gTop, 1);
+	__m256i end0 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi16(block[0])), _mm_set1_epi16(block[8]), 1);
+	__m256i end1 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi16(block[1])), _mm_set1_epi16(block[9]), 1);
+
+	__m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(end0, w0), _mm256_mullo_epi16(end1, w1));
+	__m256i palettes = _mm256_or_si256(_mm256_mulhi_epu16(sum, recip), top);
+
+	__m256i red[2], green[2];
+	AlphaLookupAVX2(red, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(palettes)), LoadAlphaSelectors(block));
+	AlphaLookupAVX2(green, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(palettes, 1)), LoadAlphaSelectors(block+8));
+
+	const __m256i opaque = _mm256_set1_epi32(int(0xFF000000));
+	for (int h = 0; h < 2; h++)
+	{
+		__m256i result = _mm256_or_si256(_mm256_or_si256(red[h], _mm256_slli_epi32(green[h], 8)), opaque);
+		_mm256_storeu_si256((__m256i*)(texels + 8*h), result);
+	}
+}
+#endif
+
+
+BlockDecode::BlockFunction* BlockDecode::GetBlockFunction(tImage::tPixelFormat format, tImage::tBlockDecodePath path)
+{
+	using namespace tImage;
+
+	// BC6H and BC7 have a single implementation shared by every path.
+	switch (format)
+	{
+		case tPixelFormat::BC6H:		return DecodeBC6H;
+		case tPixelFormat::BC7:			return DecodeBC7;
+		default:						break;
+	}
+
+	#ifdef BLOCK_DECODE_SIMD
+	if (path == tBlockDecodePath::AVX2)
+	{
+		switch (format)
+		{
+			case tPixelFormat::BC1_DXT1:	return DecodeBC1AVX2;
+			case tPixelFormat::BC1_DXT1BA:	return DecodeBC1BAAVX2;
+			case tPixelFormat::BC2_DXT3:	return DecodeBC2AVX2;
+			case tPixelFormat::BC3_DXT5:	return DecodeBC3AVX2;
+			case tPixelFormat::BC4_ATI1:	return DecodeBC4AVX2;
+			case tPixelFormat::BC5_ATI2:	return DecodeBC5AVX2;
+			default:						return nullptr;
+		}
+	}
+
+	if (path == tBlockDecodePath::SSE2)
+	{
+		switch (format)
+		{
+			case tPixelFormat::BC1_DXT1:	return DecodeBC1SSE2;
+			case tPixelFormat::BC1_DXT1BA:	return DecodeBC1BASSE2;
+			case tPixelFormat::BC2_DXT3:	return DecodeBC2SSE2;
+			case tPixelFormat::BC3_DXT5:	return DecodeBC3SSE2;
+			case tPixelFormat::BC4_ATI1:	return DecodeBC4SSE2;
+			case tPixelFormat::BC5_ATI2:	return DecodeBC5SSE2;
+			default:						return nullptr;
+		}
+	}
+	#endif
+
+	switch (format)
+	{
+		case tPixelFormat::BC1_DXT1:		return DecodeBC1Scalar;
+		case tPixelFormat::BC1_DXT1BA:		return DecodeBC1BAScalar;
+		case tPixelFormat::BC2_DXT3:		return DecodeBC2Scalar;
+		case tPixelFormat::BC3_DXT5:		return DecodeBC3Scalar;
+		case tPixelFormat::BC4_ATI1:		return DecodeBC4Scalar;
+		case tPixelFormat::BC5_ATI2:		return DecodeBC5Scalar;
+		default:							return nullptr;
+	}
+}
+
+
+void BlockDecode::DecodeBlockRow(tPixel* dest, const uint8* blocks, int blockSize, int width, int height, int blockY, BlockFunction* decodeBlock)
+{
+	int numBlocksX = (width + 3) >> 2;
+	const uint8* block = blocks + blockY*numBlocksX*blockSize;
+	int y = blockY*4;
+	int numRows = tMath::tMin(4, height - y);
+
+	uint32 texels[16];
+	for (int blockX = 0; blockX < numBlocksX; blockX++, block += blockSize)
+	{
+		decodeBlock(texels, block);
+
+		// Texels outside the picture are dropped.
+		int x = blockX*4;
+		int numCols = tMath::tMin(4, width - x);
+		for (int r = 0; r < numRows; r++)
+			tStd::tMemcpy(dest + (y+r)*width + x, texels + r*4, numCols*sizeof(uint32));
+	}
+}
+
+
+bool tImage::tIsBlockDecodePathSupported(tBlockDecodePath path)
+{
+	switch (path)
+	{
+		case tBlockDecodePath::Auto:
+		case tBlockDecodePath::Scalar:
+			return true;
+
+		#ifdef BLOCK_DECODE_SIMD
+		case tBlockDecodePath::SSE2:
+			return tSystem::tSupportsSSE2();
+
+		case tBlockDecodePath::AVX2:
+			return tSystem::tSupportsAVX2();
+		#endif
+
+		default:
+			return false;
+	}
+}
+
+
+bool tImage::tDecodeBlocks
+(
+	tPixel* dest, const uint8* blocks, tPixelFormat format, int width, int height,
+	tBlockDecodePath path, int maxThreads
+)
+{
+	if (!dest || !blocks || (width <= 0) || (height <= 0) || !tIsBlockFormat(format))
+		return false;
+
+	if (!tIsBlockDecodePathSupported(path))
+		return false;
+
+	// CPU detection isn't free, so Auto is only resolved once.
+	if (path == tBlockDecodePath::Auto)
+	{
+		static tBlockDecodePath bestPath =
+			tIsBlockDecodePathSupported(tBlockDecodePath::AVX2) ? tBlockDecodePath::AVX2 :
+			tIsBlockDecodePathSupported(tBlockDecodePath::SSE2) ? tBlockDecodePath::SSE2 :
+			tBlockDecodePath::Scalar;
+		path = bestPath;
+	}
+
+	BlockDecode::BlockFunction* decodeBlock = BlockDecode::GetBlockFunction(format, path);
+	if (!decodeBlock)
+		return false;
+
+	int blockSize = tGetBytesPer4x4PixelBlock(format);
+	int numBlocksY = (height + 3) >> 2;
+	int numBlocks = ((width + 3) >> 2) * numBlocksY;
+
+	// Block rows write disjoint sets of pixel rows so they may be decoded in any order.
+	auto decodeRow = [dest, blocks, blockSize, width, height, decodeBlock](int blockY)
+	{
+		BlockDecode::DecodeBlockRow(dest, blocks, blockSize, width, height, blockY, decodeBlock);
+	};
+
+	if ((maxThreads == 1) || (numBlocks < BlockDecode::MinParallelBlocks))
+	{
+		for (int blockY = 0; blockY < numBlocksY; blockY++)
+			decodeRow(blockY);
+	}
+	else
+	{
+		tSystem::tGetSharedJobSystem().ParallelFor(numBlocksY, decodeRow, 1, maxThreads);
+	}
+
+	return true;
+}
@@ -427,6 +427,159 @@ struct tDXT5Block
 #pragma pack(pop)
 
 
+// Determines which of our pixel formats the dds pixel format describes. Returns tPixelFormat::Invalid if it is one we
+// don't support. Note that DXT1 is always reported as BC1_DXT1. Whether it has binary alpha depends on the block data.
+static tPixelFormat DeterminePixelFormat(const tDDSPixelFormat& format)
+{
+	if (format.Flags & tDDSPixelFormatFlag_FourCC)
+	{
+		switch (format.FourCC)
+		{
+			case FourCC('D','X','T','1'):
+				// Note that during inspecition of the individual layer data, the DXT1 pixel format might be modified
+				// to DXT1BA (binary alpha).
+				return tPixelFormat::BC1_DXT1;
+
+			case FourCC('D','X','T','3'):
+				return tPixelFormat::BC2_DXT3;
+
+			case FourCC('D','X','T','5'):
+				return tPixelFormat::BC3_DXT5;
+
+			case tD3DFMT_R32F:
+				return tPixelFormat::R32F;
+
+			case tD3DFMT_G32R32F:
+				return tPixelFormat::G32R32F;
+
+			case tD3DFMT_A32B32G32R32F:
+				return tPixelFormat::A32B32G32R32F;
+
+			case FourCC('D','X','1','0'):
+			default:
+				return tPixelFormat::Invalid;
+		}
+	}
+
+	// It must be an RGB format. Remember this is a little endian machine, so the masks are lying. Eg. 0xFF0000 in memory
+	// is 00 00 FF, so the red is last.
+	bool rgbHasAlpha = (format.Flags & tDDSPixelFormatFlag_Alpha) ? true : false;
+	switch (format.RGBBitCount)
+	{
+		case 16:
+			// Supports G3B5A1R5G2, G4B4A4R4, and G3B5R5G3.
+			if
+			(
+				rgbHasAlpha &&
+				(format.MaskAlpha	== 0x8000) &&
+				(format.MaskRed		== 0x7C00) &&
+				(format.MaskGreen	== 0x03E0) &&
+				(format.MaskBlue	== 0x001F)
+			)
+				return tPixelFormat::G3B5A1R5G2;
+
+			if
+			(
+				rgbHasAlpha &&
+				(format.MaskAlpha	== 0xF000) &&
+				(format.MaskRed		== 0x0F00) &&
+				(format.MaskGreen	== 0x00F0) &&
+				(format.MaskBlue	== 0x000F)
+			)
+				return tPixelFormat::G4B4A4R4;
+
+			if
+			(
+				!rgbHasAlpha &&
+				(format.MaskRed		== 0xF800) &&
+				(format.MaskGreen	== 0x07E0) &&
+				(format.MaskBlue	== 0x001F)
+			)
+				return tPixelFormat::G3B5R5G3;
+			break;
+
+		case 24:
+			// Supports B8G8R8.
+			if
+			(
+				!rgbHasAlpha &&
+				(format.MaskRed		== 0xFF0000) &&
+				(format.MaskGreen	== 0x00FF00) &&
+				(format.MaskBlue	== 0x0000FF)
+			)
+				return tPixelFormat::B8G8R8;
+			break;
+
+		case 32:
+			// Supports B8G8R8A8. This is a little endian machine so the masks are lying. 0xFF000000 in memory is
+			// 00 00 00 FF with alpha last.
+			if
+			(
+				rgbHasAlpha &&
+				(format.MaskAlpha	== 0xFF000000) &&
+				(format.MaskRed		== 0x00FF0000) &&
+				(format.MaskGreen	== 0x0000FF00) &&
+				(format.MaskBlue	== 0x000000FF)
+			)
+				return tPixelFormat::B8G8R8A8;
+			break;
+	}
+
+	return tPixelFormat::Invalid;
+}
+
+
+bool tImageDDS::GetHeaderInfo
+(
+	const uint8* ddsHead, int numBytes, int& width, int& height,
+	int& numMipmapLevels, bool& isCubemap, tPixelFormat& pixelFormat
+)
+{
+	if (!ddsHead || (numBytes < int(sizeof(tDDSHeader)+4)))
+		return false;
+
+	if (*((uint32*)ddsHead) != ' SDD')
+		return false;
+
+	const tDDSHeader& header = *((tDDSHeader*)(ddsHead+4));
+	const tDDSPixelFormat& ddsFormat = header.PixelFormat;
+	if ((header.Size != 124) || (header.Flags & tDDSFlag_Depth) || (ddsFormat.Size != 32))
+		return false;
+
+	bool rgbFormat = (ddsFormat.Flags & tDDSPixelFormatFlag_RGB) ? true : false;
+	bool fourCCFormat = (ddsFormat.Flags & tDDSPixelFormatFlag_FourCC) ? true : false;
+	if (rgbFormat == fourCCFormat)
+		return false;
+
+	// Same restrictions as LoadFromMemory so we never report a file as valid that can't actually be loaded.
+	tPixelFormat format = DeterminePixelFormat(ddsFormat);
+	if
+	(
+		(format == tPixelFormat::Invalid) || (format == tPixelFormat::R32F) ||
+		(format == tPixelFormat::G32R32F) || (format == tPixelFormat::A32B32G32R32F)
+	)
+		return false;
+
+	int w = header.Width;
+	int h = header.Height;
+	if (!tMath::tIsPower2(w) || !tMath::tIsPower2(h) || (!rgbFormat && ((w%4) || (h%4))))
+		return false;
+
+	int numLevels = 1;
+	if ((header.Flags & tDDSFlag_MipmapCount) && (header.Capabilities.FlagsCapsBasic & tDDSCapsBasic_Mipmap))
+		numLevels = header.MipmapCount;
+	if (numLevels > MaxMipmapLayers)
+		return false;
+
+	width = w;
+	height = h;
+	numMipmapLevels = numLevels;
+	isCubemap = (header.Capabilities.FlagsCapsExtra & tDDSCapsExtra_CubeMap) ? true : false;
+	pixelFormat = format;
+	return true;
+}
+
+
 void tImageDDS::Load(const tString& ddsFile, bool reverseRowOrder)
 {
 	Clear();
@@ -554,8 +707,6 @@ void tImageDDS::LoadFromMemory(const uint8* ddsData, int ddsSizeBytes, bool reve
 		throw tDDSError(tDDSError::tCode::IncorrectPixelFormatSize, baseName);
 	}
 
-	// Has alpha should be true if the pixel format is uncompressed (RGB) and there is an alpha channel.
-	bool rgbHasAlpha = (format.Flags & tDDSPixelFormatFlag_Alpha) ? true : false;
 	bool rgbFormat = (format.Flags & tDDSPixelFormatFlag_RGB) ? true : false;
 	bool fourCCFormat = (format.Flags & tDDSPixelFormatFlag_FourCC) ? true : false;
 
@@ -565,141 +716,11 @@ void tImageDDS::LoadFromMemory(const uint8* ddsData, int ddsSizeBytes, bool reve
 		throw tDDSError(tDDSError::tCode::InconsistentPixelFormat, baseName);
 	}
 
-	if (fourCCFormat)
+	PixelFormat = DeterminePixelFormat(format);
+	if (PixelFormat == tPixelFormat::Invalid)
 	{
-		switch (format.FourCC)
-		{
-			case FourCC('D','X','T','1'):
-				// Note that during inspecition of the individual layer data, the DXT1 pixel format might be modified
-				// to DXT1BA (binary alpha).
-				PixelFormat = tPixelFormat::BC1_DXT1;
-				break;
-
-			case FourCC('D','X','T','3'):
-				PixelFormat = tPixelFormat::BC2_DXT3;
-				break;
-
-			case FourCC('D','X','T','5'):
-				PixelFormat = tPixelFormat::BC3_DXT5;
-				break;
-
-			case tD3DFMT_R32F:
-				PixelFormat = tPixelFormat::R32F;
-				break;
-
-			case tD3DFMT_G32R32F:
-				PixelFormat = tPixelFormat::G32R32F;
-				break;
-
-			case tD3DFMT_A32B32G32R32F:
-				PixelFormat = tPixelFormat::A32B32G32R32F;
-				break;
-
-			case FourCC('D','X','1','0'):
-			default:
-				delete[] ddsData;
-				throw tDDSError(tDDSError::tCode::UnsupportedFourCCPixelFormat, baseName);
-		}
-	}
-
-	// It must be an RGB format.
-	else
-	{
-		// Remember this is a little endian machine, so the masks are lying. Eg. 0xFF0000 in memory is 00 00 FF, so the red
-		// is last.
-		switch (format.RGBBitCount)
-		{
-			case 16:
-				// Supports G3B5A1R5G2, G4B4A4R4, and G3B5R5G3.
-				if
-				(
-					rgbHasAlpha &&
-					(format.MaskAlpha	== 0x8000) &&
-					(format.MaskRed		== 0x7C00) &&
-					(format.MaskGreen	== 0x03E0) &&
-					(format.MaskBlue	== 0x001F)
-				)
-				{
-					PixelFormat = tPixelFormat::G3B5A1R5G2;
-				}
-
-				else if
-				(
-					rgbHasAlpha &&
-					(format.MaskAlpha	== 0xF000) &&
-					(format.MaskRed		== 0x0F00) &&
-					(format.MaskGreen	== 0x00F0) &&
-					(format.MaskBlue	== 0x000F)
-				)
-				{
-					PixelFormat = tPixelFormat::G4B4A4R4;
-				}
-
-				else if
-				(
-					!rgbHasAlpha &&
-					(format.MaskRed		== 0xF800) &&
-					(format.MaskGreen	== 0x07E0) &&
-					(format.MaskBlue	== 0x001F)
-				)
-				{
-					PixelFormat = tPixelFormat::G3B5R5G3;
-				}
-
-				else
-				{
-					delete[] ddsData;
-					throw tDDSError(tDDSError::tCode::UnsupportedRGBPixelFormat, baseName);
-				}
-
-				break;
-
-			case 24:
-				// Supports B8G8R8.
-				if
-				(
-					!rgbHasAlpha &&
-					(format.MaskRed		== 0xFF0000) &&
-					(format.MaskGreen	== 0x00FF00) &&
-					(format.MaskBlue	== 0x0000FF)
-				)
-				{
-					PixelFormat = tPixelFormat::B8G8R8;
-				}
-
-				else
-				{
-					delete[] ddsData;
-					throw tDDSError(tDDSError::tCode::UnsupportedRGBPixelFormat, baseName);
-				}
-
-				break;
-
-			case 32:
-				// Supports B8G8R8A8. This is a little endian machine so the masks are lying. 0xFF000000 in memory is
-				// 00 00 00 FF with alpha last.
-				if
-				(
-					rgbHasAlpha &&
-					(format.MaskAlpha	== 0xFF000000) &&
-					(format.MaskRed		== 0x00FF0000) &&
-					(format.MaskGreen	== 0x0000FF00) &&
-					(format.MaskBlue	== 0x000000FF)
-				)
-				{
-					PixelFormat = tPixelFormat::B8G8R8A8;
-				}
-				else
-				{
-					delete[] ddsData;
-					throw tDDSError(tDDSError::tCode::UnsupportedRGBPixelFormat, baseName);
-				}
-				break;
-
-			default:
-				delete[] ddsData;
-				throw tDDSError(tDDSError::tCode::UnsupportedRGBPixelFormat, baseName);
-		}
+		delete[] ddsData;
+		throw tDDSError(fourCCFormat ? tDDSError::tCode::UnsupportedFourCCPixelFormat : tDDSError::tCode::UnsupportedRGBPixelFormat, baseName);
 	}
 
 	// @todo We do not yet support these formats.
@@ -24,8 +24,8 @@ namespace tImage
 {
 
 
-// This callback is a essentially the example code from gif_load.
-void tImageGIF::FrameCallback(struct GIF_WHDR* whdr)
+// This callback is a essentially the example code from gif_load. It is called once per decoded frame.
+void tImageGIF::FrameStream::FrameCallback(struct GIF_WHDR* whdr)
 {
     #define RGBA(i)											\
 	(														\
@@ -38,15 +38,6 @@ void tImageGIF::FrameCallback(struct GIF_WHDR* whdr)
 		)													\
 	)
 
-	// Is first frame?
-	if (whdr->ifrm == 0)
-	{
-		Width = whdr->xdim;
-		Height = whdr->ydim;
-		FrmPict = new tPixel[Width * Height];
-		FrmPrev = new tPixel[Width * Height];
-	}
-
 	int numPixels = Width * Height;
 	tPixel* pict = FrmPict;
 	tPixel* prev = nullptr;
@@ -64,14 +55,17 @@ void tImageGIF::FrameCallback(struct GIF_WHDR* whdr)
 				if (whdr->tran != (long)whdr->bptr[++dsrc])
 					pict[whdr->xdim * y + x + ddst].BP = RGBA(dsrc);
 
-	tImageGIF::Frame* frame = new tImageGIF::Frame();
-	Frames.Append(frame);
-	frame->Pixels = new tPixel[numPixels];
-	frame->Duration = float(whdr->time) / 100.0f;
+	// Frames that are only decoded to build up the canvas are not kept.
+	if (KeepFrame)
+	{
+		DecodedFrame = new tImageGIF::Frame();
+		DecodedFrame->Pixels = new tPixel[numPixels];
+		DecodedFrame->Duration = float(whdr->time) / 100.0f;
 
-	// We store rows starting from the bottom (lower left is 0,0).
-	for (int row = Height-1; row >= 0; row--)
-		tStd::tMemcpy(frame->Pixels + (row*Width), pict + ((Height-row-1)*Width), Width*sizeof(tPixel));
+		// We store rows starting from the bottom (lower left is 0,0).
+		for (int row = Height-1; row >= 0; row--)
+			tStd::tMemcpy(DecodedFrame->Pixels + (row*Width), pict + ((Height-row-1)*Width), Width*sizeof(tPixel));
+	}
 
 	if ((whdr->mode == GIF_PREV) && !FrmLast)
 	{
@@ -107,9 +101,9 @@ void tImageGIF::FrameCallback(struct GIF_WHDR* whdr)
 }
 
 
-bool tImageGIF::Load(const tString& gifFile)
+bool tImageGIF::FrameStream::Open(const tString& gifFile)
 {
-	Clear();
+	Close();
 
 	if (tSystem::tGetFileType(gifFile) != tSystem::tFileType::GIF)
 		return false;
@@ -117,20 +111,213 @@ bool tImageGIF::Load(const tString& gifFile)
 	if (!tFileExists(gifFile))
 		return false;
 
-	int numBytes = 0;
-	uint8* gifFileInMemory = tLoadFile(gifFile, nullptr, &numBytes);
+	// The extra EOF byte is there because gif_load may look one byte past the data it is given.
+	FileData = tLoadFile(gifFile, nullptr, &FileSize, true);
+	if (!FileData || !IndexFrames())
+	{
+		Close();
+		return false;
+	}
 
-	// This call allocated scratchpad memory pointed to by FrmPict and FrmPrev.
-	// They are set to null just in case GIF_Load fails to allocate.
-	FrmPict = nullptr;
-	FrmPrev = nullptr;
-	int result = GIF_Load(gifFileInMemory, numBytes, FrameCallbackBridge, nullptr, (void*)this, 0);
+	return true;
+}
+
+
+bool tImageGIF::FrameStream::IndexFrames()
+{
+	// Header, logical screen descriptor, and optional global palette.
+	const int headerSize = 13;
+	if ((FileSize < headerSize) || tStd::tMemcmp(FileData, "GIF8", 4))
+		return false;
+
+	Width = FileData[6] | (FileData[7] << 8);
+	Height = FileData[8] | (FileData[9] << 8);
+	if ((Width <= 0) || (Height <= 0))
+		return false;
+
+	uint8 screenFlags = FileData[10];
+	int pos = headerSize + ((screenFlags & 0x80) ? 3 * (2 << (screenFlags & 0x07)) : 0);
+
+	// Skips a run of data sub-blocks. Returns false if the file ends first.
+	auto skipSubBlocks = [this](int& pos) -> bool
+	{
+		while (pos < FileSize)
+		{
+			int length = FileData[pos++];
+			if (!length)
+				return true;
+			pos += length;
+		}
+		return false;
+	};
+
+	// The offsets are collected into a list first since we don't know how many frames there are.
+	struct FrameEnd : public tLink<FrameEnd> { FrameEnd(int offset, bool key) : Offset(offset), Key(key) { } int Offset; bool Key; };
+	tList<FrameEnd> frameEnds;
+	bool transparent = false;
+	bool restorePrev = false;
+	while (pos < FileSize)
+	{
+		uint8 desc = FileData[pos++];
+		if (desc == 0x21)
+		{
+			// Extension. The label is followed by sub-blocks. A graphic control extension with the transparency bit
+			// set means the next frame has transparent pixels. It also holds how that frame is disposed of.
+			if ((pos + 3 < FileSize) && (FileData[pos] == 0xF9) && (FileData[pos + 1] >= 4))
+			{
+				transparent = (FileData[pos + 2] & 0x01) ? true : false;
+				restorePrev = (((FileData[pos + 2] >> 2) & 0x07) == GIF_PREV);
+				if (transparent)
+					Opaque = false;
+			}
+			pos++;
+			if (!skipSubBlocks(pos))
+				break;
+		}
+		else if (desc == 0x2C)
+		{
+			// Image descriptor, optional local palette, LZW minimum code size, and the image sub-blocks. The canvas
+			// starts out transparent so a frame that doesn't cover all of it leaves transparent pixels.
+			if (pos + 10 > FileSize)
+				break;
+			int frameX = FileData[pos] | (FileData[pos + 1] << 8);
+			int frameY = FileData[pos + 2] | (FileData[pos + 3] << 8);
+			int frameW = FileData[pos + 4] | (FileData[pos + 5] << 8);
+			int frameH = FileData[pos + 6] | (FileData[pos + 7] << 8);
+			bool full = (frameX <= 0) && (frameY <= 0) && (frameX + frameW >= Width) && (frameY + frameH >= Height);
+			if (!full)
+				Opaque = false;
+			uint8 frameFlags = FileData[pos + 8];
+			pos += 9 + ((frameFlags & 0x80) ? 3 * (2 << (frameFlags & 0x07)) : 0) + 1;
+			if (!skipSubBlocks(pos))
+				break;
+
+			// A frame that overwrites every pixel doesn't need anything before it. Restore-previous frames are left
+			// out because the canvas they restore comes from earlier frames.
+			bool keyFrame = frameEnds.IsEmpty() || (full && !transparent && !restorePrev);
+			frameEnds.Append(new FrameEnd(pos, keyFrame));
+			transparent = false;
+			restorePrev = false;
+		}
+		else
+		{
+			// Trailer, or something we don't understand.
+			break;
+		}
+	}
+
+	NumFrames = frameEnds.GetNumItems();
+	if (NumFrames <= 0)
+		return false;
+
+	FrameEnds = new int[NumFrames];
+	KeyFrames = new bool[NumFrames];
+	int frame = 0;
+	for (FrameEnd* frameEnd = frameEnds.First(); frameEnd; frameEnd = frameEnd->Next(), frame++)
+	{
+		FrameEnds[frame] = frameEnd->Offset;
+		KeyFrames[frame] = frameEnd->Key;
+	}
+	return true;
+}
+
+
+void tImageGIF::FrameStream::Close()
+{
+	delete[] FileData;
+	FileData = nullptr;
+	FileSize = 0;
+	delete[] FrameEnds;
+	FrameEnds = nullptr;
+	delete[] KeyFrames;
+	KeyFrames = nullptr;
+	Width = 0;
+	Height = 0;
+	NumFrames = 0;
+	Opaque = true;
+	NextFrame = 0;
+
+	FrmLast = 0;
 	delete[] FrmPict;
+	FrmPict = nullptr;
 	delete[] FrmPrev;
-	delete[] gifFileInMemory;
-	if (result <= 0)
+	FrmPrev = nullptr;
+}
+
+
+void tImageGIF::FrameStream::ResetCanvas()
+{
+	// The canvas starts out transparent.
+	int numPixels = Width * Height;
+	if (!FrmPict)
+	{
+		FrmPict = new tPixel[numPixels];
+		FrmPrev = new tPixel[numPixels];
+	}
+	tStd::tMemset(FrmPict, 0, numPixels*sizeof(tPixel));
+	tStd::tMemset(FrmPrev, 0, numPixels*sizeof(tPixel));
+	FrmLast = 0;
+}
+
+
+tImageGIF::Frame* tImageGIF::FrameStream::ReadFrame(int frameNum)
+{
+	if (!IsValid() || (frameNum < 0) || (frameNum >= NumFrames))
+		return nullptr;
+
+	// Unless the canvas is already somewhere between the closest key frame and the one we want, start at the key frame.
+	int keyFrame = frameNum;
+	while (!KeyFrames[keyFrame])
+		keyFrame--;
+	if ((NextFrame > frameNum) || (NextFrame <= keyFrame))
+	{
+		ResetCanvas();
+		NextFrame = keyFrame;
+	}
+
+	// Giving gif_load the data only up to the end of the frame we want, and telling it to skip the frames before,
+	// makes it decode exactly one frame per call.
+	while (NextFrame <= frameNum)
+	{
+		KeepFrame = (NextFrame == frameNum);
+		DecodedFrame = nullptr;
+		long result = GIF_Load(FileData, FrameEnds[NextFrame], FrameCallbackBridge, nullptr, (void*)this, NextFrame);
+		if (result == 0)
+		{
+			NextFrame = 0;
+			if (DecodedFrame)
+			{
+				delete[] DecodedFrame->Pixels;
+				delete DecodedFrame;
+			}
+			return nullptr;
+		}
+		NextFrame++;
+	}
+
+	return DecodedFrame;
+}
+
+
+bool tImageGIF::Load(const tString& gifFile)
+{
+	Clear();
+
+	FrameStream stream(gifFile);
+	if (!stream.IsValid())
 		return false;
 
+	while (Frame* frame = stream.ReadNextFrame())
+		Frames.Append(frame);
+
+	if (Frames.GetNumItems() != stream.GetNumFrames())
+	{
+		Clear();
+		return false;
+	}
+
+	Width = stream.GetWidth();
+	Height = stream.GetHeight();
 	SrcPixelFormat = tPixelFormat::PAL_8BIT;
 	return true;
 }
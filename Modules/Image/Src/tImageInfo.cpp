@@ -0,0 +1,546 @@
+// tImageInfo.cpp
+//
+// Probes an image file for its dimensions, pixel format, number of frames, number of mipmaps, and whether it has
+// alpha, without decoding any pixels. For most formats only the first few bytes of the file are read. This is much
+// faster than constructing a tPicture, tImageDDS, or tTexture when all you need is the metadata, for example when
+// indexing a large number of files.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <Foundation/tStandard.h>
+#include <Foundation/tString.h>
+#include <Math/tFundamentals.h>
+#include <System/tFile.h>
+#include <OpenEXR/namespaceAlias.h>
+#include <OpenEXR/IlmImf/ImfMultiPartInputFile.h>
+#include <OpenEXR/IlmImf/ImfHeader.h>
+#include <OpenEXR/IlmImf/ImfChannelList.h>
+#include "Image/tImageInfo.h"
+#include "Image/tImageDDS.h"
+#if defined(PLATFORM_WINDOWS)
+#include "WebP/Windows/include/decode.h"
+#elif defined(PLATFORM_LINUX)
+#include "WebP/Linux/include/decode.h"
+#endif
+using namespace tSystem;
+namespace tImage
+{
+
+
+namespace ImageInfo
+{
+	// Reads small pieces of a file at arbitrary offsets. Only what is asked for is read.
+	struct Reader
+	{
+		Reader(const tString& file)																						: Handle(tOpenFile(file.Chars(), "rb")) { Size = Handle ? tGetFileSize(Handle) : 0; }
+		~Reader()																										{ if (Handle) tCloseFile(Handle); }
+		bool IsValid() const																							{ return Handle ? true : false; }
+
+		// Returns false if the numBytes at offset can't all be read.
+		bool Read(int64 offset, void* dest, int numBytes);
+
+		tFileHandle Handle;
+		int64 Size;
+	};
+
+	int GetLE16(const uint8* b)																							{ return b[0] | (b[1] << 8); }
+	uint32 GetLE32(const uint8* b)																						{ return uint32(b[0]) | (uint32(b[1]) << 8) | (uint32(b[2]) << 16) | (uint32(b[3]) << 24); }
+	int GetBE16(const uint8* b)																							{ return (b[0] << 8) | b[1]; }
+	uint32 GetBE32(const uint8* b)																						{ return (uint32(b[0]) << 24) | (uint32(b[1]) << 16) | (uint32(b[2]) << 8) | uint32(b[3]); }
+
+	// Colour types 4 and 6 are greyscale and truecolour with an alpha channel.
+	bool PNGColourTypeHasAlpha(int colourType)																			{ return (colourType == 4) || (colourType == 6); }
+
+	bool GetInfoTGA(tImageInfo&, const tString& file);
+	bool GetInfoJPG(tImageInfo&, const tString& file);
+	bool GetInfoPNG(tImageInfo&, const tString& file);
+	bool GetInfoDDS(tImageInfo&, const tString& file);
+	bool GetInfoHDR(tImageInfo&, const tString& file);
+	bool GetInfoEXR(tImageInfo&, const tString& file);
+	bool GetInfoGIF(tImageInfo&, const tString& file);
+	bool GetInfoWEBP(tImageInfo&, const tString& file);
+	bool GetInfoICO(tImageInfo&, const tString& file);
+}
+
+
+bool ImageInfo::Reader::Read(int64 offset, void* dest, int numBytes)
+{
+	if (!Handle || (offset < 0) || (offset + numBytes > Size))
+		return false;
+
+	if (tFileSeek(Handle, offset) != 0)
+		return false;
+
+	return tReadFile(Handle, dest, numBytes) == numBytes;
+}
+
+
+bool ImageInfo::GetInfoTGA(tImageInfo& info, const tString& file)
+{
+	// We only need the 18 byte header. The checks are the same as the ones tImageTGA makes.
+	Reader reader(file);
+	uint8 header[18];
+	if (!reader.Read(0, header, 18))
+		return false;
+
+	int colourMapType = header[1];
+	int dataType = header[2];
+	int bitDepth = header[16];
+	if
+	(
+		((bitDepth != 16) && (bitDepth != 24) && (bitDepth != 32)) ||
+		((dataType != 2) && (dataType != 10)) ||
+		((colourMapType != 0) && (colourMapType != 1))
+	)
+		return false;
+
+	info.Width = GetLE16(header + 12);
+	info.Height = GetLE16(header + 14);
+	info.NumFrames = 1;
+	info.NumMipmaps = 1;
+	switch (bitDepth)
+	{
+		case 16:	info.PixelFormat = tPixelFormat::G3B5A1R5G2;	info.HasAlpha = true;	break;
+		case 24:	info.PixelFormat = tPixelFormat::R8G8B8;		info.HasAlpha = false;	break;
+		case 32:	info.PixelFormat = tPixelFormat::R8G8B8A8;		info.HasAlpha = true;	break;
+	}
+	return true;
+}
+
+
+bool ImageInfo::GetInfoJPG(tImageInfo& info, const tString& file)
+{
+	// Walk the markers until we hit a start-of-frame. Each marker is 0xFF, the marker code, and (for all but the
+	// standalone markers) a big-endian length that includes itself. Metadata like exif and icc profiles can be large
+	// so this skips over them rather than reading a fixed size head.
+	Reader reader(file);
+	uint8 buf[9];
+	if (!reader.Read(0, buf, 2) || (buf[0] != 0xFF) || (buf[1] != 0xD8))
+		return false;
+
+	int64 pos = 2;
+	while (reader.Read(pos, buf, 4))
+	{
+		if (buf[0] != 0xFF)
+			return false;
+
+		uint8 marker = buf[1];
+
+		// Any number of 0xFF fill bytes may come before a marker.
+		if (marker == 0xFF)
+		{
+			pos++;
+			continue;
+		}
+
+		// Standalone markers (TEM and RSTn) have no length.
+		if ((marker == 0x01) || ((marker >= 0xD0) && (marker <= 0xD7)))
+		{
+			pos += 2;
+			continue;
+		}
+
+		// Reaching the image data or the end without a frame header means the file is broken.
+		if ((marker == 0xDA) || (marker == 0xD9))
+			return false;
+
+		// SOF0 to SOF15. 0xC4, 0xC8, and 0xCC are DHT, JPG, and DAC which share the range.
+		if ((marker >= 0xC0) && (marker <= 0xCF) && (marker != 0xC4) && (marker != 0xC8) && (marker != 0xCC))
+		{
+			// Marker, length, precision, height, width, and number of components.
+			if (!reader.Read(pos, buf, 9))
+				return false;
+
+			info.Height = GetBE16(buf + 5);
+			info.Width = GetBE16(buf + 7);
+			info.NumFrames = 1;
+			info.NumMipmaps = 1;
+			info.PixelFormat = tPixelFormat::R8G8B8;
+			info.HasAlpha = false;
+			return true;
+		}
+
+		pos += 2 + GetBE16(buf + 2);
+	}
+
+	return false;
+}
+
+
+bool ImageInfo::GetInfoPNG(tImageInfo& info, const tString& file)
+{
+	// The signature is followed by the IHDR chunk which must come first.
+	Reader reader(file);
+	const uint8 signature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+	uint8 head[33];
+	if (!reader.Read(0, head, 33) || tStd::tMemcmp(head, signature, 8) || tStd::tMemcmp(head + 12, "IHDR", 4))
+		return false;
+
+	info.Width = int(GetBE32(head + 16));
+	info.Height = int(GetBE32(head + 20));
+	info.NumFrames = 1;
+	info.NumMipmaps = 1;
+	int colourType = head[25];
+	bool hasAlpha = PNGColourTypeHasAlpha(colourType);
+
+	// Images without an alpha channel may still have transparency in a tRNS chunk. It must come before the first
+	// IDAT, so we only need to look at the chunk headers up to there.
+	int64 pos = 33;
+	uint8 chunk[8];
+	while (!hasAlpha && reader.Read(pos, chunk, 8))
+	{
+		if (!tStd::tMemcmp(chunk + 4, "IDAT", 4) || !tStd::tMemcmp(chunk + 4, "IEND", 4))
+			break;
+
+		if (!tStd::tMemcmp(chunk + 4, "tRNS", 4))
+			hasAlpha = true;
+
+		// Length, type, data, and crc.
+		pos += 12 + int64(GetBE32(chunk));
+	}
+
+	// Same as what tPicture reports after loading a png.
+	info.PixelFormat = hasAlpha ? tPixelFormat::R8G8B8A8 : tPixelFormat::R8G8B8;
+	info.HasAlpha = hasAlpha;
+	return true;
+}
+
+
+bool ImageInfo::GetInfoDDS(tImageInfo& info, const tString& file)
+{
+	// The magic number and the 124 byte header.
+	Reader reader(file);
+	uint8 head[128];
+	if (!reader.Read(0, head, 128))
+		return false;
+
+	if (!tImageDDS::GetHeaderInfo(head, 128, info.Width, info.Height, info.NumMipmaps, info.IsCubemap, info.PixelFormat))
+		return false;
+
+	info.NumFrames = 1;
+	switch (info.PixelFormat)
+	{
+		case tPixelFormat::B8G8R8A8:
+		case tPixelFormat::BC2_DXT3:
+		case tPixelFormat::BC3_DXT5:
+		case tPixelFormat::G3B5A1R5G2:
+		case tPixelFormat::G4B4A4R4:
+			info.HasAlpha = true;
+			break;
+
+		default:
+			info.HasAlpha = false;
+			break;
+	}
+	return true;
+}
+
+
+bool ImageInfo::GetInfoHDR(tImageInfo& info, const tString& file)
+{
+	// The text header ends with a blank line and is followed by the resolution line. Headers are short so a small
+	// head of the file is plenty.
+	const int maxHeadSize = 4096;
+	uint8 head[maxHeadSize + 1];
+	int headSize = maxHeadSize;
+	tLoadFileHead(file, headSize, head);
+	if (headSize <= 0)
+		return false;
+	head[headSize] = '\0';
+
+	char* blankLine = nullptr;
+	for (int c = 0; c < headSize - 1; c++)
+	{
+		if ((head[c] == 0x0A) && (head[c+1] == 0x0A))
+		{
+			blankLine = (char*)&head[c];
+			break;
+		}
+
+		// We are not allowed any '\0' characters in the header. Some Mac-generated images have one!
+		if (head[c] == '\0')
+			head[c] = '_';
+	}
+	if (!blankLine)
+		return false;
+
+	char* resLine = blankLine + 2;
+	char* eol = tStd::tStrchr(resLine, '\n');
+	if (!eol)
+		return false;
+	*eol = '\0';
+
+	// Like tImageHDR we only support the standard -Y height +X width orientation.
+	tList<tStringItem> comps;
+	tStd::tExplode(comps, tString(resLine), ' ');
+	if ((comps.GetNumItems() != 4) || (*comps.First() != "-Y") || (*comps.First()->Next()->Next() != "+X"))
+		return false;
+
+	info.Height = comps.First()->Next()->AsInt();
+	info.Width = comps.Last()->AsInt();
+	info.NumFrames = 1;
+	info.NumMipmaps = 1;
+	info.PixelFormat = tPixelFormat::HDR_RAD;
+	info.HasAlpha = false;
+	return true;
+}
+
+
+bool ImageInfo::GetInfoEXR(tImageInfo& info, const tString& file)
+{
+	// Opening the file only reads the headers and the chunk offset tables.
+	try
+	{
+		IMF::MultiPartInputFile mpfile(file.Chars());
+		int numParts = mpfile.parts();
+		if (numParts <= 0)
+			return false;
+
+		// tImageEXR loads the data window.
+		const IMF::Header& header = mpfile.header(0);
+		const IMATH::Box2i& dataWindow = header.dataWindow();
+		info.Width = dataWindow.max.x - dataWindow.min.x + 1;
+		info.Height = dataWindow.max.y - dataWindow.min.y + 1;
+		info.NumFrames = numParts;
+		info.NumMipmaps = 1;
+		info.PixelFormat = tPixelFormat::HDR_EXR;
+		info.HasAlpha = header.channels().findChannel("A") ? true : false;
+	}
+	catch (IEX_NAMESPACE::BaseExc&)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+bool ImageInfo::GetInfoGIF(tImageInfo& info, const tString& file)
+{
+	// Counting the frames means walking every block in the file. Only the block headers and sub-block lengths are
+	// read. The image data is skipped over. The opacity rules are the same as tImageGIF::FrameStream's.
+	Reader reader(file);
+	uint8 head[13];
+	if (!reader.Read(0, head, 13) || tStd::tMemcmp(head, "GIF8", 4))
+		return false;
+
+	int width = GetLE16(head + 6);
+	int height = GetLE16(head + 8);
+	if ((width <= 0) || (height <= 0))
+		return false;
+
+	// Skips the logical screen descriptor and the global palette if there is one.
+	uint8 screenFlags = head[10];
+	int64 pos = 13 + ((screenFlags & 0x80) ? 3 * (2 << (screenFlags & 0x07)) : 0);
+
+	// Skips a run of data sub-blocks. Returns false if the file ends first.
+	auto skipSubBlocks = [&reader](int64& pos) -> bool
+	{
+		uint8 length = 0;
+		while (reader.Read(pos++, &length, 1))
+		{
+			if (!length)
+				return true;
+			pos += length;
+		}
+		return false;
+	};
+
+	int numFrames = 0;
+	bool opaque = true;
+	uint8 block[10];
+	while (reader.Read(pos++, block, 1))
+	{
+		if (block[0] == 0x21)
+		{
+			// Extension. A graphic control extension with the transparency bit set means the frame has transparent
+			// pixels.
+			if (reader.Read(pos, block, 3) && (block[0] == 0xF9) && (block[1] >= 4) && (block[2] & 0x01))
+				opaque = false;
+			pos++;
+			if (!skipSubBlocks(pos))
+				break;
+		}
+		else if (block[0] == 0x2C)
+		{
+			// Image descriptor, optional local palette, LZW minimum code size, and the image sub-blocks. A frame that
+			// doesn't cover the whole canvas leaves transparent pixels.
+			if (!reader.Read(pos, block, 10))
+				break;
+			int frameX = GetLE16(block);
+			int frameY = GetLE16(block + 2);
+			int frameW = GetLE16(block + 4);
+			int frameH = GetLE16(block + 6);
+			if ((frameX > 0) || (frameY > 0) || (frameX + frameW < width) || (frameY + frameH < height))
+				opaque = false;
+			uint8 frameFlags = block[8];
+			pos += 9 + ((frameFlags & 0x80) ? 3 * (2 << (frameFlags & 0x07)) : 0) + 1;
+			if (!skipSubBlocks(pos))
+				break;
+			numFrames++;
+		}
+		else
+		{
+			// Trailer, or something we don't understand.
+			break;
+		}
+	}
+
+	if (numFrames <= 0)
+		return false;
+
+	info.Width = width;
+	info.Height = height;
+	info.NumFrames = numFrames;
+	info.NumMipmaps = 1;
+	info.PixelFormat = tPixelFormat::PAL_8BIT;
+	info.HasAlpha = !opaque;
+	return true;
+}
+
+
+bool ImageInfo::GetInfoWEBP(tImageInfo& info, const tString& file)
+{
+	// The RIFF header and the first chunk are enough for libwebp to get the canvas size, alpha, and whether it's
+	// animated. The first chunk is VP8X for extended files and has a fixed size. For simple files it is the start of
+	// the bitstream.
+	Reader reader(file);
+	const int maxHeadSize = 64;
+	uint8 head[maxHeadSize];
+	int headSize = int(tMath::tMin(reader.Size, int64(maxHeadSize)));
+	if ((headSize < 12) || !reader.Read(0, head, headSize))
+		return false;
+
+	WebPBitstreamFeatures features;
+	if (WebPGetFeatures(head, headSize, &features) != VP8_STATUS_OK)
+		return false;
+
+	info.Width = features.width;
+	info.Height = features.height;
+	info.NumFrames = 1;
+	info.NumMipmaps = 1;
+	info.PixelFormat = features.has_alpha ? tPixelFormat::R8G8B8A8 : tPixelFormat::R8G8B8;
+	info.HasAlpha = features.has_alpha ? true : false;
+	if (!features.has_animation)
+		return true;
+
+	// Animated. Count the ANMF chunks by hopping from chunk header to chunk header. Chunks are padded to an even size.
+	int numFrames = 0;
+	int64 pos = 12;
+	uint8 chunk[8];
+	while (reader.Read(pos, chunk, 8))
+	{
+		if (!tStd::tMemcmp(chunk, "ANMF", 4))
+			numFrames++;
+
+		uint32 chunkSize = GetLE32(chunk + 4);
+		pos += 8 + int64(chunkSize) + (chunkSize & 1);
+	}
+
+	if (numFrames <= 0)
+		return false;
+
+	info.NumFrames = numFrames;
+	return true;
+}
+
+
+bool ImageInfo::GetInfoICO(tImageInfo& info, const tString& file)
+{
+	// The icon directory is 6 bytes followed by a 16 byte entry for each image. Only the first image's header is
+	// read since that's the part tPicture loads by default.
+	Reader reader(file);
+	uint8 dir[6 + 16];
+	if (!reader.Read(0, dir, 6 + 16))
+		return false;
+
+	// Same limits as tImageICO.
+	int numImages = GetLE16(dir + 4);
+	if ((GetLE16(dir) != 0) || (GetLE16(dir + 2) != 1) || (numImages == 0) || (numImages > 20))
+		return false;
+
+	const uint8* entry = dir + 6;
+	int width = entry[0] ? entry[0] : 256;
+	int height = entry[1] ? entry[1] : 256;
+	int64 offset = GetLE32(entry + 12);
+
+	// Either a 40 byte bitmap info header or an embedded png. We read enough for the png IHDR.
+	uint8 image[40];
+	if (!offset || !reader.Read(offset, image, 40))
+		return false;
+
+	if (GetLE32(image) == 0x474e5089)
+	{
+		width = int(GetBE32(image + 16));
+		height = int(GetBE32(image + 20));
+		info.HasAlpha = PNGColourTypeHasAlpha(image[25]);
+		info.PixelFormat = info.HasAlpha ? tPixelFormat::R8G8B8A8 : tPixelFormat::R8G8B8;
+	}
+	else
+	{
+		// The bitmap height includes the AND mask. If there is a mask it makes some pixels transparent.
+		int bitCount = GetLE16(image + 14);
+		int bitmapHeight = int(GetLE32(image + 8));
+		bool hasAndMask = (bitCount < 32) && (height != bitmapHeight);
+		switch (bitCount)
+		{
+			case 32:	info.PixelFormat = tPixelFormat::R8G8B8A8;	break;
+			case 24:	info.PixelFormat = tPixelFormat::R8G8B8;	break;
+			case 8:		info.PixelFormat = tPixelFormat::PAL_8BIT;	break;
+			case 4:		info.PixelFormat = tPixelFormat::PAL_4BIT;	break;
+			case 1:		info.PixelFormat = tPixelFormat::PAL_1BIT;	break;
+			default:	return false;
+		}
+		info.HasAlpha = (bitCount == 32) || hasAndMask;
+	}
+
+	info.Width = width;
+	info.Height = height;
+	info.NumFrames = numImages;
+	info.NumMipmaps = 1;
+	return true;
+}
+
+
+bool tGetImageInfo(tImageInfo& info, const tString& imageFile)
+{
+	info.Clear();
+	if (!tFileExists(imageFile))
+		return false;
+
+	tFileType fileType = tGetFileType(imageFile);
+	bool ok = false;
+	switch (fileType)
+	{
+		case tFileType::TGA:	ok = ImageInfo::GetInfoTGA(info, imageFile);		break;
+		case tFileType::JPG:	ok = ImageInfo::GetInfoJPG(info, imageFile);		break;
+		case tFileType::PNG:	ok = ImageInfo::GetInfoPNG(info, imageFile);		break;
+		case tFileType::DDS:	ok = ImageInfo::GetInfoDDS(info, imageFile);		break;
+		case tFileType::HDR:	ok = ImageInfo::GetInfoHDR(info, imageFile);		break;
+		case tFileType::EXR:	ok = ImageInfo::GetInfoEXR(info, imageFile);		break;
+		case tFileType::GIF:	ok = ImageInfo::GetInfoGIF(info, imageFile);		break;
+		case tFileType::WEBP:	ok = ImageInfo::GetInfoWEBP(info, imageFile);		break;
+		case tFileType::ICO:	ok = ImageInfo::GetInfoICO(info, imageFile);		break;
+		default:				break;
+	}
+
+	if (!ok || !info.IsValid())
+	{
+		info.Clear();
+		return false;
+	}
+
+	info.FileType = fileType;
+	return true;
+}
+
+
+}
@@ -28,7 +28,7 @@ namespace tImage
 {
 
 
-bool tImageJPG::Load(const tString& jpgFile)
+bool tImageJPG::Load(const tString& jpgFile, int minWidth, int minHeight, bool fastDecode)
 {
 	Clear();
 
@@ -40,14 +40,14 @@ bool tImageJPG::Load(const tString& jpgFile)
 
 	int numBytes = 0;
 	uint8* jpgFileInMemory = tLoadFile(jpgFile, nullptr, &numBytes);
-	bool success = Set(jpgFileInMemory, numBytes);
+	bool success = Set(jpgFileInMemory, numBytes, minWidth, minHeight, fastDecode);
 	delete[] jpgFileInMemory;
 
 	return success;
 }
 
 
-bool tImageJPG::Set(const uint8* jpgFileInMemory, int numBytes)
+bool tImageJPG::Set(const uint8* jpgFileInMemory, int numBytes, int minWidth, int minHeight, bool fastDecode)
 {
 	Clear();
 	if ((numBytes <= 0) || !jpgFileInMemory)
@@ -59,20 +59,58 @@ bool tImageJPG::Set(const uint8* jpgFileInMemory, int numBytes)
 
 	int subSamp = 0;
 	int colourSpace = 0;
-	int headerResult = tjDecompressHeader3(tjInstance, jpgFileInMemory, numBytes, &Width, &Height, &subSamp, &colourSpace);
+	int headerResult = tjDecompressHeader3(tjInstance, jpgFileInMemory, numBytes, &SrcWidth, &SrcHeight, &subSamp, &colourSpace);
 	if (headerResult < 0)
+	{
+		tjDestroy(tjInstance);
+		Clear();
 		return false;
+	}
+
+	// Choose the smallest supported scale that still meets the minimum size. The list is not sorted so we check them
+	// all. Scales greater than 1 are skipped since upsampling here would only make a thumbnail slower.
+	Width = SrcWidth;
+	Height = SrcHeight;
+	if ((minWidth > 0) || (minHeight > 0))
+	{
+		int numFactors = 0;
+		tjscalingfactor* factors = tjGetScalingFactors(&numFactors);
+		for (int f = 0; f < numFactors; f++)
+		{
+			tjscalingfactor factor = factors[f];
+			if (factor.num > factor.denom)
+				continue;
+
+			int scaledWidth = TJSCALED(SrcWidth, factor);
+			int scaledHeight = TJSCALED(SrcHeight, factor);
+			if ((scaledWidth < minWidth) || (scaledHeight < minHeight))
+				continue;
+
+			if (int64(scaledWidth)*scaledHeight < int64(Width)*Height)
+			{
+				Width = scaledWidth;
+				Height = scaledHeight;
+			}
+		}
+	}
 
 	int numPixels = Width * Height;
 	Pixels = new tPixel[numPixels];
 
-    int jpgPixelFormat = TJPF_RGBA;
+	int jpgPixelFormat = TJPF_RGBA;
 	int flags = 0;
 	flags |= TJFLAG_BOTTOMUP;
-	//flags |= TJFLAG_FASTUPSAMPLE;
-	//flags |= TJFLAG_FASTDCT;
-	flags |= TJFLAG_ACCURATEDCT;
+	if (fastDecode)
+	{
+		flags |= TJFLAG_FASTUPSAMPLE;
+		flags |= TJFLAG_FASTDCT;
+	}
+	else
+	{
+		flags |= TJFLAG_ACCURATEDCT;
+	}
 
+	// Passing the scaled dimensions is how libjpeg-turbo is told which scaling factor to use.
 	int decomResult = tjDecompress2(tjInstance, jpgFileInMemory, numBytes, (uint8*)Pixels, Width, 0, Height,
 		jpgPixelFormat, flags);
 	tjDestroy(tjInstance);
@@ -95,6 +133,8 @@ bool tImageJPG::Set(tPixel* pixels, int width, int height, bool steal)
 
 	Width = width;
 	Height = height;
+	SrcWidth = width;
+	SrcHeight = height;
 	if (steal)
 	{
 		Pixels = pixels;
@@ -161,6 +201,8 @@ tPixel* tImageJPG::StealPixels()
 	Pixels = nullptr;
 	Width = 0;
 	Height = 0;
+	SrcWidth = 0;
+	SrcHeight = 0;
 	return pixels;
 }
 
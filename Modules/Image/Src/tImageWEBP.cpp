@@ -27,9 +27,31 @@ namespace tImage
 {
 
 
-bool tImageWEBP::Load(const tString& webpFile)
+// Draws src over dst the same way the WebP animation decoder does for non-premultiplied alpha. Opaque pixels are
+// returned as they are since the blend would round them down.
+static tPixel BlendPixel(const tPixel& src, const tPixel& dst)
 {
-	Clear();
+	if (src.A == 0xFF)
+		return src;
+	if (src.A == 0)
+		return dst;
+
+	uint32 dstFactorA = (dst.A * (256 - src.A)) >> 8;
+	uint32 blendA = src.A + dstFactorA;
+	uint32 scale = (1u << 24) / blendA;
+	return tPixel
+	(
+		uint8(((src.R*src.A + dst.R*dstFactorA) * scale) >> 24),
+		uint8(((src.G*src.A + dst.G*dstFactorA) * scale) >> 24),
+		uint8(((src.B*src.A + dst.B*dstFactorA) * scale) >> 24),
+		uint8(blendA)
+	);
+}
+
+
+bool tImageWEBP::FrameStream::Open(const tString& webpFile)
+{
+	Close();
 
 	if (tSystem::tGetFileType(webpFile) != tSystem::tFileType::WEBP)
 		return false;
@@ -37,62 +59,216 @@ bool tImageWEBP::Load(const tString& webpFile)
 	if (!tFileExists(webpFile))
 		return false;
 
-	int numBytes = 0;
-	uint8* webpFileInMemory = tLoadFile(webpFile, nullptr, &numBytes);
+	// The demuxer keeps pointers into the file data so it must stay around until Close.
+	FileData = tLoadFile(webpFile, nullptr, &FileSize);
+	if (!FileData)
+		return false;
 
-	// Now we load and populate the frames.
 	WebPData webpData;
-	webpData.bytes = webpFileInMemory;
-	webpData.size = numBytes;
-
-	WebPDemuxer* demux = WebPDemux(&webpData);
-	uint32 width = WebPDemuxGetI(demux, WEBP_FF_CANVAS_WIDTH);
-	uint32 height = WebPDemuxGetI(demux, WEBP_FF_CANVAS_HEIGHT);
-	uint32 flags = WebPDemuxGetI(demux, WEBP_FF_FORMAT_FLAGS);
-	uint32 numFrames = WebPDemuxGetI(demux, WEBP_FF_FRAME_COUNT);
-	
-	if ((width <= 0) || (height <= 0) || (numFrames <= 0))
+	webpData.bytes = FileData;
+	webpData.size = FileSize;
+	Demux = WebPDemux(&webpData);
+	if (!Demux)
 	{
-		WebPDemuxDelete(demux);
+		Close();
 		return false;
 	}
 
-	// Iterate over all frames.
-	SrcPixelFormat = tPixelFormat::R8G8B8;
+	Width = int(WebPDemuxGetI(Demux, WEBP_FF_CANVAS_WIDTH));
+	Height = int(WebPDemuxGetI(Demux, WEBP_FF_CANVAS_HEIGHT));
+	NumFrames = int(WebPDemuxGetI(Demux, WEBP_FF_FRAME_COUNT));
+	if ((Width <= 0) || (Height <= 0) || (NumFrames <= 0) || !IndexKeyFrames())
+	{
+		Close();
+		return false;
+	}
+
+	Canvas = new tPixel[Width * Height];
+	Disposed = new tPixel[Width * Height];
+	return true;
+}
+
+
+bool tImageWEBP::FrameStream::IndexKeyFrames()
+{
+	// These are the same rules the WebP animation decoder uses. A frame that covers the whole canvas and doesn't blend
+	// replaces everything. So does any frame drawn after a key frame, or a full frame, that was disposed to background.
+	KeyFrames = new bool[NumFrames];
+	bool prevFull = false;
+	bool prevDisposeBackground = false;
+	for (int f = 0; f < NumFrames; f++)
+	{
+		// Demux frame numbers start at 1.
+		WebPIterator iter;
+		if (!WebPDemuxGetFrame(Demux, f+1, &iter))
+			return false;
+
+		bool full = (iter.width == Width) && (iter.height == Height);
+		bool noBlend = !iter.has_alpha || (iter.blend_method == WEBP_MUX_NO_BLEND);
+		KeyFrames[f] = (f == 0) || (full && noBlend) || (prevDisposeBackground && (prevFull || KeyFrames[f-1]));
+
+		prevFull = full;
+		prevDisposeBackground = (iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND);
+		WebPDemuxReleaseIterator(&iter);
+	}
+
+	return true;
+}
+
+
+void tImageWEBP::FrameStream::Close()
+{
+	if (Demux)
+		WebPDemuxDelete(Demux);
+	Demux = nullptr;
+	delete[] FileData;
+	FileData = nullptr;
+	FileSize = 0;
+	Width = 0;
+	Height = 0;
+	NumFrames = 0;
+	delete[] KeyFrames;
+	KeyFrames = nullptr;
+	NextFrame = 0;
+
+	delete[] Canvas;
+	Canvas = nullptr;
+	delete[] Disposed;
+	Disposed = nullptr;
+	PrevX = PrevY = PrevW = PrevH = 0;
+	PrevDisposeBackground = false;
+	FrameDuration = 0;
+	FrameHasAlpha = false;
+}
+
+
+bool tImageWEBP::FrameStream::DecodeFrame(int frameNum)
+{
 	WebPIterator iter;
-	if (WebPDemuxGetFrame(demux, 1, &iter))
+	if (!WebPDemuxGetFrame(Demux, frameNum+1, &iter))
+		return false;
+
+	int x = iter.x_offset;
+	int y = iter.y_offset;
+	int w = iter.width;
+	int h = iter.height;
+	if ((x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (x + w > Width) || (y + h > Height))
 	{
-		do
+		WebPDemuxReleaseIterator(&iter);
+		return false;
+	}
+
+	// A key frame starts from a transparent canvas. Anything else is drawn over what the previous frame left.
+	int numPixels = Width * Height;
+	bool keyFrame = KeyFrames[frameNum];
+	if (keyFrame)
+		tStd::tMemset(Canvas, 0, numPixels*sizeof(tPixel));
+	else
+		tStd::tMemcpy(Canvas, Disposed, numPixels*sizeof(tPixel));
+
+	// The frame is decoded straight into its rectangle on the canvas.
+	int offset = y*Width + x;
+	uint8* decoded = WebPDecodeRGBAInto
+	(
+		iter.fragment.bytes, iter.fragment.size,
+		(uint8*)(Canvas + offset), (numPixels - offset)*sizeof(tPixel), Width*sizeof(tPixel)
+	);
+	if (!decoded)
+	{
+		WebPDemuxReleaseIterator(&iter);
+		return false;
+	}
+
+	// Pixels inside the previous rectangle were cleared if it was disposed to background. Blending over transparent
+	// leaves them unchanged so they are skipped.
+	if (!keyFrame && (iter.blend_method == WEBP_MUX_BLEND))
+	{
+		for (int row = y; row < y + h; row++)
 		{
-			WebPDecoderConfig config;
-			WebPInitDecoderConfig(&config);
-
-			config.output.colorspace = MODE_RGBA;
-			config.output.is_external_memory = 0;
-			config.options.flip = 1;
-			int result = WebPDecode(iter.fragment.bytes, iter.fragment.size, &config);
-			if (result != VP8_STATUS_OK)
-				continue;
-
-			Frame* newFrame = new Frame;
-			newFrame->SrcPixelFormat = iter.has_alpha ? tPixelFormat::R8G8B8A8 : tPixelFormat::R8G8B8;
-			if (iter.has_alpha)
-				SrcPixelFormat = tPixelFormat::R8G8B8A8;
-			newFrame->Width = width;
-			newFrame->Height = height;
-			newFrame->Pixels = new tPixel[width * height];
-			newFrame->Duration = float(iter.duration) / 1000.0f;
-
-			tStd::tMemcpy(newFrame->Pixels, config.output.u.RGBA.rgba, width * height * sizeof(tPixel));
-			WebPFreeDecBuffer(&config.output);
-			Frames.Append(newFrame);
+			for (int col = x; col < x + w; col++)
+			{
+				bool insidePrev = (col >= PrevX) && (col < PrevX + PrevW) && (row >= PrevY) && (row < PrevY + PrevH);
+				if (PrevDisposeBackground && insidePrev)
+					continue;
+				int index = row*Width + col;
+				Canvas[index] = BlendPixel(Canvas[index], Disposed[index]);
+			}
 		}
-		while (WebPDemuxNextFrame(&iter));
+	}
 
-		WebPDemuxReleaseIterator(&iter);
+	tStd::tMemcpy(Disposed, Canvas, numPixels*sizeof(tPixel));
+	PrevDisposeBackground = (iter.dispose_method == WEBP_MUX_DISPOSE_BACKGROUND);
+	if (PrevDisposeBackground)
+		for (int row = y; row < y + h; row++)
+			tStd::tMemset(Disposed + row*Width + x, 0, w*sizeof(tPixel));
+
+	PrevX = x; PrevY = y; PrevW = w; PrevH = h;
+	FrameDuration = iter.duration;
+	FrameHasAlpha = iter.has_alpha ? true : false;
+	WebPDemuxReleaseIterator(&iter);
+	return true;
+}
+
+
+tImageWEBP::Frame* tImageWEBP::FrameStream::ReadFrame(int frameNum)
+{
+	if (!IsValid() || (frameNum < 0) || (frameNum >= NumFrames))
+		return nullptr;
+
+	// Unless the canvas is already somewhere between the closest key frame and the one we want, start at the key frame.
+	int keyFrame = frameNum;
+	while (!KeyFrames[keyFrame])
+		keyFrame--;
+	if ((NextFrame > frameNum) || (NextFrame < keyFrame))
+		NextFrame = keyFrame;
+
+	while (NextFrame <= frameNum)
+	{
+		if (!DecodeFrame(NextFrame))
+		{
+			NextFrame = 0;
+			return nullptr;
+		}
+		NextFrame++;
+	}
+
+	Frame* frame = new Frame;
+	frame->Width = Width;
+	frame->Height = Height;
+	frame->Pixels = new tPixel[Width * Height];
+	frame->Duration = float(FrameDuration) / 1000.0f;
+	frame->SrcPixelFormat = FrameHasAlpha ? tPixelFormat::R8G8B8A8 : tPixelFormat::R8G8B8;
+
+	// We store rows starting from the bottom (lower left is 0,0).
+	for (int row = 0; row < Height; row++)
+		tStd::tMemcpy(frame->Pixels + (row*Width), Canvas + (Height-row-1)*Width, Width*sizeof(tPixel));
+
+	return frame;
+}
+
+
+bool tImageWEBP::Load(const tString& webpFile)
+{
+	Clear();
+
+	FrameStream stream(webpFile);
+	if (!stream.IsValid())
+		return false;
+
+	SrcPixelFormat = tPixelFormat::R8G8B8;
+	while (Frame* frame = stream.ReadNextFrame())
+	{
+		if (frame->SrcPixelFormat == tPixelFormat::R8G8B8A8)
+			SrcPixelFormat = tPixelFormat::R8G8B8A8;
+		Frames.Append(frame);
+	}
+
+	if (Frames.GetNumItems() != stream.GetNumFrames())
+	{
+		Clear();
+		return false;
 	}
 
-	WebPDemuxDelete(demux);
 	return true;
 }
 
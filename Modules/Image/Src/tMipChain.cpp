@@ -0,0 +1,623 @@
+// tMipChain.cpp
+//
+// A tMipChain holds every mipmap level of an image, from the full size image down to 1x1, in a single contiguous
+// allocation of tPixels. The levels are generated in one call. Each level is a 2:1 reduction of the one above it, with
+// the intermediate levels kept in floating point so rounding errors don't accumulate down the chain. Filtering may
+// optionally be done in linear light, which stops sRGB images from darkening as they get smaller. The inner loops have
+// SSE2 and AVX2 paths with a scalar fallback, and large levels are split across the shared job system.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <Math/tFundamentals.h>
+#include <System/tJobSystem.h>
+#include <Image/tMipChain.h>
+
+// Same scheme as the resampler. SSE2 is part of the x64 baseline and the AVX2 functions are compiled for AVX2 on a
+// per-function basis.
+#if defined(ARCHITECTURE_X64)
+#define MIPCHAIN_SIMD
+#include <immintrin.h>
+#if defined(PLATFORM_WINDOWS)
+#define MIPCHAIN_AVX2
+#else
+#define MIPCHAIN_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+namespace MipChain
+{
+	const int MinParallelPixels = 128*128;
+	const int RowsPerBatch = 8;
+
+	// The Kaiser filter is evaluated at a 2:1 scale so it covers 12 source pixels. The window for destination pixel x
+	// starts 5 pixels to the left of source pixel 2x.
+	const int KaiserTaps = 12;
+	const int KaiserPadLeft = 5;
+	const int KaiserPadRight = KaiserTaps - KaiserPadLeft - 2;
+	const float* GetKaiserWeights();
+
+	// Scratch rows shared by the rows of a level that are in flight at once. ParallelFor splits the work into at most
+	// one job per job system thread, fewer if maxConcurrency is lower, and each job does its rows one at a time. Any
+	// thread may help run those jobs, including ones waiting on other ParallelFor calls, but there are never more rows
+	// in flight than jobs. With one slot per job Claim finds a free slot straight away. Should that ever not hold it
+	// spins until another row releases its slot.
+	struct ScratchRows
+	{
+		ScratchRows(int numSlots, int64 slotSize);
+		~ScratchRows()																									{ delete[] Memory; delete[] InUse; }
+		float* Claim();
+		void Release(const float* slot)																					{ InUse[(slot - Memory) / SlotSize].store(false, std::memory_order_release); }
+
+		int NumSlots;
+		int64 SlotSize;
+		float* Memory;
+		std::atomic<bool>* InUse;
+	};
+
+	// Working values are 4 floats per pixel in [0, 255]. When gamma correcting, the colour channels are linear light
+	// scaled to the same range. ToLinear decodes an sRGB byte. Thresholds[k] is the linear value halfway between sRGB
+	// bytes k and k+1, so encoding is a search that rounds correctly.
+	struct GammaTables
+	{
+		GammaTables();
+		float ToLinear[256];
+		float Thresholds[255];
+	};
+	const GammaTables& GetGammaTables();
+
+	typedef void LoadRowFunction(float* dst, const tPixel* src, int count);
+	typedef void StoreRowFunction(tPixel* dst, const float* src, int count);
+	typedef void BoxRowFunction(float* dst, const float* row0, const float* row1, int dstWidth);
+	typedef void KaiserRowFunction(float* dst, const float* padded, int dstWidth, const float* weights);
+	typedef void KaiserColumnFunction(float* dst, const float* const* rows, int width, const float* weights);
+
+	struct Kernels
+	{
+		LoadRowFunction* LoadRow;
+		StoreRowFunction* StoreRow;
+		BoxRowFunction* BoxRow;
+		KaiserRowFunction* KaiserRow;
+		KaiserColumnFunction* KaiserColumn;
+	};
+	void GetKernels(Kernels&, tImage::tResamplePath, bool gammaCorrect);
+
+	void LoadRowGamma(float* dst, const tPixel* src, int count);
+	void StoreRowGamma(tPixel* dst, const float* src, int count);
+	void LoadRowScalar(float* dst, const tPixel* src, int count);
+	void StoreRowScalar(tPixel* dst, const float* src, int count);
+	void BoxRowScalar(float* dst, const float* row0, const float* row1, int dstWidth);
+	void KaiserRowScalar(float* dst, const float* padded, int dstWidth, const float* weights);
+	void KaiserColumnScalar(float* dst, const float* const* rows, int width, const float* weights);
+
+	#ifdef MIPCHAIN_SIMD
+	void LoadRowSSE2(float* dst, const tPixel* src, int count);
+	void StoreRowSSE2(tPixel* dst, const float* src, int count);
+	void BoxRowSSE2(float* dst, const float* row0, const float* row1, int dstWidth);
+	void KaiserRowSSE2(float* dst, const float* padded, int dstWidth, const float* weights);
+	void KaiserColumnSSE2(float* dst, const float* const* rows, int width, const float* weights);
+
+	// The AVX2 functions work on two pixels, or two taps, per register. Loads and stores are cheap enough that the
+	// SSE2 versions are used for those.
+	MIPCHAIN_AVX2 void BoxRowAVX2(float* dst, const float* row0, const float* row1, int dstWidth);
+	MIPCHAIN_AVX2 void KaiserRowAVX2(float* dst, const float* padded, int dstWidth, const float* weights);
+	MIPCHAIN_AVX2 void KaiserColumnAVX2(float* dst, const float* const* rows, int width, const float* weights);
+	#endif
+}
+
+
+const float* MipChain::GetKaiserWeights()
+{
+	struct Weights
+	{
+		Weights()
+		{
+			// Tap t is centred (t - 5.5) source pixels from the destination centre, which is 2.75 at the 2:1 scale.
+			float sum = 0.0f;
+			for (int t = 0; t < KaiserTaps; t++)
+			{
+				Values[t] = tImage::tEvaluateResampleFilter(tImage::tResampleFilter::Kaiser, (float(t) - 5.5f) / 2.0f);
+				sum += Values[t];
+			}
+			for (int t = 0; t < KaiserTaps; t++)
+				Values[t] /= sum;
+		}
+		float Values[KaiserTaps];
+	};
+	static Weights weights;
+	return weights.Values;
+}
+
+
+MipChain::GammaTables::GammaTables()
+{
+	auto decode = [](float c) -> float
+	{
+		return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	};
+
+	for (int i = 0; i < 256; i++)
+		ToLinear[i] = decode(float(i) / 255.0f) * 255.0f;
+	for (int i = 0; i < 255; i++)
+		Thresholds[i] = decode((float(i) + 0.5f) / 255.0f) * 255.0f;
+}
+
+
+MipChain::ScratchRows::ScratchRows(int numSlots, int64 slotSize) :
+	NumSlots(numSlots),
+	SlotSize(slotSize),
+	Memory(new float[numSlots*slotSize]),
+	InUse(new std::atomic<bool>[numSlots])
+{
+	for (int s = 0; s < NumSlots; s++)
+		InUse[s].store(false, std::memory_order_relaxed);
+}
+
+
+float* MipChain::ScratchRows::Claim()
+{
+	while (true)
+	{
+		for (int s = 0; s < NumSlots; s++)
+		{
+			bool inUse = false;
+			if (!InUse[s].load(std::memory_order_relaxed) && InUse[s].compare_exchange_strong(inUse, true, std::memory_order_acquire))
+				return Memory + s*SlotSize;
+		}
+		std::this_thread::yield();
+	}
+}
+
+
+const MipChain::GammaTables& MipChain::GetGammaTables()
+{
+	static GammaTables tables;
+	return tables;
+}
+
+
+void MipChain::LoadRowGamma(float* dst, const tPixel* src, int count)
+{
+	const float* toLinear = GetGammaTables().ToLinear;
+	for (int x = 0; x < count; x++, dst += 4)
+	{
+		dst[0] = toLinear[src[x].R];
+		dst[1] = toLinear[src[x].G];
+		dst[2] = toLinear[src[x].B];
+		dst[3] = float(src[x].A);
+	}
+}
+
+
+void MipChain::StoreRowGamma(tPixel* dst, const float* src, int count)
+{
+	const float* thresholds = GetGammaTables().Thresholds;
+	for (int x = 0; x < count; x++, src += 4)
+	{
+		// The number of thresholds at or below the value is the nearest sRGB byte.
+		uint8 rgb[3];
+		for (int c = 0; c < 3; c++)
+			rgb[c] = uint8(std::upper_bound(thresholds, thresholds + 255, src[c]) - thresholds);
+		int a = tMath::tClamp(int(std::nearbyint(src[3])), 0, 255);
+		dst[x].Set(rgb[0], rgb[1], rgb[2], a);
+	}
+}
+
+
+void MipChain::LoadRowScalar(float* dst, const tPixel* src, int count)
+{
+	for (int x = 0; x < count; x++, dst += 4)
+		for (int c = 0; c < 4; c++)
+			dst[c] = float(src[x].E[c]);
+}
+
+
+void MipChain::StoreRowScalar(tPixel* dst, const float* src, int count)
+{
+	// Round to nearest even, the same as the SIMD conversions.
+	for (int x = 0; x < count; x++, src += 4)
+		for (int c = 0; c < 4; c++)
+			dst[x].E[c] = uint8(tMath::tClamp(int(std::nearbyint(src[c])), 0, 255));
+}
+
+
+void MipChain::BoxRowScalar(float* dst, const float* row0, const float* row1, int dstWidth)
+{
+	// The sums are done in the same order as the SIMD versions so all paths give identical results.
+	for (int x = 0; x < dstWidth; x++, dst += 4, row0 += 8, row1 += 8)
+		for (int c = 0; c < 4; c++)
+			dst[c] = ((row0[c] + row1[c]) + (row0[c+4] + row1[c+4])) * 0.25f;
+}
+
+
+void MipChain::KaiserRowScalar(float* dst, const float* padded, int dstWidth, const float* weights)
+{
+	for (int x = 0; x < dstWidth; x++, dst += 4, padded += 8)
+	{
+		float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int t = 0; t < KaiserTaps; t++)
+			for (int c = 0; c < 4; c++)
+				sum[c] += weights[t] * padded[t*4 + c];
+		for (int c = 0; c < 4; c++)
+			dst[c] = sum[c];
+	}
+}
+
+
+void MipChain::KaiserColumnScalar(float* dst, const float* const* rows, int width, const float* weights)
+{
+	for (int e = 0; e < width*4; e++)
+	{
+		float sum = 0.0f;
+		for (int t = 0; t < KaiserTaps; t++)
+			sum += weights[t] * rows[t][e];
+		dst[e] = sum;
+	}
+}
+
+
+#ifdef MIPCHAIN_SIMD
+void MipChain::LoadRowSSE2(float* dst, const tPixel* src, int count)
+{
+	__m128i zero = _mm_setzero_si128();
+	for (int x = 0; x < count; x++, dst += 4)
+	{
+		__m128i p = _mm_cvtsi32_si128(*((const int*)(src+x)));
+		p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(p, zero), zero);
+		_mm_storeu_ps(dst, _mm_cvtepi32_ps(p));
+	}
+}
+
+
+void MipChain::StoreRowSSE2(tPixel* dst, const float* src, int count)
+{
+	// The packs saturate, which clamps to [0, 255].
+	for (int x = 0; x < count; x++, src += 4)
+	{
+		__m128i p = _mm_cvtps_epi32(_mm_loadu_ps(src));
+		p = _mm_packs_epi32(p, p);
+		p = _mm_packus_epi16(p, p);
+		*((int*)(dst+x)) = _mm_cvtsi128_si32(p);
+	}
+}
+
+
+void MipChain::BoxRowSSE2(float* dst, const float* row0, const float* row1, int dstWidth)
+{
+	__m128 quarter = _mm_set1_ps(0.25f);
+	for (int x = 0; x < dstWidth; x++, dst += 4, row0 += 8, row1 += 8)
+	{
+		__m128 left = _mm_add_ps(_mm_loadu_ps(row0), _mm_loadu_ps(row1));
+		__m128 right = _mm_add_ps(_mm_loadu_ps(row0+4), _mm_loadu_ps(row1+4));
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_add_ps(left, right), quarter));
+	}
+}
+
+
+void MipChain::KaiserRowSSE2(float* dst, const float* padded, int dstWidth, const float* weights)
+{
+	__m128 w[KaiserTaps];
+	for (int t = 0; t < KaiserTaps; t++)
+		w[t] = _mm_set1_ps(weights[t]);
+
+	for (int x = 0; x < dstWidth; x++, dst += 4, padded += 8)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (int t = 0; t < KaiserTaps; t++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(padded + t*4), w[t]));
+		_mm_storeu_ps(dst, sum);
+	}
+}
+
+
+void MipChain::KaiserColumnSSE2(float* dst, const float* const* rows, int width, const float* weights)
+{
+	__m128 w[KaiserTaps];
+	for (int t = 0; t < KaiserTaps; t++)
+		w[t] = _mm_set1_ps(weights[t]);
+
+	for (int e = 0; e < width*4; e += 4)
+	{
+		__m128 sum = _mm_setzero_ps();
+		for (int t = 0; t < KaiserTaps; t++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[t] + e), w[t]));
+		_mm_storeu_ps(dst + e, sum);
+	}
+}
+
+
+MIPCHAIN_AVX2 void MipChain::BoxRowAVX2(float* dst, const float* row0, const float* row1, int dstWidth)
+{
+	// Each pair of destination pixels comes from 4 source pixels in each row. After adding the rows, the permutes line
+	// up the left and right source pixels of both destination pixels.
+	__m256 quarter = _mm256_set1_ps(0.25f);
+	int x = 0;
+	for (; x+1 < dstWidth; x += 2, dst += 8, row0 += 16, row1 += 16)
+	{
+		__m256 a = _mm256_add_ps(_mm256_loadu_ps(row0), _mm256_loadu_ps(row1));
+		__m256 b = _mm256_add_ps(_mm256_loadu_ps(row0+8), _mm256_loadu_ps(row1+8));
+		__m256 left = _mm256_permute2f128_ps(a, b, 0x20);
+		__m256 right = _mm256_permute2f128_ps(a, b, 0x31);
+		_mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_add_ps(left, right), quarter));
+	}
+
+	if (x < dstWidth)
+		BoxRowSSE2(dst, row0, row1, 1);
+}
+
+
+MIPCHAIN_AVX2 void MipChain::KaiserRowAVX2(float* dst, const float* padded, int dstWidth, const float* weights)
+{
+	// Taps t and t+1 share a register. The halves are added together at the end.
+	__m256 w[KaiserTaps/2];
+	for (int t = 0; t < KaiserTaps; t += 2)
+		w[t/2] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(weights[t])), _mm_set1_ps(weights[t+1]), 1);
+
+	for (int x = 0; x < dstWidth; x++, dst += 4, padded += 8)
+	{
+		__m256 sum = _mm256_setzero_ps();
+		for (int t = 0; t < KaiserTaps; t += 2)
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(padded + t*4), w[t/2]));
+		_mm_storeu_ps(dst, _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+	}
+}
+
+
+MIPCHAIN_AVX2 void MipChain::KaiserColumnAVX2(float* dst, const float* const* rows, int width, const float* weights)
+{
+	__m256 w[KaiserTaps];
+	for (int t = 0; t < KaiserTaps; t++)
+		w[t] = _mm256_set1_ps(weights[t]);
+
+	int e = 0;
+	for (; e+8 <= width*4; e += 8)
+	{
+		__m256 sum = _mm256_setzero_ps();
+		for (int t = 0; t < KaiserTaps; t++)
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[t] + e), w[t]));
+		_mm256_storeu_ps(dst + e, sum);
+	}
+
+	if (e < width*4)
+	{
+		const float* lastRows[KaiserTaps];
+		for (int t = 0; t < KaiserTaps; t++)
+			lastRows[t] = rows[t] + e;
+		KaiserColumnSSE2(dst + e, lastRows, 1, weights);
+	}
+}
+#endif
+
+
+void MipChain::GetKernels(Kernels& kernels, tImage::tResamplePath path, bool gammaCorrect)
+{
+	kernels.LoadRow = LoadRowScalar;
+	kernels.StoreRow = StoreRowScalar;
+	kernels.BoxRow = BoxRowScalar;
+	kernels.KaiserRow = KaiserRowScalar;
+	kernels.KaiserColumn = KaiserColumnScalar;
+
+	#ifdef MIPCHAIN_SIMD
+	if ((path == tImage::tResamplePath::SSE2) || (path == tImage::tResamplePath::AVX2))
+	{
+		kernels.LoadRow = LoadRowSSE2;
+		kernels.StoreRow = StoreRowSSE2;
+		kernels.BoxRow = BoxRowSSE2;
+		kernels.KaiserRow = KaiserRowSSE2;
+		kernels.KaiserColumn = KaiserColumnSSE2;
+	}
+	if (path == tImage::tResamplePath::AVX2)
+	{
+		kernels.BoxRow = BoxRowAVX2;
+		kernels.KaiserRow = KaiserRowAVX2;
+		kernels.KaiserColumn = KaiserColumnAVX2;
+	}
+	#endif
+
+	if (gammaCorrect)
+	{
+		kernels.LoadRow = LoadRowGamma;
+		kernels.StoreRow = StoreRowGamma;
+	}
+}
+
+
+int tImage::tMipChain::ComputeNumLevels(int width, int height)
+{
+	if ((width <= 0) || (height <= 0))
+		return 0;
+
+	int numLevels = 1;
+	while ((width > 1) || (height > 1))
+	{
+		width = tMath::tMax(width >> 1, 1);
+		height = tMath::tMax(height >> 1, 1);
+		numLevels++;
+	}
+	return numLevels;
+}
+
+
+bool tImage::tMipChain::Set
+(
+	const tPixel* src, int width, int height, tMipFilter filter, bool gammaCorrect,
+	tResamplePath path, int maxThreads, int maxLevels
+)
+{
+	Clear();
+	if (!src || (width <= 0) || (height <= 0) || !tIsResamplePathSupported(path))
+		return false;
+
+	// CPU detection isn't free, so Auto is only resolved once.
+	if (path == tResamplePath::Auto)
+	{
+		static tResamplePath bestPath =
+			tIsResamplePathSupported(tResamplePath::AVX2) ? tResamplePath::AVX2 :
+			tIsResamplePathSupported(tResamplePath::SSE2) ? tResamplePath::SSE2 :
+			tResamplePath::Scalar;
+		path = bestPath;
+	}
+	MipChain::Kernels kernels;
+	MipChain::GetKernels(kernels, path, gammaCorrect);
+
+	NumLevels = ComputeNumLevels(width, height);
+	if (maxLevels > 0)
+		NumLevels = tMath::tMin(NumLevels, maxLevels);
+	int64 numPixels = 0;
+	for (int level = 0; level < NumLevels; level++)
+	{
+		Widths[level] = width;
+		Heights[level] = height;
+		Offsets[level] = numPixels;
+		numPixels += int64(width)*height;
+		width = tMath::tMax(width >> 1, 1);
+		height = tMath::tMax(height >> 1, 1);
+	}
+	Pixels = new tPixel[numPixels];
+
+	// tMemcpy takes an int byte count, which large images can overflow.
+	memcpy(Pixels, src, size_t(Widths[0])*size_t(Heights[0])*sizeof(tPixel));
+	if (NumLevels == 1)
+		return true;
+
+	// Levels alternate between two float buffers. The first is big enough for level 1 and the second for level 2.
+	// Level 0 is read straight from src and converted a row at a time.
+	float* buffers[2];
+	buffers[0] = new float[int64(Widths[1])*Heights[1]*4];
+	buffers[1] = (NumLevels > 2) ? new float[int64(Widths[2])*Heights[2]*4] : nullptr;
+	const float* srcLevel = nullptr;
+
+	tSystem::tJobSystem& jobSystem = tSystem::tGetSharedJobSystem();
+	int numJobs = jobSystem.GetNumWorkers() + 1;
+	if (maxThreads > 0)
+		numJobs = tMath::tMin(numJobs, maxThreads);
+	for (int level = 1; level < NumLevels; level++)
+	{
+		int srcWidth = Widths[level-1];
+		int srcHeight = Heights[level-1];
+		int dstWidth = Widths[level];
+		int dstHeight = Heights[level];
+		float* dstLevel = buffers[(level-1) & 1];
+		tPixel* dstPixels = Pixels + Offsets[level];
+		bool serial = (maxThreads == 1) || (srcWidth*srcHeight < MipChain::MinParallelPixels);
+		int numScratchSlots = serial ? 1 : numJobs;
+		auto forEachRow = [&](int count, const auto& fn)
+		{
+			if (serial)
+			{
+				for (int y = 0; y < count; y++)
+					fn(y);
+			}
+			else
+			{
+				jobSystem.ParallelFor(count, fn, MipChain::RowsPerBatch, maxThreads);
+			}
+		};
+
+		// Returns row y of the level above. For level 0 it's converted into scratch first.
+		auto getSrcRow = [&](int y, float* scratch) -> const float*
+		{
+			if (srcLevel)
+				return srcLevel + int64(y)*srcWidth*4;
+			kernels.LoadRow(scratch, src + int64(y)*srcWidth, srcWidth);
+			return scratch;
+		};
+
+		if (filter == tMipFilter::Box)
+		{
+			// Only level 0 needs converting, two rows at a time.
+			MipChain::ScratchRows* scratchRows = srcLevel ? nullptr : new MipChain::ScratchRows(numScratchSlots, int64(srcWidth)*8);
+			auto boxRow = [&](int y)
+			{
+				float* scratch = scratchRows ? scratchRows->Claim() : nullptr;
+				const float* row0 = getSrcRow((srcHeight > 1) ? 2*y : 0, scratch);
+				const float* row1 = (srcHeight > 1) ? getSrcRow(2*y+1, scratch ? scratch + srcWidth*4 : nullptr) : row0;
+				float* dst = dstLevel + int64(y)*dstWidth*4;
+				if (srcWidth > 1)
+				{
+					kernels.BoxRow(dst, row0, row1, dstWidth);
+				}
+				else
+				{
+					for (int c = 0; c < 4; c++)
+						dst[c] = (row0[c] + row1[c]) * 0.5f;
+				}
+				kernels.StoreRow(dstPixels + int64(y)*dstWidth, dst, dstWidth);
+				if (scratch)
+					scratchRows->Release(scratch);
+			};
+			forEachRow(dstHeight, boxRow);
+			delete scratchRows;
+		}
+		else
+		{
+			// The horizontal pass filters every source row into a temporary with the destination width. Rows are padded
+			// by repeating the edge pixels so the kernels don't need to handle the edges.
+			const float* weights = MipChain::GetKaiserWeights();
+			float* temp = new float[int64(dstWidth)*srcHeight*4];
+			int paddedWidth = srcWidth + MipChain::KaiserPadLeft + MipChain::KaiserPadRight;
+			MipChain::ScratchRows paddedRows(numScratchSlots, int64(paddedWidth)*4);
+			auto horizontalRow = [&](int y)
+			{
+				float* padded = paddedRows.Claim();
+				float* row = padded + MipChain::KaiserPadLeft*4;
+				const float* srcRow = getSrcRow(y, row);
+				if (srcRow != row)
+					tStd::tMemcpy(row, srcRow, srcWidth*4*sizeof(float));
+				for (int p = 0; p < MipChain::KaiserPadLeft; p++)
+					tStd::tMemcpy(padded + p*4, row, 4*sizeof(float));
+				for (int p = srcWidth; p < srcWidth + MipChain::KaiserPadRight; p++)
+					tStd::tMemcpy(row + p*4, row + (srcWidth-1)*4, 4*sizeof(float));
+
+				float* dst = temp + int64(y)*dstWidth*4;
+				if (srcWidth > 1)
+					kernels.KaiserRow(dst, padded, dstWidth, weights);
+				else
+					tStd::tMemcpy(dst, row, 4*sizeof(float));
+				paddedRows.Release(padded);
+			};
+
+			auto verticalRow = [&](int y)
+			{
+				float* dst = dstLevel + int64(y)*dstWidth*4;
+				if (srcHeight > 1)
+				{
+					const float* rows[MipChain::KaiserTaps];
+					for (int t = 0; t < MipChain::KaiserTaps; t++)
+					{
+						int srcY = tMath::tClamp(2*y - MipChain::KaiserPadLeft + t, 0, srcHeight-1);
+						rows[t] = temp + int64(srcY)*dstWidth*4;
+					}
+					kernels.KaiserColumn(dst, rows, dstWidth, weights);
+				}
+				else
+				{
+					tStd::tMemcpy(dst, temp, dstWidth*4*sizeof(float));
+				}
+				kernels.StoreRow(dstPixels + int64(y)*dstWidth, dst, dstWidth);
+			};
+
+			forEachRow(srcHeight, horizontalRow);
+			forEachRow(dstHeight, verticalRow);
+			delete[] temp;
+		}
+
+		srcLevel = dstLevel;
+	}
+
+	delete[] buffers[0];
+	delete[] buffers[1];
+	return true;
+}
@@ -23,6 +23,7 @@
 
 #include "Foundation/tStandard.h"
 #include "Image/tPicture.h"
+#include "Image/tBlockDecoder.h"
 #include <OpenEXR/loadImage.h>
 #include <OpenEXR/zlib/zlib.h>
 #include <ximage.h>
@@ -94,6 +95,25 @@ void tPicture::Set(int width, int height, tPixel* pixelBuffer, bool copyPixels)
 }
 
 
+bool tPicture::Set(const tLayer& layer)
+{
+	Clear();
+	if (!layer.IsValid() || !tIsBlockFormat(layer.PixelFormat))
+		return false;
+
+	tPixel* pixels = new tPixel[layer.Width*layer.Height];
+	if (!tDecodeBlocks(pixels, layer.Data, layer.PixelFormat, layer.Width, layer.Height))
+	{
+		delete[] pixels;
+		return false;
+	}
+
+	Set(layer.Width, layer.Height, pixels, false);
+	SrcPixelFormat = layer.PixelFormat;
+	return true;
+}
+
+
 bool tPicture::CanSave(tFileType fileType)
 {
 	switch (fileType)
@@ -247,24 +267,23 @@ bool tPicture::Load(const tString& imageFile, int partNum, LoadParams params)
 
 		case tFileType::GIF:
 		{
-			tImageGIF gif;
-			bool ok = gif.Load(imageFile);
-			if (!ok || !gif.IsValid())
+			// Decoding starts at the closest key frame before partNum.
+			tImageGIF::FrameStream gif(imageFile);
+			if (!gif.IsValid() || (partNum >= gif.GetNumFrames()))
 				return false;
 
-			if (partNum >= gif.GetNumFrames())
+			tImageGIF::Frame* frame = gif.ReadFrame(partNum);
+			if (!frame)
 				return false;
 
 			Width = gif.GetWidth();
 			Height = gif.GetHeight();
-		
-			tImageGIF::Frame* stolenFrame = gif.StealFrame(partNum);
-			Pixels = stolenFrame->Pixels;
+			Pixels = frame->Pixels;
 
 			// This is safe as the frame does not own/delete the pixels.
-			delete stolenFrame;
+			delete frame;
 
-			SrcPixelFormat = gif.SrcPixelFormat;
+			SrcPixelFormat = tPixelFormat::PAL_8BIT;
 			return true;
 		}
 
@@ -316,7 +335,7 @@ bool tPicture::Load(const tString& imageFile, int partNum, LoadParams params)
 			// JPGs can only have one part.
 			if (partNum != 0)
 				return false;
-			tImageJPG jpeg(imageFile);
+			tImageJPG jpeg(imageFile, params.JPG_MinWidth, params.JPG_MinHeight, params.JPG_FastDecode);
 			if (!jpeg.IsValid())
 				return false;
 			Width = jpeg.GetWidth();
@@ -341,25 +360,24 @@ bool tPicture::Load(const tString& imageFile, int partNum, LoadParams params)
 			return true;
 		}
 
-		if (fileType == tFileType::WEBP)
+		case tFileType::WEBP:
 		{
-			tImageWEBP webp;
-			bool ok = webp.Load(imageFile);
-			if (!ok || !webp.IsValid())
+			// Decoding starts at the closest key frame before partNum.
+			tImageWEBP::FrameStream webp(imageFile);
+			if (!webp.IsValid() || (partNum >= webp.GetNumFrames()))
 				return false;
 
-			if (partNum >= webp.GetNumFrames())
+			tImageWEBP::Frame* frame = webp.ReadFrame(partNum);
+			if (!frame)
 				return false;
 
-			tImageWEBP::Frame* stolenFrame = webp.StealFrame(partNum);
-			Width = stolenFrame->Width;
-			Height = stolenFrame->Height;
-			SrcPixelFormat = stolenFrame->SrcPixelFormat;
-		
-			Pixels = stolenFrame->Pixels;
+			Width = frame->Width;
+			Height = frame->Height;
+			SrcPixelFormat = frame->SrcPixelFormat;
+			Pixels = frame->Pixels;
 
 			// This is safe as the frame does not own/delete the pixels.
-			delete stolenFrame;
+			delete frame;
 			return true;
 		}
 	}
@@ -655,7 +673,7 @@ bool tPicture::ScaleHalf()
 
 bool tPicture::Resample(int width, int height, tFilter filter)
 {
-	if (!IsValid())
+	if (!IsValid() || (width <= 0) || (height <= 0))
 		return false;
 
 	int origWidth = GetWidth();
@@ -665,81 +683,18 @@ bool tPicture::Resample(int width, int height, tFilter filter)
 	if ((width == origWidth) && (height == origHeight))
 		return true;
 
-	// For now we're using CxImage because it's there.
-	CxImage image(origWidth, origHeight, 32);
-
-	// Saying 32bbp isn't enough for CxImage to do alphas. Odd.
-	image.AlphaCreate();
-
-	for (int y = 0; y < origHeight; y++)
-	{
-		for (int x = 0; x < origWidth; x++)
-		{
-			tPixel p = GetPixel(x, y);
-			RGBQUAD q;
-			q.rgbBlue = p.B;
-			q.rgbGreen = p.G;
-			q.rgbRed = p.R;
-			q.rgbReserved = p.A;
-			image.SetPixelColor(x, y, q, true);
-		}
-	}
-
-	CxImage::InterpolationMethod interpolation = CxImage::IM_NEAREST_NEIGHBOUR;
-	switch (filter)
-	{
-		case tFilter::NearestNeighbour:
-			interpolation = CxImage::IM_NEAREST_NEIGHBOUR;
-			break;
-
-		case tFilter::Box:
-			interpolation = CxImage::IM_BOX;
-			break;
-
-		case tFilter::Bilinear:
-			interpolation = CxImage::IM_BILINEAR;
-			break;
-
-		case tFilter::Bicubic:
-			interpolation = CxImage::IM_BICUBIC2;
-			break;
-
-		case tFilter::Quadratic:
-			interpolation = CxImage::IM_QUADRATIC;
-			break;
-
-		case tFilter::Hamming:
-			interpolation = CxImage::IM_HAMMING;
-			break;
-	}
-
-	// Here's where the work is done.
-	bool ok = image.Resample2(width, height, interpolation);
+	tPixel* newPixels = new tPixel[width*height];
+	bool ok = tResample(newPixels, width, height, Pixels, origWidth, origHeight, filter);
 	if (!ok)
+	{
+		delete[] newPixels;
 		return false;
+	}
 
 	Clear();
 	Width = width;
 	Height = height;
-	Pixels = new tPixel[Width*Height];
-
-	// Now we just pull the pixels from the CxImage.
-	int index = 0;
-	for (int y = 0; y < height; y++)
-	{
-		for (int x = 0; x < width; x++)
-		{
-			// GetPixelColor gets the alpha as well.
-			RGBQUAD rgba = image.GetPixelColor(x, y);
-			tColouri colour;
-			colour.R = rgba.rgbRed;
-			colour.G = rgba.rgbGreen;
-			colour.B = rgba.rgbBlue;
-			colour.A = rgba.rgbReserved;
-			Pixels[index++] = colour;
-		}
-	}
-
+	Pixels = newPixels;
 	return true;
 }
 
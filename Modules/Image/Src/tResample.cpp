@@ -0,0 +1,492 @@
+// tResample.cpp
+//
+// A separable image resampler for 32-bit tPixels. The filter weights for each destination column and row are computed
+// once up front. The image is filtered horizontally into a floating-point intermediate and then vertically back to
+// tPixels. The inner loops have SSE2 and AVX2 paths with a scalar fallback, and the instruction set is chosen at
+// runtime. Large images are resampled a band of rows per job on the shared job system.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <cmath>
+#include <Math/tFundamentals.h>
+#include <System/tJobSystem.h>
+#include <System/tMachine.h>
+#include <Image/tResample.h>
+
+// SSE2 is part of the x64 baseline so it needs no special compiler flags. The AVX2 functions are compiled for AVX2 on
+// a per-function basis and are only called if the CPU supports them.
+#if defined(ARCHITECTURE_X64)
+#define RESAMPLE_SIMD
+#include <immintrin.h>
+#if defined(PLATFORM_WINDOWS)
+#define RESAMPLE_AVX2
+#else
+#define RESAMPLE_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+
+namespace Resample
+{
+	// Below this many pixels, in either the source or the destination, the cost of waking the workers outweighs the
+	// gain. Rows are handed out in batches so each job has a reasonable amount of work.
+	const int MinParallelPixels = 128*128;
+	const int RowsPerBatch = 8;
+
+	// The kernels are even so they only need to handle x >= 0.
+	float KernelBox(float x)																							{ return (x < 0.5f) ? 1.0f : 0.0f; }
+	float KernelTriangle(float x)																						{ return (x < 1.0f) ? 1.0f - x : 0.0f; }
+	float KernelCubic(float x);
+	float KernelQuadratic(float x);
+	float KernelHamming(float x)																						{ return (x < 1.0f) ? 0.92f*(2.0f*x - 3.0f)*x*x + 1.0f : 0.0f; }
+	float KernelLanczos3(float x);
+	float KernelKaiser(float x);
+	float Sinc(float x)																									{ if (x == 0.0f) return 1.0f; float pix = tMath::Pi*x; return std::sin(pix) / pix; }
+	float BesselI0(float x);
+
+	typedef float KernelFunction(float x);
+	void GetKernel(tImage::tResampleFilter, KernelFunction*&, float& radius);
+
+	// For every destination pixel along one axis the weights cover the same number of source pixels, NumTaps. The
+	// windows are shifted to stay inside the source, and any taps in the window that the filter doesn't reach have
+	// zero weight. This keeps the inner loops free of edge handling.
+	struct Weights
+	{
+		Weights(int srcSize, int dstSize, tImage::tResampleFilter);
+		~Weights()																										{ delete[] First; delete[] Values; }
+		const float* Get(int d) const																					{ return Values + d*NumTaps; }
+
+		int NumTaps;
+		int* First;
+		float* Values;
+	};
+
+	// The horizontal pass converts a row of tPixels to a row of 4 floats per destination pixel. The vertical pass
+	// combines NumTaps intermediate rows, starting at src and rowStride floats apart, into a row of tPixels.
+	typedef void HorizontalFunction(float* dst, const tPixel* src, int dstWidth, const Weights&);
+	typedef void VerticalFunction(tPixel* dst, const float* src, int rowStride, const float* weights, int numTaps, int width);
+
+	void HorizontalScalar(float* dst, const tPixel* src, int dstWidth, const Weights&);
+	void VerticalScalar(tPixel* dst, const float* src, int rowStride, const float* weights, int numTaps, int width);
+
+	#ifdef RESAMPLE_SIMD
+	__m128 LoadPixelSSE2(const tPixel&);
+	void StorePixelSSE2(tPixel&, __m128);
+	void HorizontalSSE2(float* dst, const tPixel* src, int dstWidth, const Weights&);
+	void VerticalSSE2(tPixel* dst, const float* src, int rowStride, const float* weights, int numTaps, int width);
+
+	// The AVX2 path handles two taps at a time in the horizontal pass and two pixels at a time in the vertical pass.
+	RESAMPLE_AVX2 void HorizontalAVX2(float* dst, const tPixel* src, int dstWidth, const Weights&);
+	RESAMPLE_AVX2 void VerticalAVX2(tPixel* dst, const float* src, int rowStride, const float* weights, int numTaps, int width);
+	#endif
+}
+
+
+float Resample::KernelCubic(float x)
+{
+	// The generalized cubic with a = -0.5.
+	const float a = -0.5f;
+	float x2 = x*x;
+	if (x < 1.0f)
+		return (a+2.0f)*x2*x - (a+3.0f)*x2 + 1.0f;
+	if (x < 2.0f)
+		return a*x2*x - 5.0f*a*x2 + 8.0f*a*x - 4.0f*a;
+	return 0.0f;
+}
+
+
+float Resample::KernelQuadratic(float x)
+{
+	if (x < 0.5f)
+		return 0.75f - x*x;
+	if (x < 1.5f)
+		return 0.5f*(x-1.5f)*(x-1.5f);
+	return 0.0f;
+}
+
+
+float Resample::KernelLanczos3(float x)
+{
+	if (x >= 3.0f)
+		return 0.0f;
+	return Sinc(x) * Sinc(x/3.0f);
+}
+
+
+float Resample::BesselI0(float x)
+{
+	// Power series. It converges quickly for the small arguments the Kaiser window uses.
+	float sum = 1.0f;
+	float term = 1.0f;
+	float halfX = x*0.5f;
+	for (int k = 1; k < 32; k++)
+	{
+		term *= (halfX / float(k)) * (halfX / float(k));
+		sum += term;
+		if (term < sum*1.0e-8f)
+			break;
+	}
+	return sum;
+}
+
+
+float Resample::KernelKaiser(float x)
+{
+	// A width of 3 and alpha of 4 is a good compromise between sharpness and ringing for mipmaps.
+	const float width = 3.0f;
+	const float alpha = 4.0f;
+	if (x >= width)
+		return 0.0f;
+
+	float t = x / width;
+	return Sinc(x) * BesselI0(alpha * std::sqrt(1.0f - t*t)) / BesselI0(alpha);
+}
+
+
+void Resample::GetKernel(tImage::tResampleFilter filter, KernelFunction*& kernel, float& radius)
+{
+	using namespace tImage;
+	switch (filter)
+	{
+		case tResampleFilter::Box:			kernel = KernelBox;			radius = 0.5f;	break;
+		case tResampleFilter::Bicubic:		kernel = KernelCubic;		radius = 2.0f;	break;
+		case tResampleFilter::Quadratic:	kernel = KernelQuadratic;	radius = 1.5f;	break;
+		case tResampleFilter::Hamming:		kernel = KernelHamming;		radius = 1.0f;	break;
+		case tResampleFilter::Lanczos3:		kernel = KernelLanczos3;	radius = 3.0f;	break;
+		case tResampleFilter::Kaiser:		kernel = KernelKaiser;		radius = 3.0f;	break;
+		case tResampleFilter::Bilinear:
+		default:							kernel = KernelTriangle;	radius = 1.0f;	break;
+	}
+}
+
+
+Resample::Weights::Weights(int srcSize, int dstSize, tImage::tResampleFilter filter) :
+	NumTaps(1),
+	First(new int[dstSize]),
+	Values(nullptr)
+{
+	float scale = float(srcSize) / float(dstSize);
+	if (filter == tImage::tResampleFilter::NearestNeighbour)
+	{
+		Values = new float[dstSize];
+		for (int d = 0; d < dstSize; d++)
+		{
+			First[d] = tMath::tMin(int((float(d) + 0.5f) * scale), srcSize-1);
+			Values[d] = 1.0f;
+		}
+		return;
+	}
+
+	// When minifying the filter is stretched so that every source pixel contributes.
+	KernelFunction* kernel = nullptr;
+	float radius = 1.0f;
+	GetKernel(filter, kernel, radius);
+	float filterScale = tMath::tMax(scale, 1.0f);
+	float support = radius * filterScale;
+
+	// The first pass finds the range of source pixels with non-zero weight for each destination pixel. The widest
+	// range determines the number of taps.
+	int* counts = new int[dstSize];
+	for (int d = 0; d < dstSize; d++)
+	{
+		float centre = (float(d) + 0.5f) * scale;
+		int start = tMath::tMax(int(std::floor(centre - support)), 0);
+		int end = tMath::tMin(int(std::ceil(centre + support)), srcSize-1);
+		while ((start < end) && (kernel(std::fabs((float(start) + 0.5f - centre) / filterScale)) == 0.0f))
+			start++;
+		while ((end > start) && (kernel(std::fabs((float(end) + 0.5f - centre) / filterScale)) == 0.0f))
+			end--;
+
+		First[d] = start;
+		counts[d] = end - start + 1;
+		NumTaps = tMath::tMax(NumTaps, counts[d]);
+	}
+
+	Values = new float[dstSize*NumTaps];
+	for (int d = 0; d < dstSize; d++)
+	{
+		float centre = (float(d) + 0.5f) * scale;
+		int start = First[d];
+		int first = tMath::tMin(start, srcSize - NumTaps);
+		float* values = Values + d*NumTaps;
+		for (int t = 0; t < NumTaps; t++)
+			values[t] = 0.0f;
+
+		float sum = 0.0f;
+		for (int i = start; i < start + counts[d]; i++)
+		{
+			float w = kernel(std::fabs((float(i) + 0.5f - centre) / filterScale));
+			values[i - first] = w;
+			sum += w;
+		}
+
+		// Normalizing makes up for the taps that were dropped at the edges. If nothing contributed at all, which can
+		// only happen with extreme filter and scale combinations, the nearest source pixel is used.
+		if (sum != 0.0f)
+		{
+			for (int t = 0; t < NumTaps; t++)
+				values[t] /= sum;
+		}
+		else
+		{
+			int nearest = tMath::tClamp(int(centre), first, first + NumTaps - 1);
+			values[nearest - first] = 1.0f;
+		}
+		First[d] = first;
+	}
+	delete[] counts;
+}
+
+
+void Resample::HorizontalScalar(float* dst, const tPixel* src, int dstWidth, const Weights& weights)
+{
+	int numTaps = weights.NumTaps;
+	for (int x = 0; x < dstWidth; x++, dst += 4)
+	{
+		const float* w = weights.Get(x);
+		const tPixel* s = src + weights.First[x];
+		float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+		for (int t = 0; t < numTaps; t++)
+		{
+			r += w[t] * float(s[t].R);
+			g += w[t] * float(s[t].G);
+			b += w[t] * float(s[t].B);
+			a += w[t] * float(s[t].A);
+		}
+		dst[0] = r; dst[1] = g; dst[2] = b; dst[3] = a;
+	}
+}
+
+
+void Resample::VerticalScalar(tPixel* dst, const float* src, int rowStride, const float* weights, int numTaps, int width)
+{
+	for (int x = 0; x < width; x++)
+	{
+		const float* column = src + x*4;
+		float c[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (int t = 0; t < numTaps; t++)
+			for (int e = 0; e < 4; e++)
+				c[e] += weights[t] * column[t*rowStride + e];
+
+		// Round to nearest even, the same as the SIMD conversions.
+		uint8 channels[4];
+		for (int e = 0; e < 4; e++)
+			channels[e] = uint8(tMath::tClamp(int(std::nearbyint(c[e])), 0, 255));
+		dst[x].Set(channels[0], channels[1], channels[2], channels[3]);
+	}
+}
+
+
+#ifdef RESAMPLE_SIMD
+inline __m128 Resample::LoadPixelSSE2(const tPixel& pixel)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i p = _mm_cvtsi32_si128(*((const int*)&pixel));
+	p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(p, zero), zero);
+	return _mm_cvtepi32_ps(p);
+}
+
+
+inline void Resample::StorePixelSSE2(tPixel& pixel, __m128 value)
+{
+	// The packs saturate, which clamps to [0, 255].
+	__m128i p = _mm_cvtps_epi32(value);
+	p = _mm_packs_epi32(p, p);
+	p = _mm_packus_epi16(p, p);
+	*((int*)&pixel) = _mm_cvtsi128_si32(p);
+}
+
+
+void Resample::HorizontalSSE2(float* dst, const tPixel* src, int dstWidth, const Weights& weights)
+{
+	int numTaps = weights.NumTaps;
+	for (int x = 0; x < dstWidth; x++, dst += 4)
+	{
+		const float* w = weights.Get(x);
+		const tPixel* s = src + weights.First[x];
+		__m128 sum = _mm_setzero_ps();
+		for (int t = 0; t < numTaps; t++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(LoadPixelSSE2(s[t]), _mm_set1_ps(w[t])));
+		_mm_storeu_ps(dst, sum);
+	}
+}
+
+
+void Resample::VerticalSSE2(tPixel* dst, const float* src, int rowStride, const float* weights, int numTaps, int width)
+{
+	for (int x = 0; x < width; x++)
+	{
+		const float* column = src + x*4;
+		__m128 sum = _mm_setzero_ps();
+		for (int t = 0; t < numTaps; t++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(column + t*rowStride), _mm_set1_ps(weights[t])));
+		StorePixelSSE2(dst[x], sum);
+	}
+}
+
+
+RESAMPLE_AVX2 void Resample::HorizontalAVX2(float* dst, const tPixel* src, int dstWidth, const Weights& weights)
+{
+	int numTaps = weights.NumTaps;
+	for (int x = 0; x < dstWidth; x++, dst += 4)
+	{
+		const float* w = weights.Get(x);
+		const tPixel* s = src + weights.First[x];
+
+		// Two neighbouring source pixels are widened to 8 floats in one go.
+		__m256 sum2 = _mm256_setzero_ps();
+		int t = 0;
+		for (; t+1 < numTaps; t += 2)
+		{
+			__m256 pixels = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(s+t))));
+			__m256 w2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(w[t])), _mm_set1_ps(w[t+1]), 1);
+			sum2 = _mm256_add_ps(sum2, _mm256_mul_ps(pixels, w2));
+		}
+
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum2), _mm256_extractf128_ps(sum2, 1));
+		if (t < numTaps)
+		{
+			__m128 pixel = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(*((const int*)(s+t)))));
+			sum = _mm_add_ps(sum, _mm_mul_ps(pixel, _mm_set1_ps(w[t])));
+		}
+		_mm_storeu_ps(dst, sum);
+	}
+}
+
+
+RESAMPLE_AVX2 void Resample::VerticalAVX2(tPixel* dst, const float* src, int rowStride, const float* weights, int numTaps, int width)
+{
+	int x = 0;
+	for (; x+1 < width; x += 2)
+	{
+		const float* column = src + x*4;
+		__m256 sum = _mm256_setzero_ps();
+		for (int t = 0; t < numTaps; t++)
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(column + t*rowStride), _mm256_set1_ps(weights[t])));
+
+		__m256i p = _mm256_cvtps_epi32(sum);
+		__m128i p16 = _mm_packs_epi32(_mm256_castsi256_si128(p), _mm256_extracti128_si256(p, 1));
+		_mm_storel_epi64((__m128i*)(dst+x), _mm_packus_epi16(p16, p16));
+	}
+
+	if (x < width)
+		VerticalSSE2(dst+x, src + x*4, rowStride, weights, numTaps, 1);
+}
+#endif
+
+
+float tImage::tEvaluateResampleFilter(tResampleFilter filter, float x)
+{
+	Resample::KernelFunction* kernel = nullptr;
+	float radius = 1.0f;
+	Resample::GetKernel(filter, kernel, radius);
+	if (filter == tResampleFilter::NearestNeighbour)
+		kernel = Resample::KernelBox;
+	return kernel(std::fabs(x));
+}
+
+
+bool tImage::tIsResamplePathSupported(tResamplePath path)
+{
+	switch (path)
+	{
+		case tResamplePath::Auto:
+		case tResamplePath::Scalar:
+			return true;
+
+		#ifdef RESAMPLE_SIMD
+		case tResamplePath::SSE2:
+			return tSystem::tSupportsSSE2();
+
+		case tResamplePath::AVX2:
+			return tSystem::tSupportsAVX2();
+		#endif
+
+		default:
+			return false;
+	}
+}
+
+
+bool tImage::tResample
+(
+	tPixel* dest, int destWidth, int destHeight, const tPixel* src, int srcWidth, int srcHeight,
+	tResampleFilter filter, tResamplePath path, int maxThreads
+)
+{
+	if (!dest || !src || (destWidth <= 0) || (destHeight <= 0) || (srcWidth <= 0) || (srcHeight <= 0))
+		return false;
+
+	if (!tIsResamplePathSupported(path))
+		return false;
+
+	// CPU detection isn't free, so Auto is only resolved once.
+	if (path == tResamplePath::Auto)
+	{
+		static tResamplePath bestPath =
+			tIsResamplePathSupported(tResamplePath::AVX2) ? tResamplePath::AVX2 :
+			tIsResamplePathSupported(tResamplePath::SSE2) ? tResamplePath::SSE2 :
+			tResamplePath::Scalar;
+		path = bestPath;
+	}
+
+	Resample::HorizontalFunction* horizontal = Resample::HorizontalScalar;
+	Resample::VerticalFunction* vertical = Resample::VerticalScalar;
+	#ifdef RESAMPLE_SIMD
+	if (path == tResamplePath::AVX2)
+	{
+		horizontal = Resample::HorizontalAVX2;
+		vertical = Resample::VerticalAVX2;
+	}
+	else if (path == tResamplePath::SSE2)
+	{
+		horizontal = Resample::HorizontalSSE2;
+		vertical = Resample::VerticalSSE2;
+	}
+	#endif
+
+	Resample::Weights weightsX(srcWidth, destWidth, filter);
+	Resample::Weights weightsY(srcHeight, destHeight, filter);
+
+	// The intermediate has the destination width and the source height.
+	int rowStride = destWidth*4;
+	float* intermediate = new float[int64(rowStride)*srcHeight];
+
+	// Every row of both passes is independent so they may be done in any order.
+	auto horizontalRow = [&](int y)
+	{
+		horizontal(intermediate + int64(y)*rowStride, src + int64(y)*srcWidth, destWidth, weightsX);
+	};
+	auto verticalRow = [&](int y)
+	{
+		const float* rows = intermediate + int64(weightsY.First[y])*rowStride;
+		vertical(dest + int64(y)*destWidth, rows, rowStride, weightsY.Get(y), weightsY.NumTaps, destWidth);
+	};
+
+	bool serial = (maxThreads == 1) ||
+		((srcWidth*srcHeight < Resample::MinParallelPixels) && (destWidth*destHeight < Resample::MinParallelPixels));
+	if (serial)
+	{
+		for (int y = 0; y < srcHeight; y++)
+			horizontalRow(y);
+		for (int y = 0; y < destHeight; y++)
+			verticalRow(y);
+	}
+	else
+	{
+		tSystem::tJobSystem& jobSystem = tSystem::tGetSharedJobSystem();
+		jobSystem.ParallelFor(srcHeight, horizontalRow, Resample::RowsPerBatch, maxThreads);
+		jobSystem.ParallelFor(destHeight, verticalRow, Resample::RowsPerBatch, maxThreads);
+	}
+
+	delete[] intermediate;
+	return true;
+}
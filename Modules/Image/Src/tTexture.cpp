@@ -22,14 +22,259 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <System/tJobSystem.h>
 #include <Image/tTexture.h>
 #define RGBCX_IMPLEMENTATION
 #include <BC7Enc/rgbcx.h>
+#include <BC7Enc/bc7enc.h>
+#include <half.h>
+
+
+namespace BC6H
+{
+	// This is a simple BC6H encoder for unsigned half-floats. It always uses mode 11, which is a single region with
+	// 10-bit endpoints stored directly (no deltas) and 4-bit indices. That is enough for LDR tPicture sources.
+	const int Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	const int MaxHalf = 0x7BFF;
+
+	int Unquantize(int q);
+	int Quantize(int halfBits);
+	int Interpolate(int unq0, int unq1, int weight)																		{ return ((64-weight)*unq0 + weight*unq1 + 32) >> 6; }
+	int FinishUnquantize(int unq)																						{ return (unq*31) >> 6; }
+
+	// Chooses the best index for every pixel given quantized endpoints. Returns the total squared error.
+	int64 ComputeIndices(const int halfs[16][3], const int q0[3], const int q1[3], int indices[16]);
+	void FitEndpoints(const int halfs[16][3], int q0[3], int q1[3]);
+	bool RefineEndpoints(const int halfs[16][3], const int indices[16], int q0[3], int q1[3]);
+	void PutBits(uint64 block[2], int& pos, uint32 value, int numBits);
+	void EncodeBlock(uint8* dest, const tPixel* pixels, int refineIterations);
+}
+
+
+int BC6H::Unquantize(int q)
+{
+	if (q == 0)
+		return 0;
+	if (q == 1023)
+		return 0xFFFF;
+	return ((q << 16) + 0x8000) >> 10;
+}
+
+
+int BC6H::Quantize(int halfBits)
+{
+	// Unquantize followed by FinishUnquantize is close to q*31 + 15, so start there and check the neighbours.
+	int guess = tMath::tClamp((halfBits - 15) / 31, 0, 1023);
+	int best = guess;
+	int bestErr = tMath::tAbs(FinishUnquantize(Unquantize(guess)) - halfBits);
+	for (int q = tMath::tMax(guess-1, 0); q <= tMath::tMin(guess+1, 1023); q++)
+	{
+		int err = tMath::tAbs(FinishUnquantize(Unquantize(q)) - halfBits);
+		if (err < bestErr)
+		{
+			bestErr = err;
+			best = q;
+		}
+	}
+	return best;
+}
+
+
+int64 BC6H::ComputeIndices(const int halfs[16][3], const int q0[3], const int q1[3], int indices[16])
+{
+	int palette[16][3];
+	for (int c = 0; c < 3; c++)
+	{
+		int unq0 = Unquantize(q0[c]);
+		int unq1 = Unquantize(q1[c]);
+		for (int i = 0; i < 16; i++)
+			palette[i][c] = FinishUnquantize(Interpolate(unq0, unq1, Weights[i]));
+	}
+
+	int64 totalErr = 0;
+	for (int p = 0; p < 16; p++)
+	{
+		int64 bestErr = -1;
+		for (int i = 0; i < 16; i++)
+		{
+			int64 err = 0;
+			for (int c = 0; c < 3; c++)
+			{
+				int64 d = palette[i][c] - halfs[p][c];
+				err += d*d;
+			}
+			if ((bestErr < 0) || (err < bestErr))
+			{
+				bestErr = err;
+				indices[p] = i;
+			}
+		}
+		totalErr += bestErr;
+	}
+	return totalErr;
+}
+
+
+void BC6H::FitEndpoints(const int halfs[16][3], int q0[3], int q1[3])
+{
+	// The endpoints are the extremes of the pixels projected onto their principal axis.
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int p = 0; p < 16; p++)
+		for (int c = 0; c < 3; c++)
+			mean[c] += float(halfs[p][c]) / 16.0f;
+
+	float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int p = 0; p < 16; p++)
+	{
+		float r = halfs[p][0] - mean[0];
+		float g = halfs[p][1] - mean[1];
+		float b = halfs[p][2] - mean[2];
+		cov[0] += r*r;	cov[1] += r*g;	cov[2] += r*b;
+		cov[3] += g*g;	cov[4] += g*b;	cov[5] += b*b;
+	}
+
+	// A few rounds of power iteration are plenty for a 3x3.
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iter = 0; iter < 8; iter++)
+	{
+		float x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+		float y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+		float z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+		float len = tMath::tSqrt(x*x + y*y + z*z);
+		if (len < 1.0e-6f)
+			break;
+		axis[0] = x/len;	axis[1] = y/len;	axis[2] = z/len;
+	}
+
+	float minT = 0.0f, maxT = 0.0f;
+	for (int p = 0; p < 16; p++)
+	{
+		float t = (halfs[p][0]-mean[0])*axis[0] + (halfs[p][1]-mean[1])*axis[1] + (halfs[p][2]-mean[2])*axis[2];
+		minT = tMath::tMin(minT, t);
+		maxT = tMath::tMax(maxT, t);
+	}
+
+	for (int c = 0; c < 3; c++)
+	{
+		q0[c] = Quantize(tMath::tClamp(int(mean[c] + minT*axis[c] + 0.5f), 0, MaxHalf));
+		q1[c] = Quantize(tMath::tClamp(int(mean[c] + maxT*axis[c] + 0.5f), 0, MaxHalf));
+	}
+}
+
+
+bool BC6H::RefineEndpoints(const int halfs[16][3], const int indices[16], int q0[3], int q1[3])
+{
+	// Least-squares fit of the endpoints given the interpolation weight of every pixel.
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[3] = { 0.0f, 0.0f, 0.0f };
+	float bx[3] = { 0.0f, 0.0f, 0.0f };
+	for (int p = 0; p < 16; p++)
+	{
+		float t = float(Weights[indices[p]]) / 64.0f;
+		float s = 1.0f - t;
+		aa += s*s;	ab += s*t;	bb += t*t;
+		for (int c = 0; c < 3; c++)
+		{
+			ax[c] += s*halfs[p][c];
+			bx[c] += t*halfs[p][c];
+		}
+	}
+
+	float det = aa*bb - ab*ab;
+	if (tMath::tAbs(det) < 1.0e-6f)
+		return false;
+
+	for (int c = 0; c < 3; c++)
+	{
+		float e0 = (bb*ax[c] - ab*bx[c]) / det;
+		float e1 = (aa*bx[c] - ab*ax[c]) / det;
+		q0[c] = Quantize(tMath::tClamp(int(e0 + 0.5f), 0, MaxHalf));
+		q1[c] = Quantize(tMath::tClamp(int(e1 + 0.5f), 0, MaxHalf));
+	}
+	return true;
+}
+
+
+void BC6H::PutBits(uint64 block[2], int& pos, uint32 value, int numBits)
+{
+	for (int b = 0; b < numBits; b++, pos++)
+		if (value & (1 << b))
+			block[pos >> 6] |= uint64(1) << (pos & 63);
+}
+
+
+void BC6H::EncodeBlock(uint8* dest, const tPixel* pixels, int refineIterations)
+{
+	int halfs[16][3];
+	for (int p = 0; p < 16; p++)
+		for (int c = 0; c < 3; c++)
+			halfs[p][c] = half(float(pixels[p].E[c]) / 255.0f).bits();
+
+	int q0[3], q1[3];
+	int indices[16];
+	FitEndpoints(halfs, q0, q1);
+	int64 err = ComputeIndices(halfs, q0, q1, indices);
+
+	for (int iter = 0; iter < refineIterations; iter++)
+	{
+		int r0[3] = { q0[0], q0[1], q0[2] };
+		int r1[3] = { q1[0], q1[1], q1[2] };
+		int refinedIndices[16];
+		if (!RefineEndpoints(halfs, indices, r0, r1))
+			break;
+
+		int64 refinedErr = ComputeIndices(halfs, r0, r1, refinedIndices);
+		if (refinedErr >= err)
+			break;
+
+		err = refinedErr;
+		for (int c = 0; c < 3; c++)
+		{
+			q0[c] = r0[c];
+			q1[c] = r1[c];
+		}
+		tStd::tMemcpy(indices, refinedIndices, sizeof(indices));
+	}
+
+	// The high bit of the first index is implicitly 0. If it isn't, swapping the endpoints fixes that.
+	if (indices[0] & 0x8)
+	{
+		for (int c = 0; c < 3; c++)
+			tStd::tSwap(q0[c], q1[c]);
+		for (int p = 0; p < 16; p++)
+			indices[p] = 15 - indices[p];
+	}
+
+	uint64 block[2] = { 0, 0 };
+	int pos = 0;
+	PutBits(block, pos, 0x03, 5);
+	for (int c = 0; c < 3; c++)
+		PutBits(block, pos, q0[c], 10);
+	for (int c = 0; c < 3; c++)
+		PutBits(block, pos, q1[c], 10);
+
+	PutBits(block, pos, indices[0], 3);
+	for (int p = 1; p < 16; p++)
+		PutBits(block, pos, indices[p], 4);
+	tAssert(pos == 128);
+
+	tStd::tMemcpy(dest, block, 16);
+}
+
+
 namespace tImage
 {
 
 
 bool tTexture::BC7EncInitialized = false;
+std::atomic<int> tTexture::MaxCompressionThreads(0);
+bool tTexture::GammaCorrectMipmaps = false;
+tTexture::tBCParams tTexture::BCParams[2] =
+{
+	// RGBCXLevel	BC7Uber	BC7Parts	BC7Perceptual	BC6HRefine
+	{ 4,			0,		16,			true,			0 },		// Fast.
+	{ 10,			2,		64,			true,			2 }			// Production.
+};
 
 
 bool tTexture::Set(tList<tLayer>& layers)
@@ -168,7 +413,7 @@ bool tTexture::Set(tPicture& image, bool generateMipmaps, tPixelFormat pixelForm
 				break;
 
 			case tQuality::Production:
-				ok = image.Resize(newWidth, newHeight, tPicture::tFilter::Bicubic);
+				ok = image.Resize(newWidth, newHeight, tPicture::tFilter::Lanczos3);
 				break;
 		}
 		if (!ok)
@@ -182,106 +427,106 @@ bool tTexture::Set(tPicture& image, bool generateMipmaps, tPixelFormat pixelForm
 	if (pixelFormat == tPixelFormat::Auto)
 		pixelFormat = DeterminePixelFormat(image);
 
+	// Every mip level is generated in one go. Without mipmaps the chain is just a copy of the image.
+	tMipChain mipChain
+	(
+		image.GetPixelPointer(), image.GetWidth(), image.GetHeight(), DetermineFilter(quality), GetGammaCorrectMipmaps(),
+		tResamplePath::Auto, GetMaxCompressionThreads(), generateMipmaps ? 0 : 1
+	);
+	if (!mipChain.IsValid())
+		throw tError("Problem generating mipmaps for texture '%s'.", tSystem::tGetFileBaseName(image.Filename).Pod());
+
 	switch (pixelFormat)
 	{
 		case tPixelFormat::R8G8B8:
 		case tPixelFormat::R8G8B8A8:
-			ProcessImageTo_R8G8B8_Or_R8G8B8A8(image, pixelFormat, generateMipmaps, quality);
+			ProcessImageTo_R8G8B8_Or_R8G8B8A8(mipChain, pixelFormat);
 			break;
 
 		case tPixelFormat::G3B5R5G3:
-			ProcessImageTo_G3B5R5G3(image, generateMipmaps, quality);
+			ProcessImageTo_G3B5R5G3(mipChain);
 			break;
 
 		case tPixelFormat::BC1_DXT1BA:
 		case tPixelFormat::BC1_DXT1:
 		case tPixelFormat::BC2_DXT3:
 		case tPixelFormat::BC3_DXT5:
-			ProcessImageTo_BCTC(image, pixelFormat, generateMipmaps, quality);
+		case tPixelFormat::BC4_ATI1:
+		case tPixelFormat::BC5_ATI2:
+		case tPixelFormat::BC6H:
+		case tPixelFormat::BC7:
+			ProcessImageTo_BCTC(mipChain, pixelFormat, quality);
 			break;
 
 		default:
 			throw tError("Conversion of image to pixel format %d failed.", int(pixelFormat));
 	}
 
-	// Since the convert functions may or may not modify the source tPicture image, we guarantee invalidness here.
+	// The source tPicture may have been resampled. We guarantee invalidness here.
 	image.Clear();
 	return true;
 }
 
 
-void tTexture::ProcessImageTo_R8G8B8_Or_R8G8B8A8(tPicture& image, tPixelFormat format, bool generateMipmaps, tQuality quality)
+void tTexture::CreateSharedLayers(const tMipChain& mipChain, tPixelFormat format)
+{
+	int totalSize = 0;
+	for (int level = 0; level < mipChain.GetNumLevels(); level++)
+	{
+		tLayer* layer = new tLayer();
+		layer->PixelFormat = format;
+		layer->Width = mipChain.GetWidth(level);
+		layer->Height = mipChain.GetHeight(level);
+		layer->OwnsData = false;
+		totalSize += layer->GetDataSize();
+		Layers.Append(layer);
+	}
+
+	tAssert(!LayerData);
+	LayerData = new uint8[totalSize];
+	uint8* data = LayerData;
+	for (tLayer* layer = Layers.First(); layer; layer = layer->Next())
+	{
+		layer->Data = data;
+		data += layer->GetDataSize();
+	}
+}
+
+
+void tTexture::ProcessImageTo_R8G8B8_Or_R8G8B8A8(const tMipChain& mipChain, tPixelFormat format)
 {
 	tAssert((format == tPixelFormat::R8G8B8) || (format == tPixelFormat::R8G8B8A8));
-	int width = image.GetWidth();
-	int height = image.GetHeight();
 	int bytesPerPixel = (format == tPixelFormat::R8G8B8) ? 3 : 4;
-	tPicture::tFilter filter = DetermineFilter(quality);
+	CreateSharedLayers(mipChain, format);
 
-	// This loop resamples (reduces) the image multiple times for mipmap generation. In general we should start with
-	// the original image every time so that we're not applying interpolations to interpolations (better quality).
-	// However, since we are only using a box-filter (pixel averaging) there is no benefit to having a fresh src
-	// image each time. The math is equivalent: (a+b/2 + c+d/2)/2 = (a+b+c+d)/4. For now we are saving the extra
-	// effort to start with an original every time. If we ever use a more advanced filter we'll need to change this
-	// behaviour. Note: we're now using bilinear as the lower quality filter. Should probably make the change.
-	while (1)
+	int level = 0;
+	for (tLayer* layer = Layers.First(); layer; layer = layer->Next(), level++)
 	{
-		int numDataBytes = width*height*bytesPerPixel;
-		uint8* layerData = new uint8[numDataBytes];
-
 		// We can just extract the data out directly from RGBA to either RGB or RGBA.
-		uint8* srcPixel = (uint8*)image.GetPixelPointer();
-		uint8* dstPixel = layerData;
-		for (int p = 0; p < width*height; p++)
+		uint8* srcPixel = (uint8*)mipChain.GetLevel(level);
+		uint8* dstPixel = layer->Data;
+		for (int p = 0; p < layer->Width*layer->Height; p++)
 		{
 			tStd::tMemcpy(dstPixel, srcPixel, bytesPerPixel);
 			srcPixel += 4;									// Src is always RGBA.
 			dstPixel += bytesPerPixel;						// Dst is RGB or RGBA.
 		}
-
-		tLayer* layer = new tLayer(format, width, height, layerData, true);
-		tAssert(numDataBytes == layer->GetDataSize());
-		Layers.Append(layer);
-
-		// Was this the last one?
-		if (((width == 1) && (height == 1)) || !generateMipmaps)
-			break;
-
-		// Remember, width and height are not necessarily the same. As soon as one reaches 1 it needs to stay there until
-		// the other gets there too.
-		if (width != 1)
-			width >>= 1;
-
-		if (height != 1)
-			height >>= 1;
-
-		image.Resize(width, height, filter);
 	}
 }
 
 
-void tTexture::ProcessImageTo_G3B5R5G3(tPicture& image, bool generateMipmaps, tQuality quality)
+void tTexture::ProcessImageTo_G3B5R5G3(const tMipChain& mipChain)
 {
-	int width = image.GetWidth();
-	int height = image.GetHeight();
 	int bytesPerPixel = 2;
-	tPicture::tFilter filter = DetermineFilter(quality);
+	CreateSharedLayers(mipChain, tPixelFormat::G3B5R5G3);
 
-	// This loop resamples (reduces) the image multiple times for mipmap generation. In general we should start with
-	// the original image every time so that we're not applying interpolations to interpolations (better quality).
-	// However, since we are only using a box-filter (pixel averaging) there is no benefit to having a fresh src
-	// image each time. The math is equivalent: (a+b/2 + c+d/2)/2 = (a+b+c+d)/4. For now we are saving the extra
-	// effort to start with an original every time. If we ever use a more advanced filter we'll need to change this
-	// behaviour. Note: we're now using bilinear as the lower quality filter. Should probably make the change.
-	while (1)
+	int level = 0;
+	for (tLayer* layer = Layers.First(); layer; layer = layer->Next(), level++)
 	{
-		int numDataBytes = width*height*bytesPerPixel;
-		uint8* layerData = new uint8[numDataBytes];
-
 		// We need to change the src data (RGBA) into 16bits.
-		tPixel* srcPixel = image.GetPixelPointer();
-		uint8* dstPixel = layerData;
-		for (int p = 0; p < width*height; p++)
+		const tPixel* srcPixel = mipChain.GetLevel(level);
+		uint8* dstPixel = layer->Data;
+		for (int p = 0; p < layer->Width*layer->Height; p++)
 		{
 			// In memory. Each letter a bit: GGGBBBBB RRRRRGGG
 			dstPixel[0] = (srcPixel->G & 0x1C << 3) | (srcPixel->B >> 3);
@@ -289,112 +534,184 @@ void tTexture::ProcessImageTo_G3B5R5G3(tPicture& image, bool generateMipmaps, tQ
 			srcPixel++;
 			dstPixel += bytesPerPixel;
 		}
-
-		tLayer* layer = new tLayer(tPixelFormat::G3B5R5G3, width, height, layerData, true);
-		tAssert(numDataBytes == layer->GetDataSize());
-		Layers.Append(layer);
-
-		// Was this the last one?
-		if (((width == 1) && (height == 1)) || !generateMipmaps)
-			break;
-
-		// Remember, width and height are not necessarily the same. As soon as one reaches 1 it needs to stay there until
-		// the other gets there too.
-		if (width != 1)
-			width >>= 1;
-
-		if (height != 1)
-			height >>= 1;
-
-		image.Resize(width, height, filter);
 	}
 }
 
 
-void tTexture::ProcessImageTo_BCTC(tPicture& image, tPixelFormat pixelFormat, bool generateMipmaps, tQuality quality)
+void tTexture::ProcessImageTo_BCTC(const tMipChain& mipChain, tPixelFormat pixelFormat, tQuality quality)
 {
-	int width = image.GetWidth();
-	int height = image.GetHeight();
-	tPicture::tFilter filter = DetermineFilter(quality);
-	if (!tMath::tIsPower2(width) || !tMath::tIsPower2(height))
+	if (!tMath::tIsPower2(mipChain.GetWidth(0)) || !tMath::tIsPower2(mipChain.GetHeight(0)))
 		throw tError("Texture must be power-of-2 to be compressed to a BC format.");
 
+	if (!tIsBlockFormat(pixelFormat))
+		throw tError("Unsupported BC pixel format %d.", int(pixelFormat));
+
+	// Neither initialization is threadsafe. They must be done before any compression jobs start.
 	if (!BC7EncInitialized)
 	{
 		rgbcx::init(rgbcx::bc1_approx_mode::cBC1Ideal);
+		bc7enc_compress_block_init();
 		BC7EncInitialized = true;
 	}
 
-	// This loop resamples (reduces) the image multiple times for mipmap generation. In general we should start with
-	// the original image every time so that we're not applying interpolations to interpolations (better quality).
-	// However, since we are only using a box-filter (pixel averaging) there is no benefit to having a fresh src
-	// image each time. The math is equivalent: (a+b/2 + c+d/2)/2 = (a+b+c+d)/4. For now we are saving the extra
-	// effort to start with an original every time. If we ever use a more advanced filter we'll need to change this
-	// behaviour. Note: we're now using bilinear as the lower quality filter. Should probably make the change.
-	while (1)
+	// The first pass sets up the layers and the list of levels. No compression happens yet. This way the second pass
+	// can compress all block rows of all levels at the same time. Levels smaller than a block still get a whole block.
+	// The compressor repeats their edge pixels to fill it.
+	CreateSharedLayers(mipChain, pixelFormat);
+	tList<BCLevel> levels;
+	int totalBlockRows = 0;
+	int levelIndex = 0;
+	for (tLayer* layer = Layers.First(); layer; layer = layer->Next(), levelIndex++)
+	{
+		BCLevel* level = new BCLevel;
+		level->Source = mipChain.GetLevel(levelIndex);
+		level->Width = layer->Width;
+		level->Height = layer->Height;
+		level->NumBlocksX = tMath::tMax(1, layer->Width/4);
+		level->NumBlocksY = tMath::tMax(1, layer->Height/4);
+		level->FirstBlockRow = totalBlockRows;
+		level->Output = layer->Data;
+		totalBlockRows += level->NumBlocksY;
+		tAssert(layer->GetDataSize() == level->NumBlocksX * level->NumBlocksY * tGetBytesPer4x4PixelBlock(pixelFormat));
+		levels.Append(level);
+	}
+
+	// The second pass does the compression. Every block row is independent and the encoder is deterministic, so the
+	// output is byte-identical regardless of how many threads are used or what order the rows complete in.
+	const tBCParams& params = GetBCParams(quality);
+	auto compressRow = [&levels, &params, pixelFormat](int blockRow)
+	{
+		BCLevel* level = levels.First();
+		while (level->Next() && (blockRow >= level->Next()->FirstBlockRow))
+			level = level->Next();
+		CompressBlockRow(pixelFormat, params, *level, blockRow - level->FirstBlockRow);
+	};
+
+	int maxThreads = GetMaxCompressionThreads();
+	if (maxThreads == 1)
+	{
+		for (int blockRow = 0; blockRow < totalBlockRows; blockRow++)
+			compressRow(blockRow);
+	}
+	else
+	{
+		tSystem::tGetSharedJobSystem().ParallelFor(totalBlockRows, compressRow, 1, maxThreads);
+	}
+}
+
+
+void tTexture::CompressBlockRow(tPixelFormat pixelFormat, const tBCParams& params, const BCLevel& level, int blockY)
+{
+	int blockSize = tGetBytesPer4x4PixelBlock(pixelFormat);
+	uint8* blockDest = level.Output + blockY*level.NumBlocksX*blockSize;
+
+	bc7enc_compress_block_params bc7Params;
+	if (pixelFormat == tPixelFormat::BC7)
 	{
-		// Setup the layer data to receive the compressed data.
-		int numBlocks = tMath::tMax(1, width/4) * tMath::tMax(1, height/4);
-		int blockSize = (pixelFormat == tPixelFormat::BC1_DXT1) ? 8 : 16;
-		int outputSize = numBlocks * blockSize;
-		uint8* outputData = new uint8[outputSize];
+		bc7enc_compress_block_params_init(&bc7Params);
+		if (!params.BC7Perceptual)
+			bc7enc_compress_block_params_init_linear_weights(&bc7Params);
+		bc7Params.m_uber_level = tMath::tClamp(params.BC7UberLevel, 0, BC7ENC_MAX_UBER_LEVEL);
+		bc7Params.m_max_partitions_mode = tMath::tClamp(params.BC7MaxPartitions, 0, BC7ENC_MAX_PARTITIONS1);
+	}
+	int rgbcxLevel = tMath::tClamp(params.RGBCXLevel, int(rgbcx::MIN_LEVEL), int(rgbcx::MAX_LEVEL));
 
-		int encoderQualityLevel = (quality == tQuality::Fast) ? 4 : 10;
-		bool allow3colour = true;
-		bool useTransparentTexelsForBlack = false;
+	// Levels smaller than a block have their reads clamped to the edges.
+	int srcMaxX = level.Width - 1;
+	int srcMaxY = level.Height - 1;
 
-		uint8* blockDest = outputData;
-		uint8* pixelSrc = (uint8*)image.GetPixelPointer();
-		for (int block = 0; block < numBlocks; block++)
+	// The encoders want the 16 pixels of a block in one contiguous run.
+	tPixel blockPixels[16];
+	for (int blockX = 0; blockX < level.NumBlocksX; blockX++)
+	{
+		for (int y = 0; y < 4; y++)
+			for (int x = 0; x < 4; x++)
+				blockPixels[y*4 + x] = level.Source[tMath::tMin(blockY*4 + y, srcMaxY)*level.Width + tMath::tMin(blockX*4 + x, srcMaxX)];
+
+		switch (pixelFormat)
 		{
-			switch (pixelFormat)
-			{
-				case tPixelFormat::BC1_DXT1:
-					rgbcx::encode_bc1(encoderQualityLevel, blockDest, pixelSrc, allow3colour, useTransparentTexelsForBlack);
-					break;
+			case tPixelFormat::BC1_DXT1:
+				rgbcx::encode_bc1(rgbcxLevel, blockDest, (uint8*)blockPixels, true, false);
+				break;
 
-				case tPixelFormat::BC3_DXT5:
-					rgbcx::encode_bc3(encoderQualityLevel, blockDest, pixelSrc);
-					break;
+			case tPixelFormat::BC1_DXT1BA:
+				rgbcx::encode_bc1(rgbcxLevel, blockDest, (uint8*)blockPixels, true, false);
+				SetBC1BinaryAlpha(blockDest, blockPixels);
+				break;
 
-				default:
-					throw tError("Unsupported BC pixel format %d.", int(pixelFormat));
+			case tPixelFormat::BC2_DXT3:
+			{
+				// Explicit 4-bit alphas followed by a colour block. BC2 colour blocks are always in 4-colour mode.
+				uint64 alphas = 0;
+				for (int p = 0; p < 16; p++)
+					alphas |= uint64((blockPixels[p].A*15 + 127) / 255) << (p*4);
+				tStd::tMemcpy(blockDest, &alphas, 8);
+				rgbcx::encode_bc1(rgbcxLevel, blockDest + 8, (uint8*)blockPixels, false, false);
+				break;
 			}
-			blockDest += blockSize;
-			pixelSrc += sizeof(tPixel);
-		}
 
-		// The last true in this call allows the layer constructor to steal the outputData pointer. Avoids extra memcpys.
-		tLayer* layer = new tLayer(pixelFormat, width, height, outputData, true);
-		tAssert(layer->GetDataSize() == outputSize);
-		Layers.Append(layer);
+			case tPixelFormat::BC3_DXT5:
+				rgbcx::encode_bc3(rgbcxLevel, blockDest, (uint8*)blockPixels);
+				break;
 
-		// Was this the last one?
-		if (((width == 1) && (height == 1)) || !generateMipmaps)
-			break;
+			case tPixelFormat::BC4_ATI1:
+				rgbcx::encode_bc4(blockDest, (uint8*)blockPixels, sizeof(tPixel));
+				break;
 
-		if (width != 1)
-			width >>= 1;
-
-		if (height != 1)
-			height >>= 1;
-
-		// When using BC compression we don't ever want to scale lower than 4x4 as that is the individual block size.
-		// we need at least that much data so the compressor can do it's job. Consider a 128x4 texture: Ideally we want
-		// that to rescale to 64x4, rather than 64x2. So it's reasonable to just stop once either dimension reaches 4
-		// because otherwise non-uniform scale issues come into play. In short, we either have to deal with this
-		// distortion, or the cropping issue of just stopping. We do the latter because it's just easier.
-		//
-		// Just because we stop downscaling doesn't mean that we don't generate all the mipmap levels! We still
-		// generate all the way to 1x1. It's only the src data that stops being down-sampled.
-		if ((image.GetWidth() >= 8) && (image.GetHeight() >= 8))
-		{
-			// This code scales by half using the correct quality filter.
-			int newWidth = image.GetWidth() / 2;
-			int newHeight = image.GetHeight() / 2;
-			image.Resize(newWidth, newHeight, filter);
+			case tPixelFormat::BC5_ATI2:
+				rgbcx::encode_bc5(blockDest, (uint8*)blockPixels, 0, 1, sizeof(tPixel));
+				break;
+
+			case tPixelFormat::BC6H:
+				BC6H::EncodeBlock(blockDest, blockPixels, params.BC6HRefineIterations);
+				break;
+
+			case tPixelFormat::BC7:
+				bc7enc_compress_block(blockDest, blockPixels, &bc7Params);
+				break;
 		}
+		blockDest += blockSize;
+	}
+}
+
+
+void tTexture::SetBC1BinaryAlpha(uint8* block, const tPixel* pixels)
+{
+	bool anyTransparent = false;
+	for (int p = 0; p < 16; p++)
+		if (pixels[p].A < 128)
+			anyTransparent = true;
+
+	if (!anyTransparent)
+		return;
+
+	// Transparent texels need the block to be in 3-colour mode (colour0 <= colour1), where index 3 is transparent. A
+	// 4-colour block is converted by swapping the endpoints and collapsing both intermediate colours to the midpoint.
+	uint16 colour0 = block[0] | (block[1] << 8);
+	uint16 colour1 = block[2] | (block[3] << 8);
+	uint32 indices = block[4] | (block[5] << 8) | (block[6] << 16) | (block[7] << 24);
+	bool fourColour = colour0 > colour1;
+	if (fourColour)
+	{
+		tStd::tSwap(block[0], block[2]);
+		tStd::tSwap(block[1], block[3]);
 	}
+
+	uint32 newIndices = 0;
+	for (int p = 0; p < 16; p++)
+	{
+		uint32 index = (indices >> (p*2)) & 0x3;
+		if (pixels[p].A < 128)
+			index = 3;
+		else if (fourColour)
+			index = (index >= 2) ? 2 : (index ^ 1);
+		newIndices |= index << (p*2);
+	}
+
+	block[4] = newIndices & 0xFF;
+	block[5] = (newIndices >> 8) & 0xFF;
+	block[6] = (newIndices >> 16) & 0xFF;
+	block[7] = (newIndices >> 24) & 0xFF;
 }
 
 
@@ -472,10 +789,10 @@ bool tTexture::operator==(const tTexture& src) const
 	if (Opaque != src.Opaque)
 		return false;
 
-	if (Layers.GetNumItems() != Layers.GetNumItems())
+	if (Layers.GetNumItems() != src.Layers.GetNumItems())
 		return false;
 
-	tLayer* srcLayer = Layers.First();
+	tLayer* srcLayer = src.Layers.First();
 	for (tLayer* layer = Layers.First(); layer; layer = layer->Next(), srcLayer = srcLayer->Next())
 		if (*layer != *srcLayer)
 			return false;
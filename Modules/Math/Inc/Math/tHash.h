@@ -20,6 +20,7 @@
 #include <Foundation/tStandard.h>
 #include <Foundation/tString.h>
 #include <Foundation/tFixInt.h>
+#include <Foundation/tHashMap.h>
 namespace tMath
 {
 
@@ -84,6 +85,70 @@ tuint256 tHashString256(const char*, const tuint256& iv = HashIV256);
 tuint256 tHashString256(const tString&, const tuint256& iv = HashIV256);
 
 
+// The hashers compute the same values as the HashData functions above, but the data may be supplied in pieces of any
+// size by calling Update as many times as needed. Unlike chaining, the result is identical to hashing all the data in
+// a single call. Only a single block of state is kept, so they are ideal for streaming large files. Call Finish once
+// after all the data has been supplied. The Fast32 hash doesn't need one as it can be chained exactly.
+class tHasher32
+{
+public:
+	tHasher32(uint32 iv = HashIV32)																						: A(0x9e3779b9), B(0x9e3779b9), C(iv), Length(0), NumBuffered(0) { }
+	void Update(const uint8* data, int length);
+	uint32 Finish();
+
+private:
+	uint32 A, B, C;
+	uint32 Length;
+	uint8 Buffer[12];
+	int NumBuffered;
+};
+
+
+class tHasher64
+{
+public:
+	tHasher64(uint64 iv = HashIV64)																						: A(0x9e3779b97f4a7c13ULL), B(0x9e3779b97f4a7c13ULL), C(iv), Length(0), NumBuffered(0) { }
+	void Update(const uint8* data, int length);
+	uint64 Finish();
+
+private:
+	uint64 A, B, C;
+	uint64 Length;
+	uint8 Buffer[24];
+	int NumBuffered;
+};
+
+
+// As with tHashDataMD5 there is no iv. MD5 values are standard.
+class tHasherMD5
+{
+public:
+	tHasherMD5();
+	void Update(const uint8* data, int length);
+	tuint128 Finish();
+
+private:
+	uint32 Count[2];										// 64bit counter for number of bits (lo, hi).
+	uint32 State[4];										// Digest so far.
+	uint8 Buffer[64];										// Bytes that didn't fit in last 64 byte chunk.
+};
+
+
+class tHasher256
+{
+public:
+	tHasher256(const tuint256& iv = HashIV256);
+	void Update(const uint8* data, int length);
+	tuint256 Finish();
+
+private:
+	uint32 State[8];										// State[0] is 'a', the most significant.
+	uint32 Length;
+	uint8 Buffer[32];
+	int NumBuffered;
+};
+
+
 // Implementation below this line.
 
 
@@ -114,3 +179,12 @@ inline tuint256 tHashString256(const tString& s, const tuint256& iv)
 
 
 }
+
+
+// Key traits so tStrings may be used directly as tHashMap and tHashSet keys. These live here rather than in
+// Foundation/tHashMap.h because the string hash functions belong to the Math module.
+template<> struct tHashKey<tString>
+{
+	static uint32 Hash(const tString& key)																				{ return tMath::tHashStringFast32(key); }
+	static bool Equal(const tString& a, const tString& b)																{ return a == b; }
+};
@@ -17,6 +17,7 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <Foundation/tStandard.h>
+#include "Math/tFundamentals.h"
 #include "Math/tHash.h"
 
 
@@ -52,28 +53,62 @@ namespace tHash
 }
 
 
-uint32 tMath::tHashData32(const uint8* data, int length, uint32 iv)
+namespace tHash
 {
-	uint32 a,b,c;											// The internal state.
-	int len;												// How many key bytes still need mixing.
-
-	len = length;
-	a = b = 0x9e3779b9;										// The golden ratio; an arbitrary value.
-	c = iv;													// Variable initialization of internal state.
-
-	// Do as many 12 byte chunks as we can.
-	while (len >= 12)
+	inline void Block32(uint32& a, uint32& b, uint32& c, const uint8* data)
 	{
 		a += data[0] + (uint32(data[1]) << 8) + (uint32(data[2]) << 16) + (uint32(data[3]) << 24);
 		b += data[4] + (uint32(data[5]) << 8) + (uint32(data[6]) << 16) + (uint32(data[7]) << 24);
 		c += data[8] + (uint32(data[9]) << 8) + (uint32(data[10]) << 16) + (uint32(data[11]) << 24);
 		tHash::Mix32(a,b,c);
-		data += 12; len -= 12;
 	}
+}
+
+
+uint32 tMath::tHashData32(const uint8* data, int length, uint32 iv)
+{
+	tHasher32 hasher(iv);
+	hasher.Update(data, length);
+	return hasher.Finish();
+}
+
+
+void tMath::tHasher32::Update(const uint8* data, int length)
+{
+	Length += length;
+
+	// Top up any partial block first.
+	if (NumBuffered)
+	{
+		int num = tMin(12 - NumBuffered, length);
+		tStd::tMemcpy(Buffer + NumBuffered, data, num);
+		NumBuffered += num; data += num; length -= num;
+		if (NumBuffered < 12)
+			return;
+		tHash::Block32(A, B, C, Buffer);
+		NumBuffered = 0;
+	}
+
+	// Do as many 12 byte chunks as we can.
+	while (length >= 12)
+	{
+		tHash::Block32(A, B, C, data);
+		data += 12; length -= 12;
+	}
+
+	tStd::tMemcpy(Buffer, data, length);
+	NumBuffered = length;
+}
+
+
+uint32 tMath::tHasher32::Finish()
+{
+	uint32 a = A, b = B, c = C;
+	const uint8* data = Buffer;
 
 	// Finish up the last 11 bytes.
-	c += length;
-	switch (len)											// All the case statements fall through.
+	c += Length;
+	switch (NumBuffered)									// All the case statements fall through.
 	{
 		case 11: c += uint32(data[10]) << 24;
 		case 10: c += uint32(data[9]) << 16;
@@ -115,17 +150,9 @@ namespace tHash
 }
 
 
-uint64 tMath::tHashData64(const uint8* data, int length, uint64 iv)
+namespace tHash
 {
-	uint64 a,b,c;											// The internal state.
-	int len;												// How many key bytes still need mixing.
-
-	len = length;
-	a = b = 0x9e3779b97f4a7c13ULL;							// The golden ratio; an arbitrary value.
-	c = iv;													// Variable initialization of internal state.
-
-	// Do as many 24 byte chunks as we can.
-	while (len >= 24)
+	inline void Block64(uint64& a, uint64& b, uint64& c, const uint8* data)
 	{
 		a += (uint64(data[0]) << 0) + (uint64(data[1]) << 8) + (uint64(data[2]) << 16) + (uint64(data[3]) << 24)
 		  + (uint64(data[4]) << 32) + (uint64(data[5]) << 40) + (uint64(data[6]) << 48) + (uint64(data[7]) << 56);
@@ -137,12 +164,54 @@ uint64 tMath::tHashData64(const uint8* data, int length, uint64 iv)
 		  + (uint64(data[20]) << 32) + (uint64(data[21]) << 40) + (uint64(data[22]) << 48) + (uint64(data[23]) << 56);
 
 		tHash::Mix64(a,b,c);
-		data += 24; len -= 24;
+	}
+}
+
+
+uint64 tMath::tHashData64(const uint8* data, int length, uint64 iv)
+{
+	tHasher64 hasher(iv);
+	hasher.Update(data, length);
+	return hasher.Finish();
+}
+
+
+void tMath::tHasher64::Update(const uint8* data, int length)
+{
+	Length += length;
+
+	// Top up any partial block first.
+	if (NumBuffered)
+	{
+		int num = tMin(24 - NumBuffered, length);
+		tStd::tMemcpy(Buffer + NumBuffered, data, num);
+		NumBuffered += num; data += num; length -= num;
+		if (NumBuffered < 24)
+			return;
+		tHash::Block64(A, B, C, Buffer);
+		NumBuffered = 0;
+	}
+
+	// Do as many 24 byte chunks as we can.
+	while (length >= 24)
+	{
+		tHash::Block64(A, B, C, data);
+		data += 24; length -= 24;
 	}
 
+	tStd::tMemcpy(Buffer, data, length);
+	NumBuffered = length;
+}
+
+
+uint64 tMath::tHasher64::Finish()
+{
+	uint64 a = A, b = B, c = C;
+	const uint8* data = Buffer;
+
 	// Finish up the last 23 bytes.
-	c += length;
-	switch (len)											// All the case statements fall through.
+	c += Length;
+	switch (NumBuffered)									// All the case statements fall through.
 	{
 		case 23: c += uint64(data[22]) << 56;
 		case 22: c += uint64(data[21]) << 48;
@@ -373,24 +442,33 @@ void tHash::MD5Update(uint32 count[2], uint32 state[4], const uint8* data, uint3
 
 tuint128 tMath::tHashDataMD5(const uint8* data, int len, tuint128 iv)
 {
-	uint32 length = len;
-	uint8 buffer[tHash::iMD5BlockSize];						// Bytes that didn't fit in last 64 byte chunk.
-	uint32 count[2];										// 64bit counter for number of bits (lo, hi).
-	uint32 state[4];										// Digest so far.
-	uint8 digest[16];										// The result.
+	tHasherMD5 hasher;
+	hasher.Update(data, len);
+	return hasher.Finish();
+}
+
 
+tMath::tHasherMD5::tHasherMD5()
+{
 	// Phase 1. Initialize state variables.
-	count[0] = 0;
-	count[1] = 0;
-	state[0] = 0x67452301;									// Load magic initialization constants.
-	state[1] = 0xefcdab89;
-	state[2] = 0x98badcfe;
-	state[3] = 0x10325476;
+	Count[0] = 0;
+	Count[1] = 0;
+	State[0] = 0x67452301;									// Load magic initialization constants.
+	State[1] = 0xefcdab89;
+	State[2] = 0x98badcfe;
+	State[3] = 0x10325476;
+}
+
+
+void tMath::tHasherMD5::Update(const uint8* data, int length)
+{
+	// Phase 2. Block update. Continues an MD5 message-digest operation, processing another message block.
+	tHash::MD5Update(Count, State, data, uint32(length), Buffer);
+}
 
-	// Phase 2. Block update. Could be put in a loop to process multiple chunks of data. Continues an MD5
-	// message-digest operation, processing another message block.
-	tHash::MD5Update(count, state, data, length, buffer);
 
+tuint128 tMath::tHasherMD5::Finish()
+{
 	// Phase 3. Finalize.
 	// Ends an MD5 message-digest operation, writing the the message digest and clearing the context.
 	static uint8 padding[64] =
@@ -400,25 +478,26 @@ tuint128 tMath::tHashDataMD5(const uint8* data, int len, tuint128 iv)
 		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 	};
+	uint8 digest[16];										// The result.
 
 	// Save number of bits.
 	unsigned char bits[8];
-	tHash::MD5Encode(bits, count, 8);
+	tHash::MD5Encode(bits, Count, 8);
 
 	// Pad out to 56 mod 64.
-	int index = count[0] / 8 % 64;
+	int index = Count[0] / 8 % 64;
 	int padLen = (index < 56) ? (56 - index) : (120 - index);
-	tHash::MD5Update(count, state, padding, padLen, buffer);
+	tHash::MD5Update(Count, State, padding, padLen, Buffer);
 
 	// Append length (before padding).
-	tHash::MD5Update(count, state, bits, 8, buffer);
+	tHash::MD5Update(Count, State, bits, 8, Buffer);
 
 	// Store state in digest
-	tHash::MD5Encode(digest, state, 16);
+	tHash::MD5Encode(digest, State, 16);
 
 	// Clear sensitive information.
-	tStd::tMemset(buffer, 0, sizeof buffer);
-	tStd::tMemset(count, 0, sizeof count);
+	tStd::tMemset(Buffer, 0, sizeof Buffer);
+	tStd::tMemset(Count, 0, sizeof Count);
 
 	// Digest is now valid. The lower indexed numbers are least significant so we need to reverse the order.
 	tuint128 result;
@@ -449,20 +528,12 @@ namespace tHash
 }
 
 
-tuint256 tMath::tHashData256(const uint8* data, int len, tuint256 iv)
+namespace tHash
 {
-	uint32 a, b, c, d, e, f, g, h, length;
-
-	// Use the length and level. Add in the golden ratio. Remember, 'a' is most significant.
-	length = len;
-	uint32& A = iv.RawElement(7); uint32& B = iv.RawElement(6); uint32& C = iv.RawElement(5); uint32& D = iv.RawElement(4);
-	uint32& E = iv.RawElement(3); uint32& F = iv.RawElement(2); uint32& G = iv.RawElement(1); uint32& H = iv.RawElement(0);
-	a = A; b = B; c = C; d = D;
-	e = E; f = F; g = G; h = H;
-
-	// Process most of the key.
-	while (len >= 32)
+	inline void Block256(uint32* state, const uint8* data)
 	{
+		uint32& a = state[0]; uint32& b = state[1]; uint32& c = state[2]; uint32& d = state[3];
+		uint32& e = state[4]; uint32& f = state[5]; uint32& g = state[6]; uint32& h = state[7];
 		a += *(uint32*)(data+0);
 		b += *(uint32*)(data+4);
 		c += *(uint32*)(data+8);
@@ -475,12 +546,65 @@ tuint256 tMath::tHashData256(const uint8* data, int len, tuint256 iv)
 		tHash::Mix256(a,b,c,d,e,f,g,h);
 		tHash::Mix256(a,b,c,d,e,f,g,h);
 		tHash::Mix256(a,b,c,d,e,f,g,h);
-		data += 32; len -= 32;
 	}
+}
+
+
+tuint256 tMath::tHashData256(const uint8* data, int len, tuint256 iv)
+{
+	tHasher256 hasher(iv);
+	hasher.Update(data, len);
+	return hasher.Finish();
+}
+
+
+tMath::tHasher256::tHasher256(const tuint256& iv) :
+	Length(0),
+	NumBuffered(0)
+{
+	// Remember, 'a' is most significant.
+	for (int s = 0; s < 8; s++)
+		State[s] = iv.GetRawElement(7-s);
+}
+
+
+void tMath::tHasher256::Update(const uint8* data, int length)
+{
+	Length += length;
+
+	// Top up any partial block first.
+	if (NumBuffered)
+	{
+		int num = tMin(32 - NumBuffered, length);
+		tStd::tMemcpy(Buffer + NumBuffered, data, num);
+		NumBuffered += num; data += num; length -= num;
+		if (NumBuffered < 32)
+			return;
+		tHash::Block256(State, Buffer);
+		NumBuffered = 0;
+	}
+
+	// Process most of the key.
+	while (length >= 32)
+	{
+		tHash::Block256(State, data);
+		data += 32; length -= 32;
+	}
+
+	tStd::tMemcpy(Buffer, data, length);
+	NumBuffered = length;
+}
+
+
+tuint256 tMath::tHasher256::Finish()
+{
+	uint32 a = State[0], b = State[1], c = State[2], d = State[3];
+	uint32 e = State[4], f = State[5], g = State[6], h = State[7];
+	const uint8* data = Buffer;
 
 	// Process the last 31 bytes.
-	h += length;
-	switch (len)
+	h += Length;
+	switch (NumBuffered)
 	{
 		case 31: h += (data[30] << 24);
 		case 30: h += (data[29] << 16);
@@ -520,7 +644,8 @@ tuint256 tMath::tHashData256(const uint8* data, int len, tuint256 iv)
 	tHash::Mix256(a,b,c,d,e,f,g,h);
 	tHash::Mix256(a,b,c,d,e,f,g,h);
 
-	A = a; B = b; C = c; D = d;
-	E = e; F = f; G = g; H = h;
-	return iv;
+	tuint256 result;
+	result.RawElement(7) = a; result.RawElement(6) = b; result.RawElement(5) = c; result.RawElement(4) = d;
+	result.RawElement(3) = e; result.RawElement(2) = f; result.RawElement(1) = g; result.RawElement(0) = h;
+	return result;
 }
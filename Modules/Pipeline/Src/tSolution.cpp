@@ -27,14 +27,16 @@ tVisualStudioSolution::tVisualStudioSolution(const tString& slnFile) :
 	if (!tSystem::tFileExists(slnFile))
 		throw tSolutionError("Cannot process solution file [%s] for dependencies.", slnFile.Pod());
 
-	int numBytes = tSystem::tGetFileSize(slnFile);
+	int64 numBytes = tSystem::tGetFileSize(slnFile);
 	if (numBytes <= 0)
 		return;
+	if (numBytes >= 0x7FFFFFFF)
+		throw tSolutionError("Solution file [%s] is too big to process.", slnFile.Pod());
 
 	Directory = tSystem::tGetDir(slnFile);
 
 	// Load the file into a string.
-	tString fileData(numBytes);
+	tString fileData(int(numBytes));
 	tSystem::tLoadFile(slnFile, (uint8*)fileData.Text());
 	tString extension(".vcxproj");
 
@@ -72,14 +74,16 @@ tVisualStudioProject::tVisualStudioProject(const tString& projFile) :
 	if (!tSystem::tFileExists(projFile))
 		throw tSolutionError("Cannot process project file [%s] for dependencies.", projFile.Pod());
 
-	int numBytes = tSystem::tGetFileSize(projFile);
+	int64 numBytes = tSystem::tGetFileSize(projFile);
 	if (numBytes <= 0)
 		return;
+	if (numBytes >= 0x7FFFFFFF)
+		throw tSolutionError("Project file [%s] is too big to process.", projFile.Pod());
 
 	Directory = tSystem::tGetDir(projFile);
 
 	// Load the file into a string.
-	tString fileData(numBytes);
+	tString fileData(int(numBytes));
 	tSystem::tLoadFile(projFile, (uint8*)fileData.Text());
 	tString tagA("ClCompile Include=");
 	tString tagB("ClInclude Include=");
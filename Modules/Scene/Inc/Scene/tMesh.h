@@ -47,13 +47,20 @@ class tMesh
 {
 public:
 	tMesh()																												{ }
-	tMesh(const tChunk& chunk)																							{ Load(chunk); }
+	tMesh(const tChunk& chunk, bool ownsTables = true)																	{ Load(chunk, ownsTables); }
 	tMesh(const tMesh& src)																								{ *this = src; }
 	virtual ~tMesh()																									{ }
 
 	void Save(tChunkWriter&) const;
-	void Load(const tChunk&);
+	// If ownsTables is false the tables point directly into the chunk data instead of being copied. This is fast when
+	// the chunk file is memory mapped, but the chunk memory must outlive the mesh. A mesh that doesn't own its tables
+	// may still be modified in place, but the Create table functions may not be called until the mesh is cleared.
+	// Assigning such a mesh to another one makes a deep copy that owns its tables.
+	void Load(const tChunk&, bool ownsTables = true);
+
+	// Clear destroys all tables. After a clear the mesh always owns its tables.
 	void Clear();
+	bool GetOwnsTables() const																							{ return OwnsTables; }
 	void Scale(float);
 
 	// Reverses the winding order of all face index tables. That is, those tables that are arrays of tTriFaces.
@@ -66,24 +73,24 @@ public:
 	// number of faces does _not_ modify or delete the associated tables.
 	void SetNumFaces(int numFaces)																						{ NumFaces = numFaces; }
 	int GetNumFaces() const																								{ return NumFaces; }
-	void CreateFaceTableVertPositionIndices()																			{ DestroyFaceTableVertPositionIndices(); if (NumFaces) FaceTableVertPositionIndices = new tMath::tTriFace[NumFaces]; }
-	void DestroyFaceTableVertPositionIndices()																			{ delete[] FaceTableVertPositionIndices; FaceTableVertPositionIndices = nullptr; }
-	void CreateFaceTableVertWeightSetIndices()																			{ DestroyFaceTableVertWeightSetIndices(); if (NumFaces) FaceTableVertWeightSetIndices = new tMath::tTriFace[NumFaces]; }
-	void DestroyFaceTableVertWeightSetIndices()																			{ delete[] FaceTableVertWeightSetIndices; FaceTableVertWeightSetIndices = nullptr; }
-	void CreateFaceTableVertNormalIndices()																				{ DestroyFaceTableVertNormalIndices(); if (NumFaces) FaceTableVertNormalIndices = new tMath::tTriFace[NumFaces]; }
-	void DestroyFaceTableVertNormalIndices()																			{ delete[] FaceTableVertNormalIndices; FaceTableVertNormalIndices = nullptr; }
-	void CreateFaceTableFaceNormals()																					{ DestroyFaceTableFaceNormals(); if (NumFaces) FaceTableFaceNormals = new tMath::tVector3[NumFaces]; }
-	void DestroyFaceTableFaceNormals()																					{ delete[] FaceTableFaceNormals; FaceTableFaceNormals = nullptr; }
-	void CreateFaceTableUVIndices()																						{ DestroyFaceTableUVIndices(); if (NumFaces) FaceTableUVIndices = new tMath::tTriFace[NumFaces]; }
-	void DestroyFaceTableUVIndices()																					{ delete[] FaceTableUVIndices; FaceTableUVIndices = nullptr; }
-	void CreateFaceTableNormalMapUVIndices()																			{ DestroyFaceTableNormalMapUVIndices(); if (NumFaces) FaceTableNormalMapUVIndices = new tMath::tTriFace[NumFaces]; }
-	void DestroyFaceTableNormalMapUVIndices()																			{ delete[] FaceTableNormalMapUVIndices; FaceTableNormalMapUVIndices = nullptr; }
-	void CreateFaceTableColourIndices()																					{ DestroyFaceTableColourIndices(); if (NumFaces) FaceTableColourIndices = new tMath::tTriFace[NumFaces]; }
-	void DestroyFaceTableColourIndices()																				{ delete[] FaceTableColourIndices; FaceTableColourIndices = nullptr; }
-	void CreateFaceTableMaterialIDs()																					{ DestroyFaceTableMaterialIDs(); if (NumFaces) FaceTableMaterialIDs = new uint32[NumFaces]; }
-	void DestroyFaceTableMaterialIDs()																					{ delete[] FaceTableMaterialIDs; FaceTableMaterialIDs = nullptr; }
-	void CreateFaceTableTangentIndices()																				{ DestroyFaceTableTangentIndices(); if (NumFaces) FaceTableTangentIndices = new tMath::tTriFace[NumFaces]; }
-	void DestroyFaceTableTangentIndices()																				{ delete[] FaceTableTangentIndices; FaceTableTangentIndices = nullptr; }
+	void CreateFaceTableVertPositionIndices()																			{ tAssert(OwnsTables); DestroyFaceTableVertPositionIndices(); if (NumFaces) FaceTableVertPositionIndices = new tMath::tTriFace[NumFaces]; }
+	void DestroyFaceTableVertPositionIndices()																			{ if (OwnsTables) delete[] FaceTableVertPositionIndices; FaceTableVertPositionIndices = nullptr; }
+	void CreateFaceTableVertWeightSetIndices()																			{ tAssert(OwnsTables); DestroyFaceTableVertWeightSetIndices(); if (NumFaces) FaceTableVertWeightSetIndices = new tMath::tTriFace[NumFaces]; }
+	void DestroyFaceTableVertWeightSetIndices()																			{ if (OwnsTables) delete[] FaceTableVertWeightSetIndices; FaceTableVertWeightSetIndices = nullptr; }
+	void CreateFaceTableVertNormalIndices()																				{ tAssert(OwnsTables); DestroyFaceTableVertNormalIndices(); if (NumFaces) FaceTableVertNormalIndices = new tMath::tTriFace[NumFaces]; }
+	void DestroyFaceTableVertNormalIndices()																			{ if (OwnsTables) delete[] FaceTableVertNormalIndices; FaceTableVertNormalIndices = nullptr; }
+	void CreateFaceTableFaceNormals()																					{ tAssert(OwnsTables); DestroyFaceTableFaceNormals(); if (NumFaces) FaceTableFaceNormals = new tMath::tVector3[NumFaces]; }
+	void DestroyFaceTableFaceNormals()																					{ if (OwnsTables) delete[] FaceTableFaceNormals; FaceTableFaceNormals = nullptr; }
+	void CreateFaceTableUVIndices()																						{ tAssert(OwnsTables); DestroyFaceTableUVIndices(); if (NumFaces) FaceTableUVIndices = new tMath::tTriFace[NumFaces]; }
+	void DestroyFaceTableUVIndices()																					{ if (OwnsTables) delete[] FaceTableUVIndices; FaceTableUVIndices = nullptr; }
+	void CreateFaceTableNormalMapUVIndices()																			{ tAssert(OwnsTables); DestroyFaceTableNormalMapUVIndices(); if (NumFaces) FaceTableNormalMapUVIndices = new tMath::tTriFace[NumFaces]; }
+	void DestroyFaceTableNormalMapUVIndices()																			{ if (OwnsTables) delete[] FaceTableNormalMapUVIndices; FaceTableNormalMapUVIndices = nullptr; }
+	void CreateFaceTableColourIndices()																					{ tAssert(OwnsTables); DestroyFaceTableColourIndices(); if (NumFaces) FaceTableColourIndices = new tMath::tTriFace[NumFaces]; }
+	void DestroyFaceTableColourIndices()																				{ if (OwnsTables) delete[] FaceTableColourIndices; FaceTableColourIndices = nullptr; }
+	void CreateFaceTableMaterialIDs()																					{ tAssert(OwnsTables); DestroyFaceTableMaterialIDs(); if (NumFaces) FaceTableMaterialIDs = new uint32[NumFaces]; }
+	void DestroyFaceTableMaterialIDs()																					{ if (OwnsTables) delete[] FaceTableMaterialIDs; FaceTableMaterialIDs = nullptr; }
+	void CreateFaceTableTangentIndices()																				{ tAssert(OwnsTables); DestroyFaceTableTangentIndices(); if (NumFaces) FaceTableTangentIndices = new tMath::tTriFace[NumFaces]; }
+	void DestroyFaceTableTangentIndices()																				{ if (OwnsTables) delete[] FaceTableTangentIndices; FaceTableTangentIndices = nullptr; }
 
 	int NumFaces;
 	tMath::tTriFace* FaceTableVertPositionIndices = nullptr;	// Contains indices into the vert position table.
@@ -100,8 +107,8 @@ public:
 	void SetNumEdges(int numEdges)																						{ NumEdges = numEdges; }
 	int GetNumEdges() const																								{ return NumEdges; }
 	int FindEdgeIndex(const tMath::tEdge& edge) const																	{ for (int e = 0; e < NumEdges; e++) if (EdgeTableVertPositionIndices[e] == edge) return e; return -1; }
-	void CreateEdgeTableVertPositionIndices()																			{ DestroyEdgeTableVertPositionIndices(); if (NumEdges) EdgeTableVertPositionIndices = new tMath::tEdge[NumEdges]; }
-	void DestroyEdgeTableVertPositionIndices()																			{ delete[] EdgeTableVertPositionIndices; EdgeTableVertPositionIndices = nullptr; }
+	void CreateEdgeTableVertPositionIndices()																			{ tAssert(OwnsTables); DestroyEdgeTableVertPositionIndices(); if (NumEdges) EdgeTableVertPositionIndices = new tMath::tEdge[NumEdges]; }
+	void DestroyEdgeTableVertPositionIndices()																			{ if (OwnsTables) delete[] EdgeTableVertPositionIndices; EdgeTableVertPositionIndices = nullptr; }
 	int NumEdges;
 	tMath::tEdge* EdgeTableVertPositionIndices = nullptr;		// Contains indices into the vert pos table, 2 per edge.
 	
@@ -109,58 +116,61 @@ public:
 	void SetNumVertPositions(int numVertPositions)																		{ NumVertPositions = numVertPositions; }
 	int GetNumVertPositions() const																						{ return NumVertPositions; }
 	int FindVertPositionIndex(const tMath::tVector3& pos) const															{ for (int p = 0; p < NumVertPositions; p++) if (VertTablePositions[p] == pos) return p; return -1; }
-	void CreateVertTablePositions()																						{ DestroyVertTablePositions(); if (NumVertPositions) VertTablePositions = new tMath::tVector3[NumVertPositions]; }
-	void DestroyVertTablePositions()																					{ delete[] VertTablePositions; VertTablePositions = nullptr; }
+	void CreateVertTablePositions()																						{ tAssert(OwnsTables); DestroyVertTablePositions(); if (NumVertPositions) VertTablePositions = new tMath::tVector3[NumVertPositions]; }
+	void DestroyVertTablePositions()																					{ if (OwnsTables) delete[] VertTablePositions; VertTablePositions = nullptr; }
 	int NumVertPositions;
 	tMath::tVector3* VertTablePositions = nullptr;
 
 	void SetNumVertWeightSets(int numVertWeightSets)																	{ NumVertWeightSets = numVertWeightSets; }
 	int GetNumVertWeightSets() const																					{ return NumVertWeightSets; }
 	int FindWeightSetIndex(const tWeightSet& set) const																	{ for (int s = 0; s < NumVertWeightSets; s++) if (VertTableWeightSets[s] == set) return s; return -1; }
-	void CreateVertTableWeightSets()																					{ DestroyVertTableWeightSets(); if (NumVertWeightSets) VertTableWeightSets = new tWeightSet[NumVertWeightSets]; }
-	void DestroyVertTableWeightSets()																					{ delete[] VertTableWeightSets; VertTableWeightSets = nullptr; }
+	void CreateVertTableWeightSets()																					{ tAssert(OwnsTables); DestroyVertTableWeightSets(); if (NumVertWeightSets) VertTableWeightSets = new tWeightSet[NumVertWeightSets]; }
+	void DestroyVertTableWeightSets()																					{ if (OwnsTables) delete[] VertTableWeightSets; VertTableWeightSets = nullptr; }
 	int NumVertWeightSets;
 	tWeightSet* VertTableWeightSets = nullptr;
 
 	void SetNumVertNormals(int numVertNormals)																			{ NumVertNormals = numVertNormals; }
 	int GetNumVertNormals() const																						{ return NumVertNormals; }
 	int FindVertNormalIndex(const tMath::tVector3& normal) const														{ for (int n = 0; n < NumVertNormals; n++) if (VertTableNormals[n] == normal) return n; return -1; }
-	void CreateVertTableNormals()																						{ DestroyVertTableNormals(); if (NumVertNormals) VertTableNormals = new tMath::tVector3[NumVertNormals]; }
-	void DestroyVertTableNormals()																						{ delete[] VertTableNormals; VertTableNormals = nullptr; }
+	void CreateVertTableNormals()																						{ tAssert(OwnsTables); DestroyVertTableNormals(); if (NumVertNormals) VertTableNormals = new tMath::tVector3[NumVertNormals]; }
+	void DestroyVertTableNormals()																						{ if (OwnsTables) delete[] VertTableNormals; VertTableNormals = nullptr; }
 	int NumVertNormals;
 	tMath::tVector3* VertTableNormals = nullptr;
 
 	void SetNumVertUVs(int numVertUVs)																					{ NumVertUVs = numVertUVs; }
 	int GetNumVertUVs() const																							{ return NumVertUVs; }
 	int FindVertUVIndex(const tMath::tVector2& uv) const																{ for (int u = 0; u < NumVertUVs; u++) if (VertTableUVs[u] == uv) return u; return -1; }
-	void CreateVertTableUVs()																							{ DestroyVertTableUVs(); if (NumVertUVs) VertTableUVs = new tMath::tVector2[NumVertUVs]; }
-	void DestroyVertTableUVs()																							{ delete[] VertTableUVs; VertTableUVs = nullptr; }
+	void CreateVertTableUVs()																							{ tAssert(OwnsTables); DestroyVertTableUVs(); if (NumVertUVs) VertTableUVs = new tMath::tVector2[NumVertUVs]; }
+	void DestroyVertTableUVs()																							{ if (OwnsTables) delete[] VertTableUVs; VertTableUVs = nullptr; }
 	int NumVertUVs;
 	tMath::tVector2* VertTableUVs = nullptr;
 
 	void SetNumVertNormalMapUVs(int numVertNormalMapUVs)																{ NumVertNormalMapUVs = numVertNormalMapUVs; }
 	int GetNumVertNormalMapUVs() const																					{ return NumVertNormalMapUVs; }
 	int FindNormalMapUVIndex(const tMath::tVector2& uv) const															{ for (int u = 0; u < NumVertNormalMapUVs; u++) if (VertTableNormalMapUVs[u] == uv) return u; return -1; }
-	void CreateVertTableNormalMapUVs()																					{ DestroyVertTableNormalMapUVs(); if (NumVertNormalMapUVs) VertTableNormalMapUVs = new tMath::tVector2[NumVertNormalMapUVs]; }
-	void DestroyVertTableNormalMapUVs()																					{ delete[] VertTableNormalMapUVs; VertTableNormalMapUVs = nullptr; }
+	void CreateVertTableNormalMapUVs()																					{ tAssert(OwnsTables); DestroyVertTableNormalMapUVs(); if (NumVertNormalMapUVs) VertTableNormalMapUVs = new tMath::tVector2[NumVertNormalMapUVs]; }
+	void DestroyVertTableNormalMapUVs()																					{ if (OwnsTables) delete[] VertTableNormalMapUVs; VertTableNormalMapUVs = nullptr; }
 	int NumVertNormalMapUVs;
 	tMath::tVector2* VertTableNormalMapUVs = nullptr;
 
 	void SetNumVertColours(int numVertColours)																			{ NumVertColours = numVertColours; }
 	int GetNumVertColours() const																						{ return NumVertColours; }
 	int FindVertColourIndex(const tColouri& colour) const																{ for (int c = 0; c < NumVertColours; c++) if (VertTableColours[c] == colour) return c; return -1; }
-	void CreateVertTableColours()																						{ DestroyVertTableColours(); if (NumVertColours) VertTableColours = new tColouri[NumVertColours]; }
-	void DestroyVertTableColours()																						{ delete[] VertTableColours; VertTableColours = nullptr; }
+	void CreateVertTableColours()																						{ tAssert(OwnsTables); DestroyVertTableColours(); if (NumVertColours) VertTableColours = new tColouri[NumVertColours]; }
+	void DestroyVertTableColours()																						{ if (OwnsTables) delete[] VertTableColours; VertTableColours = nullptr; }
 	int NumVertColours;
 	tColouri* VertTableColours = nullptr;
 
 	void SetNumVertTangents(int numVertTangents)																		{ NumVertTangents = numVertTangents; }
 	int GetNumVertTangents() const																						{ return NumVertTangents; }
 	int FindVertTangentIndex(const tMath::tVector4& tangent) const														{ for (int t = 0; t < NumVertTangents; t++) if (VertTableTangents[t] == tangent) return t; return -1; }
-	void CreateVertTableTangents()																						{ DestroyVertTableTangents(); if (NumVertTangents) VertTableTangents = new tMath::tVector4[NumVertTangents]; }
-	void DestroyVertTableTangents()																						{ delete[] VertTableTangents; VertTableTangents = nullptr; }
+	void CreateVertTableTangents()																						{ tAssert(OwnsTables); DestroyVertTableTangents(); if (NumVertTangents) VertTableTangents = new tMath::tVector4[NumVertTangents]; }
+	void DestroyVertTableTangents()																						{ if (OwnsTables) delete[] VertTableTangents; VertTableTangents = nullptr; }
 	int NumVertTangents;
 	tMath::tVector4* VertTableTangents = nullptr;
+
+private:
+	bool OwnsTables = true;
 };
 
 
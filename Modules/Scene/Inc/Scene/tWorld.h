@@ -27,6 +27,8 @@
 #pragma once
 #include <Foundation/tPlatform.h>
 #include <Foundation/tList.h>
+#include <Foundation/tHashMap.h>
+#include <Math/tHash.h>
 #include "Scene/tCamera.h"
 #include "Scene/tLight.h"
 #include "Scene/tPath.h"
@@ -44,6 +46,34 @@ const uint32 SceneMajorVersion = 1;
 const uint32 SceneMinorVersion = 0;
 
 
+// Indexes one of the tWorld object lists by ID and by name so the tWorld Find calls are O(1). As with a linear search,
+// the first object in the list with a particular ID or name is the one found. The index remembers the list's
+// modification count and rebuilds itself on the next Find if anything was inserted, appended, or removed since. If you
+// change object IDs or names directly, call tWorld::InvalidateIndices.
+template<typename T> class tObjectIndex
+{
+public:
+	T* Find(uint32 id, const tItList<T>& objects)																		{ Validate(objects); T** obj = IDs.Find(id); return obj ? *obj : nullptr; }
+	T* Find(const tString& name, const tItList<T>& objects)																{ Validate(objects); T** obj = Names.Find(name); return obj ? *obj : nullptr; }
+
+	// Call after appending an object to the list. Keeps an up-to-date index up-to-date without a rebuild.
+	void Add(T* obj, const tItList<T>& objects);
+	void Invalidate()																									{ Indexed = false; }
+	void Clear()																										{ IDs.Reset(); Names.Reset(); Indexed = false; }
+
+private:
+	void Validate(const tItList<T>& objects)																			{ if (!Indexed || (ModCount != objects.GetModCount())) Rebuild(objects); }
+	void Rebuild(const tItList<T>& objects);
+
+	tHashMap<uint32, T*> IDs;
+	tHashMap<tString, T*> Names;
+
+	// The index is only valid if it was built from the list when its modification count was ModCount.
+	bool Indexed = false;
+	uint32 ModCount = 0;
+};
+
+
 class tWorld
 {
 public:
@@ -193,6 +223,11 @@ public:
 	// highest of any current LodGroups.
 	int GenerateLodGroupsFromModelNamingConvention();
 
+	// The Find calls use per-type ID and name indices. These are kept current by the Insert calls, Load, the merge
+	// functions, and AddOffsetToAllIDs. Call this if you remove objects from, or rename or re-ID objects in, the public
+	// lists directly.
+	void InvalidateIndices();
+
 private:
 	// These are helper functions to save and load different types of tObjects.
 	void SaveMaterials(tChunkWriter&) const;
@@ -260,7 +295,49 @@ public:
 	uint32 NextLodGroupID = 0;
 	uint32 NextInstanceID = 0;
 	uint32 NextSelectionID = 0;
+
+private:
+	mutable tObjectIndex<tCamera> CameraIndex;
+	mutable tObjectIndex<tLight> LightIndex;
+	mutable tObjectIndex<tPath> PathIndex;
+	mutable tObjectIndex<tMaterial> MaterialIndex;
+	mutable tObjectIndex<tSkeleton> SkeletonIndex;
+	mutable tObjectIndex<tPolyModel> PolyModelIndex;
+	mutable tObjectIndex<tLodGroup> LodGroupIndex;
+	mutable tObjectIndex<tInstance> InstanceIndex;
+	mutable tObjectIndex<tSelection> SelectionIndex;
 };
 
 
+// Implementation below this line.
+
+
+template<typename T> inline void tObjectIndex<T>::Add(T* obj, const tItList<T>& objects)
+{
+	// Only an index that was current before the append can be brought up-to-date. Otherwise leave it for a rebuild.
+	if (!Indexed || (ModCount != objects.GetModCount() - 1))
+		return;
+
+	IDs.Insert(obj->ID, obj);
+	Names.Insert(obj->Name, obj);
+	ModCount = objects.GetModCount();
+}
+
+
+template<typename T> inline void tObjectIndex<T>::Rebuild(const tItList<T>& objects)
+{
+	IDs.Clear();
+	Names.Clear();
+	IDs.Reserve(objects.GetNumItems());
+	Names.Reserve(objects.GetNumItems());
+	for (typename tItList<T>::Iter obj = objects.First(); obj; ++obj)
+	{
+		IDs.Insert(obj->ID, obj);
+		Names.Insert(obj->Name, obj);
+	}
+	ModCount = objects.GetModCount();
+	Indexed = true;
+}
+
+
 }
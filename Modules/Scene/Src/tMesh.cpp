@@ -18,6 +18,24 @@ using namespace tStd;
 using namespace tMath;
 namespace tScene
 {
+	namespace MeshLoad
+	{
+		// Returns a table of count items read from the chunk data. If the table is not owned it points straight into
+		// the chunk data. Chunk data is at least 4-byte aligned, which is all any of the table types need.
+		template<typename T> T* LoadTable(const tChunk&, int count, bool ownsTable);
+	}
+
+
+template<typename T> T* MeshLoad::LoadTable(const tChunk& chunk, int count, bool ownsTable)
+{
+	T* src = (T*)chunk.GetData();
+	if (!ownsTable)
+		return src;
+
+	T* table = new T[count];
+	tMemcpy(table, src, count * sizeof(T));
+	return table;
+}
 
 
 tMesh& tMesh::operator=(const tMesh& src)
@@ -143,13 +161,15 @@ void tMesh::Clear()
 
 	SetNumVertTangents(0);
 	DestroyVertTableTangents();
+	OwnsTables = true;
 }
 
 
-void tMesh::Load(const tChunk& meshChunk)
+void tMesh::Load(const tChunk& meshChunk, bool ownsTables)
 {
 	tAssert(meshChunk.ID() == tChunkID::Scene_Mesh);
 	Clear();
+	OwnsTables = ownsTables;
 
 	for (tChunk chunk = meshChunk.First(); chunk.Valid(); chunk = chunk.Next())
 	{
@@ -168,191 +188,89 @@ void tMesh::Load(const tChunk& meshChunk)
 				break;
 
 			case tChunkID::Scene_FaceTable_VertPositionIndices:
-			{
 				tAssert(NumFaces);
-				FaceTableVertPositionIndices = new tTriFace[NumFaces];
-				tTriFace* faces = (tTriFace*)chunk.Data();
-				for (int f = 0; f < NumFaces; f++)
-					FaceTableVertPositionIndices[f] = faces[f];
-
+				FaceTableVertPositionIndices = MeshLoad::LoadTable<tTriFace>(chunk, NumFaces, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_FaceTable_VertWeightSetIndices:
-			{
 				tAssert(NumFaces);
-				FaceTableVertWeightSetIndices = new tTriFace[NumFaces];
-				tTriFace* faces = (tTriFace*)chunk.Data();
-				for (int f = 0; f < NumFaces; f++)
-					FaceTableVertWeightSetIndices[f] = faces[f];
-
+				FaceTableVertWeightSetIndices = MeshLoad::LoadTable<tTriFace>(chunk, NumFaces, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_FaceTable_VertNormalIndices:
-			{
 				tAssert(NumFaces);
-				FaceTableVertNormalIndices = new tTriFace[NumFaces];
-				tTriFace* normalFaces = (tTriFace*)chunk.Data();
-				for (int f = 0; f < NumFaces; f++)
-					FaceTableVertNormalIndices[f] = normalFaces[f];
-
+				FaceTableVertNormalIndices = MeshLoad::LoadTable<tTriFace>(chunk, NumFaces, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_FaceTable_FaceNormals:
-			{
 				tAssert(NumFaces);
-				FaceTableFaceNormals = new tVector3[NumFaces];
-				tVector3* normals = (tVector3*)chunk.Data();
-				for (int f = 0; f < NumFaces; f++)
-					FaceTableFaceNormals[f] = normals[f];
-
+				FaceTableFaceNormals = MeshLoad::LoadTable<tVector3>(chunk, NumFaces, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_FaceTable_TexCoordIndices:
-			{
 				tAssert(NumFaces);
-				FaceTableUVIndices = new tTriFace[NumFaces];
-				tTriFace* uvFaces = (tTriFace*)chunk.Data();
-				for (int f = 0; f < NumFaces; f++)
-					FaceTableUVIndices[f] = uvFaces[f];
-
+				FaceTableUVIndices = MeshLoad::LoadTable<tTriFace>(chunk, NumFaces, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_FaceTable_NormalMapTexCoordIndices:
-			{
 				tAssert(NumFaces);
-				FaceTableNormalMapUVIndices = new tTriFace[NumFaces];
-				tTriFace* normalMapUVFaces = (tTriFace*)chunk.Data();
-				for (int f = 0; f < NumFaces; f++)
-					FaceTableNormalMapUVIndices[f] = normalMapUVFaces[f];
-
+				FaceTableNormalMapUVIndices = MeshLoad::LoadTable<tTriFace>(chunk, NumFaces, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_FaceTable_ColourIndices:
-			{
 				tAssert(NumFaces);
-				FaceTableColourIndices = new tTriFace[NumFaces];
-				tTriFace* colourFaces = (tTriFace*)chunk.Data();
-				for (int f = 0; f < NumFaces; f++)
-					FaceTableColourIndices[f] = colourFaces[f];
-
+				FaceTableColourIndices = MeshLoad::LoadTable<tTriFace>(chunk, NumFaces, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_FaceTable_MaterialIDs:
-			{
 				tAssert(NumFaces);
-				FaceTableMaterialIDs = new uint32[NumFaces];
-				uint32* matIDs = (uint32*)chunk.Data();
-				for (int f = 0; f < NumFaces; f++)
-					FaceTableMaterialIDs[f] = matIDs[f];
-
+				FaceTableMaterialIDs = MeshLoad::LoadTable<uint32>(chunk, NumFaces, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_FaceTable_TangentIndices:
-			{
 				tAssert(NumFaces);
-				FaceTableTangentIndices = new tTriFace[NumFaces];
-				tTriFace* tangentFaces = (tTriFace*)chunk.Data();
-				for (int f = 0; f < NumFaces; f++)
-					FaceTableTangentIndices[f] = tangentFaces[f];
-
+				FaceTableTangentIndices = MeshLoad::LoadTable<tTriFace>(chunk, NumFaces, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_EdgeTable_VertPositionIndices:
-			{
 				tAssert(NumEdges);
-				EdgeTableVertPositionIndices = new tEdge[NumEdges];
-				tEdge* edges = (tEdge*)chunk.Data();
-				for (int e = 0; e < NumEdges; e++)
-					EdgeTableVertPositionIndices[e] = edges[e];
-
+				EdgeTableVertPositionIndices = MeshLoad::LoadTable<tEdge>(chunk, NumEdges, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_VertTable_Positions:
-			{
 				tAssert(NumVertPositions);
-				VertTablePositions = new tVector3[NumVertPositions];
-				tVector3* verts = (tVector3*)chunk.Data();
-				for (int v = 0; v < NumVertPositions; v++)
-					VertTablePositions[v] = verts[v];
-
+				VertTablePositions = MeshLoad::LoadTable<tVector3>(chunk, NumVertPositions, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_VertTable_WeightSets:
-			{
 				tAssert(NumVertWeightSets);
-				VertTableWeightSets = new tWeightSet[NumVertWeightSets];
-				tWeightSet* weightSets = (tWeightSet*)chunk.GetData();
-				for (int s = 0; s < NumVertWeightSets; s++)
-					VertTableWeightSets[s] = weightSets[s];
-
+				VertTableWeightSets = MeshLoad::LoadTable<tWeightSet>(chunk, NumVertWeightSets, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_VertTable_Normals:
-			{
 				tAssert(NumVertNormals);
-				VertTableNormals = new tVector3[NumVertNormals];
-				tVector3* normals = (tVector3*)chunk.Data();
-				for (int n = 0; n < NumVertNormals; n++)
-					VertTableNormals[n] = normals[n];
-
+				VertTableNormals = MeshLoad::LoadTable<tVector3>(chunk, NumVertNormals, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_VertTable_TexCoords:
-			{
 				tAssert(NumVertUVs);
-				VertTableUVs = new tVector2[NumVertUVs];
-				tVector2* uvs = (tVector2*)chunk.Data();
-				for (int uv = 0; uv < NumVertUVs; uv++)
-					VertTableUVs[uv] = uvs[uv];
-
+				VertTableUVs = MeshLoad::LoadTable<tVector2>(chunk, NumVertUVs, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_VertTable_NormalMapTexCoords:
-			{
 				tAssert(NumVertNormalMapUVs);
-				VertTableNormalMapUVs = new tVector2[NumVertNormalMapUVs];
-				tVector2* uvs = (tVector2*)chunk.Data();
-				for (int uv = 0; uv < NumVertNormalMapUVs; uv++)
-					VertTableNormalMapUVs[uv] = uvs[uv];
-
+				VertTableNormalMapUVs = MeshLoad::LoadTable<tVector2>(chunk, NumVertNormalMapUVs, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_VertTable_Colours:
-			{
 				tAssert(NumVertColours);
-				VertTableColours = new tColouri[NumVertColours];
-				tColouri* colours = (tColouri*)chunk.Data();
-				for (int c = 0; c < NumVertColours; c++)
-					VertTableColours[c] = colours[c];
-
+				VertTableColours = MeshLoad::LoadTable<tColouri>(chunk, NumVertColours, ownsTables);
 				break;
-			}
 
 			case tChunkID::Scene_VertTable_Tangents:
-			{
 				tAssert(NumVertTangents);
-				VertTableTangents = new tVector4[NumVertTangents];
-				tVector4* tangents = (tVector4*)chunk.Data();
-				for (int t = 0; t < NumVertTangents; t++)
-					VertTableTangents[t] = tangents[t];
-
+				VertTableTangents = MeshLoad::LoadTable<tVector4>(chunk, NumVertTangents, ownsTables);
 				break;
-			}
 		}
 	}
 }
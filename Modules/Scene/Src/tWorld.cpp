@@ -28,6 +28,16 @@ namespace tScene
 {
 
 
+// Maps each object ID to the list index of the first object with that ID. Used when re-assigning IDs on load and merge.
+template<typename T> void BuildFirstIndexMap(tHashMap<uint32, int>& indices, const tItList<T>& objects)
+{
+	indices.Reserve(objects.GetNumItems());
+	int index = 0;
+	for (typename tItList<T>::Iter obj = objects.First(); obj; ++obj)
+		indices.Insert(obj->ID, index++);
+}
+
+
 void tWorld::Clear()
 {
 	Name.Clear();
@@ -43,6 +53,16 @@ void tWorld::Clear()
 	Instances.Empty();
 	Selections.Empty();
 
+	CameraIndex.Clear();
+	LightIndex.Clear();
+	PathIndex.Clear();
+	MaterialIndex.Clear();
+	SkeletonIndex.Clear();
+	PolyModelIndex.Clear();
+	LodGroupIndex.Clear();
+	InstanceIndex.Clear();
+	SelectionIndex.Clear();
+
 	// Empty scenes can be assumed to be at the current version.
 	MajorVersion = SceneMajorVersion;
 	MinorVersion = SceneMinorVersion;
@@ -81,6 +101,20 @@ void tWorld::Scale(float scale)
 }
 
 
+void tWorld::InvalidateIndices()
+{
+	CameraIndex.Invalidate();
+	LightIndex.Invalidate();
+	PathIndex.Invalidate();
+	MaterialIndex.Invalidate();
+	SkeletonIndex.Invalidate();
+	PolyModelIndex.Invalidate();
+	LodGroupIndex.Invalidate();
+	InstanceIndex.Invalidate();
+	SelectionIndex.Invalidate();
+}
+
+
 void tWorld::MergeScene(tWorld& sceneDestroyed)
 {
 	MergeItems
@@ -138,6 +172,8 @@ void tWorld::AddOffsetToAllIDs(uint32 offset)
 			*id += offset;
 		}
 	}
+
+	InvalidateIndices();
 }
 
 
@@ -207,31 +243,58 @@ bool tWorld::MergeItems
 
 	// We can now add the groups, cameras, lights, materials, skeletons, models, and instances to the scene.
 	while (tCamera* c = newCameras.Remove())
+	{
 		Cameras.Append(c);
+		CameraIndex.Add(c, Cameras);
+	}
 
 	while (tLight* l = newLights.Remove())
+	{
 		Lights.Append(l);
+		LightIndex.Add(l, Lights);
+	}
 
 	while (tPath* s = newPaths.Remove())
+	{
 		Paths.Append(s);
+		PathIndex.Add(s, Paths);
+	}
 
 	while (tMaterial* m = newMaterials.Remove())
+	{
 		Materials.Append(m);
+		MaterialIndex.Add(m, Materials);
+	}
 
 	while (tSkeleton* s = newSkeletons.Remove())
+	{
 		Skeletons.Append(s);
+		SkeletonIndex.Add(s, Skeletons);
+	}
 
 	while (tPolyModel* m = newPolyModels.Remove())
+	{
 		PolyModels.Append(m);
+		PolyModelIndex.Add(m, PolyModels);
+	}
 
 	while (tLodGroup* l = newLodGroups.Remove())
+	{
 		LodGroups.Append(l);
+		LodGroupIndex.Add(l, LodGroups);
+	}
 
 	while (tInstance* i = newInstances.Remove())
+	{
 		Instances.Append(i);
+		InstanceIndex.Add(i, Instances);
+	}
 
 	while (tSelection* s = newSelections.Remove())
+	{
 		Selections.Append(s);
+		SelectionIndex.Add(s, Selections);
+	}
 
 	return true;
 }
@@ -264,7 +327,7 @@ bool tWorld::CombinePolyModelInstances(tItList<tInstance>& polymodelInstances, t
 	int numColourTotal = 0;
 	int numTangentTotal =0;
 	
-	tItList<tPolyModel> combinedModels;
+	tItList<tPolyModel> combinedModels(false);
 	for (tItList<tInstance>::Iter it = polymodelInstances.First(); it; ++it)
 	{
 		tInstance* inst = it;
@@ -433,49 +496,35 @@ bool tWorld::CombinePolyModelInstances(tItList<tInstance>& polymodelInstances, t
 		it = next;
 	}
 
-	// Now remove any models left stranded.
-	tItList<tPolyModel> strandedModels;
-	for (tItList<tPolyModel>::Iter it = combinedModels.First(); it;)
-	{
-		tItList<tPolyModel>::Iter next = it + 1;
-		tPolyModel* model = it;
-
-		bool stranded = true;
-		for (tItList<tInstance>::Iter it2 = Instances.First(); stranded && it2; ++it2)
-		{
-			tInstance* inst = it2;
-			if (inst->ObjectType != tInstance::tType::PolyModel)
-				continue;
-
-			if (inst->ObjectID == model->ID)
-				stranded = false;
-		}
-
-		if (stranded)
-			strandedModels.Append(model);
+	// Now remove any models left stranded. A model is stranded if no remaining instance refers to it.
+	tHashSet<uint32> referencedModelIDs(Instances.GetNumItems());
+	for (tItList<tInstance>::Iter inst = Instances.First(); inst; ++inst)
+		if (inst->ObjectType == tInstance::tType::PolyModel)
+			referencedModelIDs.Insert(inst->ObjectID);
 
-		it = next;
-	}
+	tHashSet<tPolyModel*> strandedModels;
+	for (tItList<tPolyModel>::Iter model = combinedModels.First(); model; ++model)
+		if (!referencedModelIDs.Contains(model->ID))
+			strandedModels.Insert(model);
 
-	for (tItList< tPolyModel >::Iter it = PolyModels.First(); it;)
+	for (tItList<tPolyModel>::Iter it = PolyModels.First(); it;)
 	{
 		tItList<tPolyModel>::Iter next = it+1;
-		tPolyModel* m1 = it;
-		for (tItList<tPolyModel>::Iter it2 = strandedModels.First(); it2; ++it2)
+		tPolyModel* model = it;
+		if (strandedModels.Contains(model))
 		{
-			tPolyModel* m2 = it2;
-			if (m1 == m2)
-			{
-				PolyModels.Remove(it);
-				delete m1;
-				break;
-			}
+			PolyModels.Remove(it);
+			delete model;
 		}
 		it = next;
 	}
 
 	Instances.Append(newInstance);
 	PolyModels.Append(newModel);
+
+	// Instances and models were removed so the indices must be rebuilt.
+	InstanceIndex.Invalidate();
+	PolyModelIndex.Invalidate();
 	return true;
 }
 
@@ -598,31 +647,58 @@ void tWorld::Load(const tString& tacFile, uint32 loadFilter)
 
 	// We can now add the groups, cameras, lights, materials, skeletons, models, and instances to the scene.
 	while (tCamera* c = newCameras.Remove())
+	{
 		Cameras.Append(c);
+		CameraIndex.Add(c, Cameras);
+	}
 
 	while (tLight* l = newLights.Remove())
+	{
 		Lights.Append(l);
+		LightIndex.Add(l, Lights);
+	}
 
 	while (tPath* s = newPaths.Remove())
+	{
 		Paths.Append(s);
+		PathIndex.Add(s, Paths);
+	}
 
 	while (tMaterial* m = newMaterials.Remove())
+	{
 		Materials.Append(m);
+		MaterialIndex.Add(m, Materials);
+	}
 
 	while (tSkeleton* s = newSkeletons.Remove())
+	{
 		Skeletons.Append(s);
+		SkeletonIndex.Add(s, Skeletons);
+	}
 
 	while (tPolyModel* m = newPolyModels.Remove())
+	{
 		PolyModels.Append(m);
+		PolyModelIndex.Add(m, PolyModels);
+	}
 
 	while (tLodGroup* l = newLodGroups.Remove())
+	{
 		LodGroups.Append(l);
+		LodGroupIndex.Add(l, LodGroups);
+	}
 
 	while (tInstance* i = newInstances.Remove())
+	{
 		Instances.Append(i);
+		InstanceIndex.Add(i, Instances);
+	}
 
 	while (tSelection* s = newSelections.Remove())
+	{
 		Selections.Append(s);
+		SelectionIndex.Add(s, Selections);
+	}
 }
 
 
@@ -638,6 +714,10 @@ void tWorld::CorrectCameraIDs(tItList<tCamera>& newCameras, tItList<tInstance>&
 	for (int i = 0; i < numNewCameras; i++)
 		newIDTable[i] = NextCameraID++;
 
+	// Map original IDs to list indices so fixing up references is linear.
+	tHashMap<uint32, int> newIndices;
+	BuildFirstIndexMap(newIndices, newCameras);
+
 	// Correct all references to these IDs by the instances.
 	for (tItList<tInstance>::Iter inst = newInstances.First(); inst; ++inst)
 	{
@@ -647,23 +727,11 @@ void tWorld::CorrectCameraIDs(tItList<tCamera>& newCameras, tItList<tInstance>&
 		uint32 origID = inst->ObjectID;
 
 		// Find the correct cameras.
-		int newCameraIndex = 0;
-		bool foundCamera = false;
-		for (tItList<tCamera>::Iter camera = newCameras.First(); camera; ++camera)
-		{
-			if (origID == camera->ID)
-			{
-				foundCamera = true;
-				break;
-			}
-
-			newCameraIndex++;
-		}
-
-		if (!foundCamera)
+		int* newCameraIndex = newIndices.Find(origID);
+		if (!newCameraIndex)
 			throw tError("Could not find camera with ID %d. Could be that the list has 2 models with the same ID.", origID);
 
-		inst->ObjectID = newIDTable[newCameraIndex];
+		inst->ObjectID = newIDTable[*newCameraIndex];
 	}
 
 	// Assign the cameras their new ID.
@@ -687,6 +755,10 @@ void tWorld::CorrectLightIDs(tItList<tLight>& newLights, tItList<tInstance>& new
 	for (int i = 0; i < numNewLights; i++)
 		newIDTable[i] = NextLightID++;
 
+	// Map original IDs to list indices so fixing up references is linear.
+	tHashMap<uint32, int> newIndices;
+	BuildFirstIndexMap(newIndices, newLights);
+
 	// Correct all references to these IDs by the instances.
 	for (tItList<tInstance>::Iter inst = newInstances.First(); inst; ++inst)
 	{
@@ -696,23 +768,11 @@ void tWorld::CorrectLightIDs(tItList<tLight>& newLights, tItList<tInstance>& new
 		uint32 origID = inst->ObjectID;
 
 		// Find the correct lights.
-		int newLightIndex = 0;
-		bool foundLight = false;
-		for (tItList<tLight>::Iter light = newLights.First(); light; ++light)
-		{
-			if (origID == light->ID)
-			{
-				foundLight = true;
-				break;
-			}
-
-			newLightIndex++;
-		}
-
-		if (!foundLight)
+		int* newLightIndex = newIndices.Find(origID);
+		if (!newLightIndex)
 			throw tError("Could not find light with ID %d. Could be that the list has 2 models with the same ID.", origID);
 
-		inst->ObjectID = newIDTable[newLightIndex];
+		inst->ObjectID = newIDTable[*newLightIndex];
 	}
 
 	// Assign the lights their new ID.
@@ -736,6 +796,10 @@ void tWorld::CorrectPathIDs(tItList<tPath>& newPaths, tItList<tInstance>& newIns
 	for (int i = 0; i < numNewPaths; i++)
 		newIDTable[i] = NextPathID++;
 
+	// Map original IDs to list indices so fixing up references is linear.
+	tHashMap<uint32, int> newIndices;
+	BuildFirstIndexMap(newIndices, newPaths);
+
 	// Correct all references to these IDs by the instances.
 	for (tItList<tInstance>::Iter inst = newInstances.First(); inst; ++inst)
 	{
@@ -745,21 +809,9 @@ void tWorld::CorrectPathIDs(tItList<tPath>& newPaths, tItList<tInstance>& newIns
 		uint32 origID = inst->ObjectID;
 
 		// Find the correct path.
-		int newPathIndex = 0;
-		bool foundPath = false;
-		for (tItList<tPath>::Iter path = newPaths.First(); path; ++path)
-		{
-			if (origID == path->ID)
-			{
-				foundPath = true;
-				break;
-			}
-
-			newPathIndex++;
-		}
-
-		tAssert(foundPath);
-		inst->ObjectID = newIDTable[newPathIndex];
+		int* newPathIndex = newIndices.Find(origID);
+		tAssert(newPathIndex);
+		inst->ObjectID = newIDTable[*newPathIndex];
 	}
 
 	// Assign the paths their new ID.
@@ -787,6 +839,10 @@ void tWorld::CorrectMaterialIDs(tItList<tMaterial>& newMaterials, tItList<tPolyM
 		for (int i = 0; i < numNewMaterials; i++)
 			newIDTable[i] = NextMaterialID++;
 
+		// Map original IDs to list indices so fixing up references is linear.
+		tHashMap<uint32, int> newIndices;
+		BuildFirstIndexMap(newIndices, newMaterials);
+
 		// Correct all references to these IDs in the models. Loop through all the faces on all the new models.
 		for (tItList<tPolyModel>::Iter model = newPolyModels.First(); model; ++model)
 		{
@@ -800,21 +856,9 @@ void tWorld::CorrectMaterialIDs(tItList<tMaterial>& newMaterials, tItList<tPolyM
 				uint32 origID = mesh.FaceTableMaterialIDs[f];
 
 				// Find the correct material.
-				int newMatIndex = 0;
-				bool foundMat = false;
-				for (tItList<tMaterial>::Iter mat = newMaterials.First(); mat; ++mat)
-				{
-					if (origID == mat->ID)
-					{
-						foundMat = true;
-						break;
-					}
-
-					newMatIndex++;
-				}
-
-				tAssert(foundMat);
-				mesh.FaceTableMaterialIDs[f] = newIDTable[newMatIndex];
+				int* newMatIndex = newIndices.Find(origID);
+				tAssert(newMatIndex);
+				mesh.FaceTableMaterialIDs[f] = newIDTable[*newMatIndex];
 			}
 		}
 
@@ -839,6 +883,10 @@ void tWorld::CorrectSkeletonIDs(tItList<tSkeleton>& newSkeletons, tItList<tPolyM
 		for (int i = 0; i < numNewSkeletons; i++)
 			newIDTable[i] = NextSkeletonID++;
 
+		// Map original IDs to list indices so fixing up references is linear.
+		tHashMap<uint32, int> newIndices;
+		BuildFirstIndexMap(newIndices, newSkeletons);
+
 		// Correct all references to these IDs in the models.
 		for (tItList<tPolyModel>::Iter model = newPolyModels.First(); model; ++model)
 		{
@@ -857,21 +905,9 @@ void tWorld::CorrectSkeletonIDs(tItList<tSkeleton>& newSkeletons, tItList<tPolyM
 					uint32 origID = weightSet->Weights[w].SkeletonID;
 
 					// Find the correct skeleton.
-					int newSkelIndex = 0;
-					bool foundSkel = false;
-					for (tItList<tSkeleton>::Iter skel = newSkeletons.First(); skel; ++skel)
-					{
-						if (origID == skel->ID)
-						{
-							foundSkel = true;
-							break;
-						}
-
-						newSkelIndex++;
-					}
-
-					tAssert(foundSkel);
-					weightSet->Weights[w].SkeletonID = newIDTable[newSkelIndex];
+					int* newSkelIndex = newIndices.Find(origID);
+					tAssert(newSkelIndex);
+					weightSet->Weights[w].SkeletonID = newIDTable[*newSkelIndex];
 				}
 			}
 		}
@@ -900,6 +936,10 @@ void tWorld::CorrectPolyModelIDs(tItList<tPolyModel>& newPolyModels, tItList<tLo
 	for (int i = 0; i < numNewModels; i++)
 		newIDTable[i] = NextPolyModelID++;
 
+	// Map original IDs to list indices so fixing up references is linear.
+	tHashMap<uint32, int> newIndices;
+	BuildFirstIndexMap(newIndices, newPolyModels);
+
 	// Correct all references to these IDs by the LOD groups.
 	for (tItList<tLodGroup>::Iter group = newLodGroups.First(); group; ++group)
 	{
@@ -908,21 +948,9 @@ void tWorld::CorrectPolyModelIDs(tItList<tPolyModel>& newPolyModels, tItList<tLo
 			uint32 origID = lod->ModelID;
 
 			// Find the correct poly model.
-			int newModelIndex = 0;
-			bool foundModel = false;
-			for (tItList<tPolyModel>::Iter model = newPolyModels.First(); model; ++model)
-			{
-				if (origID == model->ID)
-				{
-					foundModel = true;
-					break;
-				}
-
-				newModelIndex++;
-			}
-
-			tAssert(foundModel);
-			lod->ModelID = newIDTable[newModelIndex];
+			int* newModelIndex = newIndices.Find(origID);
+			tAssert(newModelIndex);
+			lod->ModelID = newIDTable[*newModelIndex];
 		}
 	}
 
@@ -935,23 +963,11 @@ void tWorld::CorrectPolyModelIDs(tItList<tPolyModel>& newPolyModels, tItList<tLo
 		uint32 origID = inst->ObjectID;
 
 		// Find the correct poly model.
-		int newModelIndex = 0;
-		bool foundModel = false;
-		for (tItList<tPolyModel>::Iter model = newPolyModels.First(); model; ++model)
-		{
-			if (origID == model->ID)
-			{
-				foundModel = true;
-				break;
-			}
-
-			newModelIndex++;
-		}
-
-		if (!foundModel)
+		int* newModelIndex = newIndices.Find(origID);
+		if (!newModelIndex)
 			throw tError("Could not find model with ID %d. Could be that the list has 2 models with the same ID.", origID);
 
-		inst->ObjectID = newIDTable[newModelIndex];
+		inst->ObjectID = newIDTable[*newModelIndex];
 	}
 
 	// Assign the poly models their new ID.
@@ -986,6 +1002,10 @@ void tWorld::CorrectInstanceIDs(tItList<tInstance>& newInstances, tItList<tSelec
 	for (int i = 0; i < numNewInstances; i++)
 		newIDTable[i] = NextInstanceID++;
 
+	// Map original IDs to list indices so fixing up references is linear.
+	tHashMap<uint32, int> newIndices;
+	BuildFirstIndexMap(newIndices, newInstances);
+
 	// Correct all references to these IDs by the selections.
 	for (tItList<tSelection>::Iter sel = newSelections.First(); sel; ++sel)
 	{
@@ -996,23 +1016,11 @@ void tWorld::CorrectInstanceIDs(tItList<tInstance>& newInstances, tItList<tSelec
 			uint32 origID = *instID;
 
 			// Find the correct instances.
-			int newInstanceIndex = 0;
-			bool foundInstance = false;
-			for (tItList<tInstance>::Iter inst = newInstances.First(); inst; ++inst)
-			{
-				if (origID == inst->ID)
-				{
-					foundInstance = true;
-					break;
-				}
-
-				newInstanceIndex++;
-			}
-
-			if (!foundInstance)
+			int* newInstanceIndex = newIndices.Find(origID);
+			if (!newInstanceIndex)
 				throw tError("Could not find instance with ID %d while resolving selections.", origID);
 
-			*instID = newIDTable[newInstanceIndex];
+			*instID = newIDTable[*newInstanceIndex];
 		}
 	}
 
@@ -1042,10 +1050,14 @@ void tWorld::MergeToExistingSelections(tItList<tSelection>& newSelections)
 		}
 
 		// Transfer all the instance IDs to the existing selection if they aren't there already.
+		tHashSet<uint32> existingIDs(existingSel->InstanceIDs.GetNumItems());
+		for (tItList<uint32>::Iter instID = existingSel->InstanceIDs.First(); instID; ++instID)
+			existingIDs.Insert(*(instID.GetObject()));
+
 		for (tItList<uint32>::Iter instID = newSel->InstanceIDs.First(); instID; ++instID)
 		{
 			uint32 newID = *(instID.GetObject());
-			if (existingSel->ContainsInstance(newID))
+			if (!existingIDs.Insert(newID))
 				continue;
 
 			existingSel->InstanceIDs.Append(new uint32(newID));
@@ -1089,6 +1101,7 @@ void tWorld::Save(const tString& tacFile) const
 		SaveSelections(chunk);
 	}
 	chunk.End();
+	chunk.WriteIndex();
 }
 
 
@@ -1313,26 +1326,19 @@ int tWorld::GetNumMaterials(const tString& name) const
 void tWorld::InsertMaterial(tMaterial* material)
 {
 	Materials.Append(material);
+	MaterialIndex.Add(material, Materials);
 }
 
 
 tMaterial* tWorld::FindMaterial(const tString& name) const
 {
-	for (tItList<tMaterial>::Iter m = Materials.First(); m; ++m)
-		if (m->Name == name)
-			return m;
-
-	return nullptr;
+	return MaterialIndex.Find(name, Materials);
 }
 
 
 tMaterial* tWorld::FindMaterial(uint32 id) const
 {
-	for (tItList<tMaterial>::Iter m = Materials.First(); m; ++m)
-		if (m->ID == id)
-			return m;
-
-	return nullptr;
+	return MaterialIndex.Find(id, Materials);
 }
 
 
@@ -1353,26 +1359,19 @@ int tWorld::GetNumSkeletons(const tString& name) const
 void tWorld::InsertSkeleton(tSkeleton* skeleton)
 {
 	Skeletons.Append(skeleton);
+	SkeletonIndex.Add(skeleton, Skeletons);
 }
 
 
 tSkeleton* tWorld::FindSkeleton(const tString& name) const
 {
-	for (tItList<tSkeleton>::Iter s = Skeletons.First(); s; ++s)
-		if (s->Name == name)
-			return s;
-
-	return nullptr;
+	return SkeletonIndex.Find(name, Skeletons);
 }
 
 
 tSkeleton* tWorld::FindSkeleton(uint32 id) const
 {
-	for (tItList<tSkeleton>::Iter s = Skeletons.First(); s; ++s)
-		if (s->ID == id)
-			return s;
-
-	return nullptr;
+	return SkeletonIndex.Find(id, Skeletons);
 }
 
 
@@ -1393,26 +1392,19 @@ int tWorld::GetNumModels(const tString& name) const
 void tWorld::InsertPolyModel(tPolyModel* polyModel)
 {
 	PolyModels.Append(polyModel);
+	PolyModelIndex.Add(polyModel, PolyModels);
 }
 
 
 tPolyModel* tWorld::FindPolyModel(const tString& name) const
 {
-	for (tItList<tPolyModel>::Iter m = PolyModels.First(); m; ++m)
-		if (m->Name == name)
-			return m;
-
-	return nullptr;
+	return PolyModelIndex.Find(name, PolyModels);
 }
 
 
 tPolyModel* tWorld::FindPolyModel(uint32 id) const
 {
-	for (tItList<tPolyModel>::Iter m = PolyModels.First(); m; ++m)
-		if (m->ID == id)
-			return m;
-
-	return nullptr;
+	return PolyModelIndex.Find(id, PolyModels);
 }
 
 
@@ -1433,26 +1425,19 @@ int tWorld::GetNumCameras(const tString& name) const
 void tWorld::InsertCamera(tCamera* camera)
 {
 	Cameras.Append(camera);
+	CameraIndex.Add(camera, Cameras);
 }
 
 
 tCamera* tWorld::FindCamera(const tString& name) const
 {
-	for (tItList<tCamera>::Iter c = Cameras.First(); c; ++c)
-		if (c->Name == name)
-			return c;
-
-	return nullptr;
+	return CameraIndex.Find(name, Cameras);
 }
 
 
 tCamera* tWorld::FindCamera(uint32 id) const
 {
-	for (tItList<tCamera>::Iter c = Cameras.First(); c; ++c)
-		if (c->ID == id)
-			return c;
-
-	return nullptr;
+	return CameraIndex.Find(id, Cameras);
 }
 
 
@@ -1473,26 +1458,19 @@ int tWorld::GetNumLights(const tString& name) const
 void tWorld::InsertLight(tLight* light)
 {
 	Lights.Append(light);
+	LightIndex.Add(light, Lights);
 }
 
 
 tLight* tWorld::FindLight(const tString& name) const
 {
-	for (tItList<tLight>::Iter l = Lights.First(); l; ++l)
-		if (l->Name == name)
-			return l;
-
-	return nullptr;
+	return LightIndex.Find(name, Lights);
 }
 
 
 tLight* tWorld::FindLight(uint32 id) const
 {
-	for (tItList<tLight>::Iter l = Lights.First(); l; ++l)
-		if (l->ID == id)
-			return l;
-
-	return nullptr;
+	return LightIndex.Find(id, Lights);
 }
 
 
@@ -1513,26 +1491,19 @@ int tWorld::GetNumPaths(const tString& name) const
 void tWorld::InsertPath(tPath* path)
 {
 	Paths.Append(path);
+	PathIndex.Add(path, Paths);
 }
 
 
 tPath* tWorld::FindPath(const tString& name) const
 {
-	for (tItList<tPath>::Iter s = Paths.First(); s; ++s)
-		if (s->Name == name)
-			return s;
-
-	return nullptr;
+	return PathIndex.Find(name, Paths);
 }
 
 
 tPath* tWorld::FindPath(uint32 id) const
 {
-	for (tItList<tPath>::Iter s = Paths.First(); s; ++s)
-		if (s->ID == id)
-			return s;
-
-	return nullptr;
+	return PathIndex.Find(id, Paths);
 }
 
 
@@ -1553,26 +1524,19 @@ int tWorld::GetNumLodGroups(const tString& name) const
 void tWorld::InsertLodGroup(tLodGroup* lodGroup)
 {
 	LodGroups.Append(lodGroup);
+	LodGroupIndex.Add(lodGroup, LodGroups);
 }
 
 
 tLodGroup* tWorld::FindLodGroup(const tString& name) const
 {
-	for (tItList<tLodGroup>::Iter g = LodGroups.First(); g; ++g)
-		if (g->Name == name)
-			return g;
-
-	return nullptr;
+	return LodGroupIndex.Find(name, LodGroups);
 }
 
 
 tLodGroup* tWorld::FindLodGroup(uint32 id) const
 {
-	for (tItList<tLodGroup>::Iter g = LodGroups.First(); g; ++g)
-		if (g->ID == id)
-			return g;
-
-	return nullptr;
+	return LodGroupIndex.Find(id, LodGroups);
 }
 
 
@@ -1617,6 +1581,7 @@ int tWorld::GenerateLodGroupsFromModelNamingConvention()
 			group->ID = nextLodGroupID++;
 			group->Name = baseName;
 			LodGroups.Append(group);
+			LodGroupIndex.Add(group, LodGroups);
 			numGroupsCreated++;
 		}
 
@@ -1654,26 +1619,19 @@ int tWorld::GetNumInstances(const tString& name) const
 void tWorld::InsertInstance(tInstance* instance)
 {
 	Instances.Append(instance);
+	InstanceIndex.Add(instance, Instances);
 }
 
 
 tInstance* tWorld::FindInstance(const tString& name) const
 {
-	for (tItList<tInstance>::Iter inst = Instances.First(); inst; ++inst)
-		if (inst->Name == name)
-			return inst;
-
-	return nullptr;
+	return InstanceIndex.Find(name, Instances);
 }
 
 
 tInstance* tWorld::FindInstance(uint32 id) const
 {
-	for (tItList<tInstance>::Iter inst = Instances.First(); inst; ++inst)
-		if (inst->ID == id)
-			return inst;
-
-	return nullptr;
+	return InstanceIndex.Find(id, Instances);
 }
 
 
@@ -1703,16 +1661,13 @@ int tWorld::GetNumSelections(const tString& name) const
 void tWorld::InsertSelection(tSelection* sel)
 {
 	Selections.Append(sel);
+	SelectionIndex.Add(sel, Selections);
 }
 
 
 tSelection* tWorld::FindSelection(const tString& name) const
 {
-	for (tItList<tSelection>::Iter sel = Selections.First(); sel; ++sel)
-		if (sel->Name == name)
-			return sel;
-
-	return nullptr;
+	return SelectionIndex.Find(name, Selections);
 }
 
 
@@ -1732,11 +1687,7 @@ void tWorld::FindSelectionsContaining(tItList<tSelection*>& sels, const tString&
 
 tSelection* tWorld::FindSelection(uint32 id) const
 {
-	for (tItList<tSelection>::Iter sel = Selections.First(); sel; ++sel)
-		if (sel->ID == id)
-			return sel;
-
-	return nullptr;
+	return SelectionIndex.Find(id, Selections);
 }
 
 
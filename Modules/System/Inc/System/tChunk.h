@@ -10,7 +10,7 @@
 //			3  bits: Alignment shift.
 //			28 bits: Chunk ID.
 //		2) A 4 byte unsigned int (big-endian? or plat-dependent?). This is the chunk data size not including any
-//			leading alignment padding.
+//			leading alignment padding. For data chunks the top bit is set if the data is compressed.
 //		3) Zero or more alignment padding bytes.
 //		4) The data.
 //		5) Any necessary ending alignment pad to achieve 4-byte alignment.
@@ -43,7 +43,10 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #pragma once
+#include <atomic>
+#include <mutex>
 #include <Foundation/tPlatform.h>
+#include <Foundation/tArray.h>
 #include <Math/tLinearAlgebra.h>
 #include <Math/tGeometry.h>
 #include <Math/tVector2.h>
@@ -54,10 +57,41 @@
 #include <Math/tQuaternion.h>
 #include <Math/tColour.h>
 #include "System/tFile.h"
+namespace tSystem { struct tJob; }
 #ifdef PLATFORM_WINDOWS
 #pragma warning (disable: 4311 4369 4302)
 #endif
 
+// An entry in the optional index chunk that tChunkWriter can append to a file. Entries are stored in the order the
+// chunks were begun, so a container's entry always comes before its children and offsets are increasing.
+struct tChunkIndexEntry
+{
+	uint32 IDRaw;						// Includes the container and alignment bits.
+	int32 Parent;						// Entry number of the parent container or -1 for top-level chunks.
+	uint32 Offset;						// Where the chunk starts, in bytes from the beginning of the file.
+	uint32 DataSize;					// The same value returned by tChunk::GetDataSize.
+};
+
+
+// Data chunks may be compressed. The chunk ID and alignment stay the same and the top bit of the size field is set. The
+// stored data starts with this header followed by the compressed bytes.
+enum class tChunkCodec
+{
+	None,
+	Deflate								// Uses zlib.
+};
+
+
+struct tChunkCompressionHeader
+{
+	uint32 Codec;						// A tChunkCodec value.
+	uint32 UncompressedSize;
+
+	// Reserved. Always written as zero.
+	uint32 Reserved[3];
+};
+
+
 // Use this to write a tChunk file. Chunk data may be guaranteed to be aligned by various amounts from 4 bytes to
 // 512 bytes in powers of 2 only.
 class tChunkWriter
@@ -65,22 +99,23 @@ class tChunkWriter
 public:
 	// Creates the file if it doesn't exist, overwrites it if it does. See the Open() function comment. The endianness
 	// is the desired endianness of the written data.
-	tChunkWriter(const tString& filename, tEndianness endianness = tEndianness::Little)									: NeedsEndianSwap(false), IsContainer(true), ChunkInfos(), ChunkFile(0), WriteBuffer(nullptr), WriteBufferSize(0), WriteBufferPos(0) { Open(filename, endianness); }
+	tChunkWriter(const tString& filename, tEndianness endianness = tEndianness::Little)									: NeedsEndianSwap(false), IsContainer(true), ChunkInfos(), ChunkFile(0), WriteBuffer(nullptr), WriteBufferSize(0), WriteBufferPos(0), IsBufferOwned(false), NumBytesFlushed(0), Scratch(nullptr), ScratchSize(0), Codec(tChunkCodec::None), Staging(nullptr), StagingSize(0), StagingPos(0) { Open(filename, endianness); }
 
 	// Same as above but decides the endianness based on the supplied platform.
-	tChunkWriter(const tString& filename, tPlatform platform)															: NeedsEndianSwap(false), IsContainer(true), ChunkInfos(), ChunkFile(0), WriteBuffer(nullptr), WriteBufferSize(0), WriteBufferPos(0) { Open(filename, tGetEndianness(platform)); }
+	tChunkWriter(const tString& filename, tPlatform platform)															: NeedsEndianSwap(false), IsContainer(true), ChunkInfos(), ChunkFile(0), WriteBuffer(nullptr), WriteBufferSize(0), WriteBufferPos(0), IsBufferOwned(false), NumBytesFlushed(0), Scratch(nullptr), ScratchSize(0), Codec(tChunkCodec::None), Staging(nullptr), StagingSize(0), StagingPos(0) { Open(filename, tGetEndianness(platform)); }
 
-	// Use this if you want this class to write to memory instead of a file. To compute the size of the buffer you'll
-	// need, use this to be conservative:
+	// Use this if you want this class to write to memory you manage instead of a file. The buffer can't grow so it must
+	// be big enough up front. If you don't know the size, use OpenMemory instead. To compute the size of the buffer
+	// you'll need, use this to be conservative:
 	// numBytesNeeded = (numChunks * 8) + SumOverAllChunks(chunkDataSize + chunkAlignmentSize).
 	// Also note that if you want the written data aligned you'll need to supply an aligned dst pointer. Choose a value
 	// that is the maximum of your alignment requirements for all chunks you will be writing. Supplying a buffer that
 	// is 512 byte aligned is guaranteed to work in all cases.
-	tChunkWriter(uint8* dst, int dstBufSize, tEndianness endianness = tEndianness::Little)								: NeedsEndianSwap(false), IsContainer(true), ChunkInfos(), ChunkFile(0), WriteBuffer(dst), WriteBufferSize(dstBufSize), WriteBufferPos(0) { tEndianness srcEndianness = tGetEndianness(); NeedsEndianSwap = (srcEndianness == endianness) ? false : true; }
+	tChunkWriter(uint8* dst, int dstBufSize, tEndianness endianness = tEndianness::Little)								: NeedsEndianSwap(false), IsContainer(true), ChunkInfos(), ChunkFile(0), WriteBuffer(dst), WriteBufferSize(dstBufSize), WriteBufferPos(0), IsBufferOwned(false), NumBytesFlushed(0), Scratch(nullptr), ScratchSize(0), Codec(tChunkCodec::None), Staging(nullptr), StagingSize(0), StagingPos(0) { tEndianness srcEndianness = tGetEndianness(); NeedsEndianSwap = (srcEndianness == endianness) ? false : true; }
 
 	// If you want to open the file at a later time. You must open it before calling any other function.
-	tChunkWriter()																										: NeedsEndianSwap(false), IsContainer(true), ChunkInfos(), ChunkFile(0), WriteBuffer(nullptr), WriteBufferSize(0), WriteBufferPos(0) { }
-	~tChunkWriter()																										{ if (ChunkFile) tSystem::tCloseFile(ChunkFile); while (ChunkInfo* chunkInfo = ChunkInfos.Remove()) delete chunkInfo; }
+	tChunkWriter()																										: NeedsEndianSwap(false), IsContainer(true), ChunkInfos(), ChunkFile(0), WriteBuffer(nullptr), WriteBufferSize(0), WriteBufferPos(0), IsBufferOwned(false), NumBytesFlushed(0), Scratch(nullptr), ScratchSize(0), Codec(tChunkCodec::None), Staging(nullptr), StagingSize(0), StagingPos(0) { }
+	~tChunkWriter();
 
 	// Creates the file if it doesn't exist, overwrites it if it does. This function won't overwrite hidden files.
 	// Fixing this problem would slow it down for people who don't use hidden files, so I have opted to document the
@@ -94,8 +129,15 @@ public:
 	bool OpenSafe(const tString& filename, tPlatform platform)															{ return OpenSafe(filename, tGetEndianness(platform)); }
 	bool OpenSafe(const tString& filename, tEndianness = tEndianness::Little);
 
+	// Writes to a buffer that the writer manages and grows as needed. The buffer is aligned to Alignment::Largest so
+	// chunk data alignment is the same as it would be in a file. Use GetBuffer and GetNumBytesWritten to access the
+	// result. It is valid until the writer is opened again or destroyed.
+	void OpenMemory(tEndianness = tEndianness::Little);
+	void OpenMemory(tPlatform platform)																					{ OpenMemory(tGetEndianness(platform)); }
+
 	// In case you want to open something else. You should have finished writing all the chunks by this time. You can
-	// optionally let the destructor call this fn for you.
+	// optionally let the destructor call this fn for you. Writes to a file are buffered, but the buffer is written out
+	// whenever a top-level chunk is ended.
 	void Close();
 
 	// Use this enum to enforce data alignment of written chunks. Alignment of data within chunk data is the user's
@@ -117,10 +159,13 @@ public:
 	};
 
 	// Alignment is ignored for container chunks. Containerness is determined by the MS bit of the chunkID.
-	void BeginChunk(uint32 chunkID, Alignment a = Alignment::B4)														{ BeginChunk(chunkID, 1 << (int(a)+2)); }
+	void BeginChunk(uint32 chunkID, Alignment a = Alignment::B4, tChunkCodec codec = tChunkCodec::None)				{ BeginChunk(chunkID, 1 << (int(a)+2), codec); }
 
 	// Same as above except alignmentInBytes must be 4, 8, 16, 32, 64, 128, 256, or 512.
-	void BeginChunk(uint32 chunkID, int alignmentInBytes);
+	// Data chunks may be compressed by supplying a codec. Everything written to the chunk is compressed when it is
+	// ended. If compressing doesn't make it smaller the chunk is stored uncompressed. Compressed chunks keep their
+	// alignment in the sense that the decompressed data returned by tChunk::GetData is aligned as requested.
+	void BeginChunk(uint32 chunkID, int alignmentInBytes, tChunkCodec = tChunkCodec::None);
 	void EndChunk();
 
 	// All write functions return the number of bytes written. Here's the generic form of Write for various data types.
@@ -171,7 +216,7 @@ public:
 	int Write(const tMath::tTri* data, int numItems);
 	int Write(const tMath::tQuad* data, int numItems);
 	int Write(const tMath::tSphere* data, int numItems);
-	template<typename T> int Write(const T* data, int numItems)															{ if (!numItems || !data) return 0; if (NeedsEndianSwap) { T* swapped = new T[numItems]; for (int i = 0; i < numItems; i++) swapped[i] = tGetSwapEndian(data[i]); int n = Write( (void*)swapped, sizeof(T)*numItems ); delete[] swapped; return n; } return Write( (void*)data, sizeof(T)*numItems ); }
+	template<typename T> int Write(const T* data, int numItems)															{ if (!numItems || !data) return 0; if (NeedsEndianSwap) { T* swapped = (T*)GetScratch(sizeof(T)*numItems); for (int i = 0; i < numItems; i++) swapped[i] = tGetSwapEndian(data[i]); return Write( (void*)swapped, sizeof(T)*numItems ); } return Write( (void*)data, sizeof(T)*numItems ); }
 
 	// The layout string lets the Write call know the format of the data so it can perform the appropriate endian swaps
 	// if necessary. The characters '1', '2', '4', and '8' are used to represent the number of bytes for each item. In
@@ -189,54 +234,112 @@ public:
 	int Write(const void* data, const tString& layout);
 
 	// Shortened versions of the commands so you don't have to type as much.
-	void Begin(uint32 chunkID, Alignment align = Alignment::B4)															{ BeginChunk(chunkID, align); }
-	void Begin(uint32 chunkID, int alignmentInBytes)																	{ BeginChunk(chunkID, alignmentInBytes); }
+	void Begin(uint32 chunkID, Alignment align = Alignment::B4, tChunkCodec codec = tChunkCodec::None)					{ BeginChunk(chunkID, align, codec); }
+	void Begin(uint32 chunkID, int alignmentInBytes, tChunkCodec codec = tChunkCodec::None)								{ BeginChunk(chunkID, alignmentInBytes, codec); }
 
 	void End()																											{ EndChunk(); }
+
+	// Appends an index chunk describing every chunk written so far. Call it once, after all other chunks are ended.
+	// The index stores the ID, location, size and parent of each chunk so tChunkReader can find chunks by ID without
+	// walking the file. It is optional. Files without one load exactly the same, and readers that predate it just
+	// see an unknown top-level chunk.
+	void WriteIndex();
+
 	bool GetNeedsEndianSwap() const																						{ return NeedsEndianSwap; }
-	int GetNumBytesWritten() const																						{ return WriteBufferPos; }
+	int GetNumBytesWritten() const																						{ return NumBytesFlushed + WriteBufferPos; }
+
+	// Only valid when writing to memory.
+	const uint8* GetBuffer() const																						{ return ChunkFile ? nullptr : WriteBuffer; }
 
 private:
 	// This must remain private, otherwise you wouldn't get a compiler error if the proper Write function didn't exist.
 	// Returns the number of bytes written.
 	int Write(const void* data, int sizeInBytes);
 
+	// Writes to a file are collected in a buffer of this size and written out in large blocks. Chunk sizes are
+	// patched in the buffer unless the chunk has already been flushed. A writer that owns a memory buffer starts with
+	// the smaller size and doubles it whenever it runs out.
+	static const int FileBufferSize = 1024*1024;
+	static const int MemoryBufferSize = 64*1024;
+
+	void ResetBuffer(int minSize);
+	bool Flush();
+	void WriteBytes(const void* data, int numBytes);
+	void WriteZeros(int numBytes);
+	// Overwrites bytes already written. Returns false if the bytes were already flushed and the file couldn't be patched.
+	bool PatchBytes(int position, const void* data, int numBytes);
+
+	// Returns reusable memory for endian-swapped copies of data. The contents only last until the next call.
+	uint8* GetScratch(int numBytes);
+
+	// Compresses the staged data of the current chunk and writes it, or writes it as is if it doesn't get smaller.
+	// Returns true if it was compressed.
+	bool WriteStaging();
+
 	struct ChunkInfo : public tLink<ChunkInfo>
 	{
-		ChunkInfo()																										: StartChunk(0), StartData(0) { }
-		ChunkInfo(uint c, uint d)																						: StartChunk(c), StartData(d) { }
+		ChunkInfo()																										: StartChunk(0), StartData(0), IndexEntry(-1) { }
+		ChunkInfo(uint c, uint d, int e)																				: StartChunk(c), StartData(d), IndexEntry(e) { }
 		uint StartChunk;				// Start of the chunk.
 		uint StartData;					// Start of the data.
+		int IndexEntry;					// Where the chunk is in IndexEntries.
 	};
 
 	bool NeedsEndianSwap;				// True if the data needs an endianness swap before being written.
 	bool IsContainer;					// True if the current chunk being created is a container. False for data-only.
 	tList<ChunkInfo> ChunkInfos;
+	tArray<tChunkIndexEntry> IndexEntries;
 	tFileHandle ChunkFile;
 
-	uint8* WriteBuffer;					// Only non-null if user supplied the buffer to write to.
+	uint8* WriteBuffer;					// Either supplied by the user or owned. Files are written through an owned buffer.
 	int WriteBufferSize;
 	int WriteBufferPos;
+	bool IsBufferOwned;
+	int NumBytesFlushed;				// Bytes already written to the file. Always zero when writing to memory.
+
+	uint8* Scratch;
+	int ScratchSize;
+
+	// Data written to a compressed chunk is collected here and compressed when the chunk ends.
+	tChunkCodec Codec;
+	uint8* Staging;
+	int StagingSize;
+	int StagingPos;
 };
 
 
+class tChunkReader;
+
+
 // The tChunk class is used for reading chunk files. Use a tChunkReader to begin parsing tChunks.
 class tChunk
 {
 public:
-	tChunk()																											: Chunk(nullptr), LastChunk(nullptr), ItemData(nullptr) { }
-	tChunk(uint8* chunk);
-	tChunk(uint8* chunk, uint8* lastChunk);
+	tChunk()																											: Chunk(nullptr), LastChunk(nullptr), Reader(nullptr), ItemData(nullptr) { }
+	tChunk(uint8* chunk, const tChunkReader* reader = nullptr);
+	tChunk(uint8* chunk, uint8* lastChunk, const tChunkReader* reader = nullptr);
 	tChunk(uint8* chunk, tChunk lastChunk);
 
-	// Returns nullptr if this is not a valid chunk.
+	// Returns nullptr if this is not a valid chunk. If the chunk is compressed it is decompressed on first access
+	// and the decompressed data is returned. The decompressed data has the alignment the chunk was written with and
+	// is owned by the tChunkReader. Compressed chunks must come from a tChunkReader (or one of its chunks) or nullptr
+	// is returned.
 	uint8* GetData() const;
 
 	// Returns the size of the data in bytes (not including pro or epi-log padding). Returns zero if the chunk is not
-	// valid.
-	int GetDataSize() const																								{ return IsValid() ? *((int*)(Chunk+4)) : 0; }
+	// valid. For compressed chunks this is the decompressed size.
+	int GetDataSize() const;
+
+	// The stored data is what is actually in the file. For uncompressed chunks it is the same as the data. For
+	// compressed chunks it starts with a tChunkCompressionHeader followed by the compressed bytes.
+	uint8* GetStoredData() const;
+	int GetStoredSize() const																							{ return IsValid() ? int(*((uint32*)(Chunk+4)) & ~CompressedFlag) : 0; }
+	bool IsCompressed() const																							{ return IsDataOnly() ? ((*((uint32*)(Chunk+4)) & CompressedFlag) ? true : false) : false; }
 
-	// Same as above except returns data size including all padding.
+	// The top bit of the size field marks a compressed data chunk.
+	static const uint32 CompressedFlag = 0x80000000;
+
+	// Returns the stored data size including all padding. This is the number of bytes after the chunk header.
 	int GetDataSizeRaw() const;
 
 	// Returns the ID of the chunk or 0 if it's not a valid chunk. The returned ID has the alignment bits zeroed out.
@@ -248,15 +351,15 @@ public:
 	bool IsDataOnly() const																								{ if (!IsValid()) return false; return ((*((uint32*)Chunk)) & 0x80000000) ? false : true; }
 
 	// Assumes first byte of data is another chunk.
-	tChunk GetFirstChunk() const																						{ tAssert(IsContainer()); return tChunk(GetData(), Chunk + GetDataSizeRaw() + 8); }
+	tChunk GetFirstChunk() const																						{ tAssert(IsContainer()); return tChunk(GetData(), Chunk + GetDataSizeRaw() + 8, Reader); }
 
 	// Assumes there is another chunk after the current one. Returns an invalid one if we reach the end in which case
 	// Data == InvalidData == the last addr. Also returns invalid if the lastchunk was never specified.
-	tChunk GetNextChunk() const																							{ tAssert(IsValid()); return LastChunk ? tChunk(Chunk + GetDataSizeRaw() + 8, LastChunk) : tChunk(); }
+	tChunk GetNextChunk() const																							{ tAssert(IsValid()); return LastChunk ? tChunk(Chunk + GetDataSizeRaw() + 8, LastChunk, Reader) : tChunk(); }
 
 	// Chunk should equal LastChunk for this one. Getting data will return an invalid tChunk. Use of this fn is
 	// optional as IsValid can be called after each GetNext.
-	tChunk GetLastChunk() const																							{ return tChunk(LastChunk, LastChunk); }
+	tChunk GetLastChunk() const																							{ return tChunk(LastChunk, LastChunk, Reader); }
 
 	// These don't care about the LastChunk stuff.
 	bool operator!=(const tChunk& c) const																				{ return (c.Chunk != Chunk); }
@@ -279,6 +382,7 @@ public:
 	// maintained. ItemReset can reset it to the beginning if necessary. In most cases this isn't necessary as that's
 	// where you start. All the GetItem functions return the number of bytes read from the chunk stream. In some cases
 	// this does not match the size of the item being read. For example, bools are stored as 4 bytes by tChunkWriter.
+	// For compressed chunks the item pointer is set up, and the chunk decompressed, on the first item access.
 	void ItemReset() const																								{ tAssert(IsDataOnly()); ItemData = GetData(); }
 
 	// Here's the generic form of GetItem. It will work on most basic data types. The functions after are
@@ -288,24 +392,26 @@ public:
 	// any endian conversions. The chunk data is already in the correct format for the destination platform. These
 	// functions return the number of bytes read. OK, turns out overloads are matched before specializations, so we
 	// can keep it simple and just do that.
-	int GetItem(bool& item) const																						{ tAssert(IsDataOnly()); uint8 b = *((uint8*)ItemData); item = b ? true : false; ItemData += sizeof(uint8); return sizeof(uint8); }
-	int GetItem(tString& item) const																					{ tAssert(IsDataOnly()); item.Set((char*)ItemData); int n = item.Length()+1; ItemData += n; return n;}
-	template<typename T> int GetItem(T& item) const																		{ tAssert(IsDataOnly()); item = *((T*)ItemData); ItemData += sizeof(T); return sizeof(T); }
+	int GetItem(bool& item) const																						{ tAssert(IsDataOnly()); if (!ItemData) ItemReset(); uint8 b = *((uint8*)ItemData); item = b ? true : false; ItemData += sizeof(uint8); return sizeof(uint8); }
+	int GetItem(tString& item) const																					{ tAssert(IsDataOnly()); if (!ItemData) ItemReset(); item.Set((char*)ItemData); int n = item.Length()+1; ItemData += n; return n;}
+	template<typename T> int GetItem(T& item) const																		{ tAssert(IsDataOnly()); if (!ItemData) ItemReset(); item = *((T*)ItemData); ItemData += sizeof(T); return sizeof(T); }
 
 	// Here are versions that get multiple items at once. numItems must be >= 1.
-	int GetItems(bool* dest, int numItems) const																		{ tAssert(IsDataOnly()); for (int i = 0; i < numItems; i++) { uint8 b = *((uint8*)ItemData); *dest = b ? true : false; ItemData += sizeof(uint8); dest++; } return numItems*sizeof(uint8); }
+	int GetItems(bool* dest, int numItems) const																		{ tAssert(IsDataOnly()); if (!ItemData) ItemReset(); for (int i = 0; i < numItems; i++) { uint8 b = *((uint8*)ItemData); *dest = b ? true : false; ItemData += sizeof(uint8); dest++; } return numItems*sizeof(uint8); }
 	int GetItems(tString* dest, int numItems) const																		{ tAssert(IsDataOnly()); int bytes = 0; for (int i = 0; i < numItems; i++) { bytes += GetItem(*dest); dest++; } return bytes; }
-	template<typename T> int GetItems(T* dest, int numItems) const														{ tAssert(IsDataOnly()); for (int i = 0; i < numItems; i++) { *dest = *((T*)ItemData); ItemData += sizeof(T); dest++; } return numItems*sizeof(T); }
+	template<typename T> int GetItems(T* dest, int numItems) const														{ tAssert(IsDataOnly()); if (!ItemData) ItemReset(); for (int i = 0; i < numItems; i++) { *dest = *((T*)ItemData); ItemData += sizeof(T); dest++; } return numItems*sizeof(T); }
 
 	// Gets the current item as a uint8 pointer, and increments the item pointer by size bytes.
-	uint8* GetItemCurrent(int size) const																				{ tAssert(IsDataOnly()); uint8* item = ItemData; ItemData += size; return item; }
-	uint8* GetItemCurrent() const																						{ tAssert(IsDataOnly()); return ItemData; }
-	void ItemAdvance(int numBytes) const																				{ tAssert(IsDataOnly()); ItemData += numBytes; }
+	uint8* GetItemCurrent(int size) const																				{ tAssert(IsDataOnly()); if (!ItemData) ItemReset(); uint8* item = ItemData; ItemData += size; return item; }
+	uint8* GetItemCurrent() const																						{ tAssert(IsDataOnly()); if (!ItemData) ItemReset(); return ItemData; }
+	void ItemAdvance(int numBytes) const																				{ tAssert(IsDataOnly()); if (!ItemData) ItemReset(); ItemData += numBytes; }
 
 protected:
+	friend class tChunkReader;
 	uint8* Chunk;						// The memory for this not managed by this class.
 	uint8* LastChunk;					// Needed so that GetNextChunk knows when it should return an invalid chunk.
-	mutable uint8* ItemData;
+	const tChunkReader* Reader;			// Owns decompressed data. May be nullptr if the chunk wasn't made by a reader.
+	mutable uint8* ItemData;			// Stays nullptr until first use for compressed chunks.
 };
 
 
@@ -315,16 +421,16 @@ class tChunkReader
 {
 public:
 	// If you want to load in the file at a later time. You must load it before calling any other function.
-	tChunkReader()																										: IsBufferOwned(false), ReadBufferSize(0), ReadBuffer(nullptr) { }
+	tChunkReader()																										: IsBufferOwned(false), IsBufferMapped(false), ReadBufferSize(0), ContentSize(0), ReadBuffer(nullptr), Index(nullptr), NumIndexEntries(0), IndexTable(nullptr), IndexTableSize(0), IndexNext(nullptr), DecompressedMutex(), CompressedFound(false), CompressedChunks(), DecompressedSlots(nullptr), BackgroundJob(nullptr) { }
 
 	// If buffer is nullptr, loads the entire file into memory. Acquires filesize bytes. If you want to manage the
 	// memory yourself give it a valid buffer that is big enough. Call SizeNeeded first to find out. Note that a
 	// supplied buffer must be aligned to Alignment::Largest.
-	tChunkReader(const tString& filename, uint8* buffer = nullptr)														: IsBufferOwned(false), ReadBufferSize(0), ReadBuffer(nullptr) { Load(filename, buffer); }
+	tChunkReader(const tString& filename, uint8* buffer = nullptr)														: IsBufferOwned(false), IsBufferMapped(false), ReadBufferSize(0), ContentSize(0), ReadBuffer(nullptr), Index(nullptr), NumIndexEntries(0), IndexTable(nullptr), IndexTableSize(0), IndexNext(nullptr), DecompressedMutex(), CompressedFound(false), CompressedChunks(), DecompressedSlots(nullptr), BackgroundJob(nullptr) { Load(filename, buffer); }
 
 	// This constructor assumes you already have a buffer with the file loaded. Note that a supplied buffer must be
 	// aligned to Alignment_Largest.
-	tChunkReader(uint8* buffer, int bufferSizeBytes)																	: IsBufferOwned(false), ReadBufferSize(0), ReadBuffer(nullptr) { Load(buffer, bufferSizeBytes); }
+	tChunkReader(uint8* buffer, int64 bufferSizeBytes)																	: IsBufferOwned(false), IsBufferMapped(false), ReadBufferSize(0), ContentSize(0), ReadBuffer(nullptr), Index(nullptr), NumIndexEntries(0), IndexTable(nullptr), IndexTableSize(0), IndexNext(nullptr), DecompressedMutex(), CompressedFound(false), CompressedChunks(), DecompressedSlots(nullptr), BackgroundJob(nullptr) { Load(buffer, bufferSizeBytes); }
 	~tChunkReader()																										{ UnLoad(); }
 
 	// Reads in a file. Note that tChunkRead will need to unload any buffers it may currently be maintaining. Same
@@ -333,31 +439,87 @@ public:
 
 	// This call assumes the buffer is already allocated and has the data in it. See the corresponding constructor for
 	// info. Same alignment requirements as above.
-	void Load(uint8* buffer, int bufferSizeBytes);
+	void Load(uint8* buffer, int64 bufferSizeBytes);
 
-	// Same as load but returns false at first sign of trouble.
+	// Same as load but returns false at first sign of trouble. Files of 2GB or more can't be loaded into a buffer owned
+	// by the reader. Load them into a supplied buffer or use LoadMapped.
 	bool LoadSafe(const tString& filename);
 
+	// Maps the file into memory instead of reading it. No copy of the file data is made and pages are only read from
+	// disk when first touched, so this is the fastest way to open a large chunk file. Mapped memory is page aligned so
+	// the GetBufferAlignmentNeeded guarantee still holds, and chunk data may be referenced in place. For example, a
+	// tLayer constructed from a chunk with ownsData false or a tMesh loaded with ownsTables false will point straight
+	// into the mapped pages, so they must not outlive this reader. The pages are copy-on-write. Modifying chunk data is
+	// allowed and Save will write the modified data, but the mapped file itself is never changed. Returns false if the
+	// file could not be mapped or is empty.
+	bool LoadMapped(const tString& filename);
+
 	// Sometimes it is useful to load in a file and then modify the data but not the chunk structure. If this is the
 	// case, you can resave the chunk file with the possibly modified data using the function below. Returns number
 	// of written bytes.
-	int Save(const tString& filename);
+	int64 Save(const tString& filename);
 
-	// Unloads from memory any buffers being maintained by tChunkReader.
+	// Unloads from memory any buffers being maintained by tChunkReader. If the file was mapped it is unmapped.
 	void UnLoad();
 
 	bool IsValid() const																								{ return (ReadBuffer && ReadBufferSize) ? true : false; }
 	bool Valid() const																									{ return IsValid(); }
-	tChunk GetFirstChunk() const																						{ tAssert(IsValid()); return tChunk(ReadBuffer, ReadBuffer + ReadBufferSize); }
+	bool IsMapped() const																								{ return IsBufferMapped; }
+	tChunk GetFirstChunk() const																						{ tAssert(IsValid()); return tChunk(ReadBuffer, ReadBuffer + ContentSize, this); }
 	tChunk First() const																								{ return GetFirstChunk(); }
 	tChunk Chunk() const																								{ return GetFirstChunk(); }
-	static int GetBufferSizeNeeded(const tString& filename)																{ return tSystem::tGetFileSize(filename); }
+	static int64 GetBufferSizeNeeded(const tString& filename)															{ return tSystem::tGetFileSize(filename); }
 	static int GetBufferAlignmentNeeded()																				{ return 1 << (int(tChunkWriter::Alignment::Largest) + 2); }
 
+	// The find functions use the index chunk, if the file has one, to look chunks up by ID in constant time. Without an
+	// index they walk the chunks instead, so they may be used on any file. Only direct children of the container are
+	// searched. An invalid container means the top level. The index chunk itself is never returned, and is not visited
+	// when walking from GetFirstChunk. To visit every chunk with a given ID do:
+	// for (tChunk ch = reader.FindChunk(id, container); ch.IsValid(); ch = reader.FindNextChunk(ch))
+	bool HasIndex() const																								{ return Index ? true : false; }
+	tChunk FindChunk(uint32 chunkID, const tChunk& container = tChunk()) const;
+
+	// Returns the next sibling of the supplied chunk that has the same ID, or an invalid chunk if there isn't one.
+	tChunk FindNextChunk(const tChunk&) const;
+
+	// Compressed chunks are normally decompressed the first time their data is accessed. This starts decompressing all
+	// of them on the shared job system and returns straight away. Accessing a chunk that a worker is busy with waits
+	// for it. maxThreads limits how many workers are used. If it is <= 0 they all may be.
+	void DecompressInBackground(int maxThreads = 0);
+
+	// Used by tChunk::GetData. Decompresses the chunk if it hasn't been already. Safe to call from multiple threads.
+	uint8* GetDecompressedData(const tChunk&) const;
+
 private:
+	void ReadIndex();
+	int FindIndexEntry(uint32 chunkID, int parent) const;
+	int GetIndexEntry(const tChunk&) const;
+	tChunk GetIndexedChunk(int entry) const;
+
 	bool IsBufferOwned;
-	int ReadBufferSize;
+	bool IsBufferMapped;
+	int64 ReadBufferSize;
+	int64 ContentSize;					// Number of bytes before the index chunk. Equals ReadBufferSize if there's no index.
 	uint8* ReadBuffer;
+
+	// Index points into the read buffer. IndexTable is an open-addressed hash table of the first entry for each
+	// parent and ID pair. IndexNext links each entry to the next one with the same parent and ID.
+	const tChunkIndexEntry* Index;
+	int NumIndexEntries;
+	int* IndexTable;
+	int IndexTableSize;
+	int* IndexNext;
+
+	// The decompression state is kept here and never in the read buffer, which may be memory the caller only lets us
+	// read. The compressed chunks are found the first time one of them is accessed. They are in buffer order so they
+	// may be binary searched. Each has a slot that holds 0 until someone starts decompressing it, Busy while they are,
+	// and then either the decompressed data pointer or Failed.
+	void FindCompressedChunks() const;
+	mutable std::mutex DecompressedMutex;
+	mutable std::atomic<bool> CompressedFound;
+	mutable tArray<tChunk> CompressedChunks;
+	mutable std::atomic<uint64>* DecompressedSlots;
+	tSystem::tJob* BackgroundJob;
 };
 
 
@@ -434,6 +596,7 @@ namespace tChunkID
 		Core_Matrix4																			= 0x00009000,			// Sixteen 4-byte floating point values.
 		Core_Transformation																		= Core_Matrix4,
 		Core_Version																			= 0x0000A000,			// Major, Minor, and possibly Revision, Build, and Release numbers.
+		Core_ChunkIndex																			= 0x0000B000,			// Entry count, tChunkIndexEntry array, offset of this chunk, and a magic number.
 	};
 
 
@@ -692,51 +855,40 @@ struct tChunkError : public tError
 // Implementation below this line.
 
 
-inline tChunk::tChunk(uint8* chunk) :
+inline tChunk::tChunk(uint8* chunk, const tChunkReader* reader) :
 	Chunk(chunk),
-	LastChunk(0)
+	LastChunk(0),
+	Reader(reader),
+	ItemData(nullptr)
 {
-	uint32 idaa = *((uint32*)Chunk);
-	int shift = ((idaa & 0x70000000) >> 28) + 2;
-	int align = 1 << shift;
-
-	// We are safe to use uint32 cast here even for 64 bit pointers because the alignment requirements are much
-	// smaller. That is, align is much less than 2^32.
-	int bytesAfterAlign = uint32(uint64(chunk+8)) % align;
-	int pad = bytesAfterAlign ? (align - bytesAfterAlign) : 0;
-	ItemData = (chunk+8) + pad;
+	if (!IsCompressed())
+		ItemData = GetStoredData();
 }
 
 
-inline tChunk::tChunk(uint8* chunk, uint8* lastChunk) :
+inline tChunk::tChunk(uint8* chunk, uint8* lastChunk, const tChunkReader* reader) :
 	Chunk(chunk),
-	LastChunk(lastChunk)
+	LastChunk(lastChunk),
+	Reader(reader),
+	ItemData(nullptr)
 {
-	uint32 idaa = *((uint32*)Chunk);
-	int shift = ((idaa & 0x70000000) >> 28) + 2;
-	int align = 1 << shift;
-
-	int bytesAfterAlign = uint32(uint64(chunk+8)) % align;
-	int pad = bytesAfterAlign ? (align - bytesAfterAlign) : 0;
-	ItemData = (chunk+8) + pad;
+	if (!IsCompressed())
+		ItemData = GetStoredData();
 }
 
 
 inline tChunk::tChunk(uint8* chunk, tChunk lastChunk) :
 	Chunk(chunk),
-	LastChunk(lastChunk.Chunk)
+	LastChunk(lastChunk.Chunk),
+	Reader(lastChunk.Reader),
+	ItemData(nullptr)
 {
-	uint32 idaa = *((uint32*)Chunk);
-	int shift = ((idaa & 0x70000000) >> 28) + 2;
-	int align = 1 << shift;
-
-	int bytesAfterAlign = uint32(uint64(chunk+8)) % align;
-	int pad = bytesAfterAlign ? (align - bytesAfterAlign) : 0;
-	ItemData = (chunk+8) + pad;
+	if (!IsCompressed())
+		ItemData = GetStoredData();
 }
 
 
-inline uint8* tChunk::GetData() const
+inline uint8* tChunk::GetStoredData() const
 {
 	if (!IsValid())
 		return nullptr;
@@ -745,12 +897,32 @@ inline uint8* tChunk::GetData() const
 	int shift = ((idaa & 0x70000000) >> 28) + 2;
 	int align = 1 << shift;
 
+	// We are safe to use uint32 cast here even for 64 bit pointers because the alignment requirements are much
+	// smaller. That is, align is much less than 2^32.
 	int bytesAfterAlign = uint32(uint64(Chunk+8)) % align;
 	int pad = bytesAfterAlign ? (align - bytesAfterAlign) : 0;
 	return Chunk + 8 + pad;
 }
 
 
+inline uint8* tChunk::GetData() const
+{
+	if (!IsCompressed())
+		return GetStoredData();
+
+	return Reader ? Reader->GetDecompressedData(*this) : nullptr;
+}
+
+
+inline int tChunk::GetDataSize() const
+{
+	if (!IsCompressed())
+		return GetStoredSize();
+
+	return int(((tChunkCompressionHeader*)GetStoredData())->UncompressedSize);
+}
+
+
 inline int tChunk::GetDataSizeRaw() const
 {
 	if (!IsValid())
@@ -763,7 +935,7 @@ inline int tChunk::GetDataSizeRaw() const
 
 	int bytesAfterAlign = uint32(uint64(data)) % align;
 	int prologPad = bytesAfterAlign ? (align - bytesAfterAlign) : 0;
-	int dataSize = GetDataSize();
+	int dataSize = GetStoredSize();
 	data += prologPad + dataSize;
 
 	int epilogPad = (uint32(uint64(data)) % 4) ? (4 - (uint32(uint64(data)) % 4)) : 0;
@@ -34,14 +34,17 @@ class tFile : public tStream
 	tFile(const tString& fileName, tStream::tModes modes)																: tStream(modes) { }
 };
 
-int tGetFileSize(tFileHandle);
-int tGetFileSize(const tString& fileName);
+// Sizes and offsets are 64 bit so files over 2GB work. A file handle's position is left at the beginning after
+// tGetFileSize. Read and write return the number of bytes actually read or written.
+int64 tGetFileSize(tFileHandle);
+int64 tGetFileSize(const tString& fileName);
 tFileHandle tOpenFile(const char* filename, const char* mode);
 void tCloseFile(tFileHandle);
-int tReadFile(tFileHandle, void* buffer, int sizeBytes);
-int tWriteFile(tFileHandle, const void* buffer, int sizeBytes);
+int64 tReadFile(tFileHandle, void* buffer, int64 sizeBytes);
+int64 tWriteFile(tFileHandle, const void* buffer, int64 sizeBytes);
 bool tPutc(char, tFileHandle);
-int tFileTell(tFileHandle);
+int64 tFileTell(tFileHandle);
+bool tFlushFile(tFileHandle);								// Pushes any data buffered by the C runtime to the OS.
 
 enum class tSeekOrigin
 {
@@ -49,7 +52,7 @@ enum class tSeekOrigin
 	Current,
 	End
 };
-int tFileSeek(tFileHandle, int offsetBytes, tSeekOrigin = tSeekOrigin::Beginning);
+int tFileSeek(tFileHandle, int64 offsetBytes, tSeekOrigin = tSeekOrigin::Beginning);		// Returns 0 on success.
 
 // Test if a file exists. Supplied filename should not have a trailing slash. Will return false if you use on
 // directories or drives. Use tDirExists for that purpose. Windows Note: tFileExists will not bring up an error box for
@@ -322,16 +325,18 @@ bool tCreateDir(const tString& dir);
 // file gone.
 bool tDeleteFile(const tString& filename, bool deleteReadOnly = true, bool tryUseRecycleBin = false);
 
-// If either (or both) file doesn't exist you get false. Entire files will temporarily be read into memory so it's not
-// too efficient (only for tool use).
+// If either (or both) file doesn't exist you get false. The files are compared a block at a time so memory use does not
+// depend on the file size.
 bool tFilesIdentical(const tString& fileA, const tString& fileB);
 
 // Loads entire file into memory. If buffer is nullptr you must free the memory returned at some point by using
 // delete[]. If buffer is non-nullptr it must be at least GetFileSize big (+1 if appending EOF). Any problems (file not exist or is
 // unreadable etc) and nullptr is returned. Fills in the file size pointer if you supply one (not including optional appened EOF). It is perfectly valid to
 // load a file with no data (0 bytes big). In this case LoadFile always returns nullptr even if a non-zero buffer was
-// passed in and the fileSize member will be set to 0 (if supplied).
+// passed in and the fileSize member will be set to 0 (if supplied). The version taking an int file size can't
+// represent files of 2GB or more and returns nullptr for them with the size set to 0. Use the int64 version instead.
 uint8* tLoadFile(const tString& filename, uint8* buffer = nullptr, int* fileSize = nullptr, bool appendEOF = false);
+uint8* tLoadFile(const tString& filename, uint8* buffer, int64* fileSize, bool appendEOF = false);
 
 // Similar to above, but is best used with a text file. If a binary file is supplied and convertZeroesTo is left at
 // default, any null characters '\0' are turned into separators (31). This ensures that the string length will be
@@ -345,17 +350,39 @@ bool tLoadFile(const tString& filename, tString& dst, char convertZeroesTo = 31)
 // supplied and there is a read problem, 0 will be returned.
 uint8* tLoadFileHead(const tString& filename, int& bytesToRead, uint8* buffer = 0);
 uint8* tLoadFileHead(const tString& filename, int bytesToRead, tString& dest);
+
+// Maps an entire file into memory read-only without copying it. The returned pointer is page aligned and the pages are
+// copy-on-write, so the caller may modify the memory but the changes are never written back to the file. Returns
+// nullptr if the file can't be opened or mapped, or if it is empty. The size of the file is returned in fileSize.
+// Unmap with tUnmapFile when done. The file should not be truncated by anyone else while it is mapped. The int version
+// fails for files of 2GB or more.
+uint8* tMapFile(const tString& filename, int& fileSize);
+uint8* tMapFile(const tString& filename, int64& fileSize);
+void tUnmapFile(uint8* mapped, int64 fileSize);
 bool tCreateFile(const tString& filename);					// Creates an empty file.
 bool tCreateFile(const tString& filename, const tString& contents);
-bool tCreateFile(const tString& filename, uint8* data, int dataLength);
+bool tCreateFile(const tString& filename, uint8* data, int64 dataLength);
+
+// File hash functions using tMath standard hash algorithms. Memory use does not depend on the file size. In Streamed
+// mode the file is read through a fixed-size buffer and the value is the same as hashing the whole file in memory
+// with the corresponding tHashData function. In Tree mode the file is split into HashTreeBlockSize blocks that are
+// hashed in parallel on the shared job system. The block hashes are then hashed with the supplied iv to get the
+// result. Tree values differ from Streamed ones, but they only depend on the file contents and not on the number of
+// threads, so either mode may be used for change detection as long as it is used consistently. If the file is empty
+// or can't be read the iv is returned.
+enum class tHashFileMode
+{
+	Streamed,
+	Tree
+};
+const int HashTreeBlockSize = 1024*1024;
 
-// File hash functions using tMath standard hash algorithms.
-uint32 tHashFileFast32(const tString& filename, uint32 iv = tMath::HashIV32);
-uint32 tHashFile32(const tString& filename, uint32 iv = tMath::HashIV32);
-uint64 tHashFile64(const tString& filename, uint64 iv = tMath::HashIV64);
-tuint128 tHashFileMD5(const tString& filename, tuint128 iv = tMath::HashIV128);
-tuint128 tHashFile128(const tString& filename, tuint128 iv = tMath::HashIV128);
-tuint256 tHashFile256(const tString& filename, const tuint256 iv = tMath::HashIV256);
+uint32 tHashFileFast32(const tString& filename, uint32 iv = tMath::HashIV32, tHashFileMode = tHashFileMode::Streamed);
+uint32 tHashFile32(const tString& filename, uint32 iv = tMath::HashIV32, tHashFileMode = tHashFileMode::Streamed);
+uint64 tHashFile64(const tString& filename, uint64 iv = tMath::HashIV64, tHashFileMode = tHashFileMode::Streamed);
+tuint128 tHashFileMD5(const tString& filename, tuint128 iv = tMath::HashIV128, tHashFileMode = tHashFileMode::Streamed);
+tuint128 tHashFile128(const tString& filename, tuint128 iv = tMath::HashIV128, tHashFileMode = tHashFileMode::Streamed);
+tuint256 tHashFile256(const tString& filename, const tuint256 iv = tMath::HashIV256, tHashFileMode = tHashFileMode::Streamed);
 
 
 };
@@ -434,7 +461,7 @@ inline void tSystem::tDriveInfo::Clear()
 #endif
 
 
-inline tuint128 tSystem::tHashFile128(const tString& filename, tuint128 iv)
+inline tuint128 tSystem::tHashFile128(const tString& filename, tuint128 iv, tHashFileMode mode)
 {
-	return tHashFileMD5(filename, iv);
+	return tHashFileMD5(filename, iv, mode);
 }
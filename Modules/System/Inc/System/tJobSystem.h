@@ -0,0 +1,215 @@
+// tJobSystem.h
+//
+// A work-stealing job system. A fixed set of worker threads each own a lock-free deque of jobs. Workers pop jobs from
+// the bottom of their own deque and, when it runs dry, steal from the top of the other workers' deques. Jobs may have
+// a parent, and a parent is not complete until all of its children are. Any thread waiting on a job helps out by
+// executing other jobs until the one it is waiting on is done.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#pragma once
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <Foundation/tStandard.h>
+#include <Foundation/tAssert.h>
+#include <Math/tFundamentals.h>
+namespace tSystem
+{
+
+
+class tJobSystem;
+
+
+// A tJob is both the unit of work and the handle you wait on. Memory for a tJob is managed by the caller and it must
+// stay alive until it is complete. Either derive from tJob and override Execute, or construct one with a function and
+// a user data pointer. A job is complete once it has executed and all of its children are complete.
+struct tJob
+{
+	typedef void JobFunction(void* userData);
+
+	// If a parent is supplied the parent will not complete until this job does. Children must be constructed before
+	// the parent completes, normally from inside the parent's Execute.
+	tJob(tJob* parent = nullptr)																						: Function(nullptr), UserData(nullptr), Parent(parent), Unfinished(1), NextQueued(nullptr) { if (Parent) Parent->Unfinished++; }
+	tJob(JobFunction* function, void* userData, tJob* parent = nullptr)													: Function(function), UserData(userData), Parent(parent), Unfinished(1), NextQueued(nullptr) { if (Parent) Parent->Unfinished++; }
+	virtual ~tJob()																										{ tAssert(IsComplete()); }
+
+	// Unless overridden, Execute calls the supplied function.
+	virtual void Execute()																								{ if (Function) Function(UserData); }
+	bool IsComplete() const																								{ return Unfinished.load(std::memory_order_acquire) == 0; }
+
+	JobFunction* Function;
+	void* UserData;
+
+private:
+	friend class tJobSystem;
+	tJob* Parent;
+
+	// The count is 1 for the job itself plus 1 for each unfinished child.
+	std::atomic<int> Unfinished;
+
+	// Intrusive link used only when the job lands in the shared submission queue.
+	tJob* NextQueued;
+};
+
+
+class tJobSystem
+{
+public:
+	// If numWorkers is <= 0 the number of workers is one less than the number of cores. The thread that calls Wait
+	// helps out, so this keeps every core busy. There is always at least one worker.
+	tJobSystem(int numWorkers = 0);
+
+	// Any jobs still queued are executed before the worker threads are stopped.
+	~tJobSystem();
+
+	int GetNumWorkers() const																							{ return NumWorkers; }
+
+	// Schedules a job. If called from one of this system's worker threads the job goes onto that worker's own deque
+	// with no locking. Calls from any other thread go into a shared submission queue.
+	void Submit(tJob*);
+
+	// Blocks until the job and all its children are complete. The calling thread executes other jobs while it waits.
+	void Wait(const tJob*);
+
+	// Convenience call that does a Submit followed by a Wait.
+	void Run(tJob* job)																									{ Submit(job); Wait(job); }
+
+	// Calls fn(index) for every index in [0, count), split into batches of batchSize consecutive indices, and returns
+	// once all are done. At most maxConcurrency batches run at the same time. If maxConcurrency is <= 0 all workers
+	// plus the calling thread are used. The function must be safe to call concurrently for different indices.
+	template<typename Fn> void ParallelFor(int count, const Fn&, int batchSize = 1, int maxConcurrency = 0);
+
+	// Returns true if the calling thread is one of this system's workers.
+	bool IsWorkerThread() const;
+
+	// The deque capacity is a power of 2. If a worker's deque is full, further submissions from it go to the shared
+	// queue instead.
+	static const int DequeCapacity = 4096;
+
+private:
+	// A lock-free Chase-Lev work-stealing deque. Only the owning worker may call Push and Pop. Any thread may call
+	// Steal. Based on "Correct and Efficient Work-Stealing for Weak Memory Models" by Le, Pop, Cohen, and Nardelli.
+	class WorkDeque
+	{
+	public:
+		WorkDeque()																										: Top(0), Bottom(0) { for (int j = 0; j < DequeCapacity; j++) Jobs[j].store(nullptr, std::memory_order_relaxed); }
+		bool Push(tJob*);				// Returns false if full.
+		tJob* Pop();					// Returns nullptr if empty.
+		tJob* Steal();					// Returns nullptr if empty or if it lost a race.
+
+	private:
+		alignas(64) std::atomic<int64> Top;
+		alignas(64) std::atomic<int64> Bottom;
+		alignas(64) std::atomic<tJob*> Jobs[DequeCapacity];
+	};
+
+	static void WorkerMain(tJobSystem*, int workerIndex);
+	tJob* FindJob(int workerIndex);
+	void ExecuteJob(tJob*);
+	void FinishJob(tJob*);
+	void SubmitShared(tJob*);
+	tJob* TakeShared();
+
+	int NumWorkers;
+	WorkDeque* Deques;
+	std::thread* Workers;
+
+	// The shared submission queue is an intrusive FIFO list. It is only used for jobs submitted by non-worker threads
+	// and for overflow.
+	std::mutex SharedMutex;
+	tJob* SharedHead;
+	tJob* SharedTail;
+	std::atomic<int> NumShared;
+
+	// Number of jobs sitting in any queue. Idle workers sleep on the condition variable when this is zero.
+	std::atomic<int> NumQueued;
+	std::atomic<int> NumSleeping;
+	std::atomic<bool> Quit;
+	std::mutex SleepMutex;
+	std::condition_variable SleepCondition;
+
+	template<typename Fn> struct ForJob : public tJob
+	{
+		ForJob()																										: tJob(), Body(nullptr), Count(0), BatchSize(1), NextBatch(nullptr) { }
+		void Execute() override;
+		const Fn* Body;
+		int Count;
+		int BatchSize;
+		std::atomic<int>* NextBatch;
+	};
+};
+
+
+// Returns a job system shared by anything that doesn't want to manage its own. It is created with the default number
+// of workers on first use and lives until the program exits.
+tJobSystem& tGetSharedJobSystem();
+
+
+}
+
+
+// Implementation below this line.
+
+
+template<typename Fn> inline void tSystem::tJobSystem::ForJob<Fn>::Execute()
+{
+	// Each ForJob keeps grabbing the next unclaimed batch. This balances uneven batches without one job per batch.
+	int numBatches = (Count + BatchSize - 1) / BatchSize;
+	for (int batch = NextBatch->fetch_add(1); batch < numBatches; batch = NextBatch->fetch_add(1))
+	{
+		int start = batch*BatchSize;
+		int end = tMath::tMin(start + BatchSize, Count);
+		for (int i = start; i < end; i++)
+			(*Body)(i);
+	}
+}
+
+
+template<typename Fn> inline void tSystem::tJobSystem::ParallelFor(int count, const Fn& fn, int batchSize, int maxConcurrency)
+{
+	if (count <= 0)
+		return;
+
+	if (batchSize < 1)
+		batchSize = 1;
+
+	int numBatches = (count + batchSize - 1) / batchSize;
+	int numJobs = NumWorkers + 1;
+	if ((maxConcurrency > 0) && (maxConcurrency < numJobs))
+		numJobs = maxConcurrency;
+	if (numBatches < numJobs)
+		numJobs = numBatches;
+
+	std::atomic<int> nextBatch(0);
+	tJob root;
+	ForJob<Fn>* jobs = new ForJob<Fn>[numJobs];
+	for (int j = 0; j < numJobs; j++)
+	{
+		jobs[j].Body = &fn;
+		jobs[j].Count = count;
+		jobs[j].BatchSize = batchSize;
+		jobs[j].NextBatch = &nextBatch;
+	}
+
+	// The root is never executed. It is only there so a single Wait covers every job, and the calling thread does its
+	// share of the batches while it waits.
+	for (int j = numJobs-1; j >= 0; j--)
+	{
+		jobs[j].Parent = &root;
+		root.Unfinished++;
+		Submit(&jobs[j]);
+	}
+	FinishJob(&root);
+	Wait(&root);
+	delete[] jobs;
+}
@@ -25,6 +25,9 @@ namespace tSystem
 bool tSupportsSSE();
 bool tSupportsSSE2();
 
+// Returns true if the processor supports AVX2 and the OS saves the upper halves of the YMM registers.
+bool tSupportsAVX2();
+
 // Returns the computer's name.
 tString tGetCompName();
 
@@ -16,7 +16,11 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #pragma once
+#include <type_traits>
 #include <Foundation/tString.h>
+template<int> class tFixIntU;
+template<int> class tFixInt;
+namespace tMath { struct tVec2; struct tVec3; struct tVec4; struct tQuat; struct tMat2; struct tMat4; }
 
 
 namespace tSystem
@@ -84,13 +88,29 @@ namespace tSystem
 	// still be called regardless of what you call SetSupplimentaryDebuggerOutput with.
 	void tSetSupplimentaryDebuggerOutput(bool enable = true);
 
+	// Asynchronous output. When enabled, tPrint (and therefore tPrintf and friends) copies the already formatted text
+	// into a bounded lock-free queue and returns straight away. A background writer thread drains the queue and writes
+	// the text in batches to stdout, the redirect callback, or the file handle supplied. This stops threads that print
+	// a lot from serializing on the output. Text printed by any one thread stays in order. If the queue is full the
+	// printing thread waits for room. queueSize is the number of messages that may be pending and is rounded up to a
+	// power of two. Turn it on and off from one thread only, ideally at startup and shutdown. Turning it off writes
+	// everything still queued. While it is on the redirect callback is called from the writer thread.
+	const int tAsyncOutputDefaultQueueSize = 4096;
+	void tSetAsyncOutput(bool enable, int queueSize = tAsyncOutputDefaultQueueSize);
+	bool tGetAsyncOutput();
+
+	// Blocks until everything queued before the call has been written. Does nothing if async output is off. tFlush
+	// calls this for you.
+	void tFlushAsyncOutput();
+
 	// This is a non-formatting print. Just prints the string you give it to the supplied FileHandle. If the supplied
 	// FileHandle is set to 0 then stdout is used. When stdout is the destination this function performs filtering on
 	// the characters that are printed. On some platforms there are unprintable stdout characters that this function
 	// will skip. If FileHandle is 0 and an OutputCallback is specified the callback is called without any filtering.
 	// Returns the actual number of characters printed which, therefore, may be less than the string length. No
 	// filtering is done if FileHandle is non-zero. Note that this return value is NOT used by other functions in this
-	// header like tPrintf due to the filtering. Not that this function ignores output channels.
+	// header like tPrintf due to the filtering. Not that this function ignores output channels. With async output on
+	// the text is queued and the full string length is returned.
 	int tPrint(const char* string, tFileHandle);
 
 	// Same as above but will only print to stdout if the channel is active. Essentially it calls the above print to
@@ -264,6 +284,143 @@ int tdfPrintf(tFileHandle dest, const char* format, ...);
 int tdfPrintf(tSystem::tChannel channels, tFileHandle dest, const char* format, ...);
 
 
+// Compile-time formatting. The functions above parse the format string on every call and read the arguments with
+// va_arg. A format used on a hot path, like a telemetry line printed millions of times, may instead be parsed once by
+// the compiler into a tFormat that is passed as a template argument:
+//
+// static constexpr tFormat frameFormat("Frame %05d took %.2f ms at %v\n");
+// char line[128];
+// int len = tsPrintfCT<frameFormat>(line, sizeof(line), frameNum, ms, position);
+//
+// The tFormat must be constexpr and have static storage duration (a static local or at namespace scope). All the
+// format specifiers above are supported, including the vector, quaternion, and matrix types. Since the argument types
+// are known the typesize is optional. %d prints an int64 or a tint256 and %v prints a vector with 2, 3, or 4
+// components. Vectors, quaternions, and matrices may be passed directly without calling pod, and a tString may be
+// passed for %s. An invalid specifier, the wrong number of arguments, or an argument that doesn't suit its specifier
+// (say a float for %d or an int for %f) will not compile. None of these functions allocate heap memory.
+template<int N> struct tFormat;
+
+// Same as the sized tsPrintf. At most destSize characters are written to dest including the terminating null, and
+// the number of non-null characters written is returned.
+template<const auto& Format, typename... Args> int tsPrintfCT(char* dest, int destSize, const Args&...);
+
+// Prints to stdout if any of the channels are visible. Like tPrintf, the number of characters that would be printed is
+// returned even if the channels aren't visible. The text is formatted into a buffer that each thread reuses.
+template<const auto& Format, tSystem::tChannel Channels = tSystem::tChannel_Default, typename... Args> int tPrintfCT(const Args&...);
+
+// Prints to the file handle. Returns the number of characters printed.
+template<const auto& Format, typename... Args> int tfPrintfCT(tFileHandle dest, const Args&...);
+
+
+namespace tSystem
+{
+	enum tFormatFlag : uint32
+	{
+		tFormatFlag_ForcePosOrNegSign			= 1 << 0,
+		tFormatFlag_SpaceForPosSign				= 1 << 1,
+		tFormatFlag_LeadingZeros				= 1 << 2,
+		tFormatFlag_LeftJustify					= 1 << 3,
+		tFormatFlag_DecorativeFormatting		= 1 << 4,
+		tFormatFlag_DecorativeFormattingAlt		= 1 << 5,
+		tFormatFlag_BasePrefix					= 1 << 6
+	};
+
+	// A parsed format specification. The runtime print functions and tFormat both use tParseFormatSpec so they accept
+	// exactly the same format strings.
+	struct tFormatSpec
+	{
+		uint32 Flags				= 0;
+		int Width					= 0;
+		int Precision				= -1;
+		int TypeSizeBytes			= 0;		// Zero if the format doesn't specify one.
+		bool WidthFromArg			= false;	// True for a * width. The width comes from the next int argument.
+		bool PrecisionFromArg		= false;	// True for a * precision.
+		char Type					= '\0';
+	};
+
+	// Returns true if the character is one of the type characters listed above.
+	constexpr bool tIsFormatType(char);
+
+	// Returns true if the character may come straight after a % in a format specification.
+	constexpr bool tIsFormatSpecStart(char);
+
+	// Parses the specification that starts just after a %. Returns the number of characters read including the type
+	// character, or 0 if there isn't a valid type character where it should be.
+	constexpr int tParseFormatSpec(tFormatSpec&, const char* format);
+
+	// The rest of this namespace supports tFormat and the CT print functions. You shouldn't need to use it directly.
+	struct tFormatSegment
+	{
+		// The literal text that comes before the specification. Spec.Type is '\0' for a segment that is only text.
+		int LiteralStart			= 0;
+		int LiteralLength			= 0;
+		tFormatSpec Spec;
+	};
+
+	enum class tFormatArgType
+	{
+		None,
+		Integer,
+		FixInt,
+		Float,
+		String,
+		Pointer,
+		Vector,
+		Quaternion,
+		Matrix
+	};
+
+	// Built-in values are converted and stored in Value. Bigger types like vectors and tFixInts are pointed to by Data.
+	struct tFormatArg
+	{
+		tFormatArg()																									: Data(nullptr), SizeBytes(0) { Value.Integer = 0; }
+		const void* Data;
+		int SizeBytes;
+		union
+		{
+			uint64 Integer;
+			double Float;
+			const void* Pointer;
+		} Value;
+	};
+
+	template<typename T> constexpr tFormatArgType tGetFormatArgType();
+	template<typename T> tFormatArg tMakeFormatArg(const T&);
+
+	// Returns true if an argument of the type and size may be used for a format specification with the type character
+	// and typesize. The type is '*' for a width or precision argument.
+	constexpr bool tFormatArgMatches(char type, int typeSizeBytes, tFormatArgType, int argSizeBytes);
+
+	int tFormatToBuffer(char* dest, int destSize, const char* text, const tFormatSegment*, int numSegments, const tFormatArg*);
+	int tFormatToOutput(tFileHandle dest, tChannel, const char* text, const tFormatSegment*, int numSegments, const tFormatArg*);
+
+	// These are deliberately not constexpr. Calling one while evaluating a constexpr tFormat stops the compile and the
+	// error message names the problem.
+	inline void tFormatError_InvalidSpecifier()																			{ }
+	inline void tFormatError_PercentAtEnd()																				{ }
+}
+
+
+template<int N> struct tFormat
+{
+	constexpr tFormat(const char (&format)[N]);
+
+	// Returns true if the argument types suit the specifications in the format.
+	template<typename... Args> constexpr bool ArgsMatch() const;
+
+	char Text[N]													= { };
+
+	// A specification needs at least two characters so this is enough segments for any format.
+	tSystem::tFormatSegment Segments[N/2 + 1]						= { };
+	int NumSegments													= 0;
+
+	// The type character of the specification each argument is for. A '*' for a width or precision.
+	char ArgTypes[N]												= { };
+	int ArgSizes[N]													= { };
+	int NumArgs														= 0;
+};
+
+
 // Implementation below this line.
 
 
@@ -276,7 +433,7 @@ inline int tPrintf(const char* f, ...)
 }
 
 
-inline int tPrintf(uint32 c, const char* f, ...)
+inline int tPrintf(tSystem::tChannel c, const char* f, ...)
 {
 	va_list l;			va_start(l, f);
 	int n = tvPrintf	(c, f, l);
@@ -351,8 +508,8 @@ inline int tPrintT(const char* f, ...)
 #else
 inline int tPrintf(const char* format, ...)																				{ return 0; }
 inline int tvPrintf(const char* format, va_list)																		{ return 0; }
-inline int tPrintf(uint32 channels, const char* format, ...)															{ return 0; }
-inline int tvPrintf(uint32 channels, const char* format, va_list)														{ return 0; }
+inline int tPrintf(tSystem::tChannel channels, const char* format, ...)													{ return 0; }
+inline int tvPrintf(tSystem::tChannel channels, const char* format, va_list)											{ return 0; }
 inline int tPrintCore(const char* format, ...)																			{ return 0; }
 inline int tPrintGameplay(const char* format, ...)																		{ return 0; }
 inline int tPrintPhysics(const char* format, ...)																		{ return 0; }
@@ -434,3 +591,316 @@ inline int tdfPrintf(tSystem::tChannel channels, tFileHandle dest, const char* f
 	tvPrintf(channels, format, marker); 
 	return tvfPrintf(dest, format, marker);
 }
+
+
+inline constexpr bool tSystem::tIsFormatType(char c)
+{
+	// Keep this in sync with the handler table in tPrint.cpp.
+	const char* types = "bodiuxXpefgvqmcs";
+	for (const char* t = types; *t; t++)
+		if (c == *t)
+			return true;
+
+	return false;
+}
+
+
+inline constexpr bool tSystem::tIsFormatSpecStart(char c)
+{
+	// Flags, width, precision, typesize, and finally the type.
+	if ((c == '-') || (c == '+') || (c == ' ') || (c == '0') || (c == '#') || (c == '_') || (c == '\''))
+		return true;
+
+	if (((c >= '0') && (c <= '9')) || (c == '.') || (c == '*'))
+		return true;
+
+	if ((c == ':') || (c == '!') || (c == '|'))
+		return true;
+
+	return tIsFormatType(c);
+}
+
+
+inline constexpr int tSystem::tParseFormatSpec(tFormatSpec& spec, const char* format)
+{
+	// The specification looks like: [flags][width][.precision][:typesize][!typesize][|typesize]type
+	const char* start = format;
+	spec = tFormatSpec();
+	while ((format[0] == '-') || (format[0] == '+') || (format[0] == ' ') || (format[0] == '0') || (format[0] == '_') || (format[0] == '\'') || (format[0] == '#'))
+	{
+		switch (format[0])
+		{
+			case '-':	spec.Flags |= tFormatFlag_LeftJustify;				break;
+			case '+':	spec.Flags |= tFormatFlag_ForcePosOrNegSign;		break;
+			case ' ':	spec.Flags |= tFormatFlag_SpaceForPosSign;			break;
+			case '0':	spec.Flags |= tFormatFlag_LeadingZeros;				break;
+			case '_':	spec.Flags |= tFormatFlag_DecorativeFormatting;		break;
+			case '\'':	spec.Flags |= tFormatFlag_DecorativeFormattingAlt;	break;
+			case '#':	spec.Flags |= tFormatFlag_BasePrefix;				break;
+		}
+		format++;
+	}
+
+	// From docs: If 0 (leading zeroes) and - (left justify) appear, leading-zeroes is ignored.
+	if ((spec.Flags & tFormatFlag_LeadingZeros) && (spec.Flags & tFormatFlag_LeftJustify))
+		spec.Flags &= ~tFormatFlag_LeadingZeros;
+
+	// Optional width. The '*' means the value comes from the argument list.
+	if (format[0] == '*')
+	{
+		spec.WidthFromArg = true;
+		format++;
+	}
+	else
+	{
+		while ((format[0] >= '0') && (format[0] <= '9'))
+			spec.Width = spec.Width*10 + (*format++ - '0');
+	}
+
+	// Optional precision.
+	if (format[0] == '.')
+	{
+		spec.Precision = 0;
+		format++;
+		if (format[0] == '*')
+		{
+			spec.PrecisionFromArg = true;
+			format++;
+		}
+		else
+		{
+			while ((format[0] >= '0') && (format[0] <= '9'))
+				spec.Precision = spec.Precision*10 + (*format++ - '0');
+		}
+	}
+
+	// Optional type size. Colon is in 32-bit elements, bang is in bytes, and pipe is in bits.
+	if ((format[0] == ':') || (format[0] == '!') || (format[0] == '|'))
+	{
+		char typeUnit = *format++;
+		while ((format[0] >= '0') && (format[0] <= '9'))
+			spec.TypeSizeBytes = spec.TypeSizeBytes*10 + (*format++ - '0');
+
+		switch (typeUnit)
+		{
+			case ':':	spec.TypeSizeBytes *= 4;	break;
+			case '|':	spec.TypeSizeBytes /= 8;	break;
+		}
+	}
+
+	if (!tIsFormatType(format[0]))
+		return 0;
+
+	spec.Type = format[0];
+	return int(format - start) + 1;
+}
+
+
+template<typename T> inline constexpr tSystem::tFormatArgType tSystem::tGetFormatArgType()
+{
+	typedef typename std::decay<T>::type D;
+	if constexpr (std::is_integral<D>::value || std::is_enum<D>::value)
+		return tFormatArgType::Integer;
+	else if constexpr (std::is_floating_point<D>::value)
+		return tFormatArgType::Float;
+	else if constexpr (std::is_same<D, char*>::value || std::is_same<D, const char*>::value || std::is_base_of<tString, D>::value)
+		return tFormatArgType::String;
+	else if constexpr (std::is_pointer<D>::value || std::is_null_pointer<D>::value)
+		return tFormatArgType::Pointer;
+	else if constexpr (std::is_base_of<tMath::tVec2, D>::value || std::is_base_of<tMath::tVec3, D>::value || std::is_base_of<tMath::tVec4, D>::value)
+		return tFormatArgType::Vector;
+	else if constexpr (std::is_base_of<tMath::tQuat, D>::value)
+		return tFormatArgType::Quaternion;
+	else if constexpr (std::is_base_of<tMath::tMat2, D>::value || std::is_base_of<tMath::tMat4, D>::value)
+		return tFormatArgType::Matrix;
+	else if constexpr (std::is_base_of<tFixIntU<128>, D>::value || std::is_base_of<tFixIntU<256>, D>::value || std::is_base_of<tFixIntU<512>, D>::value)
+		return tFormatArgType::FixInt;
+	else if constexpr (std::is_base_of<tFixInt<128>, D>::value || std::is_base_of<tFixInt<256>, D>::value || std::is_base_of<tFixInt<512>, D>::value)
+		return tFormatArgType::FixInt;
+	else
+		return tFormatArgType::None;
+}
+
+
+template<typename T> inline tSystem::tFormatArg tSystem::tMakeFormatArg(const T& value)
+{
+	tFormatArg arg;
+	constexpr tFormatArgType type = tGetFormatArgType<T>();
+	if constexpr (std::is_enum<T>::value)
+	{
+		return tMakeFormatArg(typename std::underlying_type<T>::type(value));
+	}
+	else if constexpr (type == tFormatArgType::Integer)
+	{
+		// Sign extended so any typesize up to 64 bits reads the right value.
+		arg.Value.Integer = std::is_signed<T>::value ? uint64(int64(value)) : uint64(value);
+		arg.SizeBytes = (sizeof(T) <= 4) ? 4 : 8;
+	}
+	else if constexpr (type == tFormatArgType::Float)
+	{
+		arg.Value.Float = double(value);
+		arg.SizeBytes = sizeof(double);
+	}
+	else if constexpr (type == tFormatArgType::String)
+	{
+		if constexpr (std::is_base_of<tString, T>::value)
+			arg.Value.Pointer = value.Chars();
+		else
+			arg.Value.Pointer = (const char*)value;
+		arg.SizeBytes = sizeof(const char*);
+	}
+	else if constexpr (type == tFormatArgType::Pointer)
+	{
+		arg.Value.Pointer = (const void*)value;
+		arg.SizeBytes = sizeof(void*);
+	}
+	else
+	{
+		arg.Data = &value;
+		arg.SizeBytes = sizeof(T);
+	}
+	return arg;
+}
+
+
+inline constexpr bool tSystem::tFormatArgMatches(char type, int typeSizeBytes, tFormatArgType argType, int argSizeBytes)
+{
+	// Built-in integers are stored sign extended to 64 bits so they may be printed as 32 or 64 bit.
+	bool sizeOK = (typeSizeBytes == 0) || (typeSizeBytes == argSizeBytes);
+	bool nativeSizeOK = (typeSizeBytes == 0) || (typeSizeBytes == 4) || (typeSizeBytes == 8);
+	switch (type)
+	{
+		case '*':
+		case 'c':
+			return (argType == tFormatArgType::Integer);
+
+		case 'b': case 'o': case 'd': case 'i': case 'u': case 'x': case 'X':
+			return ((argType == tFormatArgType::Integer) && nativeSizeOK) || ((argType == tFormatArgType::FixInt) && sizeOK);
+
+		case 'p':
+			return ((argType == tFormatArgType::Pointer) || (argType == tFormatArgType::String)) && sizeOK;
+
+		case 'e': case 'f': case 'g':
+			return (argType == tFormatArgType::Float) && sizeOK;
+
+		case 's':
+			return (argType == tFormatArgType::String);
+
+		case 'v':
+			return (argType == tFormatArgType::Vector) && sizeOK;
+
+		case 'q':
+			return (argType == tFormatArgType::Quaternion);
+
+		case 'm':
+			return (argType == tFormatArgType::Matrix) && sizeOK;
+	}
+
+	return false;
+}
+
+
+template<int N> inline constexpr tFormat<N>::tFormat(const char (&format)[N])
+{
+	for (int c = 0; c < N; c++)
+		Text[c] = format[c];
+
+	int pos = 0;
+	int literalStart = 0;
+	while (format[pos] != '\0')
+	{
+		if (format[pos] != '%')
+		{
+			pos++;
+			continue;
+		}
+
+		tSystem::tFormatSegment& segment = Segments[NumSegments++];
+		segment.LiteralStart = literalStart;
+		segment.LiteralLength = pos - literalStart;
+
+		// Like the runtime functions, a % followed by a character that can't start a specification outputs that
+		// character. This is how %% works.
+		if (!tSystem::tIsFormatSpecStart(format[pos+1]))
+		{
+			if (format[pos+1] == '\0')
+			{
+				tSystem::tFormatError_PercentAtEnd();
+				return;
+			}
+			literalStart = pos + 1;
+			pos += 2;
+			continue;
+		}
+
+		int numRead = tSystem::tParseFormatSpec(segment.Spec, format + pos + 1);
+		if (!numRead)
+		{
+			tSystem::tFormatError_InvalidSpecifier();
+			return;
+		}
+
+		if (segment.Spec.WidthFromArg)
+			ArgTypes[NumArgs++] = '*';
+		if (segment.Spec.PrecisionFromArg)
+			ArgTypes[NumArgs++] = '*';
+		ArgTypes[NumArgs] = segment.Spec.Type;
+		ArgSizes[NumArgs++] = segment.Spec.TypeSizeBytes;
+
+		pos += numRead + 1;
+		literalStart = pos;
+	}
+
+	if (pos > literalStart)
+	{
+		tSystem::tFormatSegment& segment = Segments[NumSegments++];
+		segment.LiteralStart = literalStart;
+		segment.LiteralLength = pos - literalStart;
+	}
+}
+
+
+template<int N> template<typename... Args> inline constexpr bool tFormat<N>::ArgsMatch() const
+{
+	// The extra entries keep the arrays from being empty when there are no arguments.
+	constexpr tSystem::tFormatArgType types[] = { tSystem::tGetFormatArgType<Args>()..., tSystem::tFormatArgType::None };
+	constexpr int sizes[] = { int(sizeof(Args))..., 0 };
+	for (int a = 0; a < NumArgs; a++)
+	{
+		int argSize = sizes[a];
+		if (types[a] == tSystem::tFormatArgType::Integer)
+			argSize = (argSize <= 4) ? 4 : 8;
+
+		if (!tSystem::tFormatArgMatches(ArgTypes[a], ArgSizes[a], types[a], argSize))
+			return false;
+	}
+
+	return true;
+}
+
+
+template<const auto& Format, typename... Args> inline int tsPrintfCT(char* dest, int destSize, const Args&... args)
+{
+	tStaticAssertMsg(Format.NumArgs == sizeof...(Args), "The number of arguments doesn't match the format.");
+	tStaticAssertMsg(Format.template ArgsMatch<Args...>(), "An argument doesn't suit its format specification.");
+	const tSystem::tFormatArg argList[] = { tSystem::tMakeFormatArg(args)..., tSystem::tFormatArg() };
+	return tSystem::tFormatToBuffer(dest, destSize, Format.Text, Format.Segments, Format.NumSegments, argList);
+}
+
+
+template<const auto& Format, tSystem::tChannel Channels, typename... Args> inline int tPrintfCT(const Args&... args)
+{
+	tStaticAssertMsg(Format.NumArgs == sizeof...(Args), "The number of arguments doesn't match the format.");
+	tStaticAssertMsg(Format.template ArgsMatch<Args...>(), "An argument doesn't suit its format specification.");
+	const tSystem::tFormatArg argList[] = { tSystem::tMakeFormatArg(args)..., tSystem::tFormatArg() };
+	return tSystem::tFormatToOutput(tFileHandle(0), Channels, Format.Text, Format.Segments, Format.NumSegments, argList);
+}
+
+
+template<const auto& Format, typename... Args> inline int tfPrintfCT(tFileHandle dest, const Args&... args)
+{
+	tStaticAssertMsg(Format.NumArgs == sizeof...(Args), "The number of arguments doesn't match the format.");
+	tStaticAssertMsg(Format.template ArgsMatch<Args...>(), "An argument doesn't suit its format specification.");
+	const tSystem::tFormatArg argList[] = { tSystem::tMakeFormatArg(args)..., tSystem::tFormatArg() };
+	return tSystem::tFormatToOutput(dest, tSystem::tChannel_All, Format.Text, Format.Segments, Format.NumSegments, argList);
+}
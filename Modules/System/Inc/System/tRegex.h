@@ -36,10 +36,19 @@
 #include "Foundation/tStandard.h"
 #include "Foundation/tList.h"
 #include "Foundation/tString.h"
+#include "Foundation/tBitArray.h"
 namespace tSystem
 {
 
 
+// Which matcher a compiled tRegex uses. Both accept exactly the same pattern syntax.
+enum class tRegexEngine
+{
+	Backtrack,												// Recursive matcher. May take exponential time and is not thread-safe.
+	Automaton												// NFA with a lazily built DFA. Linear time and thread-safe.
+};
+
+
 // The format of the regular expression pattern strings is fairly standard. The following is supported:
 //
 // Expressions:
@@ -84,20 +93,34 @@ namespace tSystem
 //		\P		Non-punctuation.
 //		\b		Word boundary.
 //		\B		Non-word boundary.
+//
+// The Backtrack engine is the default. Its match state lives in the tRegex object, so a compiled tRegex must not be
+// used by more than one thread at a time, and some patterns like (a*)*b can take exponential time on text that almost
+// matches. The Automaton engine compiles the pattern into a Thompson NFA and builds a DFA from it lazily as text is
+// scanned. The DFA states are cached in the tRegex and shared by all callers, and any per-match state lives on the
+// caller's stack, so IsMatch and Search run in time linear in the text length and may be called concurrently on the
+// same object. A literal that every match must contain is found at compile time and searched for with memchr first,
+// so text that can't match is usually rejected without running the automaton at all.
+//
+// The engines can differ in which substrings they report. The Automaton engine gives the leftmost match and prefers
+// the first alternative and the longest closure, as a full backtracking matcher would. The Backtrack engine commits to
+// a closure as soon as what follows it matches and never revisits that choice. For the Automaton engine \b is a
+// boundary between a space and a non-space character, with the ends of the text counting as spaces.
 class tRegex
 {
 public:
-	tRegex()																											: Pattern(nullptr), Nodes(nullptr), Matches(nullptr) { Clear(); }
-	tRegex(const tString& pattern)																						: Pattern(nullptr), Nodes(nullptr), Matches(nullptr) { Clear(); Compile(pattern); }
-	tRegex(const char* pattern)																							: Pattern(nullptr), Nodes(nullptr), Matches(nullptr) { Clear(); Compile(pattern); }
+	tRegex()																											: Pattern(nullptr), Nodes(nullptr), Matches(nullptr), Auto(nullptr) { Clear(); }
+	tRegex(const tString& pattern, tRegexEngine engine = tRegexEngine::Backtrack)										: Pattern(nullptr), Nodes(nullptr), Matches(nullptr), Auto(nullptr) { Clear(); Compile(pattern, engine); }
+	tRegex(const char* pattern, tRegexEngine engine = tRegexEngine::Backtrack)											: Pattern(nullptr), Nodes(nullptr), Matches(nullptr), Auto(nullptr) { Clear(); Compile(pattern, engine); }
 	~tRegex()																											{ Clear(); }
 
 	// Compiles a regular expression (described above). Any previously compiled expression is lost.
-	void Compile(const tString& pattern);
+	void Compile(const tString& pattern, tRegexEngine = tRegexEngine::Backtrack);
 	bool IsMatch(const tString& text) const																				{ return IsMatch(text.ConstText()); }
-	void Compile(const char* pattern);
+	void Compile(const char* pattern, tRegexEngine = tRegexEngine::Backtrack);
 	bool IsMatch(const char* text) const;					// Returns true is a perfect match is attained.
 	bool IsValid() const																								{ return Pattern ? true : false; }
+	tRegexEngine GetEngine() const																						{ return Auto ? tRegexEngine::Automaton : tRegexEngine::Backtrack; }
 	void Clear();
 
 	// Returns the number of sub-expressions for the compiled pattern. If all expressions match a test pattern, this is
@@ -123,6 +146,7 @@ public:
 	void Search(const tString& text, tList<Match>& matches) const														{ Search(text.ConstText(), matches); }
 
 private:
+	friend class tRegexSet;
 	struct Node
 	{
 		// These members may be an operator or the actual character. That's why they are ints and not tOperators.
@@ -153,6 +177,10 @@ private:
 	bool MatchClass(const Node*, char c) const;
 	const char* MatchNode(const Node*, const char* str, const Node* next) const;
 
+	// The Automaton engine is built from the parsed nodes. It is only defined in the cpp file.
+	struct Automaton;
+	void CompileAutomaton();
+
 	char* Pattern;											// Owned by this object.
 	mutable const char* EOL;								// End of line.
 	mutable const char* BOL;								// Beginning of line.
@@ -164,6 +192,42 @@ private:
 	int NumSubExpr;
 	MatchInternal* Matches;
 	mutable int CurrSubExpr;
+	Automaton* Auto;										// Only valid for the Automaton engine.
+};
+
+
+// A tRegexSet compiles many patterns into a single automaton and finds every one that matches some text in one pass
+// over it. The cost grows with the length of the text, not with the number of patterns. Patterns use the tRegex
+// syntax, and a pattern matches exactly when IsMatch would return true for a tRegex compiled from it. As with the
+// Automaton engine, a compiled set may be used by many threads at once.
+class tRegexSet
+{
+public:
+	tRegexSet()																											: Auto(nullptr), NumPatterns(0) { }
+	tRegexSet(const tList<tStringItem>& patterns)																		: Auto(nullptr), NumPatterns(0) { Compile(patterns); }
+	tRegexSet(const char* const* patterns, int numPatterns)																: Auto(nullptr), NumPatterns(0) { Compile(patterns, numPatterns); }
+	~tRegexSet()																										{ Clear(); }
+
+	// Compiles all the patterns. Any previously compiled set is lost. A malformed pattern throws a tError just like it
+	// does for tRegex. Empty patterns are allowed but never match.
+	void Compile(const tList<tStringItem>& patterns);
+	void Compile(const char* const* patterns, int numPatterns);
+	bool IsValid() const																								{ return Auto ? true : false; }
+	int GetNumPatterns() const																							{ return NumPatterns; }
+	void Clear();
+
+	// Returns true if any of the patterns is a perfect match.
+	bool IsMatch(const tString& text) const																				{ return IsMatch(text.ConstText()); }
+	bool IsMatch(const char* text) const;
+
+	// Sets matched to have one bit per pattern, in the order they were supplied, and sets the bits of the patterns
+	// that are a perfect match. Returns the number of patterns that matched.
+	int Match(const tString& text, tBitArray& matched) const															{ return Match(text.ConstText(), matched); }
+	int Match(const char* text, tBitArray& matched) const;
+
+private:
+	tRegex::Automaton* Auto;
+	int NumPatterns;
 };
 
 
@@ -36,6 +36,24 @@
 #include "System/tFile.h"
 
 
+// A node in the optional parse tree built by tScriptReader::Parse. The nodes live in a single arena owned by the
+// reader. The items of a list are stored contiguously so the child and sibling offsets (relative to the node itself)
+// give O(1) access to any item. Atoms have their numeric values parsed up-front. Text still points into the read
+// buffer, so atom access does not need to copy anything.
+struct tScriptNode
+{
+	const char* Text;									// The start of the expression. Lists begin with a '['.
+	int LineNumber;
+	int ChildOffset;									// Offset to the first item. Zero for atoms and empty lists.
+	int SiblingOffset;									// Offset to the next item. Zero for the last item in a list.
+	int NumItems;										// Zero for atoms.
+	int AtomLength;										// Does not include the quotes of a quoted atom.
+	bool AtomBool;
+	uint64 AtomBits;									// Low 32 bits are the int and uint values.
+	double AtomDouble;
+};
+
+
 // An s-expression has the following syntax: [command argument1 argument2 argument3] where both the commands and
 // arguments are also expressions. At the leaf level an expression is an Atom. This is the essence of symbolic
 // expressions. ex. (a.(b.(c.()))) == [a b c] is supported but (a.b) is not. Cdr is not much use in proper lists, but
@@ -43,12 +61,12 @@
 class tExpression
 {
 public:
-	tExpression()																										: ValueData(nullptr), LineNumber(0) { }
-	tExpression(const char* v)																							: ValueData(v), LineNumber(0) { }
+	tExpression()																										: ValueData(nullptr), LineNumber(0), Node(nullptr) { }
+	tExpression(const char* v)																							: ValueData(v), LineNumber(0), Node(nullptr) { }
 
 	// If you want the expression to keep track of what line number it's on then you should supply the current line
 	// number. Thrown error messages will include the line number if it's set.
-	tExpression(const char* v, int lineNumber)																			: ValueData(v), LineNumber(lineNumber) { }
+	tExpression(const char* v, int lineNumber)																			: ValueData(v), LineNumber(lineNumber), Node(nullptr) { }
 	virtual ~tExpression()																								{ }
 
 	// Like in scheme. Contents of the Address Register from the old IBM days.
@@ -68,13 +86,18 @@ public:
 	bool IsValid() const																								{ return ValueData ? true : false; }
 	bool IsAtom() const;
 
+	// Returns a pointer to the atom text inside the script and sets length. The text is not null-terminated. This is
+	// zero-copy and, for a parsed script, O(1).
+	const char* GetAtomText(int& length) const;
+
+	// The numeric getters use the pre-parsed values if the script was parsed.
 	tString GetAtomString() const;
-	bool GetAtomBool() const																							{ return GetAtomString().GetAsBool(); }
-	uint GetAtomUint() const																							{ return GetAtomString().GetAsUInt(); }
-	uint64 GetAtomUint64() const																						{ return GetAtomString().GetAsUInt64(); }
-	int GetAtomInt() const																								{ return GetAtomString().GetAsInt(); }
-	float GetAtomFloat() const																							{ return GetAtomString().GetAsFloat(); }
-	double GetAtomDouble() const																						{ return GetAtomString().GetAsDouble(); }
+	bool GetAtomBool() const																							{ const tScriptNode* n = GetParsedAtom(); return n ? n->AtomBool : GetAtomString().GetAsBool(); }
+	uint GetAtomUint() const																							{ const tScriptNode* n = GetParsedAtom(); return n ? uint(uint32(n->AtomBits)) : GetAtomString().GetAsUInt(); }
+	uint64 GetAtomUint64() const																						{ const tScriptNode* n = GetParsedAtom(); return n ? n->AtomBits : GetAtomString().GetAsUInt64(); }
+	int GetAtomInt() const																								{ const tScriptNode* n = GetParsedAtom(); return n ? int(int32(n->AtomBits)) : GetAtomString().GetAsInt(); }
+	float GetAtomFloat() const																							{ const tScriptNode* n = GetParsedAtom(); return n ? float(n->AtomDouble) : GetAtomString().GetAsFloat(); }
+	double GetAtomDouble() const																						{ const tScriptNode* n = GetParsedAtom(); return n ? n->AtomDouble : GetAtomString().GetAsDouble(); }
 	uint32 GetAtomHash() const																							{ return tMath::tHashString(GetAtomString()); }
 	uint32 Hash() const																									{ return GetAtomHash(); }
 
@@ -115,7 +138,7 @@ public:
 	tExpression Arg5() const																							{ return Cadddddr(); }
 	tExpression Arg6() const																							{ return Caddddddr(); }
 	tExpression ArgN(int n) const																						{ return CarCdrN(n); }
-	int CountArgs() const									/* Not fast. */												{ if (!IsValid()) return 0; int c = 0; while (CarCdrN(c).IsValid()) c++; return c; }
+	int CountArgs() const									/* Fast only if parsed. */									{ if (!IsValid()) return 0; if (Node && !IsAtom()) return Node->NumItems; int c = 0; while (CarCdrN(c).IsValid()) c++; return c; }
 
 	tExpression Item0() const																							{ return Car(); }
 	tExpression Item1() const																							{ return Cadr(); }
@@ -125,7 +148,7 @@ public:
 	tExpression Item5() const																							{ return Cadddddr(); }
 	tExpression Item6() const																							{ return Caddddddr(); }
 	tExpression ItemN(int n) const																						{ return CarCdrN(n); }
-	int CountItems() const									/* Not fast. */												{ return CountArgs(); }
+	int CountItems() const									/* Fast only if parsed. */									{ return CountArgs(); }
 
 	tExpression Cmd() const																								{ return Car(); }
 	tExpression Command() const																							{ return Car(); }
@@ -139,6 +162,9 @@ public:
 	int GetLineNumber() const																							{ return LineNumber; }
 
 protected:
+	// Only tScriptReader makes expressions that refer to parse tree nodes.
+	tExpression(const tScriptNode* node)																				: ValueData(node->Text), LineNumber(node->LineNumber), Node(node) { }
+
 	// Chugs along the in-memory data ignoring stuff that is allowed to be ignored. Returns the number of new lines
 	// encountered along the way.
 	static const char* EatWhiteAndComments(const char*, int& lineCount);
@@ -149,6 +175,9 @@ protected:
 	// The first valid line number starts at 1.
 	int LineNumber;
 
+	// Non-null if the script was parsed. The node memory is also owned by the tScriptReader.
+	const tScriptNode* Node;
+
 	// When throwing an error this is how much of the file is supplied to give a context.
 	static const int ContextSize = 32;
 
@@ -157,6 +186,9 @@ private:
 	// brackets and removes all spaces. This function is a helper for getting atoms that are vectors, quaternions,
 	// matrices, or colours.
 	tString GetAtomTupleString() const;
+
+	// Returns the parse tree node if this expression is a parsed atom, nullptr otherwise.
+	const tScriptNode* GetParsedAtom() const																			{ return (Node && IsAtom()) ? Node : nullptr; }
 };
 
 // If you don't like to type.
@@ -169,41 +201,69 @@ typedef tExpression tExpr;
 // [a b c]				; Arg0
 // d					; Arg1
 // [e f]				; Arg2
+//
+// By default expressions are evaluated by scanning the text every time they are accessed. That is fine for small
+// scripts but walking a large one is quadratic. If parse is set when loading, a tree is built in a single pass so that
+// Car, Next, ItemN, CountArgs, and the numeric atom getters are all O(1).
 class tScriptReader : public tExpression
 {
 public:
 	// Constructs an initially invalid tScriptReader.
-	tScriptReader()																										: tExpression(), ReadBuffer(nullptr) { }
+	tScriptReader()																										: tExpression(), ReadBuffer(nullptr), Nodes(nullptr), NumNodes(0) { }
 
 	// If isFile is true then the file 'name' is loaded, otherwise treats 'name' as the actual script string.
-	tScriptReader(const tString& name, bool isFile = true)																: tExpression(), ReadBuffer(nullptr) { Load(name, isFile); }
+	tScriptReader(const tString& name, bool isFile = true, bool parse = false)											: tExpression(), ReadBuffer(nullptr), Nodes(nullptr), NumNodes(0) { Load(name, isFile, parse); }
 
 	// Useful for command line utilities. Makes a script from standard command line argc and argv parameters. Honestly,
 	// I'm not sure how useful this is now that we have tOption for parsing command lines in a nice way that is a bit
 	// more standard.
 	tScriptReader(int argc, char** argv);
-	~tScriptReader()																									{ delete[] ReadBuffer; }
+	~tScriptReader()																									{ Clear(); }
 
 	// If isFile is true then the file 'name' is loaded, otherwise treats 'name' as the actual script string. The
-	// object is cleared before the new information is loaded. Any previous information is lost.
-	void Load(const tString& name, bool isFile = true);
+	// object is cleared before the new information is loaded. Any previous information is lost. If parse is true the
+	// parse tree is built straight away.
+	void Load(const tString& name, bool isFile = true, bool parse = false);
+
+	// Builds the parse tree for the loaded script. Expressions obtained from this reader after the call are backed by
+	// the tree. Expressions obtained before it still work but remain unindexed. Does nothing if already parsed.
+	void Parse();
+	bool IsParsed() const																								{ return Nodes ? true : false; }
 
 	// The object will be invalid after this call.
-	void Clear()																										{ delete[] ReadBuffer; ReadBuffer = 0; }
+	void Clear()																										{ delete[] ReadBuffer; ReadBuffer = 0; delete[] Nodes; Nodes = nullptr; NumNodes = 0; Node = nullptr; }
 	bool IsValid() const																								{ return ReadBuffer ? true : false; }
 
 private:
 	char* ReadBuffer;
+
+	// The parse tree arena. The root node is the last one.
+	tScriptNode* Nodes;
+	int NumNodes;
 };
 
 
-// Use this to create a script file.
+// Use this to create a script file. Output is formatted into an internal buffer and written out in large blocks, so
+// the file is not complete until the writer is destroyed or flushed. A writer may also write to memory, which is
+// handy for passing a script straight to a tScriptReader.
 class tScriptWriter
 {
 public:
 	// Creates the file if it doesn't exist, overwrites it if it does.
 	tScriptWriter(const tString& filename);
-	~tScriptWriter()																									{ tSystem::tCloseFile(ScriptFile); }
+
+	// Writes to a buffer that the writer manages and grows as needed. Use GetText to access the result.
+	tScriptWriter();
+	~tScriptWriter();
+
+	// Writes any buffered output to the file. Throws a tScriptError if the write fails. The destructor also flushes
+	// but can't report errors. Does nothing when writing to memory.
+	void Flush();
+
+	// Only valid when writing to memory. The text is null-terminated and remains valid until the writer is destroyed
+	// or written to again. Returns nullptr when writing to a file.
+	const char* GetText() const;
+	int GetTextLength() const																							{ return ScriptFile ? 0 : WriteBufferPos; }
 
 	void BeginExpression();
 	void EndExpression();
@@ -278,10 +338,31 @@ public:
 	template<typename T> void Comp(const tString& s, const T& a, const T& b, const T& c, const T& d)					{ WriteIndents(); Begin(); Atom(s); Atom(a); Atom(b); Atom(c); Atom(d); End(); CR(); }
 
 private:
-	void WriteIndents()																									{ int tabs = CurrIndent / IndentDelta; for (int t = 0; t < tabs; t++) tfPrintf(ScriptFile, "\t"); }
+	void WriteIndents()																									{ int tabs = CurrIndent / IndentDelta; for (int t = 0; t < tabs; t++) Write('\t'); }
 	int CurrIndent;
 	static const int IndentDelta = 4;
 
+	// Files are written through a buffer of this size. A memory writer starts with the smaller size and doubles it
+	// whenever it runs out.
+	static const int FileBufferSize = 256*1024;
+	static const int MemoryBufferSize = 4*1024;
+
+	void Write(char c)																									{ if (WriteBufferPos >= WriteBufferSize-1) Reserve(1); WriteBuffer[WriteBufferPos++] = c; }
+	void Write(const char* data, int numBytes);
+	void Reserve(int numBytes);
+	bool FlushBuffer();
+
+	// Writes an atom that is known not to need quotes, followed by a space.
+	void WriteAtomUnquoted(const char* atom, int length);
+
+	// Writes an atom of the form (a, b, c, ...) from float components.
+	void WriteAtomTuple(const float* components, int numComponents);
+
+	// The memory writer always keeps room for a terminating null.
+	char* WriteBuffer;
+	int WriteBufferSize;
+	int WriteBufferPos;
+
 protected:
 	tFileHandle ScriptFile;
 };
@@ -14,6 +14,7 @@
 
 #pragma once
 #include <Foundation/tPriorityQueue.h>
+namespace tSystem { class tJobSystem; }
 
 
 // The tTask class is virtual. All tasks that you want in a collection must be derived from a tTask.
@@ -43,6 +44,11 @@ public:
 
 	void SetCounter(int64 counterFreq, double maxTimeDelta)																{ CounterFreq = counterFreq; MaxTimeDelta = maxTimeDelta; }
 
+	// If a job system is set, Update sends all tasks that are ready to it and they execute in parallel. Update still
+	// returns only once they are all done, so the tasks don't need to change, but their Execute functions must be safe
+	// to call concurrently with each other. Set to nullptr (the default) to execute in order on the calling thread.
+	void SetJobSystem(tSystem::tJobSystem* jobSystem)																	{ JobSystem = jobSystem; }
+
 	// Inserts a task in O(lg(n)) time. Memory for tTask is managed by the caller. When a task is first inserted, it
 	// gets scheduled to be executed on the next call to Update. After that, the task controls the next execution time
 	// by returning the desired number of seconds.
@@ -56,10 +62,14 @@ public:
 	void Update(int64 counter);
 
 private:
+	void UpdateParallel(int64 counter);
+	int64 GetNextTimeDelta(double nextTime) const;
+
 	int64 ExecuteTime;					// Time execute was run last.
 	int64 CounterFreq;					// How quickly the counter value that gets passed to Execute() is going in Hz.
 	double MaxTimeDelta;
 	tPriorityQueue<tTask*> PriorityQueue;
+	tSystem::tJobSystem* JobSystem;
 
 	static const int NumTasks = 64;
 	static const int GrowSize = 32;
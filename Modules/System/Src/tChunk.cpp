@@ -42,17 +42,119 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <thread>
+#include <zlib.h>
 #include <Foundation/tMemory.h>
 #include "System/tFile.h"
+#include "System/tJobSystem.h"
 #include "System/tChunk.h"
 using namespace tStd;
 using namespace tSystem;
 using namespace tMath;
 
 
+namespace ChunkIndex
+{
+	// The index chunk data ends with the offset of the index chunk followed by this value, "TCIX" when read as a
+	// little-endian string. This lets a reader find the index from the end of the file.
+	const uint32 Magic = 0x58494354;
+	inline uint32 Hash(uint32 chunkID, int parent)																		{ uint32 h = (chunkID * 0x9E3779B1) ^ (uint32(parent + 1) * 0x85EBCA77); return h ^ (h >> 15); }
+}
+
+
+namespace ChunkCompression
+{
+	// Values of a decompressed slot that aren't data pointers.
+	const uint64 Busy = 1;
+	const uint64 Failed = 2;
+	uint8* Decompress(const tChunk&);
+	void GatherCompressed(tArray<tChunk>& chunks, tChunk first);
+
+	// The background job only walks the chunks. The decompression itself is spread out with a ParallelFor.
+	struct BackgroundJob : public tJob
+	{
+		BackgroundJob(const tChunkReader* reader, int maxThreads)														: tJob(), Reader(reader), MaxThreads(maxThreads) { }
+		void Execute() override;
+		const tChunkReader* Reader;
+		int MaxThreads;
+	};
+}
+
+
+uint8* ChunkCompression::Decompress(const tChunk& chunk)
+{
+	const tChunkCompressionHeader* header = (const tChunkCompressionHeader*)chunk.GetStoredData();
+	int storedSize = chunk.GetStoredSize();
+	if ((storedSize < int(sizeof(tChunkCompressionHeader))) || (header->Codec != uint32(tChunkCodec::Deflate)))
+		return nullptr;
+
+	// The decompressed data gets the same alignment the chunk data would have had if it weren't compressed.
+	int alignment = 1 << (((chunk.GetIDRaw() & 0x70000000) >> 28) + 2);
+	int size = int(header->UncompressedSize);
+	uint8* data = (uint8*)tMem::tMalloc(tMax(size, 1), alignment);
+
+	uLongf destLen = size;
+	int result = uncompress(data, &destLen, (const Bytef*)(header+1), storedSize - int(sizeof(tChunkCompressionHeader)));
+	if ((result != Z_OK) || (int(destLen) != size))
+	{
+		tMem::tFree(data);
+		return nullptr;
+	}
+
+	return data;
+}
+
+
+void ChunkCompression::GatherCompressed(tArray<tChunk>& chunks, tChunk first)
+{
+	for (tChunk chunk = first; chunk.IsValid(); chunk = chunk.GetNextChunk())
+	{
+		if (chunk.IsContainer())
+			GatherCompressed(chunks, chunk.GetFirstChunk());
+		else if (chunk.IsCompressed())
+			chunks.Append(chunk);
+	}
+}
+
+
+void ChunkCompression::BackgroundJob::Execute()
+{
+	tArray<tChunk> chunks;
+	GatherCompressed(chunks, Reader->GetFirstChunk());
+	const tChunk* elements = chunks.GetElements();
+	const tChunkReader* reader = Reader;
+	tGetSharedJobSystem().ParallelFor
+	(
+		chunks.GetNumElements(),
+		[elements, reader](int c) { reader->GetDecompressedData(elements[c]); },
+		1, MaxThreads
+	);
+}
+
+
+tChunkWriter::~tChunkWriter()
+{
+	if (ChunkFile)
+	{
+		Flush();
+		tCloseFile(ChunkFile);
+	}
+
+	while (ChunkInfo* chunkInfo = ChunkInfos.Remove())
+		delete chunkInfo;
+
+	if (IsBufferOwned && WriteBuffer)
+		tMem::tFree(WriteBuffer);
+	if (Scratch)
+		tMem::tFree(Scratch);
+	if (Staging)
+		tMem::tFree(Staging);
+}
+
+
 void tChunkWriter::Open(const tString& fileName, tEndianness dstEndianness)
 {
-	tAssert(!WriteBuffer);
+	tAssert(!WriteBuffer || IsBufferOwned);
 
 	#ifdef PLATFORM_WINDOWS
 	if (ChunkFile)
@@ -74,12 +176,14 @@ void tChunkWriter::Open(const tString& fileName, tEndianness dstEndianness)
 	#else
 	tAssert(ChunkFile);
 	#endif
+
+	ResetBuffer(FileBufferSize);
 }
 
 
 bool tChunkWriter::OpenSafe(const tString& fileName, tEndianness dstEndianness)
 {
-	tAssert(!WriteBuffer);
+	tAssert(!WriteBuffer || IsBufferOwned);
 
 	#ifdef PLATFORM_WINDOWS
 	if (ChunkFile)
@@ -102,18 +206,37 @@ bool tChunkWriter::OpenSafe(const tString& fileName, tEndianness dstEndianness)
 	tAssert(ChunkFile);
 	#endif
 
+	ResetBuffer(FileBufferSize);
 	return true;
 }
 
 
+void tChunkWriter::OpenMemory(tEndianness dstEndianness)
+{
+	tAssert(!ChunkFile && (!WriteBuffer || IsBufferOwned));
+	tEndianness srcEndianness = tGetEndianness();
+	NeedsEndianSwap = (srcEndianness == dstEndianness) ? false : true;
+	IsContainer = true;
+	ResetBuffer(MemoryBufferSize);
+}
+
+
 void tChunkWriter::Close()
 {
-	tAssert(!WriteBuffer);
+	tAssert(ChunkFile || IsBufferOwned);
 
 	if (ChunkFile)
 	{
+		bool flushed = Flush();
 		tCloseFile(ChunkFile);
 		ChunkFile = 0;
+
+		#ifdef PLATFORM_WINDOWS
+		if (!flushed)
+			throw tChunkError("Could not write to chunk file.");
+		#else
+		tAssert(flushed);
+		#endif
 	}
 
 	#ifndef PLATFORM_WINDOWS
@@ -133,12 +256,19 @@ void tChunkWriter::Close()
 }
 
 
-void tChunkWriter::BeginChunk(uint32 id, int alignment)
+void tChunkWriter::BeginChunk(uint32 id, int alignment, tChunkCodec codec)
 {
 	// Alignment variable is overridden for container chunks.
 	if (id & 0x80000000)
 		alignment = 4;
 
+	#ifdef PLATFORM_WINDOWS
+	if ((id & 0x80000000) && (codec != tChunkCodec::None))
+		throw tChunkError("Only data chunks may be compressed.");
+	#else
+	tAssert(!(id & 0x80000000) || (codec == tChunkCodec::None));
+	#endif
+
 	#ifdef PLATFORM_WINDOWS
 	if (!IsContainer)
 		throw tChunkError("You can only begin a chunk from a container.");
@@ -174,54 +304,38 @@ void tChunkWriter::BeginChunk(uint32 id, int alignment)
 	if ((id & 0xF0000000) == 0x00000000)
 		IsContainer = false;
 
-	int chunkStart = WriteBuffer ? WriteBufferPos : tSystem::tFileTell(ChunkFile);
+	int chunkStart = GetNumBytesWritten();
 	tAssert((chunkStart % 4) == 0);
 
+	// The data size gets filled in when the chunk is ended.
+	ChunkInfo* parentInfo = ChunkInfos.Head();
+	tChunkIndexEntry entry;
+	entry.IDRaw = idaa;
+	entry.Parent = parentInfo ? parentInfo->IndexEntry : -1;
+	entry.Offset = chunkStart;
+	entry.DataSize = 0;
+	IndexEntries.Append(entry);
+
 	if (NeedsEndianSwap)
 		tSwapEndian(idaa);
 
-	if (ChunkFile)
-	{
-		tWriteFile(ChunkFile, &idaa, sizeof(uint32));	// Chunk ID and alignment shift.
-		tWriteFile(ChunkFile, &idaa, sizeof(uint32));	// Dummy size.
-	}
-	else
-	{
-		tAssert((WriteBufferSize - WriteBufferPos) >= 8);
-		tMemcpy(WriteBuffer+WriteBufferPos, &idaa, sizeof(uint32));	WriteBufferPos += 4;	// Chunk ID and alignment shift.
-		tMemcpy(WriteBuffer+WriteBufferPos, &idaa, sizeof(uint32));	WriteBufferPos += 4;	// Dummy size
-	}
+	// Chunk ID and alignment shift followed by a dummy size. They go in a single write so the size can never be split
+	// across a flush.
+	uint32 header[2] = { idaa, idaa };
+	WriteBytes(header, sizeof(header));
 
 	// We need to advance the position until we meet the alignment requirements for this data.
-	int dataStart = WriteBuffer ? WriteBufferPos : tSystem::tFileTell(ChunkFile);
+	int dataStart = GetNumBytesWritten();
 	int numBytesPad = (dataStart % alignment) ? (alignment - (dataStart % alignment)) : 0;
 	dataStart += numBytesPad;
-	if (ChunkFile)
-	{
-		uint32 zero = 0;
-		while (numBytesPad > 3)
-		{
-			tWriteFile(ChunkFile, &zero, 4);
-			numBytesPad -= 4;
-		}
-
-		while (numBytesPad)
-		{
-			tWriteFile(ChunkFile, &zero, 1);
-			numBytesPad--;
-		}
-	}
-	else
-	{
-		tAssert((WriteBufferSize - WriteBufferPos) >= numBytesPad);
-		for (int i = 0; i < numBytesPad; i++)
-			*(WriteBuffer + WriteBufferPos + i) = 0;
-
-		WriteBufferPos += numBytesPad;
-	}
+	WriteZeros(numBytesPad);
 
-	ChunkInfo* chunkInfo = new ChunkInfo(chunkStart, dataStart);
+	ChunkInfo* chunkInfo = new ChunkInfo(chunkStart, dataStart, IndexEntries.GetNumElements()-1);
 	ChunkInfos.Insert(chunkInfo);
+
+	// From here on the chunk data is staged if it is to be compressed.
+	Codec = codec;
+	StagingPos = 0;
 }
 
 
@@ -243,47 +357,91 @@ void tChunkWriter::EndChunk()
 	tAssert(topChunk);
 	#endif
 
+	// For compressed chunks the index records the uncompressed size since that is what tChunk::GetDataSize returns.
+	bool compressed = false;
+	int uncompressedSize = -1;
+	if (Codec != tChunkCodec::None)
+	{
+		uncompressedSize = StagingPos;
+		compressed = WriteStaging();
+	}
+
 	// We need to write the data size at the beginning of the chunk.
-	int currPos = ChunkFile ? tSystem::tFileTell(ChunkFile) : WriteBufferPos;
+	int currPos = GetNumBytesWritten();
 	tAssert(topChunk->StartData > topChunk->StartChunk);
 	uint32 dataSize = currPos - topChunk->StartData;
+	IndexEntries[topChunk->IndexEntry].DataSize = (uncompressedSize >= 0) ? uncompressedSize : dataSize;
+	if (compressed)
+		dataSize |= tChunk::CompressedFlag;
 	if (NeedsEndianSwap)
 		tSwapEndian(dataSize);
 
-	if (ChunkFile)
-	{
-		tFileSeek(ChunkFile, topChunk->StartChunk + 4, tSeekOrigin::Beginning);
-		tWriteFile(ChunkFile, &dataSize, sizeof(uint32));
-		tFileSeek(ChunkFile, currPos, tSeekOrigin::Beginning);
-	}
-	else
+	bool patched = PatchBytes(topChunk->StartChunk + 4, &dataSize, sizeof(uint32));
+	delete topChunk;
+
+	#ifdef PLATFORM_WINDOWS
+	if (!patched)
 	{
-		tMemcpy((WriteBuffer + topChunk->StartChunk + 4), &dataSize, sizeof(uint32));
+		tCloseFile(ChunkFile);
+		ChunkFile = 0;
+		throw tChunkError("Could not write to chunk file.");
 	}
-
-	delete topChunk;
+	#else
+	tAssert(patched);
+	#endif
 
 	// We need to advance the position until we aligned to 4 bytes so that the next chunk starts at a mult of 4 bytes.
 	int numBytesPad = (currPos % 4) ? (4 - (currPos % 4)) : 0;
-	if (ChunkFile)
-	{
-		uint8 zero = 0;
-		for (int p = 0; p < numBytesPad; p++)
-			tWriteFile(ChunkFile, &zero, 1);
-	}
-	else
+	WriteZeros(numBytesPad);
+
+	// Once a top-level chunk is complete it is pushed out to the file, so the file can be read before the writer is
+	// closed. Most files only have a few top-level chunks so this keeps the number of writes low.
+	if (ChunkFile && !ChunkInfos.Head())
 	{
-		tAssert((WriteBufferSize - WriteBufferPos) >= numBytesPad);
-		for (int p = 0; p < numBytesPad; p++)
-			*(WriteBuffer + WriteBufferPos + p) = 0;
+		bool flushed = Flush() && tFlushFile(ChunkFile);
 
-		WriteBufferPos += numBytesPad;
+		#ifdef PLATFORM_WINDOWS
+		if (!flushed)
+			throw tChunkError("Could not write to chunk file.");
+		#else
+		tAssert(flushed);
+		#endif
 	}
 
 	IsContainer = true;
 }
 
 
+void tChunkWriter::WriteIndex()
+{
+	#ifdef PLATFORM_WINDOWS
+	if (ChunkInfos.Head())
+		throw tChunkError("The index may only be written after all chunks are ended.");
+	#else
+	tAssert(!ChunkInfos.Head());
+	#endif
+
+	// Beginning the index chunk adds an entry for itself. Only the entries before it get written.
+	int numEntries = IndexEntries.GetNumElements();
+	int indexStart = GetNumBytesWritten();
+	BeginChunk(tChunkID::Core_ChunkIndex);
+	Write(uint32(numEntries));
+	for (int e = 0; e < numEntries; e++)
+	{
+		const tChunkIndexEntry& entry = IndexEntries[e];
+		Write(entry.IDRaw);
+		Write(entry.Parent);
+		Write(entry.Offset);
+		Write(entry.DataSize);
+	}
+	Write(uint32(indexStart));
+	Write(ChunkIndex::Magic);
+	EndChunk();
+
+	IndexEntries.Clear();
+}
+
+
 int tChunkWriter::Write(const void* data, int sizeInBytes)
 {
 	#ifdef PLATFORM_WINDOWS
@@ -297,30 +455,188 @@ int tChunkWriter::Write(const void* data, int sizeInBytes)
 	tAssert(!IsContainer);
 	#endif
 
-	int numWritten = 0;
-	if (ChunkFile)
+	WriteBytes(data, sizeInBytes);
+	return sizeInBytes;
+}
+
+
+void tChunkWriter::ResetBuffer(int minSize)
+{
+	if (!IsBufferOwned || (WriteBufferSize < minSize))
 	{
-		numWritten = tWriteFile(ChunkFile, data, sizeInBytes);
+		if (IsBufferOwned && WriteBuffer)
+			tMem::tFree(WriteBuffer);
 
-		#ifdef PLATFORM_WINDOWS
-		if (numWritten != sizeInBytes)
+		// The buffer is aligned so chunk data written to memory has the same alignment it would have in a file.
+		WriteBuffer = (uint8*)tMem::tMalloc(minSize, tChunkReader::GetBufferAlignmentNeeded());
+		WriteBufferSize = minSize;
+		IsBufferOwned = true;
+	}
+
+	WriteBufferPos = 0;
+	NumBytesFlushed = 0;
+	IndexEntries.Clear();
+}
+
+
+bool tChunkWriter::Flush()
+{
+	if (!ChunkFile || !WriteBufferPos)
+		return true;
+
+	int numBytes = WriteBufferPos;
+	int numWritten = tWriteFile(ChunkFile, WriteBuffer, numBytes);
+	NumBytesFlushed += numBytes;
+	WriteBufferPos = 0;
+	return (numWritten == numBytes) ? true : false;
+}
+
+
+void tChunkWriter::WriteBytes(const void* data, int numBytes)
+{
+	if (numBytes <= 0)
+		return;
+
+	// Data for a compressed chunk is held back until the chunk ends.
+	if (Codec != tChunkCodec::None)
+	{
+		if (StagingPos + numBytes > StagingSize)
 		{
-			tCloseFile(ChunkFile);
-			throw tChunkError("Could not write to chunk file.");
+			int newSize = tMax(StagingSize*2, StagingPos + numBytes, MemoryBufferSize);
+			uint8* newStaging = (uint8*)tMem::tMalloc(newSize, 16);
+			if (Staging)
+			{
+				tMemcpy(newStaging, Staging, StagingPos);
+				tMem::tFree(Staging);
+			}
+			Staging = newStaging;
+			StagingSize = newSize;
 		}
-		#else
-		tAssert(numWritten == sizeInBytes);
-		#endif
+		tMemcpy(Staging + StagingPos, data, numBytes);
+		StagingPos += numBytes;
+		return;
 	}
-	else
+
+	if (WriteBufferPos + numBytes > WriteBufferSize)
 	{
-		tAssert((WriteBufferSize - WriteBufferPos) >= sizeInBytes);
-		tMemcpy(WriteBuffer+WriteBufferPos, data, sizeInBytes);
-		WriteBufferPos += sizeInBytes;
-		numWritten = sizeInBytes;
+		if (ChunkFile)
+		{
+			bool written = Flush();
+
+			// Anything bigger than the whole buffer goes straight to the file. There's no point copying it first.
+			if (written && (numBytes > WriteBufferSize))
+			{
+				written = (tWriteFile(ChunkFile, data, numBytes) == numBytes) ? true : false;
+				NumBytesFlushed += numBytes;
+				numBytes = 0;
+			}
+
+			#ifdef PLATFORM_WINDOWS
+			if (!written)
+			{
+				tCloseFile(ChunkFile);
+				ChunkFile = 0;
+				throw tChunkError("Could not write to chunk file.");
+			}
+			#else
+			tAssert(written);
+			#endif
+
+			if (!numBytes)
+				return;
+		}
+		else
+		{
+			// A buffer supplied by the user can't grow.
+			tAssert(IsBufferOwned);
+			int newSize = tMax(WriteBufferSize*2, WriteBufferPos + numBytes);
+			uint8* newBuffer = (uint8*)tMem::tMalloc(newSize, tChunkReader::GetBufferAlignmentNeeded());
+			tMemcpy(newBuffer, WriteBuffer, WriteBufferPos);
+			tMem::tFree(WriteBuffer);
+			WriteBuffer = newBuffer;
+			WriteBufferSize = newSize;
+		}
 	}
 
-	return numWritten;
+	tMemcpy(WriteBuffer + WriteBufferPos, data, numBytes);
+	WriteBufferPos += numBytes;
+}
+
+
+void tChunkWriter::WriteZeros(int numBytes)
+{
+	// Padding is never more than the largest alignment.
+	static const uint8 zeros[512] = { 0 };
+	tAssert(numBytes <= int(sizeof(zeros)));
+	WriteBytes(zeros, numBytes);
+}
+
+
+bool tChunkWriter::PatchBytes(int position, const void* data, int numBytes)
+{
+	if (position >= NumBytesFlushed)
+	{
+		tAssert(position + numBytes <= NumBytesFlushed + WriteBufferPos);
+		tMemcpy(WriteBuffer + position - NumBytesFlushed, data, numBytes);
+		return true;
+	}
+
+	// The bytes have already been flushed. This only happens for chunks too big to fit in the buffer. The seek back to
+	// the end is always attempted so later writes don't land in the middle of the file.
+	tAssert(ChunkFile && (position + numBytes <= NumBytesFlushed));
+	bool patched = (tFileSeek(ChunkFile, position, tSeekOrigin::Beginning) == 0) && (tWriteFile(ChunkFile, data, numBytes) == numBytes);
+	bool restored = (tFileSeek(ChunkFile, NumBytesFlushed, tSeekOrigin::Beginning) == 0);
+	return patched && restored;
+}
+
+
+bool tChunkWriter::WriteStaging()
+{
+	// Clearing the codec first means the writes below go to the real output.
+	tChunkCodec codec = Codec;
+	Codec = tChunkCodec::None;
+	tAssert(codec == tChunkCodec::Deflate);
+
+	uLongf compressedSize = compressBound(StagingPos);
+	int headerSize = sizeof(tChunkCompressionHeader);
+	uint8* compressed = GetScratch(headerSize + int(compressedSize));
+	int result = compress2(compressed + headerSize, &compressedSize, Staging, StagingPos, Z_DEFAULT_COMPRESSION);
+
+	// Not worth it unless it makes the chunk smaller.
+	if ((result != Z_OK) || (headerSize + int(compressedSize) >= StagingPos))
+	{
+		WriteBytes(Staging, StagingPos);
+		StagingPos = 0;
+		return false;
+	}
+
+	tChunkCompressionHeader header;
+	tStd::tMemset(&header, 0, sizeof(header));
+	header.Codec = uint32(codec);
+	header.UncompressedSize = StagingPos;
+	if (NeedsEndianSwap)
+	{
+		tSwapEndian(header.Codec);
+		tSwapEndian(header.UncompressedSize);
+	}
+	tMemcpy(compressed, &header, headerSize);
+	WriteBytes(compressed, headerSize + int(compressedSize));
+	StagingPos = 0;
+	return true;
+}
+
+
+uint8* tChunkWriter::GetScratch(int numBytes)
+{
+	if (numBytes > ScratchSize)
+	{
+		if (Scratch)
+			tMem::tFree(Scratch);
+		ScratchSize = tMax(numBytes, ScratchSize*2);
+		Scratch = (uint8*)tMem::tMalloc(ScratchSize, 16);
+	}
+
+	return Scratch;
 }
 
 
@@ -478,13 +794,12 @@ int tChunkWriter::Write(const tVector2* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tVec2* swappedItems = new tVec2[numItems];
+		tVec2* swappedItems = (tVec2*)GetScratch(sizeof(tVec2)*numItems);
 		for (int i = 0; i < numItems; i++)
 			for (int e = 0; e < 2; e++)
 				swappedItems[i].E[e] = tGetSwapEndian(data[i].E[e]);
 
 		int n = Write( (void*)swappedItems, sizeof(tVec2)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 
@@ -499,13 +814,12 @@ int tChunkWriter::Write(const tVector3* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tVec3* swappedItems = new tVec3[numItems];
+		tVec3* swappedItems = (tVec3*)GetScratch(sizeof(tVec3)*numItems);
 		for (int i = 0; i < numItems; i++)
 			for (int e = 0; e < 3; e++)
 				swappedItems[i].E[e] = tGetSwapEndian(data[i].E[e]);
 
 		int n = Write( (void*)swappedItems, sizeof(tVector3)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 
@@ -520,13 +834,12 @@ int tChunkWriter::Write(const tVector4* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tVec4* swappedItems = new tVec4[numItems];
+		tVec4* swappedItems = (tVec4*)GetScratch(sizeof(tVec4)*numItems);
 		for (int i = 0; i < numItems; i++)
 			for (int e = 0; e < 4; e++)
 				swappedItems[i].E[e] = tGetSwapEndian(data[i].E[e]);
 
 		int n = Write( (void*)swappedItems, sizeof(tVec4)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 
@@ -541,13 +854,12 @@ int tChunkWriter::Write(const tQuaternion* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tQuat* swappedItems = new tQuat[numItems];
+		tQuat* swappedItems = (tQuat*)GetScratch(sizeof(tQuat)*numItems);
 		for (int i = 0; i < numItems; i++)
 			for (int e = 0; e < 4; e++)
 				swappedItems[i].E[e] = tGetSwapEndian(data[i].E[e]);
 
 		int n = Write( (void*)swappedItems, sizeof(tQuat)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 
@@ -562,13 +874,12 @@ int tChunkWriter::Write(const tMatrix2* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tMat2* swappedItems = new tMat2[numItems];
+		tMat2* swappedItems = (tMat2*)GetScratch(sizeof(tMat2)*numItems);
 		for (int i = 0; i < numItems; i++)
 			for (int e = 0; e < 4; e++)
 				swappedItems[i].E[e] = tGetSwapEndian(data[i].E[e]);
 
 		int n = Write( (void*)swappedItems, sizeof(tMat2)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 
@@ -583,13 +894,12 @@ int tChunkWriter::Write(const tMatrix4* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tMat4* swappedItems = new tMat4[numItems];
+		tMat4* swappedItems = (tMat4*)GetScratch(sizeof(tMat4)*numItems);
 		for (int i = 0; i < numItems; i++)
 			for (int e = 0; e < 16; e++)
 				swappedItems[i].E[e] = tGetSwapEndian(data[i].E[e]);
 
 		int n = Write( (void*)swappedItems, sizeof(tMat4)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 
@@ -604,13 +914,12 @@ int tChunkWriter::Write(const tEdge* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tEdge* swappedItems = new tEdge[numItems];
+		tEdge* swappedItems = (tEdge*)GetScratch(sizeof(tEdge)*numItems);
 		for (int i = 0; i < numItems; i++)
 			for (int e = 0; e < 2; e++)
 				swappedItems[i].Index[e] = tGetSwapEndian(data[i].Index[e]);
 
 		int n = Write( (void*)swappedItems, sizeof(tEdge)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 		
@@ -625,13 +934,12 @@ int tChunkWriter::Write(const tTri* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tTri* swappedItems = new tTri[numItems];
+		tTri* swappedItems = (tTri*)GetScratch(sizeof(tTri)*numItems);
 		for (int i = 0; i < numItems; i++)
 			for (int e = 0; e < 3; e++)
 				swappedItems[i].Index[e] = tGetSwapEndian(data[i].Index[e]);
 
 		int n = Write( (void*)swappedItems, sizeof(tTri)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 
@@ -646,13 +954,12 @@ int tChunkWriter::Write(const tQuad* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tQuad* swappedItems = new tQuad[numItems];
+		tQuad* swappedItems = (tQuad*)GetScratch(sizeof(tQuad)*numItems);
 		for (int i = 0; i < numItems; i++)
 			for (int e = 0; e < 4; e++)
 				swappedItems[i].Index[e] = tGetSwapEndian(data[i].Index[e]);
 
 		int n = Write( (void*)swappedItems, sizeof(tQuad)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 
@@ -667,7 +974,7 @@ int tChunkWriter::Write(const tSphere* data, int numItems)
 
 	if (NeedsEndianSwap)
 	{
-		tSphere* swappedItems = new tSphere[numItems];
+		tSphere* swappedItems = (tSphere*)GetScratch(sizeof(tSphere)*numItems);
 		for (int i = 0; i < numItems; i++)
 		{
 			for (int e = 0; e < 3; e++)
@@ -676,7 +983,6 @@ int tChunkWriter::Write(const tSphere* data, int numItems)
 		}
 
 		int n = Write( (void*)swappedItems, sizeof(tSphere)*numItems );
-		delete[] swappedItems;
 		return n;
 	}
 		
@@ -718,7 +1024,7 @@ int tChunkWriter::Write(const void* data, const tString& layoutStr)
 
 	if (NeedsEndianSwap)
 	{
-		uint8* swapped = new uint8[numBytes];
+		uint8* swapped = GetScratch(numBytes);
 		tMemcpy(swapped, data, numBytes);
 		uint8* curr = swapped;
 
@@ -756,9 +1062,7 @@ int tChunkWriter::Write(const void* data, const tString& layoutStr)
 			}
 		}
 
-		int n = Write((void*)swapped, numBytes);
-		delete[] swapped;
-		return n;
+		return Write((void*)swapped, numBytes);
 	}
 
 	return Write((void*)data, numBytes);
@@ -769,13 +1073,20 @@ void tChunkReader::Load(const tString& filename, uint8* buffer)
 {
 	UnLoad();
 	tFileHandle fh = tOpenFile(filename.ConstText(), "rb");
-	ReadBufferSize = tGetFileSize(fh);
+	int64 fileSize = tGetFileSize(fh);
 	const int maxAlign = 1 << (int(tChunkWriter::Alignment::Largest) + 2);
 
 	if (!buffer)
 	{
-		// Create a buffer big enough for the file. Make sure it is aligned.
-		ReadBuffer = (uint8*)tMem::tMalloc(ReadBufferSize, maxAlign);
+		// Create a buffer big enough for the file. Make sure it is aligned. tMalloc sizes are an int so bigger files
+		// need a supplied buffer or LoadMapped.
+		if (fileSize >= 0x7FFFFFFF)
+		{
+			tAssertMsg(false, "Chunk file too big to load without a supplied buffer.");
+			tCloseFile(fh);
+			return;
+		}
+		ReadBuffer = (uint8*)tMem::tMalloc(int(fileSize), maxAlign);
 		IsBufferOwned = true;
 	}
 	else
@@ -785,13 +1096,15 @@ void tChunkReader::Load(const tString& filename, uint8* buffer)
 
 	// Casting to uint32 is safe even for 64 bit pointers because maxAlign is much smaller than 2^32.
 	tAssert((uint32(uint64(ReadBuffer)) % maxAlign) == 0);
-	int numRead = tReadFile(fh, ReadBuffer, ReadBufferSize);
+	ReadBufferSize = fileSize;
+	int64 numRead = tReadFile(fh, ReadBuffer, ReadBufferSize);
 	tAssert(numRead == ReadBufferSize);
 	tCloseFile(fh);
+	ReadIndex();
 }
 
 
-void tChunkReader::Load(uint8* buffer, int bufferSizeBytes)
+void tChunkReader::Load(uint8* buffer, int64 bufferSizeBytes)
 {
 	UnLoad();
 	const int maxAlign = 1 << (int(tChunkWriter::Alignment::Largest) + 2);
@@ -800,6 +1113,7 @@ void tChunkReader::Load(uint8* buffer, int bufferSizeBytes)
 	IsBufferOwned = false;
 	ReadBufferSize = bufferSizeBytes;
 	ReadBuffer = buffer;
+	ReadIndex();
 }
 
 
@@ -807,8 +1121,10 @@ bool tChunkReader::LoadSafe(const tString& filename)
 {
 	UnLoad();
 	tFileHandle fh = tOpenFile(filename.ConstText(), "rb");
-	ReadBufferSize = tGetFileSize(fh);
-	if (ReadBufferSize == 0)
+	int64 fileSize = tGetFileSize(fh);
+
+	// tMalloc sizes are an int. Bigger files may still be opened with LoadMapped.
+	if ((fileSize == 0) || (fileSize >= 0x7FFFFFFF))
 	{
 		tCloseFile(fh);
 		return false;
@@ -816,20 +1132,42 @@ bool tChunkReader::LoadSafe(const tString& filename)
 	const int maxAlign = 1 << (int(tChunkWriter::Alignment::Largest) + 2);
 
 	// Create a buffer big enough for the file. Make sure it is aligned.
-	ReadBuffer = (uint8*)tMem::tMalloc(ReadBufferSize, maxAlign);
+	ReadBuffer = (uint8*)tMem::tMalloc(int(fileSize), maxAlign);
+	ReadBufferSize = fileSize;
 	IsBufferOwned = true;
 
 	tAssert((uint32(uint64(ReadBuffer)) % maxAlign) == 0);
-	int numRead = tReadFile(fh, ReadBuffer, ReadBufferSize);
+	int64 numRead = tReadFile(fh, ReadBuffer, ReadBufferSize);
 	tCloseFile(fh);
 	if (numRead != ReadBufferSize)
 		return false;
 
+	ReadIndex();
+	return true;
+}
+
+
+bool tChunkReader::LoadMapped(const tString& filename)
+{
+	UnLoad();
+	int64 fileSize = 0;
+	uint8* mapped = tMapFile(filename, fileSize);
+	if (!mapped)
+		return false;
+
+	// Mapped views always start on a page boundary, which is far coarser than the largest chunk alignment.
+	const int maxAlign = 1 << (int(tChunkWriter::Alignment::Largest) + 2);
+	tAssert((uint64(mapped) % uint64(maxAlign)) == 0);
+
+	ReadBuffer = mapped;
+	ReadBufferSize = fileSize;
+	IsBufferMapped = true;
+	ReadIndex();
 	return true;
 }
 
 
-int tChunkReader::Save(const tString& filename)
+int64 tChunkReader::Save(const tString& filename)
 {
 	if (!IsValid())
 		return 0;
@@ -837,7 +1175,7 @@ int tChunkReader::Save(const tString& filename)
 	tFileHandle chunkFile = tOpenFile(filename, "wb");
 	tAssert(chunkFile);
 
-	int numWritten = tWriteFile(chunkFile, ReadBuffer, ReadBufferSize);
+	int64 numWritten = tWriteFile(chunkFile, ReadBuffer, ReadBufferSize);
 	tAssert(numWritten == ReadBufferSize);
 
 	tCloseFile(chunkFile);
@@ -847,11 +1185,282 @@ int tChunkReader::Save(const tString& filename)
 
 void tChunkReader::UnLoad()
 {
+	// The background job must be done before its chunks go away.
+	if (BackgroundJob)
+	{
+		tGetSharedJobSystem().Wait(BackgroundJob);
+		delete BackgroundJob;
+		BackgroundJob = nullptr;
+	}
+
+	for (int c = 0; c < CompressedChunks.GetNumElements(); c++)
+	{
+		uint64 state = DecompressedSlots[c].load(std::memory_order_relaxed);
+		if (state > ChunkCompression::Failed)
+			tMem::tFree((uint8*)state);
+	}
+	delete[] DecompressedSlots;
+	DecompressedSlots = nullptr;
+	CompressedChunks.Clear();
+	CompressedFound.store(false, std::memory_order_relaxed);
+
 	// Unload anything currently maintained.
-	if (IsBufferOwned && ReadBuffer)
+	if (IsBufferMapped && ReadBuffer)
+		tUnmapFile(ReadBuffer, ReadBufferSize);
+	else if (IsBufferOwned && ReadBuffer)
 		tMem::tFree(ReadBuffer);
 
+	delete[] IndexTable;
+	delete[] IndexNext;
+	IndexTable = nullptr;
+	IndexNext = nullptr;
+	IndexTableSize = 0;
+	Index = nullptr;
+	NumIndexEntries = 0;
+
 	ReadBuffer = nullptr;
 	ReadBufferSize = 0;
+	ContentSize = 0;
 	IsBufferOwned = false;
+	IsBufferMapped = false;
+}
+
+
+void tChunkReader::ReadIndex()
+{
+	ContentSize = ReadBufferSize;
+	if (!ReadBuffer || (ReadBufferSize < 20))
+		return;
+
+	// Anything that doesn't look exactly like an index written by tChunkWriter is ignored and the file is treated as
+	// if it had none.
+	uint32* footer = (uint32*)(ReadBuffer + ReadBufferSize - 8);
+	uint32 indexStart = footer[0];
+	if ((footer[1] != ChunkIndex::Magic) || (indexStart % 4) || (int64(indexStart) > ReadBufferSize - 20))
+		return;
+
+	tChunk indexChunk(ReadBuffer + indexStart, ReadBuffer + ReadBufferSize);
+	if ((indexChunk.GetID() != tChunkID::Core_ChunkIndex) || (indexChunk.GetData() + indexChunk.GetDataSize() != ReadBuffer + ReadBufferSize))
+		return;
+
+	uint8* data = indexChunk.GetData();
+	int numEntries = *((int*)data);
+	if ((numEntries < 0) || (int64(indexChunk.GetDataSize()) != 12 + int64(numEntries)*int64(sizeof(tChunkIndexEntry))))
+		return;
+
+	const tChunkIndexEntry* entries = (const tChunkIndexEntry*)(data + 4);
+	for (int e = 0; e < numEntries; e++)
+	{
+		const tChunkIndexEntry& entry = entries[e];
+		if ((entry.Parent >= e) || (entry.Parent < -1) || (entry.Offset % 4) || (entry.Offset + 8 > indexStart))
+			return;
+	}
+
+	Index = entries;
+	NumIndexEntries = numEntries;
+	ContentSize = indexStart;
+
+	// Keep the table at most half full so probe sequences stay short.
+	IndexTableSize = int(tNextHigherPower2(uint(tMax(16, numEntries*2))));
+	IndexTable = new int[IndexTableSize];
+	IndexNext = new int[tMax(1, numEntries)];
+	for (int t = 0; t < IndexTableSize; t++)
+		IndexTable[t] = -1;
+
+	// Going backwards means the table ends up with the first entry for each key, and the next links are in order.
+	for (int e = numEntries-1; e >= 0; e--)
+	{
+		uint32 id = Index[e].IDRaw & 0x8FFFFFFF;
+		int parent = Index[e].Parent;
+		uint32 slot = ChunkIndex::Hash(id, parent) & (IndexTableSize-1);
+		IndexNext[e] = -1;
+		while (IndexTable[slot] >= 0)
+		{
+			int other = IndexTable[slot];
+			if ((Index[other].Parent == parent) && ((Index[other].IDRaw & 0x8FFFFFFF) == id))
+			{
+				IndexNext[e] = other;
+				break;
+			}
+			slot = (slot + 1) & (IndexTableSize-1);
+		}
+		IndexTable[slot] = e;
+	}
+}
+
+
+int tChunkReader::FindIndexEntry(uint32 chunkID, int parent) const
+{
+	tAssert(Index);
+	uint32 slot = ChunkIndex::Hash(chunkID, parent) & (IndexTableSize-1);
+	for (int entry = IndexTable[slot]; entry >= 0; entry = IndexTable[slot])
+	{
+		if ((Index[entry].Parent == parent) && ((Index[entry].IDRaw & 0x8FFFFFFF) == chunkID))
+			return entry;
+		slot = (slot + 1) & (IndexTableSize-1);
+	}
+
+	return -1;
+}
+
+
+int tChunkReader::GetIndexEntry(const tChunk& chunk) const
+{
+	tAssert(Index);
+	if ((chunk.Chunk < ReadBuffer) || (chunk.Chunk >= ReadBuffer + ContentSize))
+		return -1;
+
+	// Entries are sorted by offset so a binary search finds the chunk.
+	uint32 offset = uint32(chunk.Chunk - ReadBuffer);
+	int lo = 0;
+	int hi = NumIndexEntries-1;
+	while (lo <= hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (Index[mid].Offset == offset)
+			return mid;
+		else if (Index[mid].Offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+
+	return -1;
+}
+
+
+tChunk tChunkReader::GetIndexedChunk(int entry) const
+{
+	tAssert(Index && (entry >= 0) && (entry < NumIndexEntries));
+	uint8* chunk = ReadBuffer + Index[entry].Offset;
+	int parent = Index[entry].Parent;
+	if (parent < 0)
+		return tChunk(chunk, ReadBuffer + ContentSize, this);
+
+	// Siblings end where the parent container ends, just like with tChunk::GetFirstChunk.
+	tChunk container(ReadBuffer + Index[parent].Offset, ReadBuffer + ContentSize, this);
+	return tChunk(chunk, container.Chunk + container.GetDataSizeRaw() + 8, this);
+}
+
+
+tChunk tChunkReader::FindChunk(uint32 chunkID, const tChunk& container) const
+{
+	if (!IsValid())
+		return tChunk();
+
+	int parent = -1;
+	if (Index && container.IsValid())
+		parent = GetIndexEntry(container);
+
+	if (Index && (!container.IsValid() || (parent >= 0)))
+	{
+		int entry = FindIndexEntry(chunkID, parent);
+		return (entry >= 0) ? GetIndexedChunk(entry) : tChunk();
+	}
+
+	// No index, or the container isn't in it. Walk the chunks instead.
+	tChunk first = container.IsValid() ? container.GetFirstChunk() : GetFirstChunk();
+	for (tChunk chunk = first; chunk.IsValid(); chunk = chunk.GetNextChunk())
+		if (chunk.GetID() == chunkID)
+			return chunk;
+
+	return tChunk();
+}
+
+
+tChunk tChunkReader::FindNextChunk(const tChunk& chunk) const
+{
+	if (!chunk.IsValid())
+		return tChunk();
+
+	int entry = Index ? GetIndexEntry(chunk) : -1;
+	if (entry >= 0)
+	{
+		int next = IndexNext[entry];
+		return (next >= 0) ? GetIndexedChunk(next) : tChunk();
+	}
+
+	uint32 chunkID = chunk.GetID();
+	for (tChunk next = chunk.GetNextChunk(); next.IsValid(); next = next.GetNextChunk())
+		if (next.GetID() == chunkID)
+			return next;
+
+	return tChunk();
+}
+
+
+void tChunkReader::DecompressInBackground(int maxThreads)
+{
+	tAssert(IsValid());
+	if (BackgroundJob)
+		return;
+
+	BackgroundJob = new ChunkCompression::BackgroundJob(this, maxThreads);
+	tGetSharedJobSystem().Submit(BackgroundJob);
+}
+
+
+void tChunkReader::FindCompressedChunks() const
+{
+	std::lock_guard<std::mutex> lock(DecompressedMutex);
+	if (CompressedFound.load(std::memory_order_relaxed))
+		return;
+
+	ChunkCompression::GatherCompressed(CompressedChunks, GetFirstChunk());
+	int numCompressed = CompressedChunks.GetNumElements();
+	DecompressedSlots = new std::atomic<uint64>[tMax(numCompressed, 1)];
+	for (int c = 0; c < numCompressed; c++)
+		DecompressedSlots[c].store(0, std::memory_order_relaxed);
+
+	CompressedFound.store(true, std::memory_order_release);
+}
+
+
+uint8* tChunkReader::GetDecompressedData(const tChunk& chunk) const
+{
+	if (!chunk.IsCompressed())
+		return chunk.GetStoredData();
+
+	if (!CompressedFound.load(std::memory_order_acquire))
+		FindCompressedChunks();
+
+	// The chunks were gathered in the order they appear in the buffer.
+	const tChunk* compressed = CompressedChunks.GetElements();
+	int lo = 0, hi = CompressedChunks.GetNumElements() - 1;
+	std::atomic<uint64>* slot = nullptr;
+	while (lo <= hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (compressed[mid].Chunk == chunk.Chunk)
+		{
+			slot = &DecompressedSlots[mid];
+			break;
+		}
+		if (compressed[mid].Chunk < chunk.Chunk)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+
+	// Not a chunk from this reader's buffer.
+	if (!slot)
+		return nullptr;
+
+	uint64 state = slot->load(std::memory_order_acquire);
+	if (state > ChunkCompression::Failed)
+		return (uint8*)state;
+
+	// Whoever moves the slot from 0 to Busy does the work. Everyone else waits for them.
+	uint64 expected = 0;
+	if ((state == 0) && slot->compare_exchange_strong(expected, ChunkCompression::Busy, std::memory_order_acq_rel))
+	{
+		uint8* data = ChunkCompression::Decompress(chunk);
+		slot->store(data ? uint64(data) : ChunkCompression::Failed, std::memory_order_release);
+		return data;
+	}
+
+	while ((state = slot->load(std::memory_order_acquire)) == ChunkCompression::Busy)
+		std::this_thread::yield();
+
+	return (state == ChunkCompression::Failed) ? nullptr : (uint8*)state;
 }
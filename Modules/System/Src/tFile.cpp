@@ -30,11 +30,16 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <fstream>
 #endif
 #include <filesystem>
+#include <Math/tFundamentals.h>
 #include "System/tTime.h"
+#include "System/tJobSystem.h"
+#include "System/tPrint.h"
 #include "System/tFile.h"
 
 
@@ -42,6 +47,11 @@ namespace tSystem
 {
 	std::time_t tFileTimeToStdTime(std::filesystem::file_time_type tp);
 
+	// Large reads and writes are split into blocks of this size. Some C runtimes can't do a single call of 2GB or more.
+	// It is also the buffer size used when streaming through whole files.
+	const int64 FileBlockSize = 64*1024*1024;
+	const int StreamBufferSize = 256*1024;
+
 	#ifdef PLATFORM_WINDOWS
 	std::time_t tFileTimeToPosixEpoch(FILETIME);
 	#endif
@@ -59,33 +69,59 @@ void tSystem::tCloseFile(tFileHandle f)
 	if (!f)
 		return;
 
+	// With async output on there may still be queued prints destined for this file.
+	tFlushAsyncOutput();
 	fclose(f);
 }
 
 
-int tSystem::tReadFile(tFileHandle f, void* buffer, int sizeBytes)
+int64 tSystem::tReadFile(tFileHandle f, void* buffer, int64 sizeBytes)
 {
-	// Load the entire thing into memory.
-	int numRead = int(fread((char*)buffer, 1, sizeBytes, f));
+	int64 numRead = 0;
+	while (numRead < sizeBytes)
+	{
+		int64 blockSize = tMath::tMin(sizeBytes - numRead, FileBlockSize);
+		int64 blockRead = int64(fread((char*)buffer + numRead, 1, size_t(blockSize), f));
+		numRead += blockRead;
+		if (blockRead != blockSize)
+			break;
+	}
 	return numRead;
 }
 
 
-int tSystem::tWriteFile(tFileHandle f, const void* buffer, int sizeBytes)
+int64 tSystem::tWriteFile(tFileHandle f, const void* buffer, int64 sizeBytes)
 {
-	// Load the entire thing into memory.
-	int numRead = int(fwrite((char*)buffer, 1, sizeBytes, f));
-	return numRead;
+	int64 numWritten = 0;
+	while (numWritten < sizeBytes)
+	{
+		int64 blockSize = tMath::tMin(sizeBytes - numWritten, FileBlockSize);
+		int64 blockWritten = int64(fwrite((const char*)buffer + numWritten, 1, size_t(blockSize), f));
+		numWritten += blockWritten;
+		if (blockWritten != blockSize)
+			break;
+	}
+	return numWritten;
+}
+
+
+int64 tSystem::tFileTell(tFileHandle handle)
+{
+	#ifdef PLATFORM_WINDOWS
+	return int64(_ftelli64(handle));
+	#else
+	return int64(ftello(handle));
+	#endif
 }
 
 
-int tSystem::tFileTell(tFileHandle handle)
+bool tSystem::tFlushFile(tFileHandle handle)
 {
-	return int(ftell(handle));
+	return (fflush(handle) == 0) ? true : false;
 }
 
 
-int tSystem::tFileSeek(tFileHandle handle, int offsetBytes, tSeekOrigin seekOrigin)
+int tSystem::tFileSeek(tFileHandle handle, int64 offsetBytes, tSeekOrigin seekOrigin)
 {
 	int origin = SEEK_SET;
 	switch (seekOrigin)
@@ -103,24 +139,28 @@ int tSystem::tFileSeek(tFileHandle handle, int offsetBytes, tSeekOrigin seekOrig
 			break;
 	}
 	
-	return fseek(handle, long(offsetBytes), origin);
+	#ifdef PLATFORM_WINDOWS
+	return _fseeki64(handle, offsetBytes, origin);
+	#else
+	return fseeko(handle, off_t(offsetBytes), origin);
+	#endif
 }
 
 
-int tSystem::tGetFileSize(tFileHandle file)
+int64 tSystem::tGetFileSize(tFileHandle file)
 {
 	if (!file)
 		return 0;
 
 	tFileSeek(file, 0, tSeekOrigin::End);
-	int fileSize = tFileTell(file);
+	int64 fileSize = tFileTell(file);
 
 	tFileSeek(file, 0, tSeekOrigin::Beginning);			// Go back to beginning.
 	return fileSize;
 }
 
 
-int tSystem::tGetFileSize(const tString& filename)
+int64 tSystem::tGetFileSize(const tString& filename)
 {
 	#ifdef PLATFORM_WINDOWS
 	if (filename.IsEmpty())
@@ -142,11 +182,11 @@ int tSystem::tGetFileSize(const tString& filename)
 
 	FindClose(h);
 	SetErrorMode(prevErrorMode);
-	return fd.nFileSizeLow;
+	return (int64(fd.nFileSizeHigh) << 32) | int64(fd.nFileSizeLow);
 	#else
 
 	tFileHandle fd = tOpenFile(filename, "rb");
-	int size = tGetFileSize(fd);
+	int64 size = tGetFileSize(fd);
 	tCloseFile(fd);
 
 	return size;
@@ -985,68 +1025,131 @@ tString tSystem::tGetFileFullName(const tString& filename)
 }
 
 
-uint32 tSystem::tHashFileFast32(const tString& filename, uint32 iv)
+namespace tSystem
 {
-	int dataSize = 0;
-	uint8* data = tLoadFile(filename, nullptr, &dataSize);
-	if (!data)
-		return iv;
+	// Adapts the fast hash, which can be chained exactly, to the same interface as the tMath hashers.
+	struct HasherFast32
+	{
+		HasherFast32(uint32 iv)																							: Hash(iv) { }
+		void Update(const uint8* data, int length)																		{ Hash = tMath::tHashDataFast32(data, length, Hash); }
+		uint32 Finish()																									{ return Hash; }
+		uint32 Hash;
+	};
 
-	uint32 hash = tMath::tHashDataFast32(data, dataSize, iv);
-	delete[] data;
-	return hash;
+	template<typename T, typename Hasher> T HashFileStreamed(const tString& filename, Hasher, T iv);
+	template<typename T, typename HashFn> T HashFileTree(const tString& filename, HashFn, T iv);
 }
 
 
-uint32 tSystem::tHashFile32(const tString& filename, uint32 iv)
+template<typename T, typename Hasher> T tSystem::HashFileStreamed(const tString& filename, Hasher hasher, T iv)
 {
-	int dataSize = 0;
-	uint8* data = tLoadFile(filename, nullptr, &dataSize);
-	if (!data)
+	tFileHandle f = tOpenFile(filename, "rb");
+	if (!f)
 		return iv;
 
-	uint32 hash = tMath::tHashData32(data, dataSize, iv);
-	delete[] data;
-	return hash;
+	uint8* buffer = new uint8[StreamBufferSize];
+	int64 total = 0;
+	while (int numRead = int(tReadFile(f, buffer, StreamBufferSize)))
+	{
+		hasher.Update(buffer, numRead);
+		total += numRead;
+	}
+
+	delete[] buffer;
+	tCloseFile(f);
+	return total ? hasher.Finish() : iv;
 }
 
 
-uint64 tSystem::tHashFile64(const tString& filename, uint64 iv)
+template<typename T, typename HashFn> T tSystem::HashFileTree(const tString& filename, HashFn hashFn, T iv)
 {
-	int dataSize = 0;
-	uint8* data = tLoadFile(filename, nullptr, &dataSize);
-	if (!data)
+	int64 size = tGetFileSize(filename);
+	if (size <= 0)
 		return iv;
 
-	uint64 hash = tMath::tHashData64(data, dataSize, iv);
-	delete[] data;
+	int numBlocks = int((size + HashTreeBlockSize - 1) / HashTreeBlockSize);
+	T* blockHashes = new T[numBlocks];
+
+	// The block hashes use the default iv so they only depend on the block contents. Mapping the file lets the
+	// workers read their blocks directly without needing a buffer each.
+	int64 mappedSize = 0;
+	uint8* mapped = tMapFile(filename, mappedSize);
+	if (mapped && (mappedSize == size))
+	{
+		auto hashBlock = [mapped, size, blockHashes, &hashFn](int b)
+		{
+			int64 start = int64(b)*HashTreeBlockSize;
+			int length = int(tMath::tMin(size - start, int64(HashTreeBlockSize)));
+			blockHashes[b] = hashFn(mapped + start, length, T(0));
+		};
+		tGetSharedJobSystem().ParallelFor(numBlocks, hashBlock);
+		tUnmapFile(mapped, mappedSize);
+	}
+	else
+	{
+		// If the file can't be mapped the blocks are read and hashed one at a time. The result is the same.
+		if (mapped)
+			tUnmapFile(mapped, mappedSize);
+
+		tFileHandle f = tOpenFile(filename, "rb");
+		uint8* buffer = f ? new uint8[HashTreeBlockSize] : nullptr;
+		for (int b = 0; buffer && (b < numBlocks); b++)
+		{
+			int numRead = int(tReadFile(f, buffer, HashTreeBlockSize));
+			blockHashes[b] = hashFn(buffer, numRead, T(0));
+		}
+		tCloseFile(f);
+		if (!buffer)
+		{
+			delete[] blockHashes;
+			return iv;
+		}
+		delete[] buffer;
+	}
+
+	T hash = hashFn((const uint8*)blockHashes, numBlocks*int(sizeof(T)), iv);
+	delete[] blockHashes;
 	return hash;
 }
 
 
-tuint128 tSystem::tHashFileMD5(const tString& filename, tuint128 iv)
+uint32 tSystem::tHashFileFast32(const tString& filename, uint32 iv, tHashFileMode mode)
 {
-	int dataSize = 0;
-	uint8* data = tLoadFile(filename, nullptr, &dataSize);
-	if (!data)
-		return iv;
+	if (mode == tHashFileMode::Tree)
+		return HashFileTree(filename, [](const uint8* d, int n, uint32 v) { return tMath::tHashDataFast32(d, n, v); }, iv);
+	return HashFileStreamed(filename, HasherFast32(iv), iv);
+}
 
-	tuint128 hash = tMath::tHashData128(data, dataSize, iv);
-	delete[] data;
-	return hash;
+
+uint32 tSystem::tHashFile32(const tString& filename, uint32 iv, tHashFileMode mode)
+{
+	if (mode == tHashFileMode::Tree)
+		return HashFileTree(filename, [](const uint8* d, int n, uint32 v) { return tMath::tHashData32(d, n, v); }, iv);
+	return HashFileStreamed(filename, tMath::tHasher32(iv), iv);
 }
 
 
-tuint256 tSystem::tHashFile256(const tString& filename, tuint256 iv)
+uint64 tSystem::tHashFile64(const tString& filename, uint64 iv, tHashFileMode mode)
 {
-	int dataSize = 0;
-	uint8* data = tLoadFile(filename, nullptr, &dataSize);
-	if (!data)
-		return iv;
+	if (mode == tHashFileMode::Tree)
+		return HashFileTree(filename, [](const uint8* d, int n, uint64 v) { return tMath::tHashData64(d, n, v); }, iv);
+	return HashFileStreamed(filename, tMath::tHasher64(iv), iv);
+}
 
-	tuint256 hash = tMath::tHashData256(data, dataSize, iv);
-	delete[] data;
-	return hash;
+
+tuint128 tSystem::tHashFileMD5(const tString& filename, tuint128 iv, tHashFileMode mode)
+{
+	if (mode == tHashFileMode::Tree)
+		return HashFileTree(filename, [](const uint8* d, int n, tuint128 v) { return tMath::tHashDataMD5(d, n, v); }, iv);
+	return HashFileStreamed(filename, tMath::tHasherMD5(), iv);
+}
+
+
+tuint256 tSystem::tHashFile256(const tString& filename, tuint256 iv, tHashFileMode mode)
+{
+	if (mode == tHashFileMode::Tree)
+		return HashFileTree(filename, [](const uint8* d, int n, tuint256 v) { return tMath::tHashData256(d, n, v); }, iv);
+	return HashFileStreamed(filename, tMath::tHasher256(iv), iv);
 }
 
 
@@ -1535,36 +1638,30 @@ bool tSystem::tFilesIdentical(const tString& fileA, const tString& fileB)
 		return false;
 	}
 
-	int faSize = tGetFileSize(fa);
-	int fbSize = tGetFileSize(fb);
+	int64 faSize = tGetFileSize(fa);
+	int64 fbSize = tGetFileSize(fb);
 	if (faSize != fbSize)
 	{
 		localCloseFiles(fa, fb);
 		return false;
 	}
 
-	uint8* bufA = new uint8[faSize];
-	uint8* bufB = new uint8[fbSize];
-
-	int numReadA = tReadFile(fa, bufA, faSize);
-	int numReadB = tReadFile(fb, bufB, fbSize);
-	tAssert((faSize + fbSize) == (numReadA + numReadB));
-
-	for (int i = 0; i < faSize; i++)
+	uint8* bufA = new uint8[StreamBufferSize];
+	uint8* bufB = new uint8[StreamBufferSize];
+	bool identical = true;
+	for (int64 remaining = faSize; identical && (remaining > 0); )
 	{
-		if (bufA[i] != bufB[i])
-		{
-			localCloseFiles(fa, fb);
-			delete[] bufA;
-			delete[] bufB;
-			return false;
-		}
+		int blockSize = int(tMath::tMin(remaining, int64(StreamBufferSize)));
+		int64 numReadA = tReadFile(fa, bufA, blockSize);
+		int64 numReadB = tReadFile(fb, bufB, blockSize);
+		identical = (numReadA == blockSize) && (numReadB == blockSize) && (tStd::tMemcmp(bufA, bufB, blockSize) == 0);
+		remaining -= blockSize;
 	}
 
 	localCloseFiles(fa, fb);
 	delete[] bufA;
 	delete[] bufB;
-	return true;
+	return identical;
 }
 
 
@@ -1586,7 +1683,7 @@ bool tSystem::tCreateFile(const tString& filename, const tString& contents)
 }
 
 
-bool tSystem::tCreateFile(const tString& filename, uint8* data, int dataLength)
+bool tSystem::tCreateFile(const tString& filename, uint8* data, int64 dataLength)
 {
 	tFileHandle dst = tOpenFile(filename.ConstText(), "wb");
 	if (!dst)
@@ -1596,7 +1693,7 @@ bool tSystem::tCreateFile(const tString& filename, uint8* data, int dataLength)
 	tFileSeek(dst, 0, tSeekOrigin::Beginning);
 
 	// Write data and close file.
-	int numWritten = tWriteFile(dst, data, dataLength);
+	int64 numWritten = tWriteFile(dst, data, dataLength);
 	tCloseFile(dst);
 
 	// Make sure it was created and an appropriate amount of bytes were written.
@@ -1640,13 +1737,20 @@ bool tSystem::tLoadFile(const tString& filename, tString& dst, char convertZeroe
 		return false;
 	}
 
-	int filesize = tGetFileSize(filename);
+	int64 filesize = tGetFileSize(filename);
 	if (filesize == 0)
 	{
 		dst.Clear();
 		return true;
 	}
 
+	// A tString can't be that big.
+	if (filesize > 0x7FFFFFFE)
+	{
+		dst.Clear();
+		return false;
+	}
+
 	dst.Reserve(filesize);
 	uint8* check = tLoadFile(filename, (uint8*)dst.Text());
 	if ((check != (uint8*)dst.Text()) || !check)
@@ -1664,11 +1768,29 @@ bool tSystem::tLoadFile(const tString& filename, tString& dst, char convertZeroe
 
 
 uint8* tSystem::tLoadFile(const tString& filename, uint8* buffer, int* fileSize, bool appendEOF)
+{
+	int64 size = tGetFileSize(filename);
+	if (size >= 0x7FFFFFFF)
+	{
+		if (fileSize)
+			*fileSize = 0;
+		return nullptr;
+	}
+
+	int64 size64 = 0;
+	uint8* data = tLoadFile(filename, buffer, &size64, appendEOF);
+	if (fileSize)
+		*fileSize = int(size64);
+	return data;
+}
+
+
+uint8* tSystem::tLoadFile(const tString& filename, uint8* buffer, int64* fileSize, bool appendEOF)
 {
 	tFileHandle f = tOpenFile(filename.ConstText(), "rb");
 	tAssert(f);
 
-	int size = tGetFileSize(f);
+	int64 size = tGetFileSize(f);
 	if (fileSize)
 		*fileSize = size;
 
@@ -1684,12 +1806,12 @@ uint8* tSystem::tLoadFile(const tString& filename, uint8* buffer, int* fileSize,
 	bool bufferAllocatedHere = false;
 	if (!buffer)
 	{
-		int bufSize = appendEOF ? size+1 : size;
+		int64 bufSize = appendEOF ? size+1 : size;
 		buffer = new uint8[bufSize];
 		bufferAllocatedHere = true;
 	}
 
-	int numRead = tReadFile(f, buffer, size);			// Load the entire thing into memory.
+	int64 numRead = tReadFile(f, buffer, size);			// Load the entire thing into memory.
 	tAssert(numRead == size);
 
 	if (appendEOF)
@@ -1709,7 +1831,7 @@ uint8* tSystem::tLoadFileHead(const tString& fileName, int& bytesToRead, uint8*
 		return buffer;
 	}
 
-	int size = tGetFileSize(f);
+	int64 size = tGetFileSize(f);
 	if (!size)
 	{
 		tCloseFile(f);
@@ -1717,7 +1839,7 @@ uint8* tSystem::tLoadFileHead(const tString& fileName, int& bytesToRead, uint8*
 		return buffer;
 	}
 
-	bytesToRead = (size < bytesToRead) ? size : bytesToRead;
+	bytesToRead = (size < bytesToRead) ? int(size) : bytesToRead;
 
 	bool bufferAllocatedHere = false;
 	if (!buffer)
@@ -1728,7 +1850,7 @@ uint8* tSystem::tLoadFileHead(const tString& fileName, int& bytesToRead, uint8*
 
 	// Load the first bytesToRead into memory.  We assume complete failure if the
 	// number we asked for was not returned.
-	int numRead = tReadFile(f, buffer, bytesToRead);
+	int64 numRead = tReadFile(f, buffer, bytesToRead);
 	if (numRead != bytesToRead)
 	{
 		if (bufferAllocatedHere)
@@ -1747,6 +1869,90 @@ uint8* tSystem::tLoadFileHead(const tString& fileName, int& bytesToRead, uint8*
 }
 
 
+uint8* tSystem::tMapFile(const tString& filename, int& fileSize)
+{
+	int64 size = 0;
+	uint8* mapped = tMapFile(filename, size);
+	fileSize = int(size);
+	if (mapped && (size > 0x7FFFFFFF))
+	{
+		tUnmapFile(mapped, size);
+		fileSize = 0;
+		return nullptr;
+	}
+
+	return mapped;
+}
+
+
+uint8* tSystem::tMapFile(const tString& filename, int64& fileSize)
+{
+	fileSize = 0;
+
+	#if defined(PLATFORM_WINDOWS)
+	HANDLE file = ::CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(file, &size) || (size.QuadPart <= 0))
+	{
+		::CloseHandle(file);
+		return nullptr;
+	}
+
+	// The view keeps the mapping object alive, so both handles may be closed straight away.
+	HANDLE mapping = ::CreateFileMapping(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	::CloseHandle(file);
+	if (!mapping)
+		return nullptr;
+
+	uint8* mapped = (uint8*)::MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	::CloseHandle(mapping);
+	if (!mapped)
+		return nullptr;
+
+	fileSize = int64(size.QuadPart);
+	return mapped;
+
+	#else
+	int fd = ::open(filename.Chars(), O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+
+	struct stat info;
+	if ((::fstat(fd, &info) != 0) || (info.st_size <= 0))
+	{
+		::close(fd);
+		return nullptr;
+	}
+
+	// A private mapping gives copy-on-write pages. The mapping holds its own reference to the file.
+	void* mapped = ::mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+		return nullptr;
+
+	fileSize = int64(info.st_size);
+	return (uint8*)mapped;
+
+	#endif
+}
+
+
+void tSystem::tUnmapFile(uint8* mapped, int64 fileSize)
+{
+	if (!mapped)
+		return;
+
+	#if defined(PLATFORM_WINDOWS)
+	::UnmapViewOfFile(mapped);
+	#else
+	::munmap(mapped, size_t(fileSize));
+	#endif
+}
+
+
 bool tSystem::tCopyFile(const tString& dest, const tString& src, bool overWriteReadOnly)
 {
 	#if defined(PLATFORM_WINDOWS)
@@ -0,0 +1,285 @@
+// tJobSystem.cpp
+//
+// A work-stealing job system. A fixed set of worker threads each own a lock-free deque of jobs. Workers pop jobs from
+// the bottom of their own deque and, when it runs dry, steal from the top of the other workers' deques. Jobs may have
+// a parent, and a parent is not complete until all of its children are. Any thread waiting on a job helps out by
+// executing other jobs until the one it is waiting on is done.
+//
+// Copyright (c) 2020 Tristan Grimmer.
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+// AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "System/tJobSystem.h"
+#include "System/tMachine.h"
+
+
+namespace tSystem
+{
+	// Each worker thread knows which system it belongs to and which deque is its own. Non-worker threads have a null
+	// system pointer.
+	thread_local tJobSystem* WorkerSystem = nullptr;
+	thread_local int WorkerIndex = -1;
+}
+
+
+bool tSystem::tJobSystem::WorkDeque::Push(tJob* job)
+{
+	int64 bottom = Bottom.load(std::memory_order_relaxed);
+	int64 top = Top.load(std::memory_order_acquire);
+	if (bottom - top >= DequeCapacity)
+		return false;
+
+	Jobs[bottom & (DequeCapacity-1)].store(job, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	Bottom.store(bottom+1, std::memory_order_relaxed);
+	return true;
+}
+
+
+tSystem::tJob* tSystem::tJobSystem::WorkDeque::Pop()
+{
+	int64 bottom = Bottom.load(std::memory_order_relaxed) - 1;
+	Bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64 top = Top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// Empty. Restore the bottom.
+		Bottom.store(bottom+1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	tJob* job = Jobs[bottom & (DequeCapacity-1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// This is the last job. We race any thieves for it by trying to advance the top.
+		if (!Top.compare_exchange_strong(top, top+1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+		Bottom.store(bottom+1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+
+tSystem::tJob* tSystem::tJobSystem::WorkDeque::Steal()
+{
+	int64 top = Top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64 bottom = Bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+		return nullptr;
+
+	tJob* job = Jobs[top & (DequeCapacity-1)].load(std::memory_order_relaxed);
+	if (!Top.compare_exchange_strong(top, top+1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+
+	return job;
+}
+
+
+tSystem::tJobSystem::tJobSystem(int numWorkers) :
+	NumWorkers(numWorkers),
+	Deques(nullptr),
+	Workers(nullptr),
+	SharedMutex(),
+	SharedHead(nullptr),
+	SharedTail(nullptr),
+	NumShared(0),
+	NumQueued(0),
+	NumSleeping(0),
+	Quit(false),
+	SleepMutex(),
+	SleepCondition()
+{
+	if (NumWorkers <= 0)
+		NumWorkers = tGetNumCores() - 1;
+	if (NumWorkers < 1)
+		NumWorkers = 1;
+
+	Deques = new WorkDeque[NumWorkers];
+	Workers = new std::thread[NumWorkers];
+	for (int w = 0; w < NumWorkers; w++)
+		Workers[w] = std::thread(WorkerMain, this, w);
+}
+
+
+tSystem::tJobSystem::~tJobSystem()
+{
+	// Drain anything still queued. The destructor may be called from a non-worker thread, so it just helps out.
+	while (NumQueued.load() > 0)
+	{
+		if (tJob* job = FindJob(-1))
+			ExecuteJob(job);
+		else
+			std::this_thread::yield();
+	}
+
+	SleepMutex.lock();
+	Quit.store(true);
+	SleepMutex.unlock();
+	SleepCondition.notify_all();
+
+	for (int w = 0; w < NumWorkers; w++)
+		Workers[w].join();
+
+	delete[] Workers;
+	delete[] Deques;
+}
+
+
+bool tSystem::tJobSystem::IsWorkerThread() const
+{
+	return WorkerSystem == this;
+}
+
+
+void tSystem::tJobSystem::Submit(tJob* job)
+{
+	tAssert(job && !job->IsComplete());
+	NumQueued.fetch_add(1);
+
+	bool pushed = false;
+	if (WorkerSystem == this)
+		pushed = Deques[WorkerIndex].Push(job);
+
+	if (!pushed)
+		SubmitShared(job);
+
+	// The seq_cst increment of NumQueued above pairs with the NumSleeping increment in WorkerMain. Either the worker
+	// sees the job or we see the sleeper. Taking the mutex guarantees the sleeper is actually waiting before we notify.
+	if (NumSleeping.load() > 0)
+	{
+		SleepMutex.lock();
+		SleepMutex.unlock();
+		SleepCondition.notify_one();
+	}
+}
+
+
+void tSystem::tJobSystem::Wait(const tJob* job)
+{
+	tAssert(job);
+	int workerIndex = (WorkerSystem == this) ? WorkerIndex : -1;
+	while (!job->IsComplete())
+	{
+		if (tJob* other = FindJob(workerIndex))
+			ExecuteJob(other);
+		else
+			std::this_thread::yield();
+	}
+}
+
+
+void tSystem::tJobSystem::SubmitShared(tJob* job)
+{
+	std::lock_guard<std::mutex> lock(SharedMutex);
+	job->NextQueued = nullptr;
+	if (SharedTail)
+		SharedTail->NextQueued = job;
+	else
+		SharedHead = job;
+	SharedTail = job;
+	NumShared.fetch_add(1);
+}
+
+
+tSystem::tJob* tSystem::tJobSystem::TakeShared()
+{
+	std::lock_guard<std::mutex> lock(SharedMutex);
+	tJob* job = SharedHead;
+	if (job)
+	{
+		SharedHead = job->NextQueued;
+		if (!SharedHead)
+			SharedTail = nullptr;
+		job->NextQueued = nullptr;
+		NumShared.fetch_sub(1);
+	}
+	return job;
+}
+
+
+tSystem::tJob* tSystem::tJobSystem::FindJob(int workerIndex)
+{
+	if (NumQueued.load(std::memory_order_relaxed) <= 0)
+		return nullptr;
+
+	tJob* job = nullptr;
+	if (workerIndex >= 0)
+		job = Deques[workerIndex].Pop();
+
+	// Steal, starting from the next worker along so thieves don't all hammer worker 0.
+	for (int v = 1; !job && (v <= NumWorkers); v++)
+	{
+		int victim = (workerIndex + v + NumWorkers) % NumWorkers;
+		if (victim != workerIndex)
+			job = Deques[victim].Steal();
+	}
+
+	// Peek before locking. A stale count only costs us one extra trip around the loop.
+	if (!job && (NumShared.load(std::memory_order_relaxed) > 0))
+		job = TakeShared();
+
+	if (job)
+		NumQueued.fetch_sub(1);
+
+	return job;
+}
+
+
+void tSystem::tJobSystem::ExecuteJob(tJob* job)
+{
+	job->Execute();
+	FinishJob(job);
+}
+
+
+void tSystem::tJobSystem::FinishJob(tJob* job)
+{
+	// The parent pointer must be read before the decrement. Once the count reaches zero the owner may delete the job.
+	while (job)
+	{
+		tJob* parent = job->Parent;
+		if (job->Unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			break;
+		job = parent;
+	}
+}
+
+
+void tSystem::tJobSystem::WorkerMain(tJobSystem* system, int workerIndex)
+{
+	WorkerSystem = system;
+	WorkerIndex = workerIndex;
+
+	while (!system->Quit.load())
+	{
+		if (tJob* job = system->FindJob(workerIndex))
+		{
+			system->ExecuteJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(system->SleepMutex);
+		system->NumSleeping.fetch_add(1);
+		system->SleepCondition.wait(lock, [system] { return (system->NumQueued.load() > 0) || system->Quit.load(); });
+		system->NumSleeping.fetch_sub(1);
+	}
+
+	WorkerSystem = nullptr;
+	WorkerIndex = -1;
+}
+
+
+tSystem::tJobSystem& tSystem::tGetSharedJobSystem()
+{
+	static tJobSystem sharedJobSystem;
+	return sharedJobSystem;
+}
@@ -70,6 +70,31 @@ bool tSystem::tSupportsSSE2()
 }
 
 
+bool tSystem::tSupportsAVX2()
+{
+	#ifdef PLATFORM_WINDOWS
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+
+	// OSXSAVE is bit 27 and AVX is bit 28 of ecx. Both are needed before xgetbv may be trusted.
+	int features = cpuInfo[2];
+	if (!(features & (1 << 27)) || !(features & (1 << 28)))
+		return false;
+
+	// The OS must save both the XMM and YMM state.
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	// AVX2 feature bit is 5 of ebx for leaf 7.
+	__cpuidex(cpuInfo, 7, 0);
+	return (cpuInfo[1] & (1 << 5)) ? true : false;
+
+	#elif defined(PLATFORM_LINUX)
+	return __builtin_cpu_supports("avx2") ? true : false;
+	#endif
+}
+
+
 tString tSystem::tGetCompName()
 {
 	#ifdef PLATFORM_WINDOWS
@@ -18,6 +18,10 @@
 #ifdef PLATFORM_WINDOWS
 #include <windows.h>
 #endif
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <Foundation/tStandard.h>
 #include <Foundation/tArray.h>
 #include <Math/tLinearAlgebra.h>
@@ -34,6 +38,31 @@ namespace tSystem
 	// Global settings for all print functionality.
 	static int DefaultPrecision = 4;
 
+	// Handlers convert a value into one of these before it is justified and received. There is room on the stack for
+	// anything but a number printed with an enormous width or precision, so converting doesn't normally touch the heap.
+	class ConvBuffer
+	{
+	public:
+		ConvBuffer()																									: Heap(nullptr), NumElements(0), Capacity(LocalSize) { }
+		~ConvBuffer()																									{ delete[] Heap; }
+
+		void Append(char c)																								{ if (NumElements >= Capacity) Grow(1); GetElements()[NumElements++] = c; }
+		void Append(const char* chars, int numChars);
+		int GetNumElements() const																						{ return NumElements; }
+		char* GetElements()																								{ return Heap ? Heap : Local; }
+		const char* GetElements() const																					{ return Heap ? Heap : Local; }
+		char& operator[](int index)																						{ tAssert((index >= 0) && (index < NumElements)); return GetElements()[index]; }
+
+	private:
+		void Grow(int numNeeded);
+
+		const static int LocalSize = 256;
+		char Local[LocalSize];
+		char* Heap;
+		int NumElements;
+		int Capacity;
+	};
+
 	// This class receives the final properly formatted characters. As it receives them it counts how many were
 	// received. If you construct with either an external character buffer or external string, it populates them.
 	class Receiver
@@ -57,7 +86,7 @@ namespace tSystem
 		void Receive(char chr);
 		void Receive(const char* str);						// Assumes null termination.
 		void Receive(const char* str, int numChars);		// No null termination necessary.
-		void Receive(const tArray<char>&);
+		void Receive(const ConvBuffer&);
 		int GetNumReceived() const																						{ return NumReceived; }
 
 	private:
@@ -75,6 +104,95 @@ namespace tSystem
 	// This is the workhorse. It processes the format string and deposits the resulting formatted text in the receiver.
 	void Process(Receiver&, const char* format, va_list);
 
+	// Same as Process but for a format the compiler has already parsed. The arguments have already been gathered too.
+	void ProcessPreparsed(Receiver&, const char* text, const tFormatSegment*, int numSegments, const tFormatArg*);
+
+	// Formatting is done into a per-thread buffer that is reused from call to call so printing doesn't allocate. If a
+	// print is nested inside another on the same thread, say by a redirect callback that prints, the nested one gets
+	// its own buffer so it doesn't trample the text the outer one is still outputting.
+	class PrintBuffer
+	{
+	public:
+		PrintBuffer()																									: Buffer(InUse ? Local : Shared), OwnsShared(!InUse) { InUse = true; Buffer.Reset(); }
+		~PrintBuffer()																									{ if (OwnsShared) InUse = false; }
+
+	private:
+		tArray<char> Local;
+		static thread_local tArray<char> Shared;
+		static thread_local bool InUse;
+
+	public:
+		tArray<char>& Buffer;
+
+	private:
+		bool OwnsShared;
+	};
+
+	// Writes the text straight to the file handle, or stdout if the handle is null. This is what tPrint does when
+	// async output is off and what the writer thread does when it is on.
+	int PrintImmediate(const char* text, tFileHandle);
+
+	// The async output sink. Printing threads claim slots in a bounded ring using the per-slot sequence number scheme
+	// from Dmitry Vyukov's bounded MPMC queue, so pushing is lock-free. There is only one consumer, the writer thread,
+	// which gathers runs of messages for the same destination into a batch and writes each batch with one call. The
+	// writer sleeps on a condition variable when the ring is empty. The timeout bounds latency should a wake be missed.
+	class AsyncSink
+	{
+	public:
+		AsyncSink()																										{ }
+		~AsyncSink()																									{ Stop(); }
+
+		void Start(int numSlots);
+		void Stop();
+		bool IsRunning() const																							{ return Running.load(std::memory_order_acquire); }
+		bool IsWriterThread() const																						{ return std::this_thread::get_id() == Writer.get_id(); }
+
+		// Copies the text, so it may be modified or freed on return. Waits if the ring is full.
+		void Push(const char* text, int numChars, tFileHandle);
+		void Flush();
+
+	private:
+		void WriterLoop();
+		void WakeWriter();
+		void WriteBatch();
+
+		// Messages that fit are stored in the slot. Longer ones are heap allocated and freed by the writer.
+		const static int SlotTextSize = 232;
+		struct Slot
+		{
+			std::atomic<uint64> Sequence;
+			tFileHandle Dest;
+			int NumChars;
+			char* LongText;
+			char Text[SlotTextSize];
+		};
+
+		// Once a batch holds this much it is written even if more messages are waiting.
+		const static int MaxBatchSize = 64*1024;
+
+		Slot* Slots = nullptr;
+		uint64 Mask = 0;
+		alignas(64) std::atomic<uint64> EnqueuePos;
+		alignas(64) std::atomic<uint64> WrittenPos;
+		uint64 DequeuePos = 0;
+		std::atomic<bool> Running { false };
+		std::atomic<bool> StopRequested { false };
+		std::atomic<bool> WriterSleeping { false };
+		std::mutex SleepMutex;
+		std::condition_variable SleepCondition;
+		std::thread Writer;
+
+		// Threads waiting in Flush sleep on this. The writer only takes the lock to notify if someone is waiting.
+		std::atomic<int> NumFlushWaiters { 0 };
+		std::mutex FlushMutex;
+		std::condition_variable FlushCondition;
+
+		// Only touched by the writer thread.
+		tArray<char> Batch;
+		tFileHandle BatchDest = nullptr;
+	};
+	AsyncSink AsyncOutput;
+
 	// Channel system. This is lazy initialized (using the name hash as the state) without any need for shutdown.
 	uint32 ComputerNameHash																								= 0;
 	tChannel OutputChannels																								= tChannel_Systems;
@@ -83,29 +201,18 @@ namespace tSystem
 
 	// A format specification consists of the information stored in the expression:
 	// %[flags] [width] [.precision] [:typesize][|typesize]type
-	// except for the type character.
+	// The parsing is shared with the compile-time tFormat so the spec and flags are declared in the header.
 	enum Flag
 	{
-		Flag_ForcePosOrNegSign					= 1 << 0,
-		Flag_SpaceForPosSign					= 1 << 1,
-		Flag_LeadingZeros						= 1 << 2,
-		Flag_LeftJustify						= 1 << 3,
-		Flag_DecorativeFormatting				= 1 << 4,
-		Flag_DecorativeFormattingAlt			= 1 << 5,
-		Flag_BasePrefix							= 1 << 6
-	};
-
-	struct FormatSpec
-	{
-		FormatSpec()																									: Flags(0), Width(0), Precision(-1), TypeSizeBytes(0) { }
-		FormatSpec(const FormatSpec& src)																				: Flags(src.Flags), Width(src.Width), Precision(src.Precision), TypeSizeBytes(src.TypeSizeBytes) { }
-		FormatSpec& operator=(const FormatSpec& src)																	{ Flags = src.Flags; Width = src.Width; Precision = src.Precision; TypeSizeBytes = src.TypeSizeBytes; return *this; }
-
-		uint32 Flags;
-		int Width;
-		int Precision;
-		int TypeSizeBytes;				// Defaults to 0, not set.
+		Flag_ForcePosOrNegSign					= tFormatFlag_ForcePosOrNegSign,
+		Flag_SpaceForPosSign					= tFormatFlag_SpaceForPosSign,
+		Flag_LeadingZeros						= tFormatFlag_LeadingZeros,
+		Flag_LeftJustify						= tFormatFlag_LeftJustify,
+		Flag_DecorativeFormatting				= tFormatFlag_DecorativeFormatting,
+		Flag_DecorativeFormattingAlt			= tFormatFlag_DecorativeFormattingAlt,
+		Flag_BasePrefix							= tFormatFlag_BasePrefix
 	};
+	typedef tFormatSpec FormatSpec;
 
 	// Type handler stuff below.
 	typedef void (*HandlerFn)(Receiver& out, const FormatSpec&, void* data);
@@ -132,20 +239,19 @@ namespace tSystem
 	extern HandlerInfo HandlerInfos[];
 	extern int HandlerJumpTable[256];
 	HandlerInfo* FindHandler(char format);
-	bool IsValidFormatSpecifierCharacter(char);
 
 	// Does the heavy-lifting of converting (built-in) integer types to strings. This function can handle both 32 and
 	// 64 bit integers (signed and unsigned). To print Tacent integral types or bit-fields of 128, 256, or 512 bits
 	// please see the function HandlerHelper_IntegerTacent.
 	void HandlerHelper_IntegerNative
 	(
-		tArray<char>&, const FormatSpec&, void* data, bool treatAsUnsigned,
+		ConvBuffer&, const FormatSpec&, void* data, bool treatAsUnsigned,
 		int bitSize, bool upperCase, int base, bool forcePrefixLowerCase = false
 	);
 
 	void HandlerHelper_IntegerTacent
 	(
-		tArray<char>&, const FormatSpec&, void* data, bool treatAsUnsigned,
+		ConvBuffer&, const FormatSpec&, void* data, bool treatAsUnsigned,
 		int bitSize, bool upperCase, int base, bool forcePrefixLowerCase = false
 	);
 
@@ -159,9 +265,9 @@ namespace tSystem
 	};
 	PrologHelperFloat HandlerHelper_FloatNormal
 	(
-		tArray<char>&, const FormatSpec&, double value, bool treatPrecisionAsSigDigits = false
+		ConvBuffer&, const FormatSpec&, double value, bool treatPrecisionAsSigDigits = false
 	);
-	bool HandlerHelper_HandleSpecialFloatTypes(tArray<char>&, double value);
+	bool HandlerHelper_HandleSpecialFloatTypes(ConvBuffer&, double value);
 	int  HandlerHelper_FloatComputeExponent(double value);
 	void HandlerHelper_Vector(Receiver&, const FormatSpec&, const float* components, int numComponents);
 	void HandlerHelper_JustificationProlog(Receiver&, int itemLength, const FormatSpec&);
@@ -236,6 +342,23 @@ int tSystem::tPrint(const char* text, tSystem::tChannel channels)
 
 
 int tSystem::tPrint(const char* text, tFileHandle fileHandle)
+{
+	if (!text || (*text == '\0'))
+		return 0;
+
+	// Anything printed by the writer thread itself, from a redirect callback for example, can't wait on the queue.
+	if (AsyncOutput.IsRunning() && !AsyncOutput.IsWriterThread())
+	{
+		int numChars = tStd::tStrlen(text);
+		AsyncOutput.Push(text, numChars, fileHandle);
+		return numChars;
+	}
+
+	return PrintImmediate(text, fileHandle);
+}
+
+
+int tSystem::PrintImmediate(const char* text, tFileHandle fileHandle)
 {
 	int numPrinted = 0;
 	if (!text || (*text == '\0'))
@@ -297,6 +420,206 @@ int tSystem::tPrint(const char* text, tFileHandle fileHandle)
 }
 
 
+void tSystem::tSetAsyncOutput(bool enable, int queueSize)
+{
+	if (enable == AsyncOutput.IsRunning())
+		return;
+
+	if (enable)
+		AsyncOutput.Start(queueSize);
+	else
+		AsyncOutput.Stop();
+}
+
+
+bool tSystem::tGetAsyncOutput()
+{
+	return AsyncOutput.IsRunning();
+}
+
+
+void tSystem::tFlushAsyncOutput()
+{
+	if (AsyncOutput.IsRunning() && !AsyncOutput.IsWriterThread())
+		AsyncOutput.Flush();
+}
+
+
+thread_local tArray<char> tSystem::PrintBuffer::Shared(256, 256);
+thread_local bool tSystem::PrintBuffer::InUse = false;
+
+
+void tSystem::AsyncSink::Start(int numSlots)
+{
+	tAssert(!IsRunning());
+	int numRequested = tMath::tMax(numSlots, 2);
+	int size = tMath::tIsPower2(numRequested) ? numRequested : int(tMath::tNextHigherPower2(uint(numRequested)));
+	Slots = new Slot[size];
+	Mask = uint64(size - 1);
+	for (int s = 0; s < size; s++)
+	{
+		Slots[s].Sequence.store(uint64(s), std::memory_order_relaxed);
+		Slots[s].LongText = nullptr;
+	}
+
+	EnqueuePos.store(0, std::memory_order_relaxed);
+	WrittenPos.store(0, std::memory_order_relaxed);
+	DequeuePos = 0;
+	StopRequested.store(false, std::memory_order_relaxed);
+	Running.store(true, std::memory_order_release);
+	Writer = std::thread(&AsyncSink::WriterLoop, this);
+}
+
+
+void tSystem::AsyncSink::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	// The writer only exits once the ring is empty, so everything already pushed gets written.
+	StopRequested.store(true, std::memory_order_seq_cst);
+	WakeWriter();
+	Writer.join();
+	Running.store(false, std::memory_order_release);
+
+	delete[] Slots;
+	Slots = nullptr;
+	Mask = 0;
+	Batch.Clear();
+}
+
+
+void tSystem::AsyncSink::Push(const char* text, int numChars, tFileHandle dest)
+{
+	uint64 pos = EnqueuePos.load(std::memory_order_relaxed);
+	Slot* slot = nullptr;
+	while (1)
+	{
+		slot = &Slots[pos & Mask];
+		uint64 seq = slot->Sequence.load(std::memory_order_acquire);
+		int64 diff = int64(seq) - int64(pos);
+		if (diff == 0)
+		{
+			if (EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+		{
+			// Full. Make sure the writer is awake and give it a chance to make room.
+			WakeWriter();
+			std::this_thread::yield();
+			pos = EnqueuePos.load(std::memory_order_relaxed);
+		}
+		else
+		{
+			pos = EnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->Dest = dest;
+	slot->NumChars = numChars;
+	if (numChars <= SlotTextSize)
+	{
+		tStd::tMemcpy(slot->Text, text, numChars);
+	}
+	else
+	{
+		slot->LongText = new char[numChars];
+		tStd::tMemcpy(slot->LongText, text, numChars);
+	}
+
+	slot->Sequence.store(pos + 1, std::memory_order_seq_cst);
+	if (WriterSleeping.load(std::memory_order_seq_cst))
+		WakeWriter();
+}
+
+
+void tSystem::AsyncSink::Flush()
+{
+	uint64 target = EnqueuePos.load(std::memory_order_acquire);
+	WakeWriter();
+
+	// The waiter count and WrittenPos are both seq_cst. Either the writer sees the waiter and notifies under the lock,
+	// or the predicate sees the new position.
+	std::unique_lock<std::mutex> lock(FlushMutex);
+	NumFlushWaiters.fetch_add(1, std::memory_order_seq_cst);
+	FlushCondition.wait(lock, [this, target]() { return WrittenPos.load(std::memory_order_seq_cst) >= target; });
+	NumFlushWaiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+void tSystem::AsyncSink::WakeWriter()
+{
+	std::lock_guard<std::mutex> lock(SleepMutex);
+	SleepCondition.notify_one();
+}
+
+
+void tSystem::AsyncSink::WriteBatch()
+{
+	if (Batch.GetNumElements())
+	{
+		Batch.Append('\0');
+		PrintImmediate(Batch.GetElements(), BatchDest);
+		Batch.Reset();
+	}
+
+	// Everything before the dequeue position has now been written.
+	WrittenPos.store(DequeuePos, std::memory_order_seq_cst);
+	if (NumFlushWaiters.load(std::memory_order_seq_cst))
+	{
+		std::lock_guard<std::mutex> lock(FlushMutex);
+		FlushCondition.notify_all();
+	}
+}
+
+
+void tSystem::AsyncSink::WriterLoop()
+{
+	while (1)
+	{
+		Slot& slot = Slots[DequeuePos & Mask];
+		if (slot.Sequence.load(std::memory_order_acquire) == DequeuePos + 1)
+		{
+			// Consecutive messages to the same destination go out together.
+			if ((slot.Dest != BatchDest) || (Batch.GetNumElements() + slot.NumChars > MaxBatchSize))
+				WriteBatch();
+
+			BatchDest = slot.Dest;
+			if (slot.LongText)
+			{
+				Batch.Append(slot.LongText, slot.NumChars);
+				delete[] slot.LongText;
+				slot.LongText = nullptr;
+			}
+			else
+			{
+				Batch.Append(slot.Text, slot.NumChars);
+			}
+
+			// The slot is free for reuse as soon as its contents are in the batch.
+			slot.Sequence.store(DequeuePos + Mask + 1, std::memory_order_release);
+			DequeuePos++;
+			continue;
+		}
+
+		// Nothing more to read right now. Write what we have.
+		WriteBatch();
+		if (StopRequested.load(std::memory_order_seq_cst) && (EnqueuePos.load(std::memory_order_seq_cst) == DequeuePos))
+			break;
+
+		std::unique_lock<std::mutex> lock(SleepMutex);
+		WriterSleeping.store(true, std::memory_order_seq_cst);
+		SleepCondition.wait_for
+		(
+			lock, std::chrono::milliseconds(10),
+			[this, &slot]() { return (slot.Sequence.load(std::memory_order_seq_cst) == DequeuePos + 1) || StopRequested.load(); }
+		);
+		WriterSleeping.store(false, std::memory_order_relaxed);
+	}
+}
+
+
 void tSystem::tSetDefaultPrecision(int precision)
 {
 	DefaultPrecision = precision;
@@ -393,16 +716,36 @@ void tSystem::Receiver::Receive(const char* str, int numChars)
 }
 
 		
-void tSystem::Receiver::Receive(const tArray<char>& buf)
+void tSystem::Receiver::Receive(const ConvBuffer& buf)
 {
-	int len = buf.GetNumElements();
-	Receive(buf.GetElements(), len);
+	Receive(buf.GetElements(), buf.GetNumElements());
 }
 
 
-// Don't forget to update the jump table if you add a new handler to this table. Also note that the
-// default size may be overridden by the format spec. For example, %d can be used for tint256 with the
-// string "%:8X", "%!32X", or "%|256d".
+void tSystem::ConvBuffer::Append(const char* chars, int numChars)
+{
+	if (NumElements + numChars > Capacity)
+		Grow(numChars);
+
+	tStd::tMemcpy(GetElements() + NumElements, chars, numChars);
+	NumElements += numChars;
+}
+
+
+void tSystem::ConvBuffer::Grow(int numNeeded)
+{
+	int capacity = tMath::tMax(Capacity*2, NumElements + numNeeded);
+	char* heap = new char[capacity];
+	tStd::tMemcpy(heap, GetElements(), NumElements);
+	delete[] Heap;
+	Heap = heap;
+	Capacity = capacity;
+}
+
+
+// Don't forget to update the jump table, as well as tIsFormatType and tFormatArgMatches in the header, if you add a
+// new handler to this table. Also note that the default size may be overridden by the format spec. For example, %d
+// can be used for tint256 with the string "%:8X", "%!32X", or "%|256d".
 tSystem::HandlerInfo tSystem::HandlerInfos[] =
 {
 	//	Type Spec	Base Type					Default Size (bytes)	Handler Function		Fast Jump Index
@@ -461,15 +804,7 @@ int tSystem::HandlerJumpTable[256] =
 
 int tvPrintf(const char* format, va_list argList)
 {
-	if (!format)
-		return 0;
-
-	tArray<char> buffer;
-	tSystem::Receiver receiver(&buffer);
-
-	Process(receiver, format, argList);
-	tSystem::tPrint(buffer.GetElements());
-	return receiver.GetNumReceived() - 1;
+	return tvPrintf(tSystem::tChannel_Default, format, argList);
 }
 
 
@@ -478,11 +813,16 @@ int tvPrintf(tSystem::tChannel channels, const char* format, va_list argList)
 	if (!format)
 		return 0;
 
-	tArray<char> buffer;
-	tSystem::Receiver receiver(&buffer);
+	// Channels are checked before anything is formatted. If none are visible we still need to return the number of
+	// characters, but only counting them is much cheaper than collecting and outputting them.
+	if (!(channels & tSystem::OutputChannels))
+		return tvcPrintf(format, argList);
+
+	tSystem::PrintBuffer buffer;
+	tSystem::Receiver receiver(&buffer.Buffer);
 
 	Process(receiver, format, argList);
-	tSystem::tPrint(buffer.GetElements(), channels);
+	tSystem::tPrint(buffer.Buffer.GetElements(), tFileHandle(0));
 	return receiver.GetNumReceived() - 1;
 }
 
@@ -564,6 +904,47 @@ int tsPrintf(char* dest, int destSize, const char* format, ...)
 }
 
 
+int tSystem::tFormatToBuffer(char* dest, int destSize, const char* text, const tFormatSegment* segments, int numSegments, const tFormatArg* args)
+{
+	if (!dest || (destSize <= 0))
+		return 0;
+
+	if (destSize == 1)
+	{
+		dest[0] = '\0';
+		return 0;
+	}
+
+	Receiver receiver(dest, destSize);
+	ProcessPreparsed(receiver, text, segments, numSegments, args);
+
+	// Possibly write a missing terminating 0 if we filled up.
+	int rec = receiver.GetNumReceived();
+	int len = rec - 1;
+	if (destSize == rec)
+		dest[len] = '\0';
+	return len;
+}
+
+
+int tSystem::tFormatToOutput(tFileHandle dest, tChannel channels, const char* text, const tFormatSegment* segments, int numSegments, const tFormatArg* args)
+{
+	// Only stdout output is filtered by channel. As with tvPrintf the characters are still counted.
+	if (!dest && !(channels & OutputChannels))
+	{
+		Receiver counter;
+		ProcessPreparsed(counter, text, segments, numSegments, args);
+		return counter.GetNumReceived() - 1;
+	}
+
+	PrintBuffer buffer;
+	Receiver receiver(&buffer.Buffer);
+	ProcessPreparsed(receiver, text, segments, numSegments, args);
+	tPrint(buffer.Buffer.GetElements(), dest);
+	return receiver.GetNumReceived() - 1;
+}
+
+
 int tcPrintf(const char* format, ...)
 {
 	va_list argList;
@@ -600,11 +981,11 @@ int tvfPrintf(tFileHandle dest, const char* format, va_list argList)
 	if (!format || !dest)
 		return 0;
 
-	tArray<char> buffer;
-	tSystem::Receiver receiver(&buffer);
+	tSystem::PrintBuffer buffer;
+	tSystem::Receiver receiver(&buffer.Buffer);
 
 	Process(receiver, format, argList);
-	tSystem::tPrint(buffer.GetElements(), dest);
+	tSystem::tPrint(buffer.Buffer.GetElements(), dest);
 	return receiver.GetNumReceived() - 1;
 }
 
@@ -627,17 +1008,18 @@ int ttvfPrintf(tFileHandle dest, const char* format, va_list argList)
 	tString stamp = tSystem::tConvertTimeToString(tSystem::tGetTimeLocal(), tSystem::tTimeFormat::Short) + " ";
 	int count = tSystem::tPrint(stamp.Pod(), dest);
 
-	tArray<char> buffer;
-	tSystem::Receiver receiver(&buffer);
+	tSystem::PrintBuffer buffer;
+	tSystem::Receiver receiver(&buffer.Buffer);
 
 	Process(receiver, format, argList);
-	tSystem::tPrint(buffer.GetElements(), dest);
+	tSystem::tPrint(buffer.Buffer.GetElements(), dest);
 	return count + receiver.GetNumReceived() - 1;
 }
 
 
 void tFlush(tFileHandle handle)
 {
+	tSystem::tFlushAsyncOutput();
 	fflush(handle);
 }
 
@@ -670,40 +1052,19 @@ tSystem::HandlerInfo* tSystem::FindHandler(char type)
 }
 
 
-bool tSystem::IsValidFormatSpecifierCharacter(char c)
-{
-	// Tests for valid character after a %. First we check optional flag characters.
-	if ((c == '-') || (c == '+') || (c == ' ') || (c == '0') || (c == '#') || (c == '_') || (c == '\''))
-		return true;
-
-	// Next test for width and precision.
-	if (tStd::tIsdigit(c) || (c == '.') || (c == '*'))
-		return true;
-
-	// Next check for typesize. We've already checked for the digit part.
-	if ((c == ':') || (c == '!') || (c == '|'))
-		return true;
-
-	// Finally check for type.
-	for (int i = 0; i < NumHandlers; i++)
-		if (c == HandlerInfos[i].SpecChar)
-			return true;
-
-	return false;
-}
-
-
 void tSystem::Process(Receiver& receiver, const char* format, va_list argList)
 {
 	while (format[0] != '\0')
 	{
 		if (format[0] != '%')
 		{
-			// Nothing special. Just receive the character.
-			receiver.Receive(format[0]);
-			format++;
+			// Nothing special. Receive everything up to the next format specification in one go.
+			const char* literal = format;
+			while ((format[0] != '%') && (format[0] != '\0'))
+				format++;
+			receiver.Receive(literal, int(format - literal));
 		}
-		else if (!IsValidFormatSpecifierCharacter(format[1]))
+		else if (!tIsFormatSpecStart(format[1]))
 		{
 			// Invalid character after the % so receive that character. This allows stuff like %% (percent symbol) to work.
 			receiver.Receive(format[1]);
@@ -713,86 +1074,18 @@ void tSystem::Process(Receiver& receiver, const char* format, va_list argList)
 		{
 			// Time to process a format specification. Again, it looks like:
 			// %[flags][width][.precision][:typesize][!typesize][|typesize]type
-			format++;
 			FormatSpec spec;
+			int numRead = tParseFormatSpec(spec, format+1);
 
-			while ((format[0] == '-') || (format[0] == '+') || (format[0] == ' ') || (format[0] == '0') || (format[0] == '_') || (format[0] == '\'') || (format[0] == '#'))
-			{
-				switch (format[0])
-				{
-					case '-':	spec.Flags |= Flag_LeftJustify;				break;
-					case '+':	spec.Flags |= Flag_ForcePosOrNegSign;		break;
-					case ' ':	spec.Flags |= Flag_SpaceForPosSign;			break;
-					case '0':	spec.Flags |= Flag_LeadingZeros;			break;
-					case '_':	spec.Flags |= Flag_DecorativeFormatting;	break;
-					case '\'':	spec.Flags |= Flag_DecorativeFormattingAlt;	break;
-					case '#':	spec.Flags |= Flag_BasePrefix;				break;
-				}
-				format++;
-			}
-
-			// From docs: If 0 (leading zeroes) and - (left justify) appear, leading-zeroes is ignored.
-			if ((spec.Flags & Flag_LeadingZeros) && (spec.Flags & Flag_LeftJustify))
-				spec.Flags &= ~Flag_LeadingZeros;
-
-			// Read optional width specification. The '*' means get the value from tha argument list.
-			if (format[0] != '*')
-			{
-				while (tStd::tIsdigit(format[0]))
-				{
-					spec.Width = spec.Width * 10 + ( format[0] - '0' ) ;
-					format++;
-				}
-			}
-			else
-			{
+			// The '*' means get the value from the argument list. Width comes before precision.
+			if (spec.WidthFromArg)
 				spec.Width = va_arg(argList, int);
-				format++;
-			}
-
-			// Read optional precision specification. The '*' means get the value from the argument list.
-			if (format[0] == '.')
-			{
-				spec.Precision = 0;
-				format++;
-
-				if (format[0] != '*')
-				{
-					while (tStd::tIsdigit(format[0]))
-					{
-						spec.Precision = spec.Precision * 10 + ( format[0] - '0' ) ;
-						format++;
-					}
-				}
-				else
-				{
-					spec.Precision = va_arg(argList, int);
-					format++;
-				}
-			}
+			if (spec.PrecisionFromArg)
+				spec.Precision = va_arg(argList, int);
 
-			// Read optional type size specification. Tacent-specific and cleaner than posix or ansi.
-			if ((format[0] == ':') || (format[0] == '!') || (format[0] == '|'))
-			{
-				char typeUnit = format[0];
-				spec.TypeSizeBytes = 0;
-				format++;
-				while (tStd::tIsdigit(format[0]))
-				{
-					spec.TypeSizeBytes = spec.TypeSizeBytes * 10 + ( format[0] - '0' ) ;
-					format++;
-				}
-
-				switch (typeUnit)
-				{
-					case ':':	spec.TypeSizeBytes *= 4;	break;
-					case '|':	spec.TypeSizeBytes /= 8;	break;
-				}
-			}
-
-			// Format now points to the type character.
-			HandlerInfo* handler = FindHandler(*format);
-			tAssert(handler);
+			// Type is '\0' if the specification wasn't valid.
+			HandlerInfo* handler = FindHandler(spec.Type);
+			tAssert(handler && numRead);
 			if (!spec.TypeSizeBytes)
 				spec.TypeSizeBytes = handler->DefaultByteSize;
 
@@ -875,7 +1168,7 @@ void tSystem::Process(Receiver& receiver, const char* format, va_list argList)
 			(handler->Handler)(receiver, spec, pval);
 
 			// We've now processed the whole format specification.
-			format++;
+			format += numRead + 1;
 		}
 	}
 
@@ -884,6 +1177,35 @@ void tSystem::Process(Receiver& receiver, const char* format, va_list argList)
 }
 
 
+void tSystem::ProcessPreparsed(Receiver& receiver, const char* text, const tFormatSegment* segments, int numSegments, const tFormatArg* args)
+{
+	for (int s = 0; s < numSegments; s++)
+	{
+		const tFormatSegment& segment = segments[s];
+		receiver.Receive(text + segment.LiteralStart, segment.LiteralLength);
+		if (segment.Spec.Type == '\0')
+			continue;
+
+		FormatSpec spec(segment.Spec);
+		if (spec.WidthFromArg)
+			spec.Width = int((args++)->Value.Integer);
+		if (spec.PrecisionFromArg)
+			spec.Precision = int((args++)->Value.Integer);
+
+		// The arguments were checked against the specifications when the format was compiled so the size is right.
+		const tFormatArg& arg = *args++;
+		if (!spec.TypeSizeBytes)
+			spec.TypeSizeBytes = arg.SizeBytes;
+
+		HandlerInfo* handler = FindHandler(spec.Type);
+		tAssert(handler);
+		(handler->Handler)(receiver, spec, const_cast<void*>(arg.Data ? arg.Data : &arg.Value));
+	}
+
+	receiver.Receive('\0');
+}
+
+
 // Below are all the handlers and their helper functions.
 
 
@@ -916,7 +1238,7 @@ void tSystem::HandlerHelper_JustificationEpilog(Receiver& receiver, int itemLeng
 
 void tSystem::HandlerHelper_IntegerNative
 (
-	tArray<char>& convBuf, const FormatSpec& spec, void* data, bool treatAsUnsigned,
+	ConvBuffer& convBuf, const FormatSpec& spec, void* data, bool treatAsUnsigned,
 	int bitSize, bool upperCase, int base, bool forcePrefixLowerCase
 )
 {
@@ -1039,7 +1361,7 @@ void tSystem::HandlerHelper_IntegerNative
 
 void tSystem::HandlerHelper_IntegerTacent
 (
-	tArray<char>& convBuf, const FormatSpec& spec, void* data, bool treatAsUnsigned,
+	ConvBuffer& convBuf, const FormatSpec& spec, void* data, bool treatAsUnsigned,
 	int bitSize, bool upperCase, int base, bool forcePrefixLowerCase
 )
 {
@@ -1178,11 +1500,7 @@ void tSystem::Handler_b(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	// Tacent integers are quite a bit bigger and will require more buffer space. Enough for 512 binary digits.
-	// Native: max 64 (*2) = 128. Tacent max 512 (*2) = 1024. Or, if the native needed X bytes (for 64bit number)
-	// then the tacent type will need 8 times that (4*X) cuz it's 512 bits.
-	int bufSize = nativeInt ? 128 : 1024;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1205,8 +1523,7 @@ void tSystem::Handler_o(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1229,8 +1546,7 @@ void tSystem::Handler_d(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1253,8 +1569,7 @@ void tSystem::Handler_i(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1277,8 +1592,7 @@ void tSystem::Handler_u(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1301,8 +1615,7 @@ void tSystem::Handler_x(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1325,8 +1638,7 @@ void tSystem::Handler_X(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool tacentInt = ((bitSize == 128) || (bitSize == 256) || (bitSize == 512));
 	tAssert(nativeInt || tacentInt);
 
-	int bufSize = nativeInt ? 64 : 512;
-	tArray<char> convInt(bufSize, 0);
+	ConvBuffer convInt;
 	if (nativeInt)
 		HandlerHelper_IntegerNative(convInt, spec, data, treatAsUnsigned, bitSize, upperCase, base);
 	else
@@ -1349,7 +1661,7 @@ void tSystem::Handler_p(Receiver& receiver, const FormatSpec& spec, void* data)
 	bool upperCase = true;
 	int base = 16;
 	bool forcePrefixLowerCase = true;
-	tArray<char> convInt(64, 0);
+	ConvBuffer convInt;
 	HandlerHelper_IntegerNative(convInt, pspec, data, treatAsUnsigned, bitSize, upperCase, base, forcePrefixLowerCase);
 
 	HandlerHelper_JustificationProlog(receiver, convInt.GetNumElements(), pspec);
@@ -1385,7 +1697,7 @@ int tSystem::HandlerHelper_FloatComputeExponent(double value)
 }
 
 
-bool tSystem::HandlerHelper_HandleSpecialFloatTypes(tArray<char>& convBuf, double value)
+bool tSystem::HandlerHelper_HandleSpecialFloatTypes(ConvBuffer& convBuf, double value)
 {
 	tStd::tFloatType ft = tStd::tGetFloatType(value);
 	switch (ft)
@@ -1420,7 +1732,7 @@ void tSystem::Handler_e(Receiver& receiver, const FormatSpec& spec, void* data)
 	double v = *((double*)data);
 
 	// Check for early exit infinities and NANs.
-	tArray<char> convBuf(64, 32);
+	ConvBuffer convBuf;
 	if (HandlerHelper_HandleSpecialFloatTypes(convBuf, v))
 	{
 		receiver.Receive(convBuf);
@@ -1547,9 +1859,9 @@ void tSystem::Handler_e(Receiver& receiver, const FormatSpec& spec, void* data)
 }
 
 
-tSystem::PrologHelperFloat tSystem::HandlerHelper_FloatNormal(tArray<char>& convBuf, const FormatSpec& spec, double value, bool treatPrecisionAsSigDigits)
+tSystem::PrologHelperFloat tSystem::HandlerHelper_FloatNormal(ConvBuffer& convBuf, const FormatSpec& spec, double value, bool treatPrecisionAsSigDigits)
 {
-	tArray<char> buf(64, 32);
+	ConvBuffer buf;
 	buf.Append('0');
 
 	// Default floating point printf precision. ANSI is 6, ours is 4.
@@ -1672,7 +1984,7 @@ void tSystem::Handler_f(Receiver& receiver, const FormatSpec& spec, void* data)
 {
 	// Variable arg rules say you must treat the data as double. It converts automatically. That's why %f is always 64 bits.
 	double value = *((double*)data);
-	tArray<char> convFloat(64, 32);
+	ConvBuffer convFloat;
 
 	// Check for early exit infinities and NANs.
 	PrologHelperFloat res = PrologHelperFloat::None;
@@ -1702,7 +2014,7 @@ void tSystem::Handler_g(Receiver& receiver, const FormatSpec& spec, void* data)
 {
 	// Variable argument specifies data should be treated data as double. i.e. %f is 64 bits.
 	double v = *((double*)data);
-	tArray<char> convBuf(64, 32);
+	ConvBuffer convBuf;
 
 	// Default floating point printf precision. ANSI is 6, ours is 4.
 	// For %g, the precision is treated as significant digits, not number of digits after the decimal point.
@@ -32,7 +32,14 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <mutex>
+#include <atomic>
 #include <Foundation/tMemory.h>
+#include <Foundation/tArray.h>
+#include <Foundation/tHashMap.h>
+#include <Foundation/tBitArray.h>
+#include <Foundation/tSort.h>
+#include <Math/tHash.h>
 #include "System/tThrow.h"
 #include "System/tRegex.h"
 #include "System/tPrint.h"
@@ -758,6 +765,931 @@ const char* tRegex::MatchNode(const tRegex::Node* node, const char* str, const t
 }
 
 
+// The Automaton engine. The parsed nodes are compiled into a program for a Thompson NFA. Each instruction either
+// consumes a character from a set, or is an epsilon transition (split, jump, save, or a zero-width assertion). IsMatch,
+// and Search when deciding if there is a match at all, use a DFA that is built from the program one state at a time
+// as text is scanned. Characters that every set treats the same are put in the same class so a DFA state only needs
+// one transition per class. Since a DFA can't tell where sub-expressions begin and end, the captures are found by
+// running the NFA directly as a Pike VM, but only once the DFA has found there is a match.
+//
+// A tRegexSet builds one automaton from many patterns. The program tries each pattern in turn and each ends with its
+// own match instruction, so a single pass finds every pattern that matches.
+struct tRegex::Automaton
+{
+	Automaton();
+	~Automaton();
+
+	// Compiles the parsed nodes of the supplied regexes. Invalid ones are skipped and never match. May throw a tError
+	// if the program gets too large.
+	void Build(const tRegex* const* regexes, int numRegexes);
+
+	// If matched is supplied a bit is set for each pattern that matches the whole text.
+	bool IsMatch(const char* begin, const char* end, tBitArray* matched = nullptr) const;
+
+	// Finds the leftmost match. Fills in NumSlots capture positions, relative to begin, if there is one. Unmatched
+	// sub-expressions are left as -1.
+	bool Search(const char* begin, const char* end, int* captures) const;
+
+	enum Op : uint8
+	{
+		Op_Set,												// Consumes a character in set X.
+		Op_Split,											// Continues at X and Y. X has priority.
+		Op_Jump,											// Continues at X.
+		Op_Save,											// Records the current position in capture slot X.
+		Op_BOL,												// Passes at the beginning of the text.
+		Op_EOL,												// Passes at the end of the text.
+		Op_WB,												// Passes at a word boundary.
+		Op_NWB,												// Passes if not at a word boundary.
+		Op_Match											// X is the index of the pattern that matched.
+	};
+
+	struct Inst
+	{
+		Op Type;
+		int X;
+		int Y;
+	};
+
+	struct CharSet
+	{
+		bool Contains(uint8 c) const																					{ return (Bits[c >> 5] & (1u << (c & 31))) ? true : false; }
+		void Add(uint8 c)																								{ Bits[c >> 5] |= (1u << (c & 31)); }
+		uint32 Bits[8];
+	};
+
+	// A DFA state is the set of program instructions that are live between two characters. Only the ones that matter
+	// to a later step are kept: character sets, end-of-text assertions, and the match. Next holds the state to go to
+	// for each character class. It starts out unknown and is filled in the first time it's needed. A transition never
+	// changes once stored, so scanning threads read them without taking the lock.
+	struct DFAState
+	{
+		int* Insts;
+		int NumInsts;
+		bool AtStart;
+		bool IsMatch;										// A match ends before the next character.
+		bool IsMatchAtEnd;									// A match ends if the text ends here.
+		int* MatchedAtEnd;									// The patterns that match if the text ends here.
+		int NumMatchedAtEnd;
+		int NextSameHash;									// Next state with the same hash or -1.
+		std::atomic<int>* Next;
+	};
+
+	// Working memory for one call. Small patterns fit in the inline buffer so matching doesn't touch the heap.
+	struct Scratch
+	{
+		Scratch(int numInts)																							: Data((numInts <= InlineSize) ? Inline : (int*)tMalloc(numInts * sizeof(int))) { }
+		~Scratch()																										{ if (Data != Inline) tFree(Data); }
+		const static int InlineSize = 1024;
+		int Inline[InlineSize];
+		int* Data;
+	};
+
+	struct ThreadList
+	{
+		bool Contains(int pc) const																						{ int i = Sparse[pc]; return (i < Count) && (Dense[i] == pc); }
+		void Add(int pc)																								{ Sparse[pc] = Count; Dense[Count++] = pc; }
+		int* Sparse;
+		int* Dense;
+		int* Captures;										// NumSlots for each instruction.
+		int Count;
+	};
+
+	struct StackEntry
+	{
+		int PC;												// Instruction to follow or -1 to restore a capture.
+		int Slot;
+		int Value;
+	};
+
+	enum class DFAResult
+	{
+		NoMatch,
+		Match,
+		CacheFull
+	};
+
+	const static int MaxInsts								= 1 << 16;
+	const static int MaxDFAStates							= 2048;
+	const static int UnanchoredPC							= 0;
+	const static int AnchoredPC								= 3;
+	const static int DeadState								= 0;
+	const static int UnknownState							= -1;
+	const static int CacheFull								= -2;
+
+	int Emit(Op, int x = 0, int y = 0);
+	int EmitSet(const CharSet&);
+	void EmitNode(const tRegex&, int node);
+	void EmitList(const tRegex&, int node);
+	void FindLiterals(const tRegex&);
+	void ComputeCharClasses();
+
+	// Pike VM.
+	bool RunNFA(const char* begin, const char* end, bool anchored, bool fullMatch, int* captures, int numSlots, tBitArray* matched = nullptr) const;
+	void AddThread(ThreadList&, int pc, int* captures, int numSlots, const char* pos, const char* begin, const char* end, StackEntry*) const;
+
+	// DFA. Closure and AddState may only be called during Build or with the DFAMutex locked.
+	DFAResult RunDFA(const char* begin, const char* end, bool fullMatch, const DFAState** last = nullptr) const;
+	int ComputeTransition(int state, int charClass) const;
+	void Closure(int pc, bool atStart, bool atEnd) const;
+	int AddState(bool atStart) const;
+
+	static bool IsWordBoundary(const char* pos, const char* begin, const char* end)										{ bool prev = (pos == begin) || tIsspace(pos[-1]); bool curr = (pos == end) || tIsspace(*pos); return prev != curr; }
+	static const char* FindLiteral(const char* begin, const char* end, const char* literal, int length);
+
+	tArray<Inst> Program;
+	tArray<CharSet> Sets;
+	const Inst* Insts;
+	int NumInsts;
+	int NumSlots;
+	int NumPatterns;
+	bool AnchoredBegin;										// Every match must start at the beginning of the text.
+	bool HasWordBoundary;									// The DFA can't look ahead so these are NFA only.
+
+	// Every match must start with Prefix and contain Required. Either may be empty.
+	char* Prefix;
+	int PrefixLength;
+	char* Required;
+	int RequiredLength;
+
+	uint8 CharClasses[256];
+	uint8 ClassChars[256];									// A representative character for each class.
+	int NumClasses;
+
+	// The DFA cache. States is allocated once and never moves so it can be read while another thread adds to it.
+	mutable std::mutex DFAMutex;
+	mutable DFAState** States;
+	mutable int NumStates;
+	mutable tHashMap<uint32, int> StateTable;				// Hash of instructions to first state with that hash.
+	mutable uint8* Marks;
+	mutable int* Marked;									// The instructions with a mark, in the order marked.
+	mutable int NumMarked;
+	mutable int* Stack;
+	int StartAnchored;
+	int StartUnanchored;
+};
+
+
+tRegex::Automaton::Automaton() :
+	Insts(nullptr),
+	NumInsts(0),
+	NumSlots(0),
+	NumPatterns(0),
+	AnchoredBegin(false),
+	HasWordBoundary(false),
+	Prefix(nullptr),
+	PrefixLength(0),
+	Required(nullptr),
+	RequiredLength(0),
+	NumClasses(0),
+	States(nullptr),
+	NumStates(0),
+	Marks(nullptr),
+	Marked(nullptr),
+	NumMarked(0),
+	Stack(nullptr),
+	StartAnchored(-1),
+	StartUnanchored(-1)
+{
+}
+
+
+tRegex::Automaton::~Automaton()
+{
+	for (int s = 0; s < NumStates; s++)
+	{
+		delete[] States[s]->Insts;
+		delete[] States[s]->MatchedAtEnd;
+		delete[] States[s]->Next;
+		delete States[s];
+	}
+	delete[] States;
+	delete[] Marks;
+	delete[] Marked;
+	delete[] Stack;
+	delete[] Prefix;
+	delete[] Required;
+}
+
+
+int tRegex::Automaton::Emit(Op type, int x, int y)
+{
+	if (Program.GetNumElements() >= MaxInsts)
+		throw tError("Pattern too large for the automaton engine.");
+
+	Inst inst;
+	inst.Type = type;
+	inst.X = x;
+	inst.Y = y;
+	Program.Append(inst);
+	return Program.GetNumElements() - 1;
+}
+
+
+int tRegex::Automaton::EmitSet(const CharSet& set)
+{
+	Sets.Append(set);
+	return Emit(Op_Set, Sets.GetNumElements() - 1);
+}
+
+
+void tRegex::Automaton::EmitList(const tRegex& regex, int node)
+{
+	for (; node != -1; node = regex.Nodes[node].Next)
+		EmitNode(regex, node);
+}
+
+
+void tRegex::Automaton::EmitNode(const tRegex& regex, int n)
+{
+	const tRegex::Node& node = regex.Nodes[n];
+	CharSet set;
+	tMemset(&set, 0, sizeof(set));
+	switch (node.Type)
+	{
+		case tOperator_Greedy:
+		{
+			int p0 = (node.Right >> 16) & 0x0000FFFF, p1 = node.Right & 0x0000FFFF;
+			for (int i = 0; i < p0; i++)
+				EmitNode(regex, node.Left);
+
+			if (p1 == 0xFFFF)
+			{
+				int loop = Emit(Op_Split);
+				EmitNode(regex, node.Left);
+				Emit(Op_Jump, loop);
+				Program[loop].X = loop + 1;
+				Program[loop].Y = Program.GetNumElements();
+			}
+			else if (p1 < p0)
+			{
+				// Can never be satisfied. An empty set fails every character.
+				EmitSet(set);
+			}
+			else
+			{
+				// Each optional repeat is nested in the previous one so there is only one way to match n of them.
+				tArray<int> splits(p1 - p0, 0);
+				for (int i = p0; i < p1; i++)
+				{
+					int split = Emit(Op_Split);
+					Program[split].X = split + 1;
+					splits.Append(split);
+					EmitNode(regex, node.Left);
+				}
+				for (int s = 0; s < splits.GetNumElements(); s++)
+					Program[splits[s]].Y = Program.GetNumElements();
+			}
+			break;
+		}
+
+		case tOperator_Or:
+		{
+			int split = Emit(Op_Split);
+			EmitList(regex, node.Left);
+			int jump = Emit(Op_Jump);
+			Program[split].X = split + 1;
+			Program[split].Y = Program.GetNumElements();
+			EmitList(regex, node.Right);
+			Program[jump].X = Program.GetNumElements();
+			break;
+		}
+
+		case tOperator_Expr:
+			Emit(Op_Save, 2*node.Right);
+			EmitList(regex, node.Left);
+			Emit(Op_Save, 2*node.Right + 1);
+			break;
+
+		case tOperator_NoCapExpr:
+			EmitList(regex, node.Left);
+			break;
+
+		case tOperator_WB:
+			Emit((node.Left == 'b') ? Op_WB : Op_NWB);
+			HasWordBoundary = true;
+			break;
+
+		case tOperator_BOL:
+			Emit(Op_BOL);
+			break;
+
+		case tOperator_EOL:
+			Emit(Op_EOL);
+			break;
+
+		case tOperator_Dot:
+			tMemset(&set, 0xFF, sizeof(set));
+			EmitSet(set);
+			break;
+
+		case tOperator_Class:
+		case tOperator_NClass:
+			for (int c = 0; c < 256; c++)
+			{
+				bool inClass = (node.Left != -1) && regex.MatchClass(&regex.Nodes[node.Left], char(c));
+				if (inClass == (node.Type == tOperator_Class))
+					set.Add(uint8(c));
+			}
+			EmitSet(set);
+			break;
+
+		case tOperator_CClass:
+			for (int c = 0; c < 256; c++)
+				if (MatchCClass(node.Left, char(c)))
+					set.Add(uint8(c));
+			EmitSet(set);
+			break;
+
+		default:
+			set.Add(uint8(node.Type));
+			EmitSet(set);
+			break;
+	}
+}
+
+
+void tRegex::Automaton::FindLiterals(const tRegex& regex)
+{
+	// The prefix is the run of single characters a match must start with. Captures don't consume anything so they are
+	// skipped. There are no branches before the end of the run so every match goes straight through it.
+	char literal[256];
+	int length = 0;
+	int pc = AnchoredPC;
+	while (Insts[pc].Type == Op_Save)
+		pc++;
+	AnchoredBegin = (Insts[pc].Type == Op_BOL);
+
+	for (; (Insts[pc].Type == Op_Set) || (Insts[pc].Type == Op_Save); pc++)
+	{
+		if (Insts[pc].Type == Op_Save)
+			continue;
+
+		const CharSet& set = Sets.GetElements()[Insts[pc].X];
+		int count = 0, c = 0;
+		for (int i = 0; (i < 256) && (count < 2); i++)
+			if (set.Contains(uint8(i)))
+				{ c = i; count++; }
+
+		if ((count != 1) || (length == sizeof(literal)))
+			break;
+		literal[length++] = char(c);
+	}
+
+	if (length)
+	{
+		Prefix = new char[length];
+		tMemcpy(Prefix, literal, length);
+		PrefixLength = length;
+	}
+
+	// The required literal is the longest run of plain characters in the top level of the pattern. Anything not at
+	// the top level may be skipped by an alternation or closure. A top-level alternation means there isn't one.
+	int node = regex.Nodes[regex.First].Left;
+	if ((node == -1) || (regex.Nodes[node].Type == tOperator_Or))
+		return;
+
+	int bestStart = -1, bestLength = 0, runStart = -1, runLength = 0;
+	int index = 0;
+	int nodeIndices[256];
+	for (; (node != -1) && (index < 256); node = regex.Nodes[node].Next, index++)
+	{
+		nodeIndices[index] = node;
+		if (regex.Nodes[node].Type < tOperator_First)
+		{
+			if (!runLength)
+				runStart = index;
+			runLength++;
+			if (runLength > bestLength)
+			{
+				bestStart = runStart;
+				bestLength = runLength;
+			}
+		}
+		else
+		{
+			runLength = 0;
+		}
+	}
+
+	// A longer prefix is just as good, and it's used anyway.
+	if (bestLength <= PrefixLength)
+		return;
+
+	Required = new char[bestLength];
+	for (int i = 0; i < bestLength; i++)
+		Required[i] = char(regex.Nodes[nodeIndices[bestStart + i]].Type);
+	RequiredLength = bestLength;
+}
+
+
+void tRegex::Automaton::ComputeCharClasses()
+{
+	// Starts with every character in one class and then splits the classes by each set in turn.
+	tMemset(CharClasses, 0, sizeof(CharClasses));
+	NumClasses = 1;
+	for (int s = 0; s < Sets.GetNumElements(); s++)
+	{
+		const CharSet& set = Sets.GetElements()[s];
+		int remap[512];
+		for (int i = 0; i < 2*NumClasses; i++)
+			remap[i] = -1;
+
+		int numClasses = 0;
+		for (int c = 0; c < 256; c++)
+		{
+			int key = 2*CharClasses[c] + (set.Contains(uint8(c)) ? 1 : 0);
+			if (remap[key] < 0)
+				remap[key] = numClasses++;
+			CharClasses[c] = uint8(remap[key]);
+		}
+		NumClasses = numClasses;
+	}
+
+	for (int c = 255; c >= 0; c--)
+		ClassChars[CharClasses[c]] = uint8(c);
+}
+
+
+void tRegex::Automaton::Build(const tRegex* const* regexes, int numRegexes)
+{
+	// The unanchored entry point is a non-greedy .* in front of the anchored one.
+	CharSet any;
+	tMemset(&any, 0xFF, sizeof(any));
+	Emit(Op_Split, AnchoredPC, UnanchoredPC + 1);
+	EmitSet(any);
+	Emit(Op_Jump, UnanchoredPC);
+	tAssert(Program.GetNumElements() == AnchoredPC);
+
+	// Each pattern is an alternative with its own match. A split to the next pattern goes in front of all but the last.
+	NumPatterns = numRegexes;
+	int lastValid = -1;
+	for (int r = 0; r < numRegexes; r++)
+		if (regexes[r]->IsValid())
+			lastValid = r;
+
+	for (int r = 0; r <= lastValid; r++)
+	{
+		if (!regexes[r]->IsValid())
+			continue;
+
+		int split = (r != lastValid) ? Emit(Op_Split) : -1;
+		EmitNode(*regexes[r], regexes[r]->First);
+		Emit(Op_Match, r);
+		if (split != -1)
+		{
+			Program[split].X = split + 1;
+			Program[split].Y = Program.GetNumElements();
+		}
+	}
+
+	// With nothing valid there must still be something that fails. An empty set never matches.
+	if (lastValid == -1)
+	{
+		CharSet none;
+		tMemset(&none, 0, sizeof(none));
+		EmitSet(none);
+	}
+
+	Insts = Program.GetElements();
+	NumInsts = Program.GetNumElements();
+	if (numRegexes == 1)
+	{
+		NumSlots = 2 * regexes[0]->NumSubExpr;
+		if (regexes[0]->IsValid())
+			FindLiterals(*regexes[0]);
+	}
+	ComputeCharClasses();
+
+	// Word boundaries need the next character, which the DFA doesn't have when it leaves a state. Those patterns only
+	// use the NFA.
+	if (HasWordBoundary)
+		return;
+
+	States = new DFAState*[MaxDFAStates];
+	Marks = new uint8[NumInsts];
+	Marked = new int[NumInsts];
+	Stack = new int[2*NumInsts + 1];
+
+	tMemset(Marks, 0, NumInsts);
+	int dead = AddState(false);
+	tAssert(dead == DeadState);
+	for (int c = 0; c < NumClasses; c++)
+		States[dead]->Next[c].store(dead, std::memory_order_relaxed);
+
+	Closure(AnchoredPC, true, false);
+	StartAnchored = AddState(true);
+	Closure(UnanchoredPC, true, false);
+	StartUnanchored = AddState(true);
+}
+
+
+void tRegex::Automaton::Closure(int pc, bool atStart, bool atEnd) const
+{
+	// Marks everything reachable from pc without consuming a character.
+	int top = 0;
+	Stack[top++] = pc;
+	while (top)
+	{
+		pc = Stack[--top];
+		if (Marks[pc])
+			continue;
+
+		Marks[pc] = 1;
+		Marked[NumMarked++] = pc;
+		const Inst& inst = Insts[pc];
+		switch (inst.Type)
+		{
+			case Op_Split:
+				Stack[top++] = inst.Y;
+				Stack[top++] = inst.X;
+				break;
+
+			case Op_Jump:
+				Stack[top++] = inst.X;
+				break;
+
+			case Op_Save:
+				Stack[top++] = pc + 1;
+				break;
+
+			case Op_BOL:
+				if (atStart)
+					Stack[top++] = pc + 1;
+				break;
+
+			case Op_EOL:
+				if (atEnd)
+					Stack[top++] = pc + 1;
+				break;
+
+			default:
+				break;
+		}
+	}
+}
+
+
+int tRegex::Automaton::AddState(bool atStart) const
+{
+	// Collects the marked instructions that are worth keeping and clears the marks. They are sorted so the same set of
+	// instructions always gives the same state.
+	int* insts = Stack;
+	int numInsts = 0;
+	bool isMatch = false;
+	bool hasEOL = false;
+	for (int m = 0; m < NumMarked; m++)
+	{
+		int pc = Marked[m];
+		Marks[pc] = 0;
+		Op type = Insts[pc].Type;
+		if ((type == Op_Set) || (type == Op_EOL) || (type == Op_Match))
+			insts[numInsts++] = pc;
+		isMatch = isMatch || (type == Op_Match);
+		hasEOL = hasEOL || (type == Op_EOL);
+	}
+	NumMarked = 0;
+	tSort::tQuick(insts, numInsts);
+
+	uint32 hash = tMath::tHashDataFast32((const uint8*)insts, numInsts * sizeof(int), atStart ? 1 : 0);
+	int* first = StateTable.Find(hash);
+	for (int s = first ? *first : -1; s != -1; s = States[s]->NextSameHash)
+	{
+		const DFAState* state = States[s];
+		if ((state->AtStart == atStart) && (state->NumInsts == numInsts) && !tMemcmp(state->Insts, insts, numInsts * sizeof(int)))
+			return s;
+	}
+
+	if (NumStates >= MaxDFAStates)
+		return CacheFull;
+
+	DFAState* state = new DFAState;
+	state->Insts = new int[numInsts];
+	tMemcpy(state->Insts, insts, numInsts * sizeof(int));
+	state->NumInsts = numInsts;
+	state->AtStart = atStart;
+	state->IsMatch = isMatch;
+	state->Next = new std::atomic<int>[NumClasses];
+	for (int c = 0; c < NumClasses; c++)
+		state->Next[c].store(UnknownState, std::memory_order_relaxed);
+
+	// The patterns that match if the text ends here are found by letting the end-of-text assertions pass.
+	for (int i = 0; i < numInsts; i++)
+	{
+		int pc = state->Insts[i];
+		if ((Insts[pc].Type == Op_Match) || (hasEOL && (Insts[pc].Type == Op_EOL)))
+			Closure(pc, atStart, true);
+	}
+
+	int* matched = Stack;
+	int numMatched = 0;
+	for (int m = 0; m < NumMarked; m++)
+	{
+		int pc = Marked[m];
+		if (Insts[pc].Type == Op_Match)
+			matched[numMatched++] = Insts[pc].X;
+		Marks[pc] = 0;
+	}
+	NumMarked = 0;
+
+	state->MatchedAtEnd = numMatched ? new int[numMatched] : nullptr;
+	if (numMatched)
+		tMemcpy(state->MatchedAtEnd, matched, numMatched * sizeof(int));
+	state->NumMatchedAtEnd = numMatched;
+	state->IsMatchAtEnd = (numMatched > 0);
+
+	int index = NumStates;
+	state->NextSameHash = first ? *first : -1;
+	if (first)
+		*first = index;
+	else
+		StateTable.Insert(hash, index);
+
+	States[index] = state;
+	NumStates++;
+	return index;
+}
+
+
+int tRegex::Automaton::ComputeTransition(int s, int charClass) const
+{
+	std::lock_guard<std::mutex> lock(DFAMutex);
+
+	// Another thread may have got here first.
+	const DFAState* state = States[s];
+	int next = state->Next[charClass].load(std::memory_order_relaxed);
+	if (next != UnknownState)
+		return next;
+
+	uint8 c = ClassChars[charClass];
+	for (int i = 0; i < state->NumInsts; i++)
+	{
+		const Inst& inst = Insts[state->Insts[i]];
+		if ((inst.Type == Op_Set) && Sets.GetElements()[inst.X].Contains(c))
+			Closure(state->Insts[i] + 1, false, false);
+	}
+
+	next = AddState(false);
+	if (next != CacheFull)
+		state->Next[charClass].store(next, std::memory_order_release);
+
+	return next;
+}
+
+
+tRegex::Automaton::DFAResult tRegex::Automaton::RunDFA(const char* begin, const char* end, bool fullMatch, const DFAState** last) const
+{
+	int s = (fullMatch || AnchoredBegin) ? StartAnchored : StartUnanchored;
+	for (const uint8* p = (const uint8*)begin; p < (const uint8*)end; p++)
+	{
+		if (!fullMatch && States[s]->IsMatch)
+			return DFAResult::Match;
+
+		int charClass = CharClasses[*p];
+		int next = States[s]->Next[charClass].load(std::memory_order_acquire);
+		if (next < 0)
+		{
+			next = ComputeTransition(s, charClass);
+			if (next == CacheFull)
+				return DFAResult::CacheFull;
+		}
+
+		s = next;
+		if (s == DeadState)
+			return DFAResult::NoMatch;
+	}
+
+	if (last)
+		*last = States[s];
+	return States[s]->IsMatchAtEnd ? DFAResult::Match : DFAResult::NoMatch;
+}
+
+
+void tRegex::Automaton::AddThread
+(
+	ThreadList& list, int pc, int* captures, int numSlots,
+	const char* pos, const char* begin, const char* end, StackEntry* stack
+) const
+{
+	// Follows the epsilon transitions from pc in priority order. Saves modify the captures in place and push an entry
+	// to restore them once everything after the save has been explored.
+	int top = 0;
+	stack[top++] = { pc, -1, 0 };
+	while (top)
+	{
+		StackEntry entry = stack[--top];
+		if (entry.PC == -1)
+		{
+			captures[entry.Slot] = entry.Value;
+			continue;
+		}
+
+		pc = entry.PC;
+		while ((pc != -1) && !list.Contains(pc))
+		{
+			list.Add(pc);
+			const Inst& inst = Insts[pc];
+			int next = -1;
+			switch (inst.Type)
+			{
+				case Op_Split:
+					stack[top++] = { inst.Y, -1, 0 };
+					next = inst.X;
+					break;
+
+				case Op_Jump:
+					next = inst.X;
+					break;
+
+				case Op_Save:
+					if (inst.X < numSlots)
+					{
+						stack[top++] = { -1, inst.X, captures[inst.X] };
+						captures[inst.X] = int(pos - begin);
+					}
+					next = pc + 1;
+					break;
+
+				case Op_BOL:
+					if (pos == begin)
+						next = pc + 1;
+					break;
+
+				case Op_EOL:
+					if (pos == end)
+						next = pc + 1;
+					break;
+
+				case Op_WB:
+				case Op_NWB:
+					if (IsWordBoundary(pos, begin, end) == (inst.Type == Op_WB))
+						next = pc + 1;
+					break;
+
+				default:
+					if (numSlots)
+						tMemcpy(list.Captures + pc*numSlots, captures, numSlots * sizeof(int));
+					break;
+			}
+			pc = next;
+		}
+	}
+}
+
+
+bool tRegex::Automaton::RunNFA(const char* begin, const char* end, bool anchored, bool fullMatch, int* captures, int numSlots, tBitArray* matched) const
+{
+	// The thread lists, the stack for AddThread and a set of captures for new threads. Everything is addressed by
+	// instruction so there are never more threads than instructions.
+	int listSize = NumInsts * (2 + numSlots);
+	Scratch scratch(2*listSize + 3*(NumInsts + 1) + numSlots);
+	int* mem = scratch.Data;
+	ThreadList lists[2];
+	for (int l = 0; l < 2; l++)
+	{
+		lists[l].Sparse = mem;
+		lists[l].Dense = mem + NumInsts;
+		lists[l].Captures = mem + 2*NumInsts;
+		lists[l].Count = 0;
+		tMemset(lists[l].Sparse, 0, NumInsts * sizeof(int));
+		mem += listSize;
+	}
+	StackEntry* stack = (StackEntry*)mem;
+	int* newCaptures = mem + 3*(NumInsts + 1);
+
+	ThreadList* curr = &lists[0];
+	ThreadList* next = &lists[1];
+	bool found = false;
+	const char* pos = begin;
+	while (1)
+	{
+		// A new thread starts at each position until a match is found. It has the lowest priority so it goes last.
+		if (!found && (!anchored || (pos == begin)))
+		{
+			// When nothing is running it's safe to skip to where the prefix occurs next.
+			if (!curr->Count && PrefixLength && !anchored)
+			{
+				pos = FindLiteral(pos, end, Prefix, PrefixLength);
+				if (!pos)
+					break;
+			}
+
+			for (int s = 0; s < numSlots; s++)
+				newCaptures[s] = -1;
+			AddThread(*curr, AnchoredPC, newCaptures, numSlots, pos, begin, end, stack);
+		}
+
+		if (!curr->Count)
+			break;
+
+		next->Count = 0;
+		for (int t = 0; t < curr->Count; t++)
+		{
+			int pc = curr->Dense[t];
+			const Inst& inst = Insts[pc];
+			int* threadCaptures = curr->Captures + pc*numSlots;
+			if (inst.Type == Op_Match)
+			{
+				if (fullMatch && (pos != end))
+					continue;
+
+				// When collecting every pattern that matches, all of the match threads are needed.
+				found = true;
+				if (matched)
+				{
+					matched->SetBit(inst.X, true);
+					continue;
+				}
+
+				if (numSlots)
+					tMemcpy(captures, threadCaptures, numSlots * sizeof(int));
+
+				// Lower priority threads are cut off. Higher priority ones keep going as they may match later.
+				break;
+			}
+
+			if ((inst.Type == Op_Set) && (pos < end) && Sets.GetElements()[inst.X].Contains(uint8(*pos)))
+				AddThread(*next, pc + 1, threadCaptures, numSlots, pos + 1, begin, end, stack);
+		}
+
+		if (pos >= end)
+			break;
+
+		tSwap(curr, next);
+		pos++;
+	}
+
+	return found;
+}
+
+
+const char* tRegex::Automaton::FindLiteral(const char* begin, const char* end, const char* literal, int length)
+{
+	const char* last = end - length;
+	while (begin <= last)
+	{
+		const char* found = (const char*)tMemchr(begin, uint8(*literal), int(last - begin) + 1);
+		if (!found)
+			return nullptr;
+
+		if (!tMemcmp(found + 1, literal + 1, length - 1))
+			return found;
+
+		begin = found + 1;
+	}
+
+	return nullptr;
+}
+
+
+bool tRegex::Automaton::IsMatch(const char* begin, const char* end, tBitArray* matched) const
+{
+	if (matched)
+		matched->Set(NumPatterns);
+
+	if (RequiredLength && !FindLiteral(begin, end, Required, RequiredLength))
+		return false;
+
+	if (PrefixLength && (((end - begin) < PrefixLength) || tMemcmp(begin, Prefix, PrefixLength)))
+		return false;
+
+	if (States)
+	{
+		const DFAState* last = nullptr;
+		DFAResult result = RunDFA(begin, end, true, &last);
+		if (result != DFAResult::CacheFull)
+		{
+			if (matched && last)
+				for (int m = 0; m < last->NumMatchedAtEnd; m++)
+					matched->SetBit(last->MatchedAtEnd[m], true);
+
+			return (result == DFAResult::Match);
+		}
+	}
+
+	return RunNFA(begin, end, true, true, nullptr, 0, matched);
+}
+
+
+bool tRegex::Automaton::Search(const char* begin, const char* end, int* captures) const
+{
+	if (RequiredLength && !FindLiteral(begin, end, Required, RequiredLength))
+		return false;
+
+	if (States && (RunDFA(begin, end, false) == DFAResult::NoMatch))
+		return false;
+
+	return RunNFA(begin, end, AnchoredBegin, false, captures, NumSlots);
+}
+
+
+void tRegex::CompileAutomaton()
+{
+	Auto = new Automaton;
+	const tRegex* regex = this;
+	Auto->Build(&regex, 1);
+}
+
+
 void tRegex::CompileInternal()
 {
 	tAssert(Pattern && !EOL && !BOL && !NumNodes && !Matches && !NumSubExpr);
@@ -793,6 +1725,9 @@ void tRegex::CompileInternal()
 
 void tRegex::Clear()
 {
+	delete Auto;
+	Auto = nullptr;
+
 	CurrSubExpr = 0;
 	if (Matches)
 		tFree(Matches);
@@ -817,7 +1752,7 @@ void tRegex::Clear()
 }
 
 
-void tRegex::Compile(const tString& pattern)
+void tRegex::Compile(const tString& pattern, tRegexEngine engine)
 {
 	Clear();
 	if (pattern.Length() == 0)
@@ -826,10 +1761,12 @@ void tRegex::Compile(const tString& pattern)
 	Pattern = (char*)tMalloc((pattern.Length() + 1) * sizeof(char));
 	tStrcpy(Pattern, pattern.ConstText());
 	CompileInternal();
+	if (engine == tRegexEngine::Automaton)
+		CompileAutomaton();
 }
 
 
-void tRegex::Compile(const char* pattern)
+void tRegex::Compile(const char* pattern, tRegexEngine engine)
 {
 	Clear();
 	if (!pattern)
@@ -842,11 +1779,16 @@ void tRegex::Compile(const char* pattern)
 	Pattern = (char*)tMalloc((len + 1) * sizeof(char));
 	tStrcpy(Pattern, pattern);
 	CompileInternal();
+	if (engine == tRegexEngine::Automaton)
+		CompileAutomaton();
 }
 
 
 bool tRegex::IsMatch(const char* text) const
 {
+	if (Auto)
+		return Auto->IsMatch(text, text + tStrlen(text));
+
 	const char* res = 0;
 	BOL = text;
 	EOL = text + tStrlen(text);
@@ -867,6 +1809,24 @@ void tRegex::Search(const char* textBegin, const char* textEnd, tList<Match>& ma
 	if (textBegin >= textEnd)
 		return;
 
+	if (Auto)
+	{
+		// The captures live on the stack so concurrent searches don't interfere.
+		Automaton::Scratch captures(Auto->NumSlots);
+		if (!Auto->Search(textBegin, textEnd, captures.Data))
+			return;
+
+		for (int m = 0; m < NumSubExpr; m++)
+		{
+			int start = captures.Data[2*m], end = captures.Data[2*m + 1];
+			if ((start >= 0) && (end >= start))
+				matches.Append(new Match(start, end - start));
+			else
+				matches.Append(new Match());
+		}
+		return;
+	}
+
 	BOL = textBegin;
 	EOL = textEnd;
 	do
@@ -901,4 +1861,67 @@ void tRegex::Search(const char* textBegin, const char* textEnd, tList<Match>& ma
 }
 
 
+
+void tRegexSet::Clear()
+{
+	delete Auto;
+	Auto = nullptr;
+	NumPatterns = 0;
+}
+
+
+void tRegexSet::Compile(const tList<tStringItem>& patterns)
+{
+	tArray<const char*> texts(patterns.GetNumItems(), 0);
+	for (const tStringItem* pattern = patterns.First(); pattern; pattern = pattern->Next())
+		texts.Append(pattern->ConstText());
+
+	Compile(texts.GetElements(), texts.GetNumElements());
+}
+
+
+void tRegexSet::Compile(const char* const* patterns, int numPatterns)
+{
+	Clear();
+	if (numPatterns <= 0)
+		return;
+
+	// Each pattern is parsed by its own tRegex. They are only needed until the combined automaton is built.
+	tItList<tRegex> regexes(true);
+	tArray<const tRegex*> parsed(numPatterns, 0);
+	for (int p = 0; p < numPatterns; p++)
+	{
+		tRegex* regex = new tRegex;
+		regexes.Append(regex);
+		regex->Compile(patterns[p]);
+		parsed.Append(regex);
+	}
+
+	Auto = new tRegex::Automaton;
+	NumPatterns = numPatterns;
+	Auto->Build(parsed.GetElements(), numPatterns);
+}
+
+
+bool tRegexSet::IsMatch(const char* text) const
+{
+	if (!Auto)
+		return false;
+
+	return Auto->IsMatch(text, text + tStrlen(text));
+}
+
+
+int tRegexSet::Match(const char* text, tBitArray& matched) const
+{
+	if (!Auto)
+	{
+		matched.Clear();
+		return 0;
+	}
+
+	Auto->IsMatch(text, text + tStrlen(text), &matched);
+	return matched.CountBits();
+}
+
 }
@@ -28,6 +28,8 @@ using namespace tMath;
 tExpression tExpression::Car() const
 {
 	tAssert( IsValid() );
+	if (Node && !IsAtom())
+		return Node->NumItems ? tExpression(Node + Node->ChildOffset) : tExpression();
 
 	const char* c = ValueData + 1;
 
@@ -47,6 +49,13 @@ tExpression tExpression::Car() const
 
 tExpression tExpression::CarCdrN(int n) const
 {
+	if (Node && !IsAtom())
+	{
+		if (n < 0)
+			n = 0;
+		return (n < Node->NumItems) ? tExpression(Node + Node->ChildOffset + n) : tExpression();
+	}
+
 	tExpression e = Car();
 
 	for (int i = 0; i < n; i++)
@@ -64,6 +73,8 @@ tExpression tExpression::CarCdrN(int n) const
 tExpression tExpression::Next() const
 {
 	tAssert( IsValid() );
+	if (Node)
+		return Node->SiblingOffset ? tExpression(Node + Node->SiblingOffset) : tExpression();
 
 	const char* c = ValueData;
 	int count = 0;
@@ -162,7 +173,7 @@ bool tExpression::IsAtom() const
 }
 
 
-tString tExpression::GetAtomString() const
+const char* tExpression::GetAtomText(int& length) const
 {
 	if (!IsAtom())
 	{
@@ -172,6 +183,12 @@ tString tExpression::GetAtomString() const
 			throw tScriptError("Atom expected near: %s", GetContext().Pod());
 	}
 
+	if (Node)
+	{
+		length = Node->AtomLength;
+		return (*ValueData == '"') ? ValueData + 1 : ValueData;
+	}
+
 	const char* start;
 	const char* end;
 	if (*ValueData == '"')
@@ -197,9 +214,19 @@ tString tExpression::GetAtomString() const
 			end++;
 	}
 
+	length = int(end - start);
+	return start;
+}
+
+
+tString tExpression::GetAtomString() const
+{
+	int length;
+	const char* start = GetAtomText(length);
+
 	// Creates a tString full of '\0's.
-	tString atom(int(end - start));
-	tStd::tStrncpy(atom.Text(), start, int(end - start));
+	tString atom(length);
+	tStd::tStrncpy(atom.Text(), start, length);
 
 	return atom;
 }
@@ -493,7 +520,7 @@ tScriptReader::tScriptReader(int argc, char** argv) :
 }
 
 
-void tScriptReader::Load(const tString& name, bool isFile)
+void tScriptReader::Load(const tString& name, bool isFile, bool parse)
 {
 	Clear();
 	if (name.IsEmpty())
@@ -506,10 +533,16 @@ void tScriptReader::Load(const tString& name, bool isFile)
 		// @todo Consider just becoming an invalid expression.
 		tAssert(file);
 
-		int fileSize = tSystem::tGetFileSize(file);
+		// Expressions index the text with ints so the buffer must stay under 2GB.
+		int64 fileSize = tSystem::tGetFileSize(file);
+		if (fileSize >= 0x7FFFFFFF - 7)
+		{
+			tSystem::tCloseFile(file);
+			throw tScriptError("File [%s] is too big to read.", name.Pod());
+		}
 
 		// Create a buffer big enough for the file, the uber []'s, two line-endings (one for each square bracket), and a terminating 0.
-		int bufferSize = fileSize + 7;
+		int bufferSize = int(fileSize) + 7;
 
 		ReadBuffer = new char[bufferSize];
 		ReadBuffer[0] = '[';
@@ -517,7 +550,7 @@ void tScriptReader::Load(const tString& name, bool isFile)
 		ReadBuffer[2] = '\n';
 
 		// Load the entire thing into memory.
-		int numRead = tSystem::tReadFile(file, (uint8*)(ReadBuffer+3), fileSize);
+		int64 numRead = tSystem::tReadFile(file, (uint8*)(ReadBuffer+3), fileSize);
 		if (numRead != fileSize)
 			throw tScriptError("Cannot read file [%s].", name.Pod());
 		tSystem::tCloseFile(file);
@@ -545,41 +578,405 @@ void tScriptReader::Load(const tString& name, bool isFile)
 
 	LineNumber = 1;
 	ValueData = EatWhiteAndComments(ReadBuffer, LineNumber);
+	if (parse)
+		Parse();
+}
+
+
+namespace ScriptParse
+{
+	// Grows a node array by doubling. Nodes are plain data so a memcpy is all that is needed.
+	void Reserve(tScriptNode*& nodes, int& capacity, int required);
+
+	// Fills in the atom fields of the node. The values match what the tString GetAs functions would return.
+	void ParseAtom(tScriptNode&, const char* atomStart);
+}
+
+
+void ScriptParse::Reserve(tScriptNode*& nodes, int& capacity, int required)
+{
+	if (required <= capacity)
+		return;
+
+	int newCapacity = capacity ? capacity : 64;
+	while (newCapacity < required)
+		newCapacity *= 2;
+
+	tScriptNode* newNodes = new tScriptNode[newCapacity];
+	if (nodes)
+		tStd::tMemcpy(newNodes, nodes, capacity*sizeof(tScriptNode));
+	delete[] nodes;
+	nodes = newNodes;
+	capacity = newCapacity;
+}
+
+
+void ScriptParse::ParseAtom(tScriptNode& node, const char* atomStart)
+{
+	// The conversion functions need a null-terminated string. Most atoms are short enough for the stack buffer.
+	const int maxLocal = 64;
+	char local[maxLocal];
+	tString big;
+	char* str = local;
+	if (node.AtomLength >= maxLocal)
+	{
+		big = tString(node.AtomLength);
+		str = big.Text();
+	}
+	tStd::tMemcpy(str, atomStart, node.AtomLength);
+	str[node.AtomLength] = '\0';
+
+	// The integer conversion is modular so the 32 bit values are the low bits of the 64 bit one.
+	node.AtomBits = tStd::tStrtoui64(str);
+	node.AtomDouble = tStd::tStrtod(str);
+	node.AtomBool = tStd::tStrtob(str);
+}
+
+
+void tScriptReader::Parse()
+{
+	if (!ReadBuffer || Nodes || !ValueData || (*ValueData != '['))
+		return;
+
+	// The items of a list are collected on the pending stack until the list closes. They are then moved into the
+	// arena contiguously. While pending, ChildOffset holds the absolute index of a list's first item.
+	struct Frame
+	{
+		const char* Text;
+		int LineNumber;
+		int PendingStart;
+	};
+	tScriptNode* pending = nullptr;
+	int numPending = 0;
+	int pendingCapacity = 0;
+	Frame* frames = nullptr;
+	int numFrames = 0;
+	int frameCapacity = 0;
+	int capacity = 0;
+
+	// A missing end quote or closing bracket throws. The partial tree is discarded so the reader stays unparsed.
+	try
+	{
+		const char* c = ValueData;
+		int lineNum = LineNumber;
+		bool done = false;
+		while (!done)
+		{
+			if (*c == '[')
+			{
+				if (numFrames == frameCapacity)
+				{
+					frameCapacity = frameCapacity ? frameCapacity*2 : 32;
+					Frame* newFrames = new Frame[frameCapacity];
+					if (frames)
+						tStd::tMemcpy(newFrames, frames, numFrames*sizeof(Frame));
+					delete[] frames;
+					frames = newFrames;
+				}
+				frames[numFrames++] = { c, lineNum, numPending };
+				c++;
+			}
+
+			// A missing closing bracket is treated the same as Next does. The end of the data closes everything.
+			else if ((*c == ']') || (*c == '\0'))
+			{
+				do
+				{
+					Frame& frame = frames[--numFrames];
+					int numItems = numPending - frame.PendingStart;
+					int first = NumNodes;
+					ScriptParse::Reserve(Nodes, capacity, NumNodes + numItems + 1);
+					for (int i = 0; i < numItems; i++)
+					{
+						tScriptNode& node = Nodes[first + i];
+						node = pending[frame.PendingStart + i];
+						node.ChildOffset = node.NumItems ? node.ChildOffset - (first + i) : 0;
+						node.SiblingOffset = (i < numItems-1) ? 1 : 0;
+					}
+					NumNodes += numItems;
+					numPending = frame.PendingStart;
+
+					ScriptParse::Reserve(pending, pendingCapacity, numPending + 1);
+					tScriptNode& list = pending[numPending++];
+					tStd::tMemset(&list, 0, sizeof(tScriptNode));
+					list.Text = frame.Text;
+					list.LineNumber = frame.LineNumber;
+					list.ChildOffset = first;
+					list.NumItems = numItems;
+				}
+				while (numFrames && (*c == '\0'));
+
+				if (!numFrames)
+					done = true;
+				else
+					c++;
+			}
+
+			else
+			{
+				// An atom. The extent of the atom text follows GetAtomString and the amount skipped follows Next.
+				ScriptParse::Reserve(pending, pendingCapacity, numPending + 1);
+				tScriptNode& atom = pending[numPending++];
+				tStd::tMemset(&atom, 0, sizeof(tScriptNode));
+				atom.Text = c;
+				atom.LineNumber = lineNum;
+
+				const char* start = c;
+				if (*c == '"')
+				{
+					start = c + 1;
+					c = strchr(start, '"');
+					if (!c)
+						throw tScriptError("Begin quote found but no end quote on line %d.", lineNum);
+					atom.AtomLength = int(c - start);
+					c++;
+				}
+				else
+				{
+					const char* end = c;
+					while ((*end != ' ') && (*end != '\t') && (*end != '[') && (*end != ']') && (*end != '\0') && (*end != '\r') && (*end != '\n'))
+						end++;
+					atom.AtomLength = int(end - start);
+
+					if (*c == '(')
+					{
+						c = strchr(c + 1, ')');
+						if (!c)
+							throw tScriptError("Opening bracket found but no closing bracket on line %d.", lineNum);
+						c++;
+					}
+					else
+					{
+						while ((*c != ' ') && (*c != '\t') && (*c != '[') && (*c != ']') && (*c != '\0') && (*c != ';') && (*c != '<') && (*c != '"'))
+						{
+							if (*c == '\n')
+								lineNum++;
+							c++;
+						}
+					}
+				}
+				ScriptParse::ParseAtom(atom, start);
+			}
+
+			if (!done)
+			{
+				int lineCount;
+				c = EatWhiteAndComments(c, lineCount);
+				lineNum += lineCount;
+			}
+		}
+	}
+	catch (...)
+	{
+		delete[] pending;
+		delete[] frames;
+		delete[] Nodes;
+		Nodes = nullptr;
+		NumNodes = 0;
+		throw;
+	}
+
+	// Only the root is left pending.
+	tAssert(numPending == 1);
+	ScriptParse::Reserve(Nodes, capacity, NumNodes + 1);
+	Nodes[NumNodes] = pending[0];
+	Nodes[NumNodes].ChildOffset = Nodes[NumNodes].NumItems ? Nodes[NumNodes].ChildOffset - NumNodes : 0;
+	NumNodes++;
+	Node = &Nodes[NumNodes-1];
+
+	delete[] pending;
+	delete[] frames;
+}
+
+
+namespace ScriptWrite
+{
+	// Formats a floating point atom the same way "%8.8f" does, with a trailing 0 added if it would end in a '.'.
+	// Special IEEE values are written as 0.0. Returns the length.
+	int FormatFloat(char* dst, int dstSize, double value);
+
+	// Formats an integer in base 10. Returns the length.
+	int FormatInt(char* dst, uint64 magnitude, bool negative);
+
+	static constexpr tFormat floatFormat("%8.8f");
+	static constexpr tFormat doubleFormat("%16.16f");
+}
+
+
+int ScriptWrite::FormatFloat(char* dst, int dstSize, double value)
+{
+	if (tStd::tIsSpecial(value))
+	{
+		tStd::tStrcpy(dst, "0.0");
+		return 3;
+	}
+
+	int l = tsPrintfCT<floatFormat>(dst, dstSize-1, value);
+
+	// Add a trailing 0 because it looks better.
+	if (dst[l-1] == '.')
+	{
+		dst[l++] = '0';
+		dst[l] = '\0';
+	}
+	return l;
+}
+
+
+int ScriptWrite::FormatInt(char* dst, uint64 magnitude, bool negative)
+{
+	// Digits are generated backwards into the end of a local buffer.
+	char digits[24];
+	char* d = digits + sizeof(digits);
+	do
+	{
+		*--d = '0' + char(magnitude % 10);
+		magnitude /= 10;
+	}
+	while (magnitude);
+
+	if (negative)
+		*--d = '-';
+
+	int length = int(digits + sizeof(digits) - d);
+	tStd::tMemcpy(dst, d, length);
+	dst[length] = '\0';
+	return length;
 }
 
 
 tScriptWriter::tScriptWriter(const tString& filename) :
-	CurrIndent(0)
+	CurrIndent(0),
+	WriteBuffer(nullptr),
+	WriteBufferSize(0),
+	WriteBufferPos(0)
 {
 	ScriptFile = tSystem::tOpenFile(filename, "wt");
 
 	if (!ScriptFile)
 		throw tScriptError("Cannot open file [%s].", pod(filename));
+
+	WriteBuffer = new char[FileBufferSize];
+	WriteBufferSize = FileBufferSize;
 }
 
 
-void tScriptWriter::BeginExpression()
+tScriptWriter::tScriptWriter() :
+	CurrIndent(0),
+	WriteBuffer(nullptr),
+	WriteBufferSize(0),
+	WriteBufferPos(0),
+	ScriptFile(nullptr)
 {
-	char beg[] = "[ ";
-	int numWritten = tSystem::tWriteFile(ScriptFile, beg, 2);
-	if (numWritten != 2)
+	WriteBuffer = new char[MemoryBufferSize];
+	WriteBufferSize = MemoryBufferSize;
+	WriteBuffer[0] = '\0';
+}
+
+
+tScriptWriter::~tScriptWriter()
+{
+	if (ScriptFile)
+	{
+		FlushBuffer();
+		tSystem::tCloseFile(ScriptFile);
+	}
+	delete[] WriteBuffer;
+}
+
+
+void tScriptWriter::Flush()
+{
+	if (!FlushBuffer())
 		throw tScriptError("Cannot write to script file.");
 }
 
 
+bool tScriptWriter::FlushBuffer()
+{
+	if (!ScriptFile || !WriteBufferPos)
+		return true;
+
+	int numBytes = WriteBufferPos;
+	int numWritten = tSystem::tWriteFile(ScriptFile, WriteBuffer, numBytes);
+	WriteBufferPos = 0;
+	return (numWritten == numBytes) ? true : false;
+}
+
+
+const char* tScriptWriter::GetText() const
+{
+	if (ScriptFile)
+		return nullptr;
+
+	WriteBuffer[WriteBufferPos] = '\0';
+	return WriteBuffer;
+}
+
+
+void tScriptWriter::Reserve(int numBytes)
+{
+	// The extra byte keeps room for the terminating null of a memory writer.
+	if (WriteBufferPos + numBytes < WriteBufferSize)
+		return;
+
+	if (ScriptFile)
+	{
+		Flush();
+		return;
+	}
+
+	int newSize = tMax(WriteBufferSize*2, WriteBufferPos + numBytes + 1);
+	char* newBuffer = new char[newSize];
+	tStd::tMemcpy(newBuffer, WriteBuffer, WriteBufferPos);
+	delete[] WriteBuffer;
+	WriteBuffer = newBuffer;
+	WriteBufferSize = newSize;
+}
+
+
+void tScriptWriter::Write(const char* data, int numBytes)
+{
+	if (numBytes <= 0)
+		return;
+
+	Reserve(numBytes);
+
+	// Even after flushing a file writer the data may not fit. In that case it goes straight to the file.
+	if (WriteBufferPos + numBytes >= WriteBufferSize)
+	{
+		tAssert(ScriptFile);
+		if (tSystem::tWriteFile(ScriptFile, data, numBytes) != numBytes)
+			throw tScriptError("Cannot write to script file.");
+		return;
+	}
+
+	tStd::tMemcpy(WriteBuffer + WriteBufferPos, data, numBytes);
+	WriteBufferPos += numBytes;
+}
+
+
+void tScriptWriter::BeginExpression()
+{
+	Write("[ ", 2);
+}
+
+
 void tScriptWriter::EndExpression()
 {
-	char end[] = "] ";
-	int numWritten = tSystem::tWriteFile(ScriptFile, end, 2);
-	if (numWritten != 2)
-		throw tScriptError("Cannot write to script file.");
+	Write("] ", 2);
 }
 
 
-void tScriptWriter::WriteAtom(const tString& atom)
+void tScriptWriter::WriteAtomUnquoted(const char* atom, int length)
 {
-	char qu = '"';
+	Write(atom, length);
+	Write(' ');
+}
 
+
+void tScriptWriter::WriteAtom(const tString& atom)
+{
 	bool hasSpace = true;
 	if (atom.FindChar(' ') == -1)
 		hasSpace = false;
@@ -591,27 +988,19 @@ void tScriptWriter::WriteAtom(const tString& atom)
 	// Here we determine whether to use quotes if necessary. If the atom is a tuple (a vector or matrix etc) then we do
 	// not use quotes even if spaces are present.
 	bool useQuotes = (hasSpace && !isTuple) || atom.IsEmpty();
-	int numWritten = 0;
 	if (useQuotes)
-		numWritten += tSystem::tWriteFile(ScriptFile, &qu, 1);
+		Write('"');
 
-	int atomLen = atom.Length();
-	numWritten += tSystem::tWriteFile(ScriptFile, atom, atomLen);
+	Write(atom.Chars(), atom.Length());
 	if (useQuotes)
-		numWritten += tSystem::tWriteFile(ScriptFile, &qu, 1);
-
-	char sp = ' ';
-	numWritten += tSystem::tWriteFile(ScriptFile, &sp, 1);
+		Write('"');
 
-	if (numWritten != (1 + (useQuotes ? 2 : 0) + atomLen))
-		throw tScriptError("Cannot write atom [%s] to script file.", pod(atom));
+	Write(' ');
 }
 
 
 void tScriptWriter::WriteAtom(const char* atom)
 {
-	char qu = '"';
-
 	bool hasSpace = false;
 	if (tStd::tStrchr(atom, ' '))
 		hasSpace = true;
@@ -623,296 +1012,156 @@ void tScriptWriter::WriteAtom(const char* atom)
 	// Here we determine whether to use quotes if necessary. If the atom is a tuple (a vector or matrix etc) then we do
 	// not use quotes even if spaces are present.
 	bool useQuotes = hasSpace && !isTuple;
-	int numWritten = 0;
 	if (useQuotes)
-		numWritten += tSystem::tWriteFile(ScriptFile, &qu, 1);
+		Write('"');
 
-	int atomLen = tStd::tStrlen(atom);
-	numWritten += tSystem::tWriteFile(ScriptFile, atom, atomLen);
+	Write(atom, tStd::tStrlen(atom));
 	if (useQuotes)
-		numWritten += tSystem::tWriteFile(ScriptFile, &qu, 1);
-
-	char sp = ' ';
-	numWritten += tSystem::tWriteFile(ScriptFile, &sp, 1);
+		Write('"');
 
-	if (numWritten != (1 + (useQuotes ? 2 : 0) + atomLen))
-		throw tScriptError("Cannot write atom '%s' to script file.", atom);
+	Write(' ');
 }
 
 
 void tScriptWriter::WriteAtom(const bool atom)
 {
 	if (atom)
-		WriteAtom("True");
+		WriteAtomUnquoted("True", 4);
 	else
-		WriteAtom("False");
+		WriteAtomUnquoted("False", 5);
 }
 
 
 void tScriptWriter::WriteAtom(const uint32 atom)
 {
-	char val[36];
-	tStd::tItoa(atom, val, 36, 10);
-	WriteAtom(val);
+	char val[24];
+	int l = ScriptWrite::FormatInt(val, atom, false);
+	WriteAtomUnquoted(val, l);
 }
 
 
 void tScriptWriter::WriteAtom(const uint64 atom)
 {
-	char val[48];
-	tStd::tItoa(atom, val, 48, 10);
-	WriteAtom(val);
+	char val[24];
+	int l = ScriptWrite::FormatInt(val, atom, false);
+	WriteAtomUnquoted(val, l);
 }
 
 
 void tScriptWriter::WriteAtom(const int atom)
 {
-	char val[36];
-	tStd::tItoa(atom, val, 36, 10);
-	WriteAtom(val);
+	// The magnitude is computed in 64 bits so the most negative int is handled.
+	char val[24];
+	int64 value = atom;
+	int l = ScriptWrite::FormatInt(val, uint64((value < 0) ? -value : value), value < 0);
+	WriteAtomUnquoted(val, l);
 }
 
 
 void tScriptWriter::WriteAtom(const float atom)
 {
-	tString val(32);
-	if (tStd::tIsSpecial(atom))
-		tsPrintf(val.Text(), "0.0");
-	else
-		tsPrintf(val.Text(), "%8.8f", atom);
-
-	int l = val.Length();
-
-	// Add a trailing 0 because it looks better.
-	if (val[l-1] == '.')
-	{
-		val[l] = '0';
-		val[l+1] = '\0';
-	}
-
-	WriteAtom(val);
+	char val[64];
+	int l = ScriptWrite::FormatFloat(val, sizeof(val), atom);
+	WriteAtomUnquoted(val, l);
 }
 
 
 void tScriptWriter::WriteAtom(const double atom)
 {
-	tString val(64);
+	char val[400];
+	int l = 3;
 	if (tStd::tIsSpecial(atom))
-		tsPrintf(val.Text(), "0.0");
-	else
-		tsPrintf(val.Text(), "%16.16f", atom);
-
-	int l = val.Length();
-
-	// Add a trailing 0 because it looks better.
-	if (val[l-1] == '.')
 	{
-		val[l] = '0';
-		val[l+1] = '\0';
+		tStd::tStrcpy(val, "0.0");
 	}
-
-	WriteAtom(val);
-}
-
-
-void tScriptWriter::WriteAtom(const tVector2& v)
-{
-	tString str("(");
-	for (int e = 0; e < 2; e++)
+	else
 	{
-		tString val(32);
-		if (tStd::tIsSpecial(v.E[e]))
-			tsPrintf(val.Text(), "0.0");
-		else
-			tsPrintf(val.Text(), "%8.8f", v.E[e]);
-
-		int l = val.Length();
+		l = tsPrintfCT<ScriptWrite::doubleFormat>(val, sizeof(val)-1, atom);
 
 		// Add a trailing 0 because it looks better.
 		if (val[l-1] == '.')
 		{
-			val[l] = '0';
-			val[l+1] = '\0';
+			val[l++] = '0';
+			val[l] = '\0';
 		}
-		str += val;
-		if (e != 1)
-			str += ", ";
 	}
-	str += ")";
-	WriteAtom(str);
+
+	WriteAtomUnquoted(val, l);
 }
 
 
-void tScriptWriter::WriteAtom(const tVector3& v)
+void tScriptWriter::WriteAtomTuple(const float* components, int numComponents)
 {
-	tString str("(");
-	for (int e = 0; e < 3; e++)
+	// Tuples contain a '(' so they are never quoted even though they contain spaces.
+	char str[64];
+	Write('(');
+	for (int e = 0; e < numComponents; e++)
 	{
-		tString val(32);
-		if (tStd::tIsSpecial(v.E[e]))
-			tsPrintf(val.Text(), "0.0");
-		else
-			tsPrintf(val.Text(), "%8.8f", v.E[e]);
-
-		int l = val.Length();
-
-		// Add a trailing 0 because it looks better.
-		if (val[l-1] == '.')
-		{
-			val[l] = '0';
-			val[l+1] = '\0';
-		}
-		str += val;
-		if (e != 2)
-			str += ", ";
+		int l = ScriptWrite::FormatFloat(str, sizeof(str), components[e]);
+		Write(str, l);
+		if (e != numComponents-1)
+			Write(", ", 2);
 	}
-	str += ")";
-	WriteAtom(str);
+	Write(") ", 2);
 }
 
 
-void tScriptWriter::WriteAtom(const tVector4& v)
+void tScriptWriter::WriteAtom(const tVector2& v)
 {
-	tString str("(");
-	for (int e = 0; e < 4; e++)
-	{
-		tString val(32);
-		if (tStd::tIsSpecial(v.E[e]))
-			tsPrintf(val.Text(), "0.0");
-		else
-			tsPrintf(val.Text(), "%8.8f", v.E[e]);
+	WriteAtomTuple(v.E, 2);
+}
 
-		int l = val.Length();
 
-		// Add a trailing 0 because it looks better.
-		if (val[l-1] == '.')
-		{
-			val[l] = '0';
-			val[l+1] = '\0';
-		}
-		str += val;
-		if (e != 3)
-			str += ", ";
-	}
-	str += ")";
-	WriteAtom(str);
+void tScriptWriter::WriteAtom(const tVector3& v)
+{
+	WriteAtomTuple(v.E, 3);
 }
 
 
-void tScriptWriter::WriteAtom(const tQuaternion& q)
+void tScriptWriter::WriteAtom(const tVector4& v)
 {
-	tString str("(");
-	for (int e = 0; e < 4; e++)
-	{
-		tString val(32);
-		if (tStd::tIsSpecial(q.E[e]))
-			tsPrintf(val.Text(), "0.0");
-		else
-			tsPrintf(val.Text(), "%8.8f", q.E[e]);
+	WriteAtomTuple(v.E, 4);
+}
 
-		int l = val.Length();
 
-		// Add a trailing 0 because it looks better.
-		if (val[l-1] == '.')
-		{
-			val[l] = '0';
-			val[l+1] = '\0';
-		}
-		str += val;
-		if (e != 3)
-			str += ", ";
-	}
-	str += ")";
-	WriteAtom(str);
+void tScriptWriter::WriteAtom(const tQuaternion& q)
+{
+	WriteAtomTuple(q.E, 4);
 }
 
 
 void tScriptWriter::WriteAtom(const tMatrix2& m)
 {
-	tString str("(");
-	for (int e = 0; e < 4; e++)
-	{
-		tString val(32);
-		if (tStd::tIsSpecial(m.E[e]))
-			tsPrintf(val.Text(), "0.0");
-		else
-			tsPrintf(val.Text(), "%8.8f", m.E[e]);
-
-		int l = val.Length();
-
-		// Add a trailing 0 because it looks better.
-		if (val[l-1] == '.')
-		{
-			val[l] = '0';
-			val[l+1] = '\0';
-		}
-		str += val;
-		if (e != 3)
-			str += ", ";
-	}
-	str += ")";
-	WriteAtom(str);
+	WriteAtomTuple(m.E, 4);
 }
 
 
 void tScriptWriter::WriteAtom(const tMatrix4& m)
 {
-	tString str("(");
-	for (int e = 0; e < 16; e++)
-	{
-		tString val(32);
-		if (tStd::tIsSpecial(m.E[e]))
-			tsPrintf(val.Text(), "0.0");
-		else
-			tsPrintf(val.Text(), "%8.8f", m.E[e]);
-
-		int l = val.Length();
-
-		// Add a trailing 0 because it looks better.
-		if (val[l-1] == '.')
-		{
-			val[l] = '0';
-			val[l+1] = '\0';
-		}
-		str += val;
-		if (e != 15)
-			str += ", ";
-	}
-	str += ")";
-	WriteAtom(str);
+	WriteAtomTuple(m.E, 16);
 }
 
 
 void tScriptWriter::WriteAtom(const tColouri& c)
 {
-	tString str("(");
+	char str[24];
+	Write('(');
 	for (int e = 0; e < 4; e++)
 	{
-		char val[36];
-		tStd::tItoa(c.E[e], val, 36, 10);
-
-		str += val;
+		int l = ScriptWrite::FormatInt(str, c.E[e], false);
+		Write(str, l);
 		if (e != 3)
-			str += ", ";
+			Write(", ", 2);
 	}
-	str += ")";
-	WriteAtom(str);
+	Write(") ", 2);
 }
 
 
 void tScriptWriter::WriteComment(const char* comment)
 {
-	char sc[] = "; ";
-	int numWritten = tSystem::tWriteFile(ScriptFile, sc, 2);
-	int commentLen = 0;
+	Write("; ", 2);
 	if (comment)
-	{
-		commentLen = tStd::tStrlen(comment);
-		numWritten += tSystem::tWriteFile(ScriptFile, comment, commentLen);
-	}
-
-	if (numWritten != (2 + commentLen))
-		throw tScriptError("Cannot write to script file.");
+		Write(comment, tStd::tStrlen(comment));
 
 	NewLine();
 }
@@ -920,25 +1169,14 @@ void tScriptWriter::WriteComment(const char* comment)
 
 void tScriptWriter::WriteCommentBegin()
 {
-	char sc[] = "<\n";
-	int numWritten = tSystem::tWriteFile(ScriptFile, sc, 2);
-	if (numWritten != 2)
-		throw tScriptError("Cannot write to script file.");
+	Write("<\n", 2);
 }
 
 
 void tScriptWriter::WriteCommentLine(const char* comment)
 {
-	int numWritten = 0;
-	int commentLen = 0;
 	if (comment)
-	{
-		commentLen = tStd::tStrlen(comment);
-		numWritten += tSystem::tWriteFile(ScriptFile, comment, commentLen);
-	}
-
-	if (numWritten != commentLen)
-		throw tScriptError("Cannot write to script file.");
+		Write(comment, tStd::tStrlen(comment));
 
 	NewLine();
 }
@@ -946,24 +1184,15 @@ void tScriptWriter::WriteCommentLine(const char* comment)
 
 void tScriptWriter::WriteCommentEnd()
 {
-	char sc[] = ">\n";
-	int numWritten = tSystem::tWriteFile(ScriptFile, sc, 2);
-	if (numWritten != 2)
-		throw tScriptError("Cannot write to script file.");
+	Write(">\n", 2);
 }
 
 
 void tScriptWriter::NewLine()
 {
-	char nl = '\n';
-	char sp = ' ';
-
-	int numWritten = tSystem::tWriteFile(ScriptFile, &nl, 1);
+	Write('\n');
 	for (int s = 0; s < CurrIndent; s++)
-		numWritten += tSystem::tWriteFile(ScriptFile, &sp, 1);
-
-	if (numWritten != CurrIndent + 1)
-		throw tScriptError("Cannot write to script file.");
+		Write(' ');
 }
 
 
@@ -1054,12 +1283,17 @@ void tFunScript::Load(const tString& fileName)
 	tFileHandle file = tSystem::tOpenFile(fileName.ConstText() , "rb");
 	tAssert(file);
 
-	// Create a buffer big enough for the file.
-	int fileSize = tSystem::tGetFileSize(file);
+	// Create a buffer big enough for the file. Expressions are parsed with int lengths so it must be under 2GB.
+	int64 fileSize = tSystem::tGetFileSize(file);
+	if (fileSize >= 0x7FFFFFFF)
+	{
+		tSystem::tCloseFile(file);
+		throw tScriptError("File '%s' is too big to read.", fileName.ConstText());
+	}
 	char* buffer = new char[fileSize + 1];
 
 	// Load the entire thing into memory.
-	int numRead = tSystem::tReadFile(file, (uint8*)buffer, fileSize);
+	int64 numRead = tSystem::tReadFile(file, (uint8*)buffer, fileSize);
 	tAssert(numRead == fileSize);
 
 	// This makes buffer a valid null terminated string.
@@ -12,14 +12,17 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <Foundation/tArray.h>
 #include "System/tTask.h"
+#include "System/tJobSystem.h"
 
 
 tTaskSet::tTaskSet(int64 counterFreq, double maxTimeDelta) :
 	ExecuteTime(0),
 	CounterFreq(counterFreq),
 	MaxTimeDelta(maxTimeDelta),
-	PriorityQueue(NumTasks, GrowSize)
+	PriorityQueue(NumTasks, GrowSize),
+	JobSystem(nullptr)
 {
 }
 
@@ -28,13 +31,32 @@ tTaskSet::tTaskSet() :
 	ExecuteTime(0),
 	CounterFreq(0),
 	MaxTimeDelta(0),
-	PriorityQueue(NumTasks, GrowSize)
+	PriorityQueue(NumTasks, GrowSize),
+	JobSystem(nullptr)
 {
 }
 
 
+int64 tTaskSet::GetNextTimeDelta(double nextTime) const
+{
+	int64 nextTimeDelta = int64( nextTime*double(CounterFreq) );
+
+	// The 1 guarantees no infinite loop in Update.
+	if (nextTimeDelta <= 0)
+		nextTimeDelta = 1;
+
+	return nextTimeDelta;
+}
+
+
 void tTaskSet::Update(int64 counter)
 {
+	if (JobSystem)
+	{
+		UpdateParallel(counter);
+		return;
+	}
+
 	bool runningTasks = true;
 	while (runningTasks)
 	{
@@ -54,13 +76,7 @@ void tTaskSet::Update(int64 counter)
 					td = MaxTimeDelta;
 
 				double nextTime = t->Execute(td);
-				int64 nextTimeDelta = int64( nextTime*double(CounterFreq) );
-
-				// The 1 guarantees no infinite loop here.
-				if (nextTimeDelta <= 0)
-					nextTimeDelta = 1;
-
-				qn.Key = counter + nextTimeDelta;
+				qn.Key = counter + GetNextTimeDelta(nextTime);
 				PriorityQueue.Insert(qn);
 			}
 		}
@@ -72,3 +88,60 @@ void tTaskSet::Update(int64 counter)
 
 	ExecuteTime = counter;
 }
+
+
+namespace tTaskJob
+{
+	struct Job : public tSystem::tJob
+	{
+		Job()																											: tJob(), Task(nullptr), DeltaTime(0.0), NextTime(0.0) { }
+		void Execute() override																							{ NextTime = Task->Execute(DeltaTime); }
+
+		tTask* Task;
+		double DeltaTime;
+		double NextTime;
+	};
+}
+
+
+void tTaskSet::UpdateParallel(int64 counter)
+{
+	// Since every task reschedules at least one count into the future, the set of ready tasks is known up front. This
+	// is the same set the serial Update would execute.
+	tArray<tPQ<tTask*>::tItem> ready(NumTasks, GrowSize);
+	while ((PriorityQueue.GetNumItems() > 0) && (PriorityQueue.GetMin().Key <= counter))
+	{
+		tPQ<tTask*>::tItem qn = PriorityQueue.GetRemoveMin();
+
+		// Removed tasks are simply dropped.
+		if (qn.Data)
+			ready.Append(qn);
+	}
+
+	int numReady = ready.GetNumElements();
+	if (numReady > 0)
+	{
+		double td = double(counter - ExecuteTime) / double(CounterFreq);
+		if (td > MaxTimeDelta)
+			td = MaxTimeDelta;
+
+		tTaskJob::Job* jobs = new tTaskJob::Job[numReady];
+		for (int r = 0; r < numReady; r++)
+		{
+			jobs[r].Task = (tTask*)ready[r].Data;
+			jobs[r].DeltaTime = td;
+			JobSystem->Submit(&jobs[r]);
+		}
+
+		for (int r = 0; r < numReady; r++)
+		{
+			JobSystem->Wait(&jobs[r]);
+			ready[r].Key = counter + GetNextTimeDelta(jobs[r].NextTime);
+			PriorityQueue.Insert(ready[r]);
+		}
+
+		delete[] jobs;
+	}
+
+	ExecuteTime = counter;
+}
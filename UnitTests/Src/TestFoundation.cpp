@@ -21,6 +21,8 @@
 #include <Foundation/tSort.h>
 #include <Foundation/tPriorityQueue.h>
 #include <Foundation/tPool.h>
+#include <Foundation/tHashMap.h>
+#include <System/tTime.h>
 #include "UnitTests.h"
 using namespace tStd;
 namespace tUnitTest
@@ -508,6 +510,55 @@ tTestUnit(String)
 	tString aa("aa");
 	tString exaa = aa.ExtractFirstWord('a');
 	tPrintf("\n\naa extract first word to a: Extracted:###%s###  Left:###%s###\n", exaa.ConstText(), aa.ConstText());
+	tRequire(exaa.IsEmpty() && (aa == "a"));
+	tRequire((count1 == 3) && (count2 == 3));
+	tRequire(expl.GetNumItems() == 4);
+	tRequire(expl2.GetNumItems() == 5);
+
+	// Lengths are cached. Writing through Text must still be seen.
+	tString small("short");
+	tString large("this string is long enough that it will not fit in the small buffer");
+	tRequire(small.Length() == 5);
+	tRequire(large.Length() == 67);
+	small.Text()[2] = '\0';
+	tRequire(small.Length() == 2);
+	small[1] = '\0';
+	tRequire(small.Length() == 1);
+
+	// Appending across the small buffer boundary, including to itself.
+	tString grow;
+	for (int i = 0; i < 10; i++)
+		grow += "abc";
+	tRequire((grow.Length() == 30) && (grow.FindString("abcabcabc") == 0));
+	grow += grow;
+	tRequire((grow.Length() == 60) && (grow.CountChar('c') == 20));
+	tRequire(small + large == tString("s") + large);
+
+	// Copies and moves must not share memory.
+	tString copied(large);
+	copied[0] = 'T';
+	tRequire((large[0] == 't') && (copied[0] == 'T'));
+	tString moved(static_cast<tString&&>(copied));
+	tRequire(copied.IsEmpty() && (moved.Length() == 67));
+	copied = moved;
+	tRequire(copied == moved);
+
+	// Edits that shorten the string in place.
+	tString path("/dir/sub/file.txt");
+	tRequire(path.Prefix('/').IsEmpty());
+	tRequire(path.Suffix('.') == "txt");
+	tRequire(path.Suffix(8) == "file.txt");
+	tString word = path.ExtractLastWord('/');
+	tRequire((word == "file.txt") && (path == "/dir/sub") && (path.Length() == 8));
+	word = path.ExtractFirstWord('/');
+	tRequire(word.IsEmpty() && (path == "dir/sub") && (path.Length() == 7));
+	tRequire((path.ExtractPrefix(4) == "dir/") && (path == "sub") && (path.Length() == 3));
+	tString padded("  ##pad##  ");
+	padded.RemoveLeading(" #");
+	padded.RemoveTrailing(" #");
+	tRequire((padded == "pad") && (padded.Length() == 3));
+	padded.Replace('a', '\0');
+	tRequire((padded == "p") && (padded.Length() == 1));
 }
 
 
@@ -595,6 +646,54 @@ tTestUnit(PriorityQueue)
 }
 
 
+// Has numThreads threads allocate and free from the pool at the same time. Each thread stamps its slots and checks the
+// stamps before freeing so any slot handed out twice is caught. Returns the time taken in seconds.
+template<typename PoolType> double PoolContention(PoolType& pool, int numThreads, bool& correct)
+{
+	const int maxThreads = 64;
+	const int slotsPerRound = 16;
+	const int numRounds = 1024;
+	tAssert(numThreads <= maxThreads);
+
+	std::thread threads[maxThreads];
+	bool threadCorrect[maxThreads];
+	int64 start = tSystem::tGetHardwareTimerCount();
+	for (int t = 0; t < numThreads; t++)
+	{
+		threads[t] = std::thread
+		(
+			[&pool, &threadCorrect, t]()
+			{
+				threadCorrect[t] = true;
+				uint64* slots[slotsPerRound];
+				for (int r = 0; r < numRounds; r++)
+				{
+					for (int s = 0; s < slotsPerRound; s++)
+					{
+						slots[s] = (uint64*)pool.Malloc(sizeof(uint64));
+						*slots[s] = uint64(t)*slotsPerRound + s;
+					}
+					for (int s = 0; s < slotsPerRound; s++)
+					{
+						if (*slots[s] != uint64(t)*slotsPerRound + s)
+							threadCorrect[t] = false;
+						pool.Free(slots[s]);
+					}
+				}
+			}
+		);
+	}
+	for (int t = 0; t < numThreads; t++)
+		threads[t].join();
+
+	double seconds = double(tSystem::tGetHardwareTimerCount() - start) / double(tSystem::tGetHardwareTimerFrequency());
+	for (int t = 0; t < numThreads; t++)
+		correct = correct && threadCorrect[t];
+
+	return seconds;
+}
+
+
 tTestUnit(MemoryPool)
 {
 	tPrintf("Sizeof (uint8*): %d\n", sizeof(uint8*));
@@ -671,6 +770,208 @@ tTestUnit(MemoryPool)
 	memPool.Free(memG);
 	memPool.Free(memH);
 	tRequire(memPool.GetNumAllocations() == 0);
+
+	// The thread caching pool behaves the same for a single thread. Slots are at least 16 bytes.
+	tMem::tThreadCachePool cachePool(bytesPerItem, initNumItems, growNumItems, true, 2);
+	tRequire(cachePool.GetSlotsPerBatch() == 2);
+	tRequire(cachePool.GetSlotSize() == 16);
+	void* cacheMem[8];
+	bool allDifferent = true;
+	for (int m = 0; m < 8; m++)
+	{
+		cacheMem[m] = cachePool.Malloc();
+		for (int n = 0; n < m; n++)
+			if (cacheMem[n] == cacheMem[m])
+				allDifferent = false;
+	}
+	tRequire(allDifferent && cacheMem[7]);
+	tRequire(cachePool.GetNumExpansionBlocks() == 2);
+	tRequire(cachePool.Malloc(17) == nullptr);
+	tRequire(cachePool.GetNumAllocations() == 8);
+
+	// The count must be the same when the pool is used through the tAllocator interface.
+	tMem::tAllocator* cacheAllocator = &cachePool;
+	tRequire(cacheAllocator->GetNumAllocations() == 8);
+	for (int m = 0; m < 8; m++)
+		cacheAllocator->Free(cacheMem[m]);
+	tRequire(cacheAllocator->GetNumAllocations() == 0);
+	tRequire(cachePool.GetNumAllocations() == 0);
+
+	// With no expansion blocks Malloc fails when the initial block is used up.
+	tMem::tThreadCachePool fixedPool(16, 8, 0, true, 4);
+	for (int m = 0; m < 8; m++)
+		cacheMem[m] = fixedPool.Malloc();
+	tRequire(cacheMem[7] && (fixedPool.Malloc() == nullptr));
+	for (int m = 0; m < 8; m++)
+		fixedPool.Free(cacheMem[m]);
+
+	// Memory allocated by one thread may be freed by another. The freeing thread's cache gives the extra slots back.
+	const int numCrossSlots = 1000;
+	void* crossSlots[numCrossSlots];
+	std::thread allocThread([&]() { for (int c = 0; c < numCrossSlots; c++) crossSlots[c] = cachePool.Malloc(); cachePool.ReleaseThreadCache(); });
+	allocThread.join();
+	tRequire(cachePool.GetNumAllocations() == numCrossSlots);
+	std::thread freeThread([&]() { for (int c = 0; c < numCrossSlots; c++) cachePool.Free(crossSlots[c]); });
+	freeThread.join();
+	tRequire(cachePool.GetNumAllocations() == 0);
+	int expansionBlocks = cachePool.GetNumExpansionBlocks();
+	for (int c = 0; c < numCrossSlots; c++)
+		crossSlots[c] = cachePool.Malloc();
+	tRequire(cachePool.GetNumExpansionBlocks() == expansionBlocks);
+	for (int c = 0; c < numCrossSlots; c++)
+		cachePool.Free(crossSlots[c]);
+
+	// Contention. Every thread allocates and frees from the same pool.
+	bool fastCorrect = true;
+	bool cacheCorrect = true;
+	double fastTime = 0.0;
+	double cacheTime = 0.0;
+	for (int numThreads = 1; numThreads <= 64; numThreads *= 2)
+	{
+		tMem::tFastPool fastPool(sizeof(uint64), 256, 128, true);
+		tMem::tThreadCachePool threadPool(sizeof(uint64), 256, 128, true);
+		fastTime = PoolContention(fastPool, numThreads, fastCorrect);
+		cacheTime = PoolContention(threadPool, numThreads, cacheCorrect);
+		tPrintf("Pool contention. Threads:%2d  tFastPool:%f ms  tThreadCachePool:%f ms\n", numThreads, fastTime*1000.0, cacheTime*1000.0);
+		tRequire((fastPool.GetNumAllocations() == 0) && (threadPool.GetNumAllocations() == 0));
+	}
+	tRequire(fastCorrect && cacheCorrect);
+	tGoal(cacheTime < fastTime);
+}
+
+
+// Key traits for C string keys. Used to check that user supplied traits work. The tString traits are in Math/tHash.h.
+struct HashKeyCStr
+{
+	static uint32 Hash(const char* key)																					{ uint32 h = 5381; while (*key) h = h*33 + uint8(*key++); return h; }
+	static bool Equal(const char* a, const char* b)																		{ return tStd::tStrcmp(a, b) == 0; }
+};
+
+
+// Forces every key to the same hash so we exercise long probe runs, displacement, and backward-shift removal.
+struct HashKeyCollide
+{
+	static uint32 Hash(int key)																							{ return 0; }
+	static bool Equal(int a, int b)																						{ return a == b; }
+};
+
+
+// An allocator that counts calls and defers to tMalloc. Lets us check the containers only allocate through it.
+class CountingAllocator : public tMem::tAllocator
+{
+public:
+	void* Malloc(int numBytes) override																					{ NumAllocations++; return tMem::tMalloc(numBytes); }
+	void Free(void* mem) override																						{ NumAllocations--; NumFrees++; tMem::tFree(mem); }
+	int NumFrees = 0;
+};
+
+
+tTestUnit(HashMap)
+{
+	// Basic insert, find, and overwrite.
+	tHashMap<uint32, int> map;
+	tRequire(map.IsEmpty());
+	tRequire(map.Find(42) == nullptr);
+	tRequire(map.Insert(42, 420));
+	tRequire(!map.Insert(42, 999));
+	tRequire(map.Find(42) && (*map.Find(42) == 420));
+	map[42] = 421;
+	map[7] = 70;
+	tRequire(map.GetNumItems() == 2);
+	tRequire(*map.Find(42) == 421);
+	tRequire(map[7] == 70);
+	tRequire(map[8] == 0);
+	tRequire(map.GetNumItems() == 3);
+
+	// Growth. Insert enough to force several rehashes and check everything is still there.
+	const int numItems = 5000;
+	for (int i = 0; i < numItems; i++)
+		map[i*7919] = i;
+	int numFound = 0;
+	for (int i = 0; i < numItems; i++)
+	{
+		int* v = map.Find(i*7919);
+		if (v && (*v == i))
+			numFound++;
+	}
+	tPrintf("HashMap items:%d capacity:%d\n", map.GetNumItems(), map.GetCapacity());
+	tRequire(numFound == numItems);
+	tRequire(map.GetCapacity()*4 >= map.GetNumItems()*5);
+
+	// Remove every other item and make sure the rest are unaffected.
+	for (int i = 0; i < numItems; i += 2)
+		map.Remove(i*7919);
+	int numPresent = 0;
+	for (int i = 0; i < numItems; i++)
+		if (map.Contains(i*7919))
+			numPresent++;
+	tRequire(numPresent == numItems/2);
+	tRequire(!map.Remove(0));
+
+	// Iteration visits each item exactly once.
+	int numIterated = 0;
+	for (auto& entry : map)
+		if (map.Find(entry.Key) == &entry.Value)
+			numIterated++;
+	tRequire(numIterated == map.GetNumItems());
+
+	// Copy.
+	tHashMap<uint32, int> mapCopy(map);
+	tRequire(mapCopy.GetNumItems() == map.GetNumItems());
+	tRequire(mapCopy.Find(7919) && (*mapCopy.Find(7919) == 1));
+	map.Clear();
+	tRequire(map.IsEmpty());
+	tRequire(!mapCopy.IsEmpty());
+
+	// Worst case hashing. Every key collides so removal must correctly shift the run back.
+	tHashMap<int, int, HashKeyCollide> collide;
+	for (int i = 0; i < 100; i++)
+		collide.Insert(i, i*2);
+	for (int i = 0; i < 100; i += 3)
+		collide.Remove(i);
+	bool collideOK = true;
+	for (int i = 0; i < 100; i++)
+	{
+		int* v = collide.Find(i);
+		if ((i % 3) ? (!v || (*v != i*2)) : (v != nullptr))
+			collideOK = false;
+	}
+	tRequire(collideOK);
+	tRequire(collide.GetNumItems() == 66);
+
+	// String values and user-supplied key traits.
+	tHashMap<const char*, tString, HashKeyCStr> names;
+	names["one"] = "uno";
+	names["two"] = "dos";
+	names["three"] = "tres";
+	char key[8] = "two";
+	tRequire(names.Find(key) && (*names.Find(key) == "dos"));
+	tRequire(names.Remove("one"));
+	tRequire(!names.Contains("one"));
+	tRequire(names.GetNumItems() == 2);
+
+	// Sets, including enum keys.
+	enum class Colour { Red, Green, Blue };
+	tHashSet<Colour> colours;
+	tRequire(colours.Insert(Colour::Red));
+	tRequire(colours.Insert(Colour::Blue));
+	tRequire(!colours.Insert(Colour::Red));
+	tRequire(colours.Contains(Colour::Blue));
+	tRequire(!colours.Contains(Colour::Green));
+	tRequire(colours.GetNumItems() == 2);
+
+	// Custom allocator. All table memory must come from (and go back to) the allocator.
+	CountingAllocator allocator;
+	{
+		tHashSet<void*> pointers(0, &allocator);
+		for (int i = 0; i < 1000; i++)
+			pointers.Insert((void*)(uint64(i+1)*64));
+		tRequire(pointers.Contains((void*)(uint64(500)*64)));
+		tRequire(allocator.GetNumAllocations() == 1);
+	}
+	tPrintf("HashSet allocator frees:%d\n", allocator.NumFrees);
+	tRequire(allocator.GetNumAllocations() == 0);
+	tRequire(allocator.NumFrees > 1);
 }
 
 
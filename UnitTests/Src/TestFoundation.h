@@ -28,4 +28,5 @@ namespace tUnitTest
 	tTestUnit(RingBuffer);
 	tTestUnit(PriorityQueue);
 	tTestUnit(MemoryPool);
+	tTestUnit(HashMap);
 }
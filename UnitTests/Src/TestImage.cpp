@@ -13,15 +13,18 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <Image/tTexture.h>
+#include <Image/tBlockDecoder.h>
 #include <Image/tImageDDS.h>
 #include <Image/tImageEXR.h>
 #include <Image/tImageGIF.h>
 #include <Image/tImageHDR.h>
 #include <Image/tImageICO.h>
+#include <Image/tImageInfo.h>
 #include <Image/tImageTGA.h>
 #include <Image/tImageJPG.h>
 #include <Image/tImageWEBP.h>
 #include <System/tFile.h>
+#include <System/tTime.h>
 #include "UnitTests.h"
 using namespace tStd;
 namespace tUnitTest
@@ -43,6 +46,68 @@ tTestUnit(Image)
 	tImage::tImageGIF imgGIF("TestData/8-cell-simple.gif");
 	tRequire(imgGIF.IsValid());
 
+	// Frames decoded on demand must match the frames decoded up front, in any order.
+	tImage::tImageGIF::FrameStream gifStream("TestData/8-cell-simple.gif");
+	tRequire(gifStream.IsValid() && (gifStream.GetNumFrames() == imgGIF.GetNumFrames()));
+	int gifFrameSize = imgGIF.GetWidth() * imgGIF.GetHeight() * sizeof(tPixel);
+	bool gifFramesMatch = true;
+	for (int frameNum : { 0, 1, 2, imgGIF.GetNumFrames()-1, 3, 3, 0 })
+	{
+		tImage::tImageGIF::Frame* frame = gifStream.ReadFrame(frameNum);
+		gifFramesMatch = gifFramesMatch && frame && !tStd::tMemcmp(frame->Pixels, imgGIF.GetFrame(frameNum)->Pixels, gifFrameSize);
+		if (frame)
+		{
+			delete[] frame->Pixels;
+			delete frame;
+		}
+	}
+	tRequire(gifFramesMatch);
+	tRequire(!gifStream.ReadFrame(imgGIF.GetNumFrames()));
+
+	tImage::tPicture gifFramePic("TestData/8-cell-simple.gif", 7);
+	tRequire(gifFramePic.IsValid() && !tStd::tMemcmp(gifFramePic.GetPixelPointer(), imgGIF.GetFrame(7)->Pixels, gifFrameSize));
+
+	// These animations have key frames part way through, so reading a frame may skip the ones before it. The frames
+	// still have to match decoding every frame in order.
+	tImage::tImageGIF keyGIF("TestData/AnimatedKeyFrames.gif");
+	tImage::tImageGIF::FrameStream keyGIFStream("TestData/AnimatedKeyFrames.gif");
+	tImage::tImageWEBP keyWEBP("TestData/AnimatedKeyFrames.webp");
+	tImage::tImageWEBP::FrameStream keyWEBPStream("TestData/AnimatedKeyFrames.webp");
+	tRequire(keyGIF.IsValid() && (keyGIFStream.GetNumFrames() == keyGIF.GetNumFrames()));
+	tRequire(keyWEBP.IsValid() && (keyWEBPStream.GetNumFrames() == keyWEBP.GetNumFrames()));
+	int keyGIFFrameSize = keyGIF.GetWidth() * keyGIF.GetHeight() * sizeof(tPixel);
+	int keyWEBPFrameSize = keyWEBPStream.GetWidth() * keyWEBPStream.GetHeight() * sizeof(tPixel);
+	bool keyFramesMatch = true;
+	for (int frameNum : { 11, 8, 3, 10, 4, 7, 2, 5, 9, 0 })
+	{
+		tImage::tImageGIF::Frame* gifFrame = keyGIFStream.ReadFrame(frameNum);
+		tImage::tImageWEBP::Frame* webpFrame = keyWEBPStream.ReadFrame(frameNum);
+		keyFramesMatch = keyFramesMatch && gifFrame && !tStd::tMemcmp(gifFrame->Pixels, keyGIF.GetFrame(frameNum)->Pixels, keyGIFFrameSize);
+		keyFramesMatch = keyFramesMatch && webpFrame && !tStd::tMemcmp(webpFrame->Pixels, keyWEBP.GetFrame(frameNum)->Pixels, keyWEBPFrameSize);
+		if (gifFrame)
+		{
+			delete[] gifFrame->Pixels;
+			delete gifFrame;
+		}
+		if (webpFrame)
+		{
+			delete[] webpFrame->Pixels;
+			delete webpFrame;
+		}
+	}
+	tRequire(keyFramesMatch);
+
+	tImage::tImageWEBP::FrameStream webpStream("TestData/RockyBeach.webp");
+	tRequire(webpStream.IsValid() && (webpStream.GetNumFrames() == 1));
+	tImage::tImageWEBP::Frame* webpFrame = webpStream.ReadNextFrame();
+	tRequire(webpFrame && (webpFrame->Width == webpStream.GetWidth()));
+	tRequire(!webpStream.ReadNextFrame());
+	if (webpFrame)
+	{
+		delete[] webpFrame->Pixels;
+		delete webpFrame;
+	}
+
 	tImage::tImageHDR imgHDR("TestData/mpi_atrium_3.hdr");
 	tRequire(imgHDR.IsValid());
 
@@ -54,10 +119,70 @@ tTestUnit(Image)
 
 	tImage::tImageJPG imgJPG("TestData/WiredDrives.jpg");
 	tRequire(imgJPG.IsValid());
+	tRequire((imgJPG.GetWidth() == imgJPG.GetSrcWidth()) && (imgJPG.GetHeight() == imgJPG.GetSrcHeight()));
+
+	// Reduced size jpg decode. The result must be smaller than the full image but no smaller than the min requested.
+	int thumbMin = imgJPG.GetSrcWidth() / 5;
+	tImage::tImageJPG imgJPGThumb("TestData/WiredDrives.jpg", thumbMin, 0, true);
+	tRequire(imgJPGThumb.IsValid());
+	tPrintf("JPG reduced decode: %d x %d from %d x %d\n", imgJPGThumb.GetWidth(), imgJPGThumb.GetHeight(), imgJPGThumb.GetSrcWidth(), imgJPGThumb.GetSrcHeight());
+	tRequire(imgJPGThumb.GetWidth() >= thumbMin);
+	tRequire(imgJPGThumb.GetWidth() < imgJPG.GetWidth());
+	tRequire(imgJPGThumb.GetHeight() < imgJPG.GetHeight());
+
+	tImage::tPicture::LoadParams jpgParams;
+	jpgParams.JPG_MinWidth = thumbMin;
+	tImage::tPicture jpgThumbPic("TestData/WiredDrives.jpg", 0, jpgParams);
+	tRequire(jpgThumbPic.IsValid() && (jpgThumbPic.GetWidth() == imgJPGThumb.GetWidth()));
 
 	tImage::tImageWEBP imgWEBP("TestData/RockyBeach.webp");
 	tRequire(imgWEBP.IsValid());
 
+	// Header-only info must agree with what a full load reports.
+	for (const char* infoFile :
+	{
+		"TestData/Gradient.tga", "TestData/WhiteBorderRLE.tga", "TestData/WiredDrives.jpg", "TestData/Xeyes.png",
+		"TestData/TextCursor.png", "TestData/mpi_atrium_3.hdr", "TestData/Desk.exr", "TestData/8-cell-simple.gif",
+		"TestData/RockyBeach.webp", "TestData/UpperBounds.ico"
+	})
+	{
+		tImage::tImageInfo info;
+		tRequire(tImage::tGetImageInfo(info, infoFile));
+		tImage::tPicture infoPic(infoFile);
+		tPrintf
+		(
+			"Info %s: %d x %d Frames:%d Format:%s Alpha:%d\n", infoFile, info.Width, info.Height,
+			info.NumFrames, tImage::tGetPixelFormatName(info.PixelFormat), info.HasAlpha
+		);
+		tRequire(infoPic.IsValid() && (info.FileType == tSystem::tGetFileType(infoFile)));
+		tRequire((info.Width == infoPic.GetWidth()) && (info.Height == infoPic.GetHeight()));
+		tRequire(info.PixelFormat == infoPic.SrcPixelFormat);
+		tRequire((info.NumMipmaps == 1) && !info.IsCubemap);
+		if (!info.HasAlpha)
+			tRequire(infoPic.IsOpaque());
+	}
+
+	tImage::tImageInfo gifInfo;
+	tRequire(tImage::tGetImageInfo(gifInfo, "TestData/8-cell-simple.gif") && (gifInfo.NumFrames == imgGIF.GetNumFrames()));
+	tRequire((gifInfo.Width == gifStream.GetWidth()) && (gifInfo.HasAlpha == !gifStream.IsOpaque()));
+
+	for (const char* ddsFile : { "TestData/TestDXT1.dds", "TestData/TestDXT5.dds", "TestData/TestR8G8B8.dds", "TestData/CubemapLayoutGuide.dds" })
+	{
+		tImage::tImageInfo info;
+		tRequire(tImage::tGetImageInfo(info, ddsFile));
+		tImage::tImageDDS infoDDS(ddsFile);
+		tPrintf("Info %s: %d x %d Mips:%d Cube:%d Format:%s\n", ddsFile, info.Width, info.Height, info.NumMipmaps, info.IsCubemap, tImage::tGetPixelFormatName(info.PixelFormat));
+		tRequire((info.Width == infoDDS.GetWidth()) && (info.Height == infoDDS.GetHeight()));
+		tRequire((info.NumMipmaps == infoDDS.GetNumMipmapLevels()) && (info.IsCubemap == infoDDS.IsCubemap()));
+		tRequire(info.PixelFormat == infoDDS.GetPixelFormat());
+		tRequire(info.HasAlpha == !infoDDS.IsOpaque());
+	}
+
+	// Unsupported or missing files.
+	tImage::tImageInfo badInfo;
+	tRequire(!tImage::tGetImageInfo(badInfo, "TestData/TestFP32.dds") && !badInfo.IsValid());
+	tRequire(!tImage::tGetImageInfo(badInfo, "TestData/NonExistent.png"));
+
 	// Test dxt1 texture.
 	tImage::tTexture dxt1Tex("TestData/TestDXT1.dds");
 	tRequire(dxt1Tex.IsValid());
@@ -88,6 +213,211 @@ tTestUnit(Image)
 	bc3Tex.Save(chunkWriterBC3);
 	tRequire( tSystem::tFileExists("TestData/WrittenBC3.tac"));
 
+	// Compressing on multiple threads must give exactly the same result as compressing serially.
+	tImage::tTexture::SetMaxCompressionThreads(1);
+	tImage::tTexture bc3Serial("TestData/UpperBounds.ico", true);
+	tImage::tTexture::SetMaxCompressionThreads(0);
+	tImage::tTexture bc3Parallel("TestData/UpperBounds.ico", true);
+	tRequire(bc3Serial.IsValid() && (bc3Serial == bc3Parallel));
+
+	// Every BC format can be encoded. This doubles as a throughput benchmark. Run with -a to see the numbers.
+	tImage::tPixelFormat bcFormats[] =
+	{
+		tImage::tPixelFormat::BC1_DXT1, tImage::tPixelFormat::BC1_DXT1BA, tImage::tPixelFormat::BC2_DXT3,
+		tImage::tPixelFormat::BC3_DXT5, tImage::tPixelFormat::BC4_ATI1, tImage::tPixelFormat::BC5_ATI2,
+		tImage::tPixelFormat::BC6H, tImage::tPixelFormat::BC7
+	};
+	tImage::tPicture benchSrc("TestData/Xeyes.png");
+	benchSrc.Resize(256, 256);
+	bool allEncoded = true;
+	bool allDecoded = true;
+	tImage::tBlockDecodePath decodePaths[] =
+	{
+		tImage::tBlockDecodePath::Scalar, tImage::tBlockDecodePath::SSE2, tImage::tBlockDecodePath::AVX2
+	};
+	for (tImage::tPixelFormat bcFormat : bcFormats)
+	{
+		for (tImage::tTexture::tQuality quality : { tImage::tTexture::tQuality::Fast, tImage::tTexture::tQuality::Production })
+		{
+			tImage::tPicture src(benchSrc);
+			double startTime = tSystem::tGetTimeDouble();
+			tImage::tTexture tex(src, false, bcFormat, quality);
+			double elapsed = tMath::tMax(tSystem::tGetTimeDouble() - startTime, 1.0e-6);
+			if (!tex.IsValid() || (tex.GetPixelFormat() != bcFormat))
+			{
+				allEncoded = false;
+				continue;
+			}
+
+			tPrintf
+			(
+				"%s %s: %.2f MP/s\n", tImage::tGetPixelFormatName(bcFormat),
+				(quality == tImage::tTexture::tQuality::Fast) ? "Fast" : "Production", (256.0*256.0/1000000.0) / elapsed
+			);
+
+			// Every decode path must give identical pixels.
+			tImage::tLayer* layer = tex.GetMainLayer();
+			tImage::tPicture decoded(*layer);
+			if (!decoded.IsValid())
+			{
+				allDecoded = false;
+				continue;
+			}
+			for (tImage::tBlockDecodePath path : decodePaths)
+			{
+				if (!tImage::tIsBlockDecodePathSupported(path))
+					continue;
+				tImage::tPicture pathDecoded(256, 256);
+				tImage::tDecodeBlocks(pathDecoded.GetPixelPointer(), layer->Data, bcFormat, 256, 256, path, 1);
+				if (pathDecoded != decoded)
+					allDecoded = false;
+			}
+
+			// And the decoded result must be close to the source. Only the channels the format stores are compared,
+			// and nearly transparent pixels are skipped since binary alpha zeroes their colour.
+			int numChannels = 3;
+			if (bcFormat == tImage::tPixelFormat::BC4_ATI1)
+				numChannels = 1;
+			else if (bcFormat == tImage::tPixelFormat::BC5_ATI2)
+				numChannels = 2;
+			double sumSquares = 0.0;
+			int count = 0;
+			for (int y = 0; y < 256; y++)
+			{
+				for (int x = 0; x < 256; x++)
+				{
+					tPixel srcPixel = benchSrc.GetPixel(x, y);
+					if (srcPixel.A < 128)
+						continue;
+					tPixel decPixel = decoded.GetPixel(x, y);
+					for (int c = 0; c < numChannels; c++)
+					{
+						double diff = double(srcPixel.E[c]) - double(decPixel.E[c]);
+						sumSquares += diff*diff;
+						count++;
+					}
+				}
+			}
+			double rmse = tMath::tSqrt(sumSquares / double(tMath::tMax(count, 1)));
+			tPrintf("%s decoded RMSE: %.2f\n", tImage::tGetPixelFormatName(bcFormat), rmse);
+			if (rmse > 12.0)
+				allDecoded = false;
+		}
+	}
+	tRequire(allEncoded);
+	tRequire(allDecoded);
+
+	// Decode throughput on a large layer, which is split across the job system.
+	tImage::tPicture largeSrc("TestData/Xeyes.png");
+	largeSrc.Resize(1024, 1024);
+	tImage::tTexture largeBC1(largeSrc, false, tImage::tPixelFormat::BC1_DXT1, tImage::tTexture::tQuality::Fast);
+	tRequire(largeBC1.IsValid());
+	double decodeStart = tSystem::tGetTimeDouble();
+	tImage::tPicture largeDecoded(*largeBC1.GetMainLayer());
+	double decodeElapsed = tMath::tMax(tSystem::tGetTimeDouble() - decodeStart, 1.0e-6);
+	tRequire(largeDecoded.IsValid() && (largeDecoded.GetWidth() == 1024));
+	tPrintf("BC1 decode: %.2f MP/s\n", (1024.0*1024.0/1000000.0) / decodeElapsed);
+
+	// Native resampler. A solid colour must survive every filter, both minifying and magnifying.
+	tPixel solid[16*16];
+	for (int p = 0; p < 16*16; p++)
+		solid[p].Set(200, 100, 50, 128);
+	bool solidPreserved = true;
+	for (int f = int(tImage::tResampleFilter::NearestNeighbour); f <= int(tImage::tResampleFilter::Kaiser); f++)
+	{
+		tPixel down[5*3];
+		tPixel up[37*41];
+		tImage::tResampleFilter filter = tImage::tResampleFilter(f);
+		solidPreserved = solidPreserved && tImage::tResample(down, 5, 3, solid, 16, 16, filter);
+		solidPreserved = solidPreserved && tImage::tResample(up, 37, 41, solid, 16, 16, filter);
+		for (int p = 0; p < 5*3; p++)
+			solidPreserved = solidPreserved && (down[p] == solid[0]);
+		for (int p = 0; p < 37*41; p++)
+			solidPreserved = solidPreserved && (up[p] == solid[0]);
+	}
+	tRequire(solidPreserved);
+	tRequire(!tImage::tResample(solid, 0, 16, solid, 16, 16));
+
+	// Every supported instruction set path must agree with the scalar one to within rounding. The picture is large
+	// enough to be split across the job system.
+	tImage::tPicture resampleSrc("TestData/Xeyes.png");
+	resampleSrc.Resize(512, 512);
+	tPixel* scalarPixels = new tPixel[300*700];
+	tPixel* simdPixels = new tPixel[300*700];
+	tRequire(tImage::tResample(scalarPixels, 300, 700, resampleSrc.GetPixelPointer(), 512, 512, tImage::tResampleFilter::Lanczos3, tImage::tResamplePath::Scalar));
+	for (int path = int(tImage::tResamplePath::SSE2); path <= int(tImage::tResamplePath::AVX2); path++)
+	{
+		if (!tImage::tIsResamplePathSupported(tImage::tResamplePath(path)))
+			continue;
+		double resampleStart = tSystem::tGetTimeDouble();
+		tRequire(tImage::tResample(simdPixels, 300, 700, resampleSrc.GetPixelPointer(), 512, 512, tImage::tResampleFilter::Lanczos3, tImage::tResamplePath(path)));
+		double resampleElapsed = tMath::tMax(tSystem::tGetTimeDouble() - resampleStart, 1.0e-6);
+		tPrintf("Resample path %d: %.2f MP/s\n", path, (300.0*700.0/1000000.0) / resampleElapsed);
+
+		int maxDiff = 0;
+		for (int p = 0; p < 300*700; p++)
+			for (int c = 0; c < 4; c++)
+				maxDiff = tMath::tMax(maxDiff, tMath::tAbs(int(scalarPixels[p].E[c]) - int(simdPixels[p].E[c])));
+		tRequire(maxDiff <= 1);
+	}
+	delete[] scalarPixels;
+	delete[] simdPixels;
+
+	// Mip chains. A 0/255 checkerboard box filters to 128, or to 188 in linear light.
+	tPixel checker[8*4];
+	for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 8; x++)
+			checker[y*8 + x].Set(((x+y) & 1) ? 255 : 0, ((x+y) & 1) ? 255 : 0, ((x+y) & 1) ? 255 : 0, 255);
+	tImage::tMipChain checkerChain(checker, 8, 4);
+	tRequire(checkerChain.IsValid() && (checkerChain.GetNumLevels() == 4));
+	tRequire((checkerChain.GetWidth(3) == 1) && (checkerChain.GetHeight(3) == 1) && (checkerChain.GetTotalNumPixels() == 32+8+2+1));
+	tRequire(checkerChain.GetLevel(1) == checkerChain.GetLevel(0) + 32);
+	tRequire((checkerChain.GetLevel(1)[0].R == 128) && (checkerChain.GetLevel(3)[0].R == 128));
+	tImage::tMipChain gammaChain(checker, 8, 4, tImage::tMipFilter::Box, true);
+	tRequire((gammaChain.GetLevel(1)[0].R == 188) && (gammaChain.GetLevel(1)[0].A == 255));
+
+	// Every path gives the same levels to within rounding, for both filters.
+	bool mipPathsAgree = true;
+	for (tImage::tMipFilter mipFilter : { tImage::tMipFilter::Box, tImage::tMipFilter::Kaiser })
+	{
+		tImage::tMipChain scalarChain(resampleSrc.GetPixelPointer(), 512, 512, mipFilter, false, tImage::tResamplePath::Scalar);
+		for (int path = int(tImage::tResamplePath::SSE2); path <= int(tImage::tResamplePath::AVX2); path++)
+		{
+			if (!tImage::tIsResamplePathSupported(tImage::tResamplePath(path)))
+				continue;
+			double mipStart = tSystem::tGetTimeDouble();
+			tImage::tMipChain simdChain(resampleSrc.GetPixelPointer(), 512, 512, mipFilter, false, tImage::tResamplePath(path));
+			double mipElapsed = tMath::tMax(tSystem::tGetTimeDouble() - mipStart, 1.0e-6);
+			tPrintf("Mip chain filter %d path %d: %.2f MP/s\n", int(mipFilter), path, (512.0*512.0/1000000.0) / mipElapsed);
+
+			mipPathsAgree = mipPathsAgree && (simdChain.GetNumLevels() == 10);
+			const tPixel* scalarMips = scalarChain.GetLevel(0);
+			const tPixel* simdMips = simdChain.GetLevel(0);
+			for (int64 p = 0; p < scalarChain.GetTotalNumPixels(); p++)
+				for (int c = 0; c < 4; c++)
+					mipPathsAgree = mipPathsAgree && (tMath::tAbs(int(scalarMips[p].E[c]) - int(simdMips[p].E[c])) <= 1);
+		}
+
+		// Threads share the scratch rows of a level, so generating on one thread must give exactly the same levels.
+		tImage::tMipChain serialChain(resampleSrc.GetPixelPointer(), 512, 512, mipFilter, false, tImage::tResamplePath::Auto, 1);
+		tImage::tMipChain parallelChain(resampleSrc.GetPixelPointer(), 512, 512, mipFilter, false, tImage::tResamplePath::Auto, 0);
+		int64 mipBytes = serialChain.GetTotalNumPixels() * sizeof(tPixel);
+		mipPathsAgree = mipPathsAgree && (parallelChain.GetTotalNumPixels() == serialChain.GetTotalNumPixels());
+		mipPathsAgree = mipPathsAgree && !tStd::tMemcmp(serialChain.GetLevel(0), parallelChain.GetLevel(0), int(mipBytes));
+	}
+	tRequire(mipPathsAgree);
+
+	// Generated texture layers all reference one allocation.
+	tImage::tPicture mipSrc(resampleSrc);
+	tImage::tTexture mipTex(mipSrc, true, tImage::tPixelFormat::R8G8B8A8, tImage::tTexture::tQuality::Production);
+	tRequire(mipTex.IsValid() && (mipTex.GetNumLayers() == 10));
+	tImage::tLayer* mainLayer = mipTex.GetMainLayer();
+	tRequire(!mainLayer->OwnsData && (mainLayer->Next()->Data == mainLayer->Data + mainLayer->GetDataSize()));
+
+	tImage::tPicture resizedPic("TestData/Xeyes.png");
+	tRequire(resizedPic.Resize(100, 60, tImage::tPicture::tFilter::Kaiser));
+	tRequire((resizedPic.GetWidth() == 100) && (resizedPic.GetHeight() == 60));
+
 	// Test tPicture loading jpg and saving as tga.
 	tImage::tPicture jpgPic("TestData/WiredDrives.jpg");
 	tRequire(jpgPic.IsValid());
@@ -195,6 +195,28 @@ tTestUnit(Hash)
 		hashString256, realHashString256
 	);
 	tRequire(hashString256 == hashStringCorrect256);
+
+	// Unlike chaining, the hashers give the same value no matter how the data is split up.
+	const char* splitString = "This is a string that will be separated into many pieces for the hashers.";
+	int splitLength = tStd::tStrlen(splitString);
+	tHasher32 hasher32(11); tHasher64 hasher64(11); tHasherMD5 hasherMD5; tHasher256 hasher256(11);
+	for (int pos = 0, piece = 1; pos < splitLength; pos += piece, piece = piece*2 + 1)
+	{
+		int length = tMin(piece, splitLength - pos);
+		hasher32.Update((uint8*)splitString + pos, length);
+		hasher64.Update((uint8*)splitString + pos, length);
+		hasherMD5.Update((uint8*)splitString + pos, length);
+		hasher256.Update((uint8*)splitString + pos, length);
+	}
+	tRequire(hasher32.Finish() == tHashString32(splitString, 11));
+	tRequire(hasher64.Finish() == tHashString64(splitString, 11));
+	tRequire(hasherMD5.Finish() == tHashStringMD5(splitString));
+	tRequire(hasher256.Finish() == tHashString256(splitString, 11));
+
+	tHasherMD5 hasherFox;
+	hasherFox.Update((uint8*)md5String, 10);
+	hasherFox.Update((uint8*)md5String + 10, tStd::tStrlen(md5String) - 10);
+	tRequire(hasherFox.Finish() == md5HashCorrect);
 }
 
 
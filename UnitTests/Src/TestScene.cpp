@@ -12,16 +12,177 @@
 // AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
+#include <Math/tHash.h>
+#include <System/tTime.h>
 #include <Scene/tWorld.h>
 #include "UnitTests.h"
 namespace tUnitTest
 {
 
 
-tTestUnit(World)
+// This is how tWorld used to find objects. Used to compare against the indexed lookups.
+tScene::tMaterial* ScanForMaterial(const tScene::tWorld& world, uint32 id)
 {
-	tRequire(true);
+	for (tItList<tScene::tMaterial>::Iter m = world.Materials.First(); m; ++m)
+		if (m->ID == id)
+			return m;
+	return nullptr;
 }
 
 
+tScene::tMaterial* ScanForMaterial(const tScene::tWorld& world, const tString& name)
+{
+	for (tItList<tScene::tMaterial>::Iter m = world.Materials.First(); m; ++m)
+		if (m->Name == name)
+			return m;
+	return nullptr;
+}
+
+
+tTestUnit(Scene)
+{
+	const int numMaterials = 2000;
+	tScene::tWorld world;
+	for (int m = 0; m < numMaterials; m++)
+	{
+		tScene::tMaterial* material = new tScene::tMaterial;
+		material->ID = 1000 + m*3;
+		tsPrintf(material->Name, "Material%04d", m);
+		world.InsertMaterial(material);
+	}
+
+	// Compare the indexed find functions against a list scan. Timings are informational.
+	int64 freq = tSystem::tGetHardwareTimerFrequency();
+	int numScanFound = 0;
+	int64 start = tSystem::tGetHardwareTimerCount();
+	for (int m = 0; m < numMaterials; m++)
+		if (ScanForMaterial(world, uint32(1000 + m*3)))
+			numScanFound++;
+	double scanIDTime = double(tSystem::tGetHardwareTimerCount() - start) / double(freq);
+
+	int numIndexFound = 0;
+	start = tSystem::tGetHardwareTimerCount();
+	for (int m = 0; m < numMaterials; m++)
+		if (world.FindMaterial(uint32(1000 + m*3)))
+			numIndexFound++;
+	double indexIDTime = double(tSystem::tGetHardwareTimerCount() - start) / double(freq);
+	tPrintf("Find %d materials by ID. Scan:%.1fus Index:%.1fus\n", numMaterials, scanIDTime*1000000.0, indexIDTime*1000000.0);
+	tRequire(numScanFound == numMaterials);
+	tRequire(numIndexFound == numMaterials);
+	tGoal(indexIDTime < scanIDTime);
+
+	tString name;
+	numScanFound = 0;
+	start = tSystem::tGetHardwareTimerCount();
+	for (int m = 0; m < numMaterials; m++)
+		if (ScanForMaterial(world, tsPrintf(name, "Material%04d", m)))
+			numScanFound++;
+	double scanNameTime = double(tSystem::tGetHardwareTimerCount() - start) / double(freq);
+
+	numIndexFound = 0;
+	start = tSystem::tGetHardwareTimerCount();
+	for (int m = 0; m < numMaterials; m++)
+		if (world.FindMaterial(tsPrintf(name, "Material%04d", m)))
+			numIndexFound++;
+	double indexNameTime = double(tSystem::tGetHardwareTimerCount() - start) / double(freq);
+	tPrintf("Find %d materials by name. Scan:%.1fus Index:%.1fus\n", numMaterials, scanNameTime*1000000.0, indexNameTime*1000000.0);
+	tRequire(numScanFound == numMaterials);
+	tRequire(numIndexFound == numMaterials);
+	tGoal(indexNameTime < scanNameTime);
+
+	// Objects appended directly to the public lists are picked up. Duplicate names find the first.
+	tScene::tMaterial* dup = new tScene::tMaterial;
+	dup->ID = 7;
+	dup->Name = "Material0000";
+	world.Materials.Append(dup);
+	tRequire(world.FindMaterial(7) == dup);
+	tRequire(world.FindMaterial("Material0000") == ScanForMaterial(world, tString("Material0000")));
+	tRequire(world.FindMaterial("Material0000") != dup);
+
+	// Offsetting IDs updates the index.
+	world.AddOffsetToAllIDs(100000);
+	tRequire(world.FindMaterial(7) == nullptr);
+	tRequire(world.FindMaterial(100007) == dup);
+	tRequire(world.FindMaterial(101000)->Name == "Material0000");
+
+	// Renames require an explicit invalidate.
+	dup->Name = "Renamed";
+	world.InvalidateIndices();
+	tRequire(world.FindMaterial("Renamed") == dup);
+
+	// Removing one object and appending another leaves the count the same. The index must still notice.
+	tItList<tScene::tMaterial>::Iter dupIter = world.Materials.Find(dup);
+	delete world.Materials.Remove(dupIter);
+	tScene::tMaterial* replacement = new tScene::tMaterial;
+	replacement->ID = 99;
+	replacement->Name = "Replacement";
+	world.Materials.Append(replacement);
+	tRequire(world.FindMaterial(100007) == nullptr);
+	tRequire(world.FindMaterial("Renamed") == nullptr);
+	tRequire(world.FindMaterial(99) == replacement);
+	tRequire(world.FindMaterial("Replacement") == replacement);
+
+	// Merging gives the incoming objects new IDs and they can be found by them.
+	tScene::tWorld other;
+	tScene::tCamera* camera = new tScene::tCamera;
+	camera->ID = 0;
+	camera->Name = "MergedCamera";
+	other.InsertCamera(camera);
+	tRequire(other.FindCamera(0u) == camera);
+	world.MergeScene(other);
+	tRequire(world.FindCamera("MergedCamera") == camera);
+	tRequire(world.FindCamera(camera->ID) == camera);
+
+	world.Clear();
+	tRequire(world.FindMaterial(100007) == nullptr);
+	tRequire(world.FindCamera("MergedCamera") == nullptr);
+
+	// A mesh loaded from a memory mapped chunk file without owning its tables points straight into the mapped pages.
+	{
+		tScene::tMesh mesh;
+		mesh.Clear();
+		mesh.SetNumVertPositions(4);
+		mesh.CreateVertTablePositions();
+		for (int v = 0; v < 4; v++)
+			mesh.VertTablePositions[v].Set(float(v), float(v*2), float(v*3));
+		mesh.SetNumFaces(2);
+		mesh.CreateFaceTableVertPositionIndices();
+		for (int i = 0; i < 3; i++)
+		{
+			mesh.FaceTableVertPositionIndices[0].Index[i] = i;
+			mesh.FaceTableVertPositionIndices[1].Index[i] = 3-i;
+		}
+
+		tChunkWriter writer("TestData/WrittenMesh.bin");
+		mesh.Save(writer);
+	}
+
+	tChunkReader reader;
+	tRequire(reader.LoadMapped("TestData/WrittenMesh.bin"));
+	{
+		tScene::tMesh mapped(reader.GetFirstChunk(), false);
+		tRequire(!mapped.GetOwnsTables());
+		tRequire((mapped.GetNumVertPositions() == 4) && (mapped.GetNumFaces() == 2));
+		tRequire((mapped.VertTablePositions[3].x == 3.0f) && (mapped.VertTablePositions[3].z == 9.0f));
+		tRequire((mapped.FaceTableVertPositionIndices[1].Index[0] == 3) && (mapped.FaceTableVertPositionIndices[1].Index[2] == 1));
+
+		tChunk meshChunk = reader.GetFirstChunk();
+		uint8* begin = meshChunk.GetData();
+		uint8* end = begin + meshChunk.GetDataSize();
+		tRequire(((uint8*)mapped.VertTablePositions >= begin) && ((uint8*)mapped.VertTablePositions < end));
+		tRequire(((uint8*)mapped.FaceTableVertPositionIndices >= begin) && ((uint8*)mapped.FaceTableVertPositionIndices < end));
+
+		// A copy owns its tables and survives the reader going away.
+		tScene::tMesh copy;
+		copy = mapped;
+		tRequire(copy.GetOwnsTables() && (copy.VertTablePositions != mapped.VertTablePositions));
+
+		// Clearing the mapped mesh must not free memory it doesn't own.
+		mapped.Clear();
+		tRequire(mapped.GetOwnsTables() && !mapped.VertTablePositions);
+		reader.UnLoad();
+		tRequire(copy.VertTablePositions[2].y == 4.0f);
+	}
+}
+
 }
@@ -21,6 +21,7 @@
 #include <Math/tMatrix4.h>
 #include <System/tCommand.h>
 #include <System/tTask.h>
+#include <System/tJobSystem.h>
 #include <System/tMachine.h>
 #include <System/tRegex.h>
 #include <System/tScript.h>
@@ -125,6 +126,95 @@ tTestUnit(Task)
 }
 
 
+struct CountingTask : public tTask
+{
+	CountingTask()																										: NumExecutes(0) { }
+	double Execute(double deltaTime) override																			{ NumExecutes++; return 0.0; }
+	int NumExecutes;
+};
+
+
+struct ParentJob : public tJob
+{
+	ParentJob(tJobSystem& system, std::atomic<int>& total)																: tJob(), System(system), Total(total) { }
+	void Execute() override;
+
+	tJobSystem& System;
+	std::atomic<int>& Total;
+	static void AddOne(void* total)																						{ ((std::atomic<int>*)total)->fetch_add(1); }
+	tJob* Children[16];
+};
+
+
+void ParentJob::Execute()
+{
+	// The children are submitted from a worker so they go on that worker's deque and get stolen by the others.
+	for (int c = 0; c < 16; c++)
+	{
+		Children[c] = new tJob(AddOne, &Total, this);
+		System.Submit(Children[c]);
+	}
+}
+
+
+tTestUnit(JobSystem)
+{
+	tJobSystem jobSystem;
+	tPrintf("Job system using %d workers.\n", jobSystem.GetNumWorkers());
+	tRequire(jobSystem.GetNumWorkers() >= 1);
+
+	// A parent is only complete once all its children are.
+	std::atomic<int> total(0);
+	ParentJob parent(jobSystem, total);
+	jobSystem.Run(&parent);
+	tRequire(parent.IsComplete());
+	tRequire(total == 16);
+	bool childrenComplete = true;
+	for (int c = 0; c < 16; c++)
+	{
+		if (!parent.Children[c]->IsComplete())
+			childrenComplete = false;
+		delete parent.Children[c];
+	}
+	tRequire(childrenComplete);
+
+	const int count = 100000;
+	int* squares = new int[count];
+	jobSystem.ParallelFor(count, [squares](int i) { squares[i] = i*i; }, 64);
+	bool allCorrect = true;
+	for (int i = 0; i < count; i++)
+		if (squares[i] != i*i)
+			allCorrect = false;
+	tRequire(allCorrect);
+
+	// Limiting the concurrency to 1 must still visit every index exactly once.
+	std::atomic<int> visits(0);
+	jobSystem.ParallelFor(count, [&visits](int i) { visits.fetch_add(1); }, 1000, 1);
+	tRequire(visits == count);
+	delete[] squares;
+
+	// Tasks in a task set can be sent to the job system. Every ready task runs once per update.
+	int64 freq = tGetHardwareTimerFrequency();
+	tTaskSet tasks(freq, 0.1);
+	tasks.SetJobSystem(&jobSystem);
+	CountingTask countingTasks[8];
+	for (int t = 0; t < 8; t++)
+		tasks.Insert(&countingTasks[t]);
+
+	for (int u = 0; u < 10; u++)
+	{
+		tSleep(1);
+		tasks.Update(tGetHardwareTimerCount());
+	}
+
+	bool allExecuted = true;
+	for (int t = 0; t < 8; t++)
+		if (countingTasks[t].NumExecutes != 10)
+			allExecuted = false;
+	tRequire(allExecuted);
+}
+
+
 // This compares the output of tvsPrintf to the standard vsprintf. Some differences are intended while others are not.
 bool PrintCompare(const char* format, ...)
 {
@@ -169,6 +259,17 @@ void PrintTest(const char* format, ...)
 }
 
 
+// Collects everything the async writer thread outputs. Only the writer thread calls this so no locking is needed.
+static char AsyncCapture[64*1024];
+static int AsyncCaptureLength = 0;
+static void AsyncCaptureCallback(const char* text, int numChars)
+{
+	int count = tMath::tMin(numChars, int(sizeof(AsyncCapture)) - AsyncCaptureLength);
+	tStd::tMemcpy(AsyncCapture + AsyncCaptureLength, text, count);
+	AsyncCaptureLength += count;
+}
+
+
 tTestUnit(Print)
 {
 	tSetDefaultPrecision(6);
@@ -371,12 +472,114 @@ tTestUnit(Print)
 	tRequire(PrintCompare("Test %%g:%g\n", 65.12345678f));
 	tRequire(PrintCompare("Test %%g:%g\n", 651.2345678f));
 
+	// Compile-time formats must produce exactly what the runtime functions produce. Where the runtime needs a typesize
+	// the compile-time version uses the argument type instead.
+	char ctBuf[512];
+	char rtBuf[512];
+	static constexpr tFormat intFormat("Int %d %05x %'u %-6d| %+d %#o %_b %c %%%^\n");
+	tsPrintfCT<intFormat>(ctBuf, sizeof(ctBuf), -42, 0xABC, 1234567u, 7, 42, 8, uint8(0xA7), 'Z');
+	tsPrintf(rtBuf, intFormat.Text, -42, 0xABC, 1234567u, 7, 42, 8, uint8(0xA7), 'Z');
+	tPrint(ctBuf);
+	tRequire(!tStd::tStrcmp(ctBuf, rtBuf));
+
+	static constexpr tFormat bigFormat("Big %d %X %'d %d\n");
+	tint128 i128 = -123456789;
+	tuint256 u256 = 0xFEDCBA9876543210ull;
+	tsPrintfCT<bigFormat>(ctBuf, sizeof(ctBuf), int64(-9000000000ll), uint64(0xFEDCBA9876543210ull), i128, u256);
+	tsPrintf(rtBuf, "Big %|64d %|64X %':4d %:8d\n", int64(-9000000000ll), uint64(0xFEDCBA9876543210ull), i128, u256);
+	tPrint(ctBuf);
+	tRequire(!tStd::tStrcmp(ctBuf, rtBuf));
+
+	static constexpr tFormat floatFormat("Float %f %08.3f % .2f %e %g [%*.*f] [%-*d]\n");
+	tsPrintfCT<floatFormat>(ctBuf, sizeof(ctBuf), 42.0f, -0.65f, 65.5775, 65e24, 651.2345678f, 10, 2, 3.14159f, 6, 42);
+	tsPrintf(rtBuf, floatFormat.Text, 42.0f, -0.65f, 65.5775, 65e24, 651.2345678f, 10, 2, 3.14159f, 6, 42);
+	tPrint(ctBuf);
+	tRequire(!tStd::tStrcmp(ctBuf, rtBuf));
+
+	static constexpr tFormat mathFormat("Math %v %.3v %_v %06.2v %q %_q %05.2m\n%_m");
+	tsPrintfCT<mathFormat>(ctBuf, sizeof(ctBuf), v2, v3, v3b, v4, quat, quat, mat, mat);
+	tsPrintf(rtBuf, "Math %:2v %.3v %_:3v %06.2:4v %q %_q %05.2m\n%_m", pod(v2), pod(v3), v3b, pod(v4), pod(quat), pod(quat), pod(mat), pod(mat));
+	tPrint(ctBuf);
+	tRequire(!tStd::tStrcmp(ctBuf, rtBuf));
+
+	static constexpr tFormat stringFormat("String %s [%10s] [%-8.3s] %p\n");
+	char chars[] = "chars";
+	tsPrintfCT<stringFormat>(ctBuf, sizeof(ctBuf), test, "literal", chars, &test);
+	tsPrintf(rtBuf, stringFormat.Text, test.Chars(), "literal", chars, &test);
+	tPrint(ctBuf);
+	tRequire(!tStd::tStrcmp(ctBuf, rtBuf));
+
+	// Truncation and counting.
+	static constexpr tFormat shortFormat("%d is too long");
+	int numCT = tsPrintfCT<shortFormat>(ctBuf, 8, 123456);
+	tRequire((numCT == 7) && !tStd::tStrcmp(ctBuf, "123456 "));
+	tRequire(tsPrintfCT<shortFormat>(ctBuf, 1, 123456) == 0);
+	int numRT = tsPrintf(rtBuf, intFormat.Text, -42, 0xABC, 1234567u, 7, 42, 8, uint8(0xA7), 'Z');
+	int numPrinted = tPrintfCT<intFormat>(-42, 0xABC, 1234567u, 7, 42, 8, uint8(0xA7), 'Z');
+	tRequire(numPrinted == numRT);
+	int numCounted = tPrintfCT<intFormat, tChannel_None>(-42, 0xABC, 1234567u, 7, 42, 8, uint8(0xA7), 'Z');
+	tRequire(numCounted == numPrinted);
+
 	tSetDefaultPrecision(4);
 
 	tFileHandle handle = tOpenFile("TestData/Written.log", "wt");
 	ttfPrintf(handle, "Log: Here is some timestamped log data. Index = %d\n", 42);
 	ttfPrintf(handle, "Warning: And a second log line.\n");
 	tCloseFile(handle);
+
+	// Async output. A small queue makes the printing threads wait for room some of the time. Every line must arrive
+	// and the lines from each thread must arrive in the order that thread printed them. Nothing is required while it's
+	// on since the test output would be captured too. Everything prints to the test result channel because it's visible
+	// whether or not all channels are.
+	AsyncCaptureLength = 0;
+	tSetStdoutRedirectCallback(AsyncCaptureCallback);
+	tSetAsyncOutput(true, 16);
+	bool asyncWasOn = tGetAsyncOutput();
+
+	const int numAsyncThreads = 4;
+	const int numAsyncLines = 250;
+	std::thread asyncThreads[numAsyncThreads];
+	for (int t = 0; t < numAsyncThreads; t++)
+		asyncThreads[t] = std::thread([t]() { for (int line = 0; line < numAsyncLines; line++) tPrintf(tChannel_TestResult, "%c%03d\n", 'A'+t, line); });
+	for (int t = 0; t < numAsyncThreads; t++)
+		asyncThreads[t].join();
+
+	// Longer than will fit in a queue slot.
+	char longLine[400];
+	tStd::tMemset(longLine, 'L', 399);
+	longLine[399] = '\0';
+	tPrintf(tChannel_TestResult, "%s\n", longLine);
+	tFlushAsyncOutput();
+	int flushedLength = AsyncCaptureLength;
+
+	tSetAsyncOutput(false);
+	tSetStdoutRedirectCallback();
+	tRequire(asyncWasOn && !tGetAsyncOutput());
+	tRequire(flushedLength == AsyncCaptureLength);
+	tRequire(AsyncCaptureLength == numAsyncThreads*numAsyncLines*5 + 400);
+
+	int nextLine[numAsyncThreads] = { 0 };
+	bool asyncOrdered = true;
+	for (int c = 0; c + 5 <= AsyncCaptureLength; )
+	{
+		const char* line = AsyncCapture + c;
+		if (line[0] == 'L')
+		{
+			asyncOrdered = asyncOrdered && !tStd::tStrncmp(line, longLine, 399);
+			c += 400;
+			continue;
+		}
+
+		int t = line[0] - 'A';
+		int lineNum = (line[1]-'0')*100 + (line[2]-'0')*10 + (line[3]-'0');
+		asyncOrdered = asyncOrdered && (t >= 0) && (t < numAsyncThreads) && (lineNum == nextLine[t]) && (line[4] == '\n');
+		if ((t >= 0) && (t < numAsyncThreads))
+			nextLine[t]++;
+		c += 5;
+	}
+	tRequire(asyncOrdered);
+	for (int t = 0; t < numAsyncThreads; t++)
+		tRequire(nextLine[t] == numAsyncLines);
 }
 
 
@@ -395,6 +598,29 @@ void RegexPattern(const char* pattern, const char* test, const char* desc)
 }
 
 
+// Runs both engines over the text and checks they give the same perfect-match result and the same sub-matches.
+bool RegexEnginesAgree(const char* pattern, const char* text)
+{
+	tRegex backtrack(pattern, tRegexEngine::Backtrack);
+	tRegex automaton(pattern, tRegexEngine::Automaton);
+	if (backtrack.IsMatch(text) != automaton.IsMatch(text))
+		return false;
+
+	tList<tRegex::Match> backtrackMatches;
+	tList<tRegex::Match> automatonMatches;
+	backtrack.Search(text, backtrackMatches);
+	automaton.Search(text, automatonMatches);
+	if (backtrackMatches.GetNumItems() != automatonMatches.GetNumItems())
+		return false;
+
+	for (tRegex::Match* b = backtrackMatches.First(), *a = automatonMatches.First(); b && a; b = b->Next(), a = a->Next())
+		if ((b->IndexStart != a->IndexStart) || (b->Length != a->Length))
+			return false;
+
+	return true;
+}
+
+
 tTestUnit(Regex)
 {
 	tString pattern = "[ABC][DEF]";
@@ -465,6 +691,260 @@ tTestUnit(Regex)
 	RegexPattern("World$", "Hello World", "Test $ to match end of the string.");
 	RegexPattern("\\a\\a\\a\\A\\A\\A", "abC123", "Test \\a to match letters and \\A to match non-letters.");
 	RegexPattern("\\a\\a\\a\\A\\A\\A", "123abC", "Test \\a to match letters and \\A to match non-letters.");
+
+	// The automaton engine must agree with the backtracking one where the backtracker's closures don't need to give
+	// anything back.
+	const char* agreePatterns[][2] =
+	{
+		{ ".....", "Hello World" },						{ "(H..).(o..)", "Hello World" },
+		{ "l+", "Hello World" },						{ "Hellp?o World", "Hellpo World" },
+		{ "z*bar*en*ess", "barrenness" },				{ "a{4}A", "aaaaA" },
+		{ "a{4}", "aaaaa" },							{ "Ab{3,}C", "AbbC" },
+		{ "H{2,4}", "HHHHH" },							{ "Vow[AEIO]", "VowI" },
+		{ "Req(One|Two|Three)", "ReqTwo" },				{ "llo\\b", "Hello" },
+		{ "ne\\b two\\b three", "one two three" },		{ "[^A-Za-z0-9_][A-Za-z0-9_]", "@Dd4_" },
+		{ "\\w*\\s[\\w]*\\s[\\w]*", "one two\tTHR33" },	{ "\\d*\\D*", "72635JHWas" },
+		{ "^Hello ^World", "Hello World" },				{ "World$", "Hello World" }
+	};
+	int numAgreePatterns = sizeof(agreePatterns) / sizeof(agreePatterns[0]);
+	for (int p = 0; p < numAgreePatterns; p++)
+		tRequire(RegexEnginesAgree(agreePatterns[p][0], agreePatterns[p][1]));
+
+	// Leftmost match with captures. Alternatives are tried in order and closures give back what they need to.
+	tRegex ranges("(\\d+)-(\\d+)", tRegexEngine::Automaton);
+	tRequire(ranges.GetEngine() == tRegexEngine::Automaton);
+	tList<tRegex::Match> rangeMatches;
+	ranges.Search("ports 8080-8090 and 9000-9001", rangeMatches);
+	tRequire(rangeMatches.GetNumItems() == 3);
+	tRequire((rangeMatches.First()->IndexStart == 6) && (rangeMatches.First()->Length == 9));
+	tRequire((rangeMatches.Last()->IndexStart == 11) && (rangeMatches.Last()->Length == 4));
+
+	tRegex giveBack("(a|ab)(c|bcd)(d*)", tRegexEngine::Automaton);
+	tList<tRegex::Match> giveBackMatches;
+	giveBack.Search("xabcd", giveBackMatches);
+	tRequire(giveBackMatches.GetNumItems() == 4);
+	tRequire((giveBackMatches.First()->IndexStart == 1) && (giveBackMatches.First()->Length == 4));
+	tRequire(giveBack.IsMatch("abcd") && !giveBack.IsMatch("xabcd"));
+	tRequire(tRegex("a*ab", tRegexEngine::Automaton).IsMatch("aaab"));
+
+	// Nested closures on text that almost matches. The automaton stays linear where a backtracker would not.
+	const int nearMissLength = 1 << 16;
+	char* nearMiss = new char[nearMissLength + 1];
+	tStd::tMemset(nearMiss, 'a', nearMissLength);
+	nearMiss[nearMissLength - 2] = 'b';
+	nearMiss[nearMissLength - 1] = 'c';
+	nearMiss[nearMissLength] = '\0';
+	int64 freq = tGetHardwareTimerFrequency();
+	int64 start = tGetHardwareTimerCount();
+	tRegex nested("(a*)*b", tRegexEngine::Automaton);
+	tRegex alternated("(a|aa)*c", tRegexEngine::Automaton);
+	tRequire(!nested.IsMatch(nearMiss) && !alternated.IsMatch(nearMiss));
+	tList<tRegex::Match> nestedMatches;
+	tList<tRegex::Match> alternatedMatches;
+	nested.Search(nearMiss, nestedMatches);
+	alternated.Search(nearMiss, alternatedMatches);
+	double nearMissTime = double(tGetHardwareTimerCount() - start) / double(freq);
+	tPrintf("Automaton near-miss time for %d characters: %f ms\n", nearMissLength, nearMissTime * 1000.0);
+	tRequire((nestedMatches.GetNumItems() == 2) && (nestedMatches.First()->Length == nearMissLength - 1));
+	tRequire((alternatedMatches.GetNumItems() == 2) && (alternatedMatches.First()->IndexStart == nearMissLength - 1));
+	tGoal(nearMissTime < 0.5);
+
+	// The required literal rejects text without running the automaton. Here it's only at the very end.
+	tRegex logLine("[a-z]+ERR\\d?", tRegexEngine::Automaton);
+	tList<tRegex::Match> logMatches;
+	logLine.Search(nearMiss, logMatches);
+	tRequire(logMatches.IsEmpty());
+	nearMiss[nearMissLength - 3] = 'E';
+	nearMiss[nearMissLength - 2] = 'R';
+	nearMiss[nearMissLength - 1] = 'R';
+	logLine.Search(nearMiss, logMatches);
+	tRequire(logMatches.GetNumItems() == 1);
+	tRequire((logMatches.First()->IndexStart == 0) && (logMatches.First()->Length == nearMissLength));
+	delete[] nearMiss;
+
+	// An 'a' thirteen characters from the end needs more DFA states than are cached so this falls back to the NFA part
+	// way through. Results must not change.
+	tRegex thirteenth("(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)", tRegexEngine::Automaton);
+	const int abLength = 20000;
+	char* ab = new char[abLength + 1];
+	uint32 seed = 12345;
+	for (int c = 0; c < abLength; c++)
+	{
+		seed = seed*1664525 + 1013904223;
+		ab[c] = (seed & 0x00010000) ? 'a' : 'b';
+	}
+	ab[abLength] = '\0';
+	bool abCorrect = true;
+	for (int len = abLength - 64; len <= abLength; len++)
+	{
+		char last = ab[len];
+		ab[len] = '\0';
+		if (thirteenth.IsMatch(ab) != (ab[len-13] == 'a'))
+			abCorrect = false;
+		ab[len] = last;
+	}
+	tRequire(abCorrect);
+	delete[] ab;
+
+	// A compiled automaton may be shared by threads. The DFA is built while they race.
+	tRegex shared("([A-Z][a-z]+) (\\d+)\\.(\\d+)", tRegexEngine::Automaton);
+	const int numRegexThreads = 4;
+	bool threadCorrect[numRegexThreads];
+	std::thread regexThreads[numRegexThreads];
+	for (int t = 0; t < numRegexThreads; t++)
+	{
+		regexThreads[t] = std::thread
+		(
+			[t, &shared, &threadCorrect]()
+			{
+				threadCorrect[t] = true;
+				for (int i = 0; i < 2000; i++)
+				{
+					tString line;
+					tsPrintf(line, "%s Version %d.%d", (i % 3) ? "Release" : "Debug", i, t);
+					tList<tRegex::Match> lineMatches;
+					shared.Search(line, lineMatches);
+					if ((lineMatches.GetNumItems() != 4) || (lineMatches.First()->IndexStart != ((i % 3) ? 8 : 6)))
+					{
+						threadCorrect[t] = false;
+						continue;
+					}
+
+					tString major = lineMatches.First()->Next()->Next()->GetString(line);
+					if ((major.AsInt() != i) || !shared.IsMatch(tStd::tStrchr(line.ConstText(), ' ') + 1))
+						threadCorrect[t] = false;
+				}
+			}
+		);
+	}
+	for (int t = 0; t < numRegexThreads; t++)
+	{
+		regexThreads[t].join();
+		tRequire(threadCorrect[t]);
+	}
+
+	// A regex set finds every pattern that is a perfect match in one pass. The results must be the same as compiling
+	// and testing each pattern on its own.
+	const char* rules[] =
+	{
+		"Textures/.*\\.tga", "Textures/UI/.*", ".*\\.(tga|png)", "Models/[A-Za-z]+_lod\\d\\.obj",
+		"Models/.*", "", ".*/Temp/.*", "Sounds/\\w+\\.wav", "[^/]*", "Textures/UI/Icon\\d{2,3}\\.png"
+	};
+	const int numRules = sizeof(rules) / sizeof(rules[0]);
+	tRegexSet ruleSet(rules, numRules);
+	tRequire(ruleSet.IsValid() && (ruleSet.GetNumPatterns() == numRules));
+	const char* paths[] =
+	{
+		"Textures/Rock.tga", "Textures/UI/Icon12.png", "Textures/UI/Icon1.png", "Models/Tree_lod2.obj",
+		"Models/Temp/Tree_lod2.obj", "Sounds/Step_01.wav", "Sounds/Step 01.wav", "Readme", "", "Textures/UI/"
+	};
+	bool setCorrect = true;
+	for (const char* path : paths)
+	{
+		tBitArray matched;
+		int numMatched = ruleSet.Match(path, matched);
+		int expectedMatched = 0;
+		for (int r = 0; r < numRules; r++)
+		{
+			bool expected = *rules[r] && tRegex(rules[r], tRegexEngine::Automaton).IsMatch(path);
+			expectedMatched += expected ? 1 : 0;
+			if (matched.GetBit(r) != expected)
+				setCorrect = false;
+		}
+		if ((numMatched != expectedMatched) || (ruleSet.IsMatch(path) != (expectedMatched > 0)))
+			setCorrect = false;
+	}
+	tRequire(setCorrect);
+
+	tBitArray readmeMatched;
+	tRequire(ruleSet.Match("Readme", readmeMatched) == 1);
+	tRequire(readmeMatched.GetBit(8) && !readmeMatched.GetBit(5));
+
+	// A word boundary in any pattern means the set runs on the NFA alone.
+	const char* boundaryRules[] = { "\\w+\\b.*", "Error\\B.*", "Warn.*" };
+	tRegexSet boundarySet(boundaryRules, 3);
+	tBitArray boundaryMatched;
+	tRequire(boundarySet.Match("Errors found", boundaryMatched) == 2);
+	tRequire(boundaryMatched.GetBit(0) && boundaryMatched.GetBit(1) && !boundaryMatched.GetBit(2));
+	tRequire(!boundarySet.IsMatch(""));
+
+	// A set holding only an empty pattern is valid but never matches anything.
+	const char* emptyRules[] = { "" };
+	tRegexSet emptySet(emptyRules, 1);
+	tBitArray emptyMatched;
+	tRequire(emptySet.IsValid() && (emptySet.GetNumPatterns() == 1));
+	tRequire(!emptySet.IsMatch("") && !emptySet.IsMatch("Readme"));
+	tRequire((emptySet.Match("Readme", emptyMatched) == 0) && !emptyMatched.GetBit(0));
+
+	// Many rules against many paths. One pass per path should beat one IsMatch per rule per path.
+	const int numManyRules = 200;
+	tList<tStringItem> manyRules;
+	for (int r = 0; r < numManyRules; r++)
+		manyRules.Append(new tStringItem(tsPrintf("Assets/Level%02d/[A-Za-z]+_%d\\.(tga|png)", r % 50, r)));
+	tRegexSet manySet(manyRules);
+	tRegex** manyRegexes = new tRegex*[numManyRules];
+	int r = 0;
+	for (tStringItem* rule = manyRules.First(); rule; rule = rule->Next(), r++)
+		manyRegexes[r] = new tRegex(*rule, tRegexEngine::Automaton);
+
+	const int numManyPaths = 2000;
+	tString* manyPaths = new tString[numManyPaths];
+	for (int p = 0; p < numManyPaths; p++)
+		tsPrintf(manyPaths[p], "Assets/Level%02d/Rock_%d.%s", p % 50, p % 250, (p % 3) ? "tga" : "dds");
+
+	start = tGetHardwareTimerCount();
+	int separateCount = 0;
+	for (int p = 0; p < numManyPaths; p++)
+		for (int r = 0; r < numManyRules; r++)
+			separateCount += manyRegexes[r]->IsMatch(manyPaths[p]) ? 1 : 0;
+	double separateTime = double(tGetHardwareTimerCount() - start) / double(freq);
+
+	start = tGetHardwareTimerCount();
+	int setCount = 0;
+	tBitArray manyMatched;
+	for (int p = 0; p < numManyPaths; p++)
+		setCount += manySet.Match(manyPaths[p], manyMatched);
+	double setTime = double(tGetHardwareTimerCount() - start) / double(freq);
+
+	tPrintf("Regex set: %d rules, %d paths. Separate:%f ms  Set:%f ms\n", numManyRules, numManyPaths, separateTime*1000.0, setTime*1000.0);
+	tRequire(setCount == separateCount);
+	tGoal(setTime < separateTime);
+
+	for (int r = 0; r < numManyRules; r++)
+		delete manyRegexes[r];
+	delete[] manyRegexes;
+	delete[] manyPaths;
+}
+
+
+// Walks two expressions for the same script, one parsed and one not, and checks they have the same structure and
+// the same atom values.
+bool ScriptTreesAgree(const tExpression& text, const tExpression& parsed)
+{
+	if ((text.IsValid() != parsed.IsValid()) || (text.IsAtom() != parsed.IsAtom()))
+		return false;
+
+	if (!text.IsValid())
+		return true;
+
+	if (text.IsAtom())
+		return
+		(
+			(text.GetAtomString() == parsed.GetAtomString()) && (text.GetAtomInt() == parsed.GetAtomInt()) &&
+			(text.GetAtomUint64() == parsed.GetAtomUint64()) && (text.GetAtomDouble() == parsed.GetAtomDouble()) &&
+			(text.GetAtomBool() == parsed.GetAtomBool())
+		);
+
+	int numItems = text.CountItems();
+	if (numItems != parsed.CountItems())
+		return false;
+
+	int index = 0;
+	for (tExpression t = text.First(), p = parsed.First(); t.IsValid() || p.IsValid(); t = t.Next(), p = p.Next(), index++)
+		if (!ScriptTreesAgree(t, p) || !ScriptTreesAgree(t, parsed.ItemN(index)))
+			return false;
+
+	return index == numItems;
 }
 
 
@@ -627,6 +1107,174 @@ tTestUnit(Script)
 		tPrintf("\n");
 	}
 	tRequire(numExceptions == 1);
+
+	tPrintf("Testing reading a parsed script.\n");
+	{
+		tScriptReader text("TestData/TestScript.txt");
+		tScriptReader parsed("TestData/TestScript.txt", true, true);
+		tRequire(!text.IsParsed() && parsed.IsParsed());
+		tRequire(ScriptTreesAgree(text, parsed));
+		tRequire(parsed.CountItems() == 8);
+		tRequire(parsed.Item1().GetAtomString() == "K");
+		tRequire(parsed.Item1().GetLineNumber() == 8);
+		tRequire(parsed.Item0().Item1().Item1().GetAtomInt() == 42);
+		tRequire(parsed.Item0().Item1().Item2().GetAtomBool());
+		tRequire(parsed.Item3().Item1().GetAtomString() == "This is a bigger atom");
+		tVector3 v = parsed.ItemN(6).Item2().GetAtomVector3();
+		tRequire((v.x == 1.0f) && (v.y == 2.0f) && (v.z == 3.0f));
+
+		int length;
+		const char* atomText = parsed.Item5().Item0().GetAtomText(length);
+		tRequire((length == 6) && !tStd::tStrncmp(atomText, "quoted", length));
+	}
+
+	{
+		// The parser respects quoted strings when finding the end of a list.
+		tScriptReader parsed("[x \"a]b\"] y", false, true);
+		tRequire(parsed.CountItems() == 2);
+		tRequire(parsed.Item0().Item1().GetAtomString() == "a]b");
+		tRequire(parsed.Item1().GetAtomString() == "y");
+
+		tScriptReader empty("[] [[]] z", false, true);
+		tRequire((empty.CountItems() == 3) && (empty.Item0().CountItems() == 0) && !empty.Item0().First().IsValid());
+		tRequire(empty.Item1().Item0().CountItems() == 0);
+		tRequire(empty.Item2().GetAtomString() == "z");
+
+		numExceptions = 0;
+		tScriptReader bad("[a \"unterminated]", false);
+		try
+		{
+			bad.Parse();
+		}
+		catch (tScriptError error)
+		{
+			numExceptions++;
+		}
+		tRequire((numExceptions == 1) && !bad.IsParsed());
+	}
+
+	// Random access into a large script is quadratic unless it is parsed.
+	const int numEntries = 1000;
+	tString largeScript;
+	for (int e = 0; e < numEntries; e++)
+	{
+		tString entry;
+		tsPrintf(entry, "[Entry%d %d %f True [a b \"c d\"]]\n", e, e, float(e) * 0.5f);
+		largeScript += entry;
+	}
+
+	int64 freq = tGetHardwareTimerFrequency();
+	int64 start = tGetHardwareTimerCount();
+	tScriptReader largeText(largeScript, false);
+	int64 textSum = 0;
+	int numTextItems = largeText.CountItems();
+	for (int e = 0; e < numTextItems; e++)
+		textSum += largeText.ItemN(e).Item1().GetAtomInt();
+	double textTime = double(tGetHardwareTimerCount() - start) / double(freq);
+
+	start = tGetHardwareTimerCount();
+	tScriptReader largeParsed(largeScript, false, true);
+	int64 parsedSum = 0;
+	int numParsedItems = largeParsed.CountItems();
+	for (int e = 0; e < numParsedItems; e++)
+		parsedSum += largeParsed.ItemN(e).Item1().GetAtomInt();
+	double parsedTime = double(tGetHardwareTimerCount() - start) / double(freq);
+
+	tPrintf("Script with %d entries. Text:%f ms  Parsed:%f ms\n", numEntries, textTime*1000.0, parsedTime*1000.0);
+	tRequire((textSum == parsedSum) && (parsedSum == int64(numEntries)*int64(numEntries-1)/2));
+	tRequire(ScriptTreesAgree(largeText, largeParsed));
+	tGoal(parsedTime < textTime);
+
+	tPrintf("Testing writing a script to memory.\n");
+	{
+		// The memory writer must produce exactly what the file writer does.
+		tScriptWriter ws;
+		ws.WriteComment();
+		ws.WriteComment("A comment!!");
+		ws.WriteComment();
+		ws.NewLine();
+		ws.BeginExpression();
+		ws.WriteAtom("A");
+		ws.BeginExpression();
+		ws.WriteAtom("B");
+		ws.WriteAtom("C");
+		ws.EndExpression();
+		ws.EndExpression();
+		ws.NewLine();
+		ws.BeginExpression();
+		ws.Indent();
+		ws.NewLine();
+			ws.WriteAtom("A longer atom");
+			ws.BeginExpression();
+			ws.WriteAtom( tString("M") );
+			ws.WriteAtom(-3.0f);
+			ws.WriteAtom(300000000000000000.0f);
+			ws.WriteAtom(-4);
+			ws.WriteAtom(true);
+			ws.EndExpression();
+			ws.Dedent();
+			ws.NewLine();
+		ws.EndExpression();
+
+		tString fileText;
+		tLoadFile("TestData/WrittenScript.txt", fileText);
+		tPrintf("Memory script:\n%s\n", ws.GetText());
+		tRequire((ws.GetTextLength() == fileText.Length()) && (fileText == ws.GetText()));
+	}
+
+	{
+		// Numbers are formatted without going through a tString but must match the printf formatting.
+		float floats[] = { 0.0f, -3.0f, 1.5f, 0.1f, -123.456f, 3.0e17f, 1.0e-9f, 0.999999999f };
+		tScriptWriter ws;
+		tString expected;
+		for (int f = 0; f < int(sizeof(floats)/sizeof(*floats)); f++)
+		{
+			ws.WriteAtom(floats[f]);
+			tString val;
+			tsPrintf(val, "%8.8f ", floats[f]);
+			expected += val;
+		}
+		ws.WriteAtom(-2147483647 - 1);
+		ws.WriteAtom(uint32(4294967295u));
+		ws.WriteAtom(uint64(18446744073709551615ull));
+		ws.WriteAtom(0.1);
+		ws.WriteAtom(tVector3(1.0f, -2.5f, 0.0f));
+		ws.WriteAtom(tColouri(255, 128, 0, 1));
+		ws.WriteAtom("two words");
+		ws.WriteAtom(tString());
+		expected += "-2147483648 4294967295 18446744073709551615 0.1000000000000000 ";
+		expected += "(1.00000000, -2.50000000, 0.00000000) (255, 128, 0, 1) \"two words\" \"\" ";
+		tPrintf("Atoms:%s\n", ws.GetText());
+		tRequire(expected == ws.GetText());
+	}
+
+	// Write a large script to a file and to memory and read it back.
+	const int numWritten = 20000;
+	int64 writeStart = tGetHardwareTimerCount();
+	{
+		tScriptWriter ws("TestData/WrittenLarge.txt");
+		for (int e = 0; e < numWritten; e++)
+			ws.Comp("Entry", e, e*2);
+	}
+	double writeTime = double(tGetHardwareTimerCount() - writeStart) / double(freq);
+	tPrintf("Wrote %d expressions to a file in %f ms\n", numWritten, writeTime*1000.0);
+
+	tScriptWriter memWriter;
+	for (int e = 0; e < numWritten; e++)
+		memWriter.Comp("Entry", e, e*2);
+
+	tString largeFileText;
+	tLoadFile("TestData/WrittenLarge.txt", largeFileText);
+	tRequire(largeFileText == memWriter.GetText());
+	tDeleteFile("TestData/WrittenLarge.txt");
+
+	tScriptReader roundTrip(memWriter.GetText(), false, true);
+	tRequire(roundTrip.CountItems() == numWritten);
+	bool roundTripCorrect = true;
+	for (tExpression e = roundTrip.First(); e.IsValid(); e = e.Next())
+		if ((e.Item0().GetAtomString() != "Entry") || (int(e.Item2()) != 2*int(e.Item1())))
+			roundTripCorrect = false;
+	tRequire(roundTripCorrect && (int(roundTrip.ItemN(numWritten-1).Item1()) == numWritten-1));
 }
 
 
@@ -682,7 +1330,7 @@ tTestUnit(Chunk)
 
 	tPrintf("Reading but managing the memory myself.\n");
 	{
-		uint8* buffer = (uint8*)tMem::tMalloc(tChunkReader::GetBufferSizeNeeded("TestData/WrittenChunk.bin"), tChunkReader::GetBufferAlignmentNeeded());
+		uint8* buffer = (uint8*)tMem::tMalloc(int(tChunkReader::GetBufferSizeNeeded("TestData/WrittenChunk.bin")), tChunkReader::GetBufferAlignmentNeeded());
 		tChunkReader c("TestData/WrittenChunk.bin", buffer);
 
 		for (tChunk ch = c.GetFirstChunk(); ch != ch.GetLastChunk(); ch = ch.GetNextChunk())
@@ -692,6 +1340,220 @@ tTestUnit(Chunk)
 		}
 		tMem::tFree(buffer);
 	}
+
+	tPrintf("Reading a memory mapped chunk file.\n");
+	{
+		tChunkReader c;
+		tRequire(c.LoadMapped("TestData/WrittenChunk.bin"));
+		tRequire(c.IsMapped());
+
+		int numChunks = 0;
+		for (tChunk ch = c.GetFirstChunk(); ch.Valid(); ch = ch.GetNextChunk(), numChunks++)
+		{
+			uint8* data = ch.GetData();
+			tPrintf("Chunk ID %x Data %s\n", ch.ID(), data);
+			tRequire((tString((char*)data) == "Does this work?") || (tString((char*)data) == "Next chunk..."));
+
+			// The data is referenced in place so the alignments requested when writing must still hold.
+			int align = (ch.ID() == 0x02424242) ? 64 : 32;
+			tRequire((uint64(data) % align) == 0);
+		}
+		tRequire(numChunks == 2);
+
+		// The pages are copy-on-write so modifying the data must not change the file.
+		tChunk first = c.GetFirstChunk();
+		first.GetData()[0] = 'X';
+		c.UnLoad();
+		tRequire(!c.IsMapped() && !c.IsValid());
+
+		tChunkReader r("TestData/WrittenChunk.bin");
+		tRequire(r.GetFirstChunk().GetData()[0] == 'D');
+		tRequire(!c.LoadMapped("TestData/NonExistentChunkFile.bin"));
+	}
+
+	tPrintf("Testing the chunk index.\n");
+	for (int withIndex = 0; withIndex < 2; withIndex++)
+	{
+		{
+			tChunkWriter w("TestData/WrittenChunkIndexed.bin");
+			for (int container = 0; container < 3; container++)
+			{
+				w.Begin(0x82424200);
+				for (int item = 0; item < 50; item++)
+				{
+					w.Begin((item % 2) ? 0x02424201 : 0x02424202, 16);
+					w.Write(container*100 + item);
+					w.End();
+				}
+				w.End();
+			}
+			w.Begin(0x02424203);
+			w.Write(tString("Last"));
+			w.End();
+			if (withIndex)
+				w.WriteIndex();
+		}
+
+		tChunkReader r;
+		tRequire(r.LoadMapped("TestData/WrittenChunkIndexed.bin"));
+		tRequire(r.HasIndex() == (withIndex ? true : false));
+
+		// Walking the top level must not see the index chunk.
+		int numTop = 0;
+		for (tChunk ch = r.First(); ch.Valid(); ch = ch.Next())
+			numTop++;
+		tRequire(numTop == 4);
+
+		tChunk last = r.FindChunk(0x02424203);
+		tRequire(last.Valid() && (tString((char*)last.Data()) == "Last"));
+		tRequire(!r.FindChunk(0x02424201).Valid());
+
+		int numContainers = 0;
+		int numOdd = 0;
+		bool valuesCorrect = true;
+		for (tChunk cont = r.FindChunk(0x82424200); cont.Valid(); cont = r.FindNextChunk(cont), numContainers++)
+		{
+			int expected = numContainers*100 + 1;
+			for (tChunk odd = r.FindChunk(0x02424201, cont); odd.Valid(); odd = r.FindNextChunk(odd), numOdd++, expected += 2)
+			{
+				if ((*((int*)odd.Data()) != expected) || (uint64(odd.Data()) % 16))
+					valuesCorrect = false;
+			}
+
+			// The chunks returned must still be able to walk to the end of their container.
+			int numAfter = 0;
+			for (tChunk ch = r.FindChunk(0x02424202, cont); ch.Valid(); ch = ch.Next())
+				numAfter++;
+			if (numAfter != 50)
+				valuesCorrect = false;
+		}
+		tRequire(numContainers == 3);
+		tRequire(numOdd == 75);
+		tRequire(valuesCorrect);
+	}
+
+	tPrintf("Testing buffered and growable chunk writing.\n");
+	{
+		// The big chunk is larger than the file write buffer so its container size gets patched after a flush.
+		const int bigCount = 1024*1024;
+		int* big = new int[bigCount];
+		for (int i = 0; i < bigCount; i++)
+			big[i] = i;
+
+		tChunkWriter fileWriter("TestData/WrittenChunkBuffered.bin");
+		tChunkWriter memWriter;
+		memWriter.OpenMemory();
+		tChunkWriter* writers[2] = { &fileWriter, &memWriter };
+		for (int w = 0; w < 2; w++)
+		{
+			tChunkWriter& c = *writers[w];
+			c.Begin(0x82424200);
+			for (int i = 0; i < 10000; i++)
+			{
+				c.Begin(0x02424201);
+				c.Write(i);
+				c.End();
+			}
+			c.Begin(0x02424202, 512);
+			c.Write(big, bigCount);
+			c.End();
+			c.End();
+		}
+		fileWriter.Close();
+		delete[] big;
+
+		int fileSize = 0;
+		uint8* fileData = tLoadFile("TestData/WrittenChunkBuffered.bin", nullptr, &fileSize);
+		tRequire(fileSize == memWriter.GetNumBytesWritten());
+		tRequire(fileData && (tStd::tMemcmp(fileData, memWriter.GetBuffer(), fileSize) == 0));
+		delete[] fileData;
+
+		tChunkReader r("TestData/WrittenChunkBuffered.bin");
+		tChunk cont = r.First();
+		tRequire(cont.IsContainer() && !cont.Next().Valid());
+		tChunk bigChunk = r.FindChunk(0x02424202, cont);
+		tRequire(bigChunk.GetDataSize() == bigCount*int(sizeof(int)));
+		tRequire(((int*)bigChunk.GetData())[bigCount-1] == bigCount-1);
+		tRequire((uint64(bigChunk.GetData()) % 512) == 0);
+	}
+
+	tPrintf("Testing compressed chunks.\n");
+	{
+		const int count = 64*1024;
+		int* values = new int[count];
+		for (int i = 0; i < count; i++)
+			values[i] = i % 100;
+
+		int uncompressedFileSize = 0;
+		for (int pass = 0; pass < 2; pass++)
+		{
+			tChunkCodec codec = pass ? tChunkCodec::Deflate : tChunkCodec::None;
+			tChunkWriter w("TestData/WrittenChunkCompressed.bin");
+			w.Begin(0x82424200);
+			for (int c = 0; c < 8; c++)
+			{
+				w.Begin(0x02424201, 64, codec);
+				w.Write(c);
+				w.Write(values, count);
+				w.End();
+			}
+
+			// Too small to get any smaller so it is stored as is.
+			w.Begin(0x02424202, tChunkWriter::Alignment::B4, codec);
+			w.Write(42);
+			w.End();
+			w.End();
+			w.WriteIndex();
+			w.Close();
+
+			if (!pass)
+			{
+				uncompressedFileSize = tGetFileSize("TestData/WrittenChunkCompressed.bin");
+				continue;
+			}
+			tRequire(tGetFileSize("TestData/WrittenChunkCompressed.bin") < uncompressedFileSize/10);
+		}
+
+		for (int background = 0; background < 2; background++)
+		{
+			tChunkReader r("TestData/WrittenChunkCompressed.bin");
+			if (background)
+				r.DecompressInBackground();
+
+			int numChunks = 0;
+			bool valuesCorrect = true;
+			for (tChunk ch = r.FindChunk(0x02424201, r.First()); ch.IsValid(); ch = r.FindNextChunk(ch), numChunks++)
+			{
+				tRequire(ch.IsCompressed() && (ch.GetDataSize() == int(sizeof(int))*(count+1)));
+				tRequire((uint64(ch.GetData()) % 64) == 0);
+
+				int c = -1;
+				ch.GetItem(c);
+				valuesCorrect = valuesCorrect && (c == numChunks);
+				valuesCorrect = valuesCorrect && (tStd::tMemcmp(ch.GetItemCurrent(), values, count*sizeof(int)) == 0);
+			}
+			tRequire(numChunks == 8);
+			tRequire(valuesCorrect);
+
+			tChunk small = r.FindChunk(0x02424202, r.First());
+			tRequire(!small.IsCompressed() && (small.GetDataSize() == int(sizeof(int))));
+			tRequire(*((int*)small.GetData()) == 42);
+		}
+
+		// Decompressing must leave the read buffer untouched, so a resave is the same as the original file.
+		tChunkReader r("TestData/WrittenChunkCompressed.bin");
+		r.DecompressInBackground();
+		for (tChunk ch = r.FindChunk(0x02424201, r.First()); ch.IsValid(); ch = r.FindNextChunk(ch))
+			ch.GetData();
+		r.Save("TestData/WrittenChunkResaved.bin");
+		int origSize = 0, resavedSize = 0;
+		uint8* orig = tLoadFile("TestData/WrittenChunkCompressed.bin", nullptr, &origSize);
+		uint8* resaved = tLoadFile("TestData/WrittenChunkResaved.bin", nullptr, &resavedSize);
+		tRequire((origSize == resavedSize) && (tStd::tMemcmp(orig, resaved, origSize) == 0));
+		delete[] orig;
+		delete[] resaved;
+		delete[] values;
+	}
 }
 
 
@@ -734,12 +1596,107 @@ tTestUnit(File)
 	tDeleteDir("TestData/CreatedDirectory/");
 	tRequire(!tDirExists("TestData/CreatedDirectory/"));
 
+	// Files bigger than the streaming buffer are compared and hashed a block at a time.
+	const int dataSize = 2500*1000;
+	uint8* data = new uint8[dataSize];
+	for (int i = 0; i < dataSize; i++)
+		data[i] = uint8(i % 251);
+	tCreateFile("TestData/WrittenFileA.bin", data, dataSize);
+	tCreateFile("TestData/WrittenFileB.bin", data, dataSize);
+	data[dataSize-1]++;
+	tCreateFile("TestData/WrittenFileC.bin", data, dataSize);
+	data[dataSize-1]--;
+	tRequire(tGetFileSize("TestData/WrittenFileA.bin") == dataSize);
+	tRequire(tFilesIdentical("TestData/WrittenFileA.bin", "TestData/WrittenFileB.bin"));
+	tRequire(!tFilesIdentical("TestData/WrittenFileA.bin", "TestData/WrittenFileC.bin"));
+	tRequire(tHashFileFast32("TestData/WrittenFileA.bin") == tMath::tHashDataFast32(data, dataSize));
+	tRequire(tHashFile32("TestData/WrittenFileA.bin") == tMath::tHashData32(data, dataSize));
+	tRequire(tHashFile64("TestData/WrittenFileA.bin", 7) == tMath::tHashData64(data, dataSize, 7));
+	tRequire(tHashFileMD5("TestData/WrittenFileA.bin") == tMath::tHashDataMD5(data, dataSize));
+	tRequire(tHashFile256("TestData/WrittenFileA.bin") == tMath::tHashData256(data, dataSize));
+
+	// Tree hashes are the hash of the block hashes.
+	const int numBlocks = (dataSize + HashTreeBlockSize - 1) / HashTreeBlockSize;
+	uint64 blockHashes[numBlocks];
+	for (int b = 0; b < numBlocks; b++)
+		blockHashes[b] = tMath::tHashData64(data + b*HashTreeBlockSize, tMath::tMin(dataSize - b*HashTreeBlockSize, HashTreeBlockSize));
+	uint64 treeHash = tMath::tHashData64((uint8*)blockHashes, sizeof(blockHashes), 7);
+	tRequire(tHashFile64("TestData/WrittenFileA.bin", 7, tHashFileMode::Tree) == treeHash);
+	tRequire(tHashFile256("TestData/WrittenFileA.bin", 0, tHashFileMode::Tree) == tHashFile256("TestData/WrittenFileB.bin", 0, tHashFileMode::Tree));
+	tRequire(tHashFile256("TestData/WrittenFileA.bin", 0, tHashFileMode::Tree) != tHashFile256("TestData/WrittenFileC.bin", 0, tHashFileMode::Tree));
+
+	int64 loadedSize = 0;
+	uint8* loaded = tLoadFile("TestData/WrittenFileA.bin", nullptr, &loadedSize);
+	tRequire((loadedSize == dataSize) && (tStd::tMemcmp(loaded, data, dataSize) == 0));
+	delete[] loaded;
+	delete[] data;
+	tDeleteFile("TestData/WrittenFileA.bin");
+	tDeleteFile("TestData/WrittenFileB.bin");
+	tDeleteFile("TestData/WrittenFileC.bin");
+
+	// Sizes and offsets past 2GB. Linux file systems create this as a sparse file so it doesn't take up any space.
+	#ifdef PLATFORM_LINUX
+	const int64 bigSize = 3LL*1024*1024*1024 + 1;
+	tFileHandle bigFile = tOpenFile("TestData/WrittenFileBig.bin", "wb");
+	tRequire(tFileSeek(bigFile, bigSize-1) == 0);
+	tRequire(tFileTell(bigFile) == bigSize-1);
+	tPutc('T', bigFile);
+	tCloseFile(bigFile);
+	tRequire(tGetFileSize("TestData/WrittenFileBig.bin") == bigSize);
+
+	int smallSize = -1;
+	tRequire(!tLoadFile("TestData/WrittenFileBig.bin", nullptr, &smallSize) && (smallSize == 0));
+
+	bigFile = tOpenFile("TestData/WrittenFileBig.bin", "rb");
+	tFileSeek(bigFile, -1, tSeekOrigin::End);
+	char lastChar = 0;
+	tReadFile(bigFile, &lastChar, 1);
+	tRequire(lastChar == 'T');
+	tCloseFile(bigFile);
+	tDeleteFile("TestData/WrittenFileBig.bin");
+	#endif
+
 	tString normalPath = "Q:/Projects/Calamity/Crypto/../../Reign/./Squiggle/";
 	tPrintf("Testing GetSimplifiedPath on '%s'\n", normalPath.Pod());
 
 	tString simpPath = tGetSimplifiedPath(normalPath);
 	tPrintf("Simplified Path '%s'\n", simpPath.Pod());
 	tRequire(simpPath =="Q:/Projects/Reign/Squiggle/");
+
+	// Timings for common path and parse operations. These lean heavily on tString copies, appends, and lengths.
+	const int numIterations = 100000;
+	int64 freq = tGetHardwareTimerFrequency();
+	int64 start = tGetHardwareTimerCount();
+	int totalLength = 0;
+	for (int i = 0; i < numIterations; i++)
+	{
+		tString path = "Q:/Projects/Calamity/";
+		path += "Assets/";
+		path += "Textures/";
+		path += "Diffuse_Albedo.tga";
+		tString name = tGetFileName(path);
+		tString base = tGetFileBaseName(path);
+		tString ext = tGetFileExtension(path);
+		tString dir = tGetDir(path);
+		totalLength += name.Length() + base.Length() + ext.Length() + dir.Length();
+	}
+	double pathTime = double(tGetHardwareTimerCount() - start) / double(freq);
+	tPrintf("Path operations. %d iterations in %.2fms\n", numIterations, pathTime*1000.0);
+	tRequire(totalLength == numIterations*(18 + 14 + 3 + 37));
+
+	start = tGetHardwareTimerCount();
+	int numComponents = 0;
+	tString csv = "alpha,beta,gamma,delta,epsilon,zeta,eta,theta,iota,kappa,lambda,mu";
+	for (int i = 0; i < numIterations/10; i++)
+	{
+		tList<tStringItem> components(true);
+		numComponents += tStd::tExplode(components, csv, ',');
+		for (tStringItem* comp = components.First(); comp; comp = comp->Next())
+			comp->ToUpper();
+	}
+	double parseTime = double(tGetHardwareTimerCount() - start) / double(freq);
+	tPrintf("Explode operations. %d iterations in %.2fms\n", numIterations/10, parseTime*1000.0);
+	tRequire(numComponents == 12*(numIterations/10));
 }
 
 
@@ -20,6 +20,7 @@ namespace tUnitTest
 {
 	tTestUnit(CmdLine);
 	tTestUnit(Task);
+	tTestUnit(JobSystem);
 	tTestUnit(Print);
 	tTestUnit(Regex);
 	tTestUnit(Script);
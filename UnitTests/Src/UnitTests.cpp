@@ -73,6 +73,7 @@ int main(int argc, char** argv)
 	tTest(RingBuffer);
 	tTest(PriorityQueue);
 	tTest(MemoryPool);
+	tTest(HashMap);
 
 	// Math tests.
 	tTest(Fundamentals);
@@ -86,6 +87,7 @@ int main(int argc, char** argv)
 	// System tests.
 	tTest(CmdLine);
 	tTest(Task);
+	tTest(JobSystem);
 	tTest(Print);
 	tTest(Regex);
 	tTest(Script);
@@ -102,6 +104,9 @@ int main(int argc, char** argv)
 	// Image tests.
 	tTest(Image);
 
+	// Scene tests.
+	tTest(Scene);
+
 	#else
 
 	// If UNIT_TEST_ONLY_ONE_TEST is defined, this is the test.